@@ -0,0 +1,554 @@
+/// \file ijkbit_grid.txx
+/// ijk templates defining grids of bits.
+/// - Version 0.1.0
+
+/*
+  IJK: Isosurface Jeneration Kode
+  Copyright (C) 2015 Rephael Wenger
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License
+  (LGPL) as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#ifndef _IJKBIT_GRID_
+#define _IJKBIT_GRID_
+
+#include <algorithm>
+
+#include "ijk.txx"
+#include "ijkgrid.txx"
+
+namespace IJK {
+
+  // **************************************************
+  // BIT WORD FUNCTIONS
+  // **************************************************
+
+  /// Word storing 64 bits of a bit grid.
+  typedef unsigned long long BIT_GRID_WORD;
+
+  /// Number of bits in BIT_GRID_WORD.
+  const int BITS_PER_BIT_GRID_WORD = 64;
+
+  /// Return number of bits set in word w.
+  inline int count_bits_in_word(const BIT_GRID_WORD w)
+  {
+#if defined(__GNUC__)
+    return(__builtin_popcountll(w));
+#else
+    int num_bits = 0;
+    for (BIT_GRID_WORD w2 = w; w2 != 0; w2 &= (w2-1))
+      { num_bits++; }
+    return(num_bits);
+#endif
+  }
+
+  /// Return index of lowest bit set in word w.
+  /// @pre w != 0.
+  inline int lowest_bit_in_word(const BIT_GRID_WORD w)
+  {
+#if defined(__GNUC__)
+    return(__builtin_ctzll(w));
+#else
+    int i = 0;
+    while ((w & (BIT_GRID_WORD(1) << i)) == 0) { i++; }
+    return(i);
+#endif
+  }
+
+  /// Return word whose bit k is true if scalar[k] >= s, for k < num_bits.
+  /// Higher bits are zero.
+  /// Comparisons are stored in a byte array so that the compiler
+  ///   can vectorize them.  Each eight bytes are packed into eight bits
+  ///   by a single multiplication.
+  /// @pre 0 <= num_bits <= BITS_PER_BIT_GRID_WORD.
+  template <typename STYPE, typename STYPE2>
+  inline BIT_GRID_WORD compute_ge_bits_in_word
+  (const STYPE * scalar, const STYPE2 s, const int num_bits)
+  {
+    unsigned char flag[BITS_PER_BIT_GRID_WORD];
+    BIT_GRID_WORD w = 0;
+
+    if (num_bits == BITS_PER_BIT_GRID_WORD) {
+      for (int k = 0; k < BITS_PER_BIT_GRID_WORD; k++)
+        { flag[k] = (scalar[k] >= s); }
+    }
+    else {
+      std::fill(flag, flag+BITS_PER_BIT_GRID_WORD, 0);
+      for (int k = 0; k < num_bits; k++)
+        { flag[k] = (scalar[k] >= s); }
+    }
+
+    for (int j = 0; j < BITS_PER_BIT_GRID_WORD; j += 8) {
+      // Byte i of x is flag[j+i], which is 0 or 1.
+      BIT_GRID_WORD x = 0;
+      for (int i = 0; i < 8; i++)
+        { x |= BIT_GRID_WORD(flag[j+i]) << (8*i); }
+      // Multiplication moves byte i to bit 56+i.
+      w |= ((x * BIT_GRID_WORD(0x0102040810204080ULL)) >> 56) << j;
+    }
+
+    return(w);
+  }
+
+  /// Return word with bits [ibit0, ibit1) set.
+  /// @pre 0 <= ibit0 < ibit1 <= BITS_PER_BIT_GRID_WORD.
+  inline BIT_GRID_WORD bit_range_mask(const int ibit0, const int ibit1)
+  {
+    const BIT_GRID_WORD all_bits = ~BIT_GRID_WORD(0);
+    const BIT_GRID_WORD mask1 =
+      (ibit1 < BITS_PER_BIT_GRID_WORD) ?
+      ((BIT_GRID_WORD(1) << ibit1) - 1) : all_bits;
+    return(mask1 & (all_bits << ibit0));
+  }
+
+  // **************************************************
+  // TEMPLATE CLASS BIT_GRID
+  // **************************************************
+
+  /// Grid of boolean values stored one bit per vertex.
+  /// Same Scalar() and Set() interface as BOOL_GRID
+  ///   using one eighth of the memory.
+  /// Bulk operations process BITS_PER_BIT_GRID_WORD vertices at a time.
+  /// Bits past the last grid vertex are always zero.
+  template <typename GRID_CLASS>
+  class BIT_GRID:public GRID_CLASS {
+
+  protected:
+    typedef typename GRID_CLASS::DIMENSION_TYPE DTYPE;
+    typedef typename GRID_CLASS::AXIS_SIZE_TYPE ATYPE;
+    typedef typename GRID_CLASS::VERTEX_INDEX_TYPE VTYPE;
+    typedef typename GRID_CLASS::NUMBER_TYPE NTYPE;
+
+    BIT_GRID_WORD * word;    ///< Bit iv is bit iv%64 of word[iv/64].
+    NTYPE num_words;
+
+    void Init();
+    void FreeAll();
+
+    /// Set bits past the last grid vertex to zero.
+    void ClearBitsPastEnd();
+
+  public:
+    typedef bool SCALAR_TYPE;
+
+  public:
+    BIT_GRID() { Init(); };
+    BIT_GRID(const DTYPE dimension, const ATYPE * axis_size);
+    ~BIT_GRID() { FreeAll(); };
+
+    // copy constructor and assignment: NOT IMPLEMENTED
+    BIT_GRID(const BIT_GRID & bit_grid);
+    const BIT_GRID & operator = (const BIT_GRID & right);
+
+    // set functions
+    /// Set dimensions and axis sizes.  Set all values to false.
+    template <typename DTYPE2, typename ATYPE2>
+    void SetSize(const DTYPE2 dimension, const ATYPE2 * axis_size);
+
+    /// Set dimensions and axis sizes.  Set all values to false.
+    template <typename DTYPE2, typename ATYPE2, typename VTYPE2,
+              typename NTYPE2>
+    void SetSize(const GRID<DTYPE2,ATYPE2,VTYPE2,NTYPE2> & grid2);
+
+    /// Set value of vertex iv to flag.
+    void Set(const VTYPE iv, const bool flag)
+    {
+      const BIT_GRID_WORD mask =
+        BIT_GRID_WORD(1) << (iv%BITS_PER_BIT_GRID_WORD);
+      if (flag) { word[iv/BITS_PER_BIT_GRID_WORD] |= mask; }
+      else { word[iv/BITS_PER_BIT_GRID_WORD] &= ~mask; }
+    }
+
+    /// Set all values to flag.
+    void SetAll(const bool flag);
+
+    /// Set values of vertices iv0, iv0+1, ..., iv1-1 to flag.
+    void SetRange(const VTYPE iv0, const VTYPE iv1, const bool flag);
+
+    /// Set values of vertices in region to flag.
+    /// @param box Region.  Includes vertices with coordinates
+    ///   box.MinCoord(d) <= coord[d] <= box.MaxCoord(d).
+    /// @pre box is contained in the grid.
+    template <typename GTYPE>
+    void SetRegion(const BOX<GTYPE> & box, const bool flag);
+
+    /// Set value of each vertex iv to (scalar[iv] >= s).
+    /// Processes BITS_PER_BIT_GRID_WORD scalar values at a time.
+    /// @pre scalar[] has NumVertices() values.
+    template <typename STYPE, typename STYPE2>
+    void SetGE(const STYPE * scalar, const STYPE2 s);
+
+    /// Set value of each vertex iv stored in word k to (scalar[iv] >= s).
+    /// Other words are unchanged.
+    /// @pre scalar[] has NumVertices() values.
+    /// @pre 0 <= k < NumWords().
+    template <typename STYPE, typename STYPE2>
+    void SetGEInWord(const STYPE * scalar, const STYPE2 s, const NTYPE k)
+    {
+      const NTYPE iv0 = k*BITS_PER_BIT_GRID_WORD;
+      const int num_bits =
+        std::min(NTYPE(BITS_PER_BIT_GRID_WORD), this->NumVertices()-iv0);
+      word[k] = compute_ge_bits_in_word(scalar+iv0, s, num_bits);
+    }
+
+    /// Form logical "or" of current grid and grid2.
+    /// @pre grid2 has same grid dimensions as current grid.
+    template <typename GRID_CLASS2>
+    void Or(const BIT_GRID<GRID_CLASS2> & grid2);
+
+    /// Form logical "and" of current grid and grid2.
+    /// @pre grid2 has same grid dimensions as current grid.
+    template <typename GRID_CLASS2>
+    void And(const BIT_GRID<GRID_CLASS2> & grid2);
+
+    /// Form logical "and" of current grid with negation of grid2.
+    /// @pre grid2 has same grid dimensions as current grid.
+    template <typename GRID_CLASS2>
+    void AndNot(const BIT_GRID<GRID_CLASS2> & grid2);
+
+    // get functions
+
+    /// Return value of vertex iv.
+    bool Scalar(const VTYPE iv) const
+    {
+      return(((word[iv/BITS_PER_BIT_GRID_WORD] >>
+               (iv%BITS_PER_BIT_GRID_WORD)) & 1) != 0);
+    }
+
+    /// Return word whose bit k is the value of vertex iv+k.
+    /// Bits for vertices past the last grid vertex are zero.
+    BIT_GRID_WORD Word(const VTYPE iv) const
+    {
+      const NTYPE k = iv/BITS_PER_BIT_GRID_WORD;
+      const int ibit = iv%BITS_PER_BIT_GRID_WORD;
+      BIT_GRID_WORD w = word[k] >> ibit;
+      if (ibit != 0 && k+1 < num_words)
+        { w |= word[k+1] << (BITS_PER_BIT_GRID_WORD-ibit); }
+      return(w);
+    }
+
+    /// Return number of vertices whose value is true.
+    NTYPE CountTrue() const;
+
+    /// Return first vertex iv2 >= iv whose value is true.
+    /// Return NumVertices() if no such vertex exists.
+    VTYPE FindNextTrue(const VTYPE iv) const;
+
+    /// Return true if some vertex iv0, iv0+1, ..., iv1-1 has value true.
+    bool IsSomeTrue(const VTYPE iv0, const VTYPE iv1) const
+    { return(iv0 < iv1 && FindNextTrue(iv0) < iv1); }
+
+    /// Return number of words.
+    NTYPE NumWords() const
+    { return(num_words); }
+
+    /// Return pointer to words.
+    const BIT_GRID_WORD * WordPtrConst() const
+    { return(word); }
+  };
+
+  // **************************************************
+  // TEMPLATE CLASS BIT_GRID MEMBER FUNCTIONS
+  // **************************************************
+
+  template <typename GRID_CLASS>
+  BIT_GRID<GRID_CLASS>::
+  BIT_GRID(const DTYPE dimension, const ATYPE * axis_size)
+  {
+    Init();
+    SetSize(dimension, axis_size);
+  }
+
+  template <typename GRID_CLASS>
+  void BIT_GRID<GRID_CLASS>::Init()
+  {
+    word = NULL;
+    num_words = 0;
+  }
+
+  template <typename GRID_CLASS>
+  void BIT_GRID<GRID_CLASS>::FreeAll()
+  {
+    delete [] word;
+    Init();
+  }
+
+  template <typename GRID_CLASS>
+  template <typename DTYPE2, typename ATYPE2>
+  void BIT_GRID<GRID_CLASS>::
+  SetSize(const DTYPE2 dimension, const ATYPE2 * axis_size)
+  {
+    GRID_CLASS::SetSize(dimension, axis_size);
+
+    const NTYPE num_words2 =
+      (this->NumVertices()+BITS_PER_BIT_GRID_WORD-1)/BITS_PER_BIT_GRID_WORD;
+
+    if (word == NULL || num_words2 != num_words) {
+      delete [] word;
+      num_words = num_words2;
+      word = new BIT_GRID_WORD[num_words];
+    }
+    SetAll(false);
+  }
+
+  template <typename GRID_CLASS>
+  template <typename DTYPE2, typename ATYPE2, typename VTYPE2, typename NTYPE2>
+  void BIT_GRID<GRID_CLASS>::SetSize
+  (const GRID<DTYPE2,ATYPE2,VTYPE2,NTYPE2> & grid2)
+  {
+    SetSize(grid2.Dimension(), grid2.AxisSize());
+  }
+
+  template <typename GRID_CLASS>
+  void BIT_GRID<GRID_CLASS>::ClearBitsPastEnd()
+  {
+    const int num_end_bits = this->NumVertices()%BITS_PER_BIT_GRID_WORD;
+    if (num_end_bits != 0)
+      { word[num_words-1] &= bit_range_mask(0, num_end_bits); }
+  }
+
+  template <typename GRID_CLASS>
+  void BIT_GRID<GRID_CLASS>::SetAll(const bool flag)
+  {
+    const BIT_GRID_WORD w = (flag ? ~BIT_GRID_WORD(0) : BIT_GRID_WORD(0));
+    std::fill(word, word+num_words, w);
+    ClearBitsPastEnd();
+  }
+
+  template <typename GRID_CLASS>
+  void BIT_GRID<GRID_CLASS>::
+  SetRange(const VTYPE iv0, const VTYPE iv1, const bool flag)
+  {
+    if (iv0 >= iv1) { return; }
+
+    const NTYPE k0 = iv0/BITS_PER_BIT_GRID_WORD;
+    const NTYPE k1 = (iv1-1)/BITS_PER_BIT_GRID_WORD;
+    const int ibit0 = iv0%BITS_PER_BIT_GRID_WORD;
+    const int ibit1 = (iv1-1)%BITS_PER_BIT_GRID_WORD + 1;
+
+    for (NTYPE k = k0; k <= k1; k++) {
+      const BIT_GRID_WORD mask =
+        bit_range_mask((k == k0) ? ibit0 : 0,
+                       (k == k1) ? ibit1 : BITS_PER_BIT_GRID_WORD);
+      if (flag) { word[k] |= mask; }
+      else { word[k] &= ~mask; }
+    }
+  }
+
+  template <typename GRID_CLASS>
+  template <typename GTYPE>
+  void BIT_GRID<GRID_CLASS>::
+  SetRegion(const BOX<GTYPE> & box, const bool flag)
+  {
+    const DTYPE dimension = this->Dimension();
+    IJK::ARRAY<GTYPE> row_coord(dimension);
+
+    if (dimension < 1) { return; }
+
+    for (DTYPE d = 0; d < dimension; d++) {
+      if (box.MinCoord(d) > box.MaxCoord(d)) { return; }
+      row_coord[d] = box.MinCoord(d);
+    }
+
+    // Set one row (along axis 0) at a time.
+    while (true) {
+      const VTYPE iv0 = this->ComputeVertexIndex(row_coord.PtrConst());
+      SetRange(iv0, iv0+box.MaxCoord(0)-box.MinCoord(0)+1, flag);
+
+      DTYPE d = 1;
+      while (d < dimension) {
+        row_coord[d]++;
+        if (row_coord[d] <= box.MaxCoord(d)) { break; }
+        row_coord[d] = box.MinCoord(d);
+        d++;
+      }
+      if (d >= dimension) { break; }
+    }
+  }
+
+  template <typename GRID_CLASS>
+  template <typename STYPE, typename STYPE2>
+  void BIT_GRID<GRID_CLASS>::SetGE(const STYPE * scalar, const STYPE2 s)
+  {
+    for (NTYPE k = 0; k < num_words; k++)
+      { SetGEInWord(scalar, s, k); }
+  }
+
+  template <typename GRID_CLASS>
+  template <typename GRID_CLASS2>
+  void BIT_GRID<GRID_CLASS>::Or(const BIT_GRID<GRID_CLASS2> & grid2)
+  {
+    const BIT_GRID_WORD * word2 = grid2.WordPtrConst();
+    for (NTYPE k = 0; k < num_words; k++)
+      { word[k] |= word2[k]; }
+  }
+
+  template <typename GRID_CLASS>
+  template <typename GRID_CLASS2>
+  void BIT_GRID<GRID_CLASS>::And(const BIT_GRID<GRID_CLASS2> & grid2)
+  {
+    const BIT_GRID_WORD * word2 = grid2.WordPtrConst();
+    for (NTYPE k = 0; k < num_words; k++)
+      { word[k] &= word2[k]; }
+  }
+
+  template <typename GRID_CLASS>
+  template <typename GRID_CLASS2>
+  void BIT_GRID<GRID_CLASS>::AndNot(const BIT_GRID<GRID_CLASS2> & grid2)
+  {
+    const BIT_GRID_WORD * word2 = grid2.WordPtrConst();
+    for (NTYPE k = 0; k < num_words; k++)
+      { word[k] &= ~word2[k]; }
+  }
+
+  template <typename GRID_CLASS>
+  typename BIT_GRID<GRID_CLASS>::NTYPE
+  BIT_GRID<GRID_CLASS>::CountTrue() const
+  {
+    NTYPE num_true = 0;
+    for (NTYPE k = 0; k < num_words; k++)
+      { num_true += count_bits_in_word(word[k]); }
+    return(num_true);
+  }
+
+  template <typename GRID_CLASS>
+  typename BIT_GRID<GRID_CLASS>::VTYPE
+  BIT_GRID<GRID_CLASS>::FindNextTrue(const VTYPE iv) const
+  {
+    if (iv >= this->NumVertices()) { return(this->NumVertices()); }
+
+    NTYPE k = iv/BITS_PER_BIT_GRID_WORD;
+    BIT_GRID_WORD w =
+      word[k] & bit_range_mask(iv%BITS_PER_BIT_GRID_WORD,
+                               BITS_PER_BIT_GRID_WORD);
+
+    while (w == 0) {
+      k++;
+      if (k >= num_words) { return(this->NumVertices()); }
+      w = word[k];
+    }
+
+    return(VTYPE(k)*BITS_PER_BIT_GRID_WORD + lowest_bit_in_word(w));
+  }
+
+  // **************************************************
+  // BIT GRID CUBE FUNCTIONS
+  // **************************************************
+
+  /// Compute index it whose bit k is the value of the k'th vertex
+  ///   of cube icube.
+  /// If bit_grid was set by SetGE(scalar, isovalue),
+  ///   then it is the isosurface table index of cube icube.
+  /// @pre GTYPE has member function CubeVertexIncrement().
+  /// @pre bit_grid.Dimension() > 0.
+  template <typename GTYPE, typename ITYPE, typename TABLE_INDEX_TYPE>
+  inline void compute_cube_bit_index
+  (const BIT_GRID<GTYPE> & bit_grid, const ITYPE icube, TABLE_INDEX_TYPE & it)
+  {
+    typedef typename GTYPE::VERTEX_INDEX_TYPE VTYPE;
+    typedef typename GTYPE::NUMBER_TYPE NTYPE;
+
+    const NTYPE num_cube_vertices = bit_grid.NumCubeVertices();
+    const VTYPE * increment = bit_grid.CubeVertexIncrement();
+
+    // Cube vertices k and k+1 are consecutive along axis 0 for even k.
+    it = 0;
+    for (NTYPE k = 0; k < num_cube_vertices; k += 2) {
+      const BIT_GRID_WORD w = bit_grid.Word(icube+increment[k]) & 0x3;
+      it = (it | TABLE_INDEX_TYPE(w << k));
+    }
+  }
+
+  /// Return word whose bit k is true if cube icube+k has some vertex
+  ///   with value true and some vertex with value false.
+  /// Bits for cubes icube+k which are not in the same row
+  ///   (along axis 0) as icube are undefined and should be masked.
+  /// @pre GTYPE has member function CubeVertexIncrement().
+  template <typename GTYPE, typename ITYPE>
+  inline BIT_GRID_WORD compute_mixed_cube_word
+  (const BIT_GRID<GTYPE> & bit_grid, const ITYPE icube)
+  {
+    typedef typename GTYPE::VERTEX_INDEX_TYPE VTYPE;
+    typedef typename GTYPE::NUMBER_TYPE NTYPE;
+
+    const NTYPE num_cube_vertices = bit_grid.NumCubeVertices();
+    const VTYPE * increment = bit_grid.CubeVertexIncrement();
+    BIT_GRID_WORD some_true = 0;
+    BIT_GRID_WORD all_true = ~BIT_GRID_WORD(0);
+
+    for (NTYPE k = 0; k < num_cube_vertices; k++) {
+      const BIT_GRID_WORD w = bit_grid.Word(icube+increment[k]);
+      some_true |= w;
+      all_true &= w;
+    }
+
+    return(some_true & ~all_true);
+  }
+
+  // **************************************************
+  // COMPUTE BOUNDARY BIT GRID
+  // **************************************************
+
+  /// Set vertices on grid boundary to true and all other vertices to false.
+  /// Sets whole rows (along axis 0) at a time.
+  template <typename GTYPE>
+  void compute_boundary_grid(BIT_GRID<GTYPE> & boundary_grid)
+  {
+    typedef typename GTYPE::DIMENSION_TYPE DTYPE;
+    typedef typename GTYPE::AXIS_SIZE_TYPE ATYPE;
+    typedef typename GTYPE::VERTEX_INDEX_TYPE VTYPE;
+
+    const DTYPE dimension = boundary_grid.Dimension();
+    IJK::ARRAY<ATYPE> row_coord(dimension);
+
+    boundary_grid.SetAll(false);
+
+    if (dimension < 1 || boundary_grid.NumVertices() == 0) { return; }
+
+    const ATYPE axis_size0 = boundary_grid.AxisSize(0);
+
+    for (DTYPE d = 0; d < dimension; d++)
+      { row_coord[d] = 0; }
+
+    VTYPE iv0 = 0;
+    while (true) {
+      bool is_boundary_row = false;
+      for (DTYPE d = 1; d < dimension; d++) {
+        if (row_coord[d] == 0 || row_coord[d]+1 == boundary_grid.AxisSize(d))
+          { is_boundary_row = true; }
+      }
+
+      if (is_boundary_row)
+        { boundary_grid.SetRange(iv0, iv0+axis_size0, true); }
+      else {
+        boundary_grid.Set(iv0, true);
+        boundary_grid.Set(iv0+axis_size0-1, true);
+      }
+      iv0 += axis_size0;
+
+      DTYPE d = 1;
+      while (d < dimension) {
+        row_coord[d]++;
+        if (row_coord[d] < boundary_grid.AxisSize(d)) { break; }
+        row_coord[d] = 0;
+        d++;
+      }
+      if (d >= dimension) { break; }
+    }
+  }
+
+}
+
+#endif
@@ -124,6 +124,10 @@ namespace IJK {
     bool ReadFailed() const      ///< Return true if read failed.
     { return(read_failed); };
 
+    /// Return nrrd type of data read, e.g. nrrdTypeFloat.
+    int NrrdType() const
+    { return(this->data->type); };
+
     /// Read nrrd file.
     void Read(const char * input_filename, IJK::ERROR & error);
 
@@ -0,0 +1,463 @@
+/// \file ijkgrid_nrrd_mmap.txx
+/// ijk templates for memory mapping raw nrrd files into scalar/vector grids.
+/// Version 0.1.0
+
+/*
+  IJK: Isosurface Jeneration Kode
+  Copyright (C) 2015 Rephael Wenger
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License
+  (LGPL) as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#ifndef _IJKGRID_NRRD_MMAP_
+#define _IJKGRID_NRRD_MMAP_
+
+#include <cstdlib>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "ijkscalar_grid.txx"
+#include "ijkvector_grid.txx"
+
+namespace IJK {
+
+  // **************************************************
+  // NRRD TYPE NAMES
+  // **************************************************
+
+  /// Return true if nrrd type name matches C++ type float.
+  inline bool is_nrrd_type_name(const std::string & name, const float *)
+  { return(name == "float"); }
+
+  /// Return true if nrrd type name matches C++ type double.
+  inline bool is_nrrd_type_name(const std::string & name, const double *)
+  { return(name == "double"); }
+
+  /// Return true if nrrd type name matches C++ type unsigned char.
+  inline bool is_nrrd_type_name
+  (const std::string & name, const unsigned char *)
+  {
+    return(name == "uchar" || name == "unsigned char" ||
+           name == "uint8" || name == "uint8_t");
+  }
+
+  /// Return true if nrrd type name matches C++ type unsigned short.
+  inline bool is_nrrd_type_name
+  (const std::string & name, const unsigned short *)
+  {
+    return(name == "ushort" || name == "unsigned short" ||
+           name == "unsigned short int" || name == "uint16" ||
+           name == "uint16_t");
+  }
+
+  /// Return true if host is little endian.
+  inline bool is_host_little_endian()
+  {
+    const unsigned short x = 1;
+    return(*((const unsigned char *) &x) == 1);
+  }
+
+  // **************************************************
+  // CLASS NRRD_MMAP_FILE
+  // **************************************************
+
+  /// Raw nrrd file whose data is memory mapped, not read.
+  /// Data pages are mapped copy-on-write (MAP_PRIVATE),
+  ///   so writes to the data never modify the file.
+  /// Only uncompressed (raw) data in host byte order
+  ///   with a single attached or detached data file can be mapped.
+  class NRRD_MMAP_FILE {
+
+  protected:
+    void * mapped_address;
+    size_t mapped_length;
+    size_t data_offset;       ///< Offset of data from mapped_address.
+    int dimension;
+    std::vector<size_t> axis_size;
+    std::vector<double> spacing;
+
+    void Init();
+
+    /// Parse nrrd header.
+    /// @param[out] data_filename Name of file containing data.
+    /// @param[out] offset Offset of data in data_filename.
+    /// @param[out] message Reason why file cannot be mapped.
+    /// @return True if data can be mapped.
+    template <typename STYPE>
+    bool ParseHeader
+    (const char * filename, std::string & data_filename,
+     size_t & offset, std::string & message);
+
+  public:
+    NRRD_MMAP_FILE() { Init(); };
+    ~NRRD_MMAP_FILE() { Unmap(); };
+
+    // copy constructor and assignment: NOT IMPLEMENTED
+    NRRD_MMAP_FILE(const NRRD_MMAP_FILE &);
+    const NRRD_MMAP_FILE & operator = (const NRRD_MMAP_FILE &);
+
+    /// Map data of nrrd file filename.
+    /// @param[out] message Reason why file cannot be mapped.
+    /// @return False if file cannot be mapped.
+    ///   Caller should read the file with GRID_NRRD_IN instead.
+    template <typename STYPE>
+    bool Map(const char * filename, std::string & message);
+
+    /// Unmap data.
+    void Unmap();
+
+    // Get functions.
+    bool IsMapped() const { return(mapped_address != NULL); };
+    int Dimension() const { return(dimension); };
+    const size_t * AxisSize() const { return(&(axis_size[0])); };
+    size_t AxisSize(const int d) const { return(axis_size[d]); };
+    double Spacing(const int d) const { return(spacing[d]); };
+
+    /// Return pointer to mapped data.
+    template <typename STYPE>
+    STYPE * DataPtr() const
+    { return((STYPE *)(((char *) mapped_address) + data_offset)); };
+  };
+
+  // **************************************************
+  // TEMPLATE CLASS SCALAR_GRID_MMAP
+  // **************************************************
+
+  /// Scalar grid whose scalar values are memory mapped from a raw nrrd file.
+  /// Does not allocate or copy scalar values.
+  template <typename GRID_CLASS, typename STYPE>
+  class SCALAR_GRID_MMAP:public SCALAR_GRID_BASE<GRID_CLASS,STYPE> {
+
+  protected:
+    NRRD_MMAP_FILE nrrd_file;
+
+  public:
+    SCALAR_GRID_MMAP() {};
+    ~SCALAR_GRID_MMAP() { this->scalar = NULL; };
+
+    /// Map scalar values from nrrd file filename.
+    /// @param[out] message Reason why file cannot be mapped.
+    /// @return False if file cannot be mapped.
+    bool Map(const char * filename, std::string & message);
+
+    /// Return mapped nrrd file.
+    const NRRD_MMAP_FILE & NrrdFile() const
+    { return(nrrd_file); }
+  };
+
+  // **************************************************
+  // TEMPLATE CLASS VECTOR_GRID_MMAP
+  // **************************************************
+
+  /// Vector grid whose vectors are memory mapped from a raw nrrd file.
+  /// Nrrd axis 0 is the vector coordinate.
+  /// Does not allocate or copy vectors.
+  template <typename GRID_CLASS, typename LTYPE, typename VCTYPE>
+  class VECTOR_GRID_MMAP:public VECTOR_GRID_BASE<GRID_CLASS,LTYPE,VCTYPE> {
+
+  protected:
+    NRRD_MMAP_FILE nrrd_file;
+
+  public:
+    VECTOR_GRID_MMAP() {};
+    ~VECTOR_GRID_MMAP() { this->vec = NULL; };
+
+    /// Map vectors from nrrd file filename.
+    /// @param[out] message Reason why file cannot be mapped.
+    /// @return False if file cannot be mapped.
+    bool Map(const char * filename, std::string & message);
+
+    /// Return mapped nrrd file.
+    const NRRD_MMAP_FILE & NrrdFile() const
+    { return(nrrd_file); }
+  };
+
+  // **************************************************
+  // CLASS NRRD_MMAP_FILE MEMBER FUNCTIONS
+  // **************************************************
+
+  inline void NRRD_MMAP_FILE::Init()
+  {
+    mapped_address = NULL;
+    mapped_length = 0;
+    data_offset = 0;
+    dimension = 0;
+  }
+
+  inline void NRRD_MMAP_FILE::Unmap()
+  {
+#if !defined(_WIN32)
+    if (mapped_address != NULL)
+      { munmap(mapped_address, mapped_length); }
+#endif
+    Init();
+    axis_size.clear();
+    spacing.clear();
+  }
+
+  template <typename STYPE>
+  bool NRRD_MMAP_FILE::ParseHeader
+  (const char * filename, std::string & data_filename,
+   size_t & offset, std::string & message)
+  {
+    std::ifstream in(filename, std::ios::in | std::ios::binary);
+    std::string line;
+    std::string type_name, encoding, endian;
+    long byte_skip = 0;
+    long line_skip = 0;
+    bool is_end_of_header = false;
+
+    if (!in.good()) {
+      message = "Unable to open file.";
+      return(false);
+    }
+
+    std::getline(in, line);
+    if (line.compare(0, 4, "NRRD") != 0) {
+      message = "Missing NRRD magic.";
+      return(false);
+    }
+
+    data_filename = "";
+    while (std::getline(in, line)) {
+
+      if (line.size() > 0 && line[line.size()-1] == '\r')
+        { line.erase(line.size()-1); }
+
+      if (line.size() == 0) {                // End of header.
+        is_end_of_header = true;
+        break;
+      }
+      if (line[0] == '#') { continue; }      // Comment.
+
+      const size_t k = line.find(": ");
+      if (k == std::string::npos) { continue; }  // Key/value pair.
+
+      const std::string field = line.substr(0, k);
+      std::istringstream value(line.substr(k+2));
+
+      if (field == "type")
+        { type_name = line.substr(k+2); }
+      else if (field == "dimension")
+        { value >> dimension; }
+      else if (field == "sizes") {
+        axis_size.resize(dimension);
+        for (int d = 0; d < dimension; d++) { value >> axis_size[d]; }
+      }
+      else if (field == "spacings") {
+        spacing.resize(dimension);
+        for (int d = 0; d < dimension; d++) {
+          std::string s;
+          value >> s;
+          spacing[d] = std::strtod(s.c_str(), NULL);
+        }
+      }
+      else if (field == "encoding")
+        { value >> encoding; }
+      else if (field == "endian")
+        { value >> endian; }
+      else if (field == "byte skip" || field == "byteskip")
+        { value >> byte_skip; }
+      else if (field == "line skip" || field == "lineskip")
+        { value >> line_skip; }
+      else if (field == "data file" || field == "datafile")
+        { data_filename = line.substr(k+2); }
+      else if (field == "space directions") {
+        message = "Space directions are not supported.";
+        return(false);
+      }
+    }
+
+    // A detached header may end at end of file without a blank line.
+    // Attached data must follow a blank line.
+    if (data_filename == "" && (!is_end_of_header || !in.good())) {
+      message = "Missing data.";
+      return(false);
+    }
+
+    if (!is_nrrd_type_name(type_name, (const STYPE *) NULL)) {
+      message = "Nrrd type " + type_name + " does not match grid type.";
+      return(false);
+    }
+
+    if (encoding != "raw") {
+      message = "Nrrd encoding " + encoding + " is not raw.";
+      return(false);
+    }
+
+    if (sizeof(STYPE) > 1) {
+      const std::string host_endian =
+        is_host_little_endian() ? "little" : "big";
+      if (endian != host_endian) {
+        message = "Nrrd endian does not match host.";
+        return(false);
+      }
+    }
+
+    if (dimension < 1 || int(axis_size.size()) != dimension) {
+      message = "Illegal nrrd dimension or sizes.";
+      return(false);
+    }
+
+    if (byte_skip < 0 || line_skip != 0) {
+      message = "Nrrd byte skip or line skip is not supported.";
+      return(false);
+    }
+
+    // As in NrrdIO, missing spacings are nan.
+    if (spacing.size() != size_t(dimension))
+      { spacing.assign(dimension, std::numeric_limits<double>::quiet_NaN()); }
+
+    if (data_filename == "") {
+      // Attached data.
+      data_filename = filename;
+      offset = size_t(in.tellg()) + byte_skip;
+    }
+    else {
+      if (data_filename == "LIST" ||
+          data_filename.find(' ') != std::string::npos) {
+        message = "Multiple nrrd data files are not supported.";
+        return(false);
+      }
+
+      // Detached data file is relative to header file directory.
+      if (data_filename[0] != '/') {
+        const std::string header_filename(filename);
+        const size_t j = header_filename.rfind('/');
+        if (j != std::string::npos)
+          { data_filename = header_filename.substr(0, j+1) + data_filename; }
+      }
+      offset = byte_skip;
+    }
+
+    if (offset % sizeof(STYPE) != 0) {
+      message = "Nrrd data is not aligned.";
+      return(false);
+    }
+
+    return(true);
+  }
+
+  template <typename STYPE>
+  bool NRRD_MMAP_FILE::Map(const char * filename, std::string & message)
+  {
+    Unmap();
+
+#if defined(_WIN32)
+    message = "Memory mapping is not supported.";
+    return(false);
+#else
+    std::string data_filename;
+    size_t offset;
+
+    if (!ParseHeader<STYPE>(filename, data_filename, offset, message)) {
+      Unmap();
+      return(false);
+    }
+
+    size_t num_values = 1;
+    for (int d = 0; d < dimension; d++)
+      { num_values *= axis_size[d]; }
+    const size_t length = offset + num_values*sizeof(STYPE);
+
+    const int fd = open(data_filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+      message = "Unable to open " + data_filename + ".";
+      Unmap();
+      return(false);
+    }
+
+    struct stat file_stat;
+    if (fstat(fd, &file_stat) != 0 || size_t(file_stat.st_size) < length) {
+      close(fd);
+      message = "Nrrd data file is too short.";
+      Unmap();
+      return(false);
+    }
+
+    void * address =
+      mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (address == MAP_FAILED) {
+      message = "Memory mapping failed.";
+      Unmap();
+      return(false);
+    }
+
+    mapped_address = address;
+    mapped_length = length;
+    data_offset = offset;
+
+    return(true);
+#endif
+  }
+
+  // **************************************************
+  // TEMPLATE CLASS SCALAR_GRID_MMAP MEMBER FUNCTIONS
+  // **************************************************
+
+  template <typename GRID_CLASS, typename STYPE>
+  bool SCALAR_GRID_MMAP<GRID_CLASS,STYPE>::
+  Map(const char * filename, std::string & message)
+  {
+    this->scalar = NULL;
+
+    if (!nrrd_file.Map<STYPE>(filename, message)) { return(false); }
+
+    this->SetSize(nrrd_file.Dimension(), nrrd_file.AxisSize());
+    this->scalar = nrrd_file.DataPtr<STYPE>();
+
+    return(true);
+  }
+
+  // **************************************************
+  // TEMPLATE CLASS VECTOR_GRID_MMAP MEMBER FUNCTIONS
+  // **************************************************
+
+  template <typename GRID_CLASS, typename LTYPE, typename VCTYPE>
+  bool VECTOR_GRID_MMAP<GRID_CLASS,LTYPE,VCTYPE>::
+  Map(const char * filename, std::string & message)
+  {
+    this->vec = NULL;
+
+    if (!nrrd_file.Map<VCTYPE>(filename, message)) { return(false); }
+
+    if (nrrd_file.Dimension() < 2) {
+      message = "Illegal dimension for vector nrrd file.";
+      nrrd_file.Unmap();
+      return(false);
+    }
+
+    this->SetSize(nrrd_file.Dimension()-1, nrrd_file.AxisSize()+1,
+                  nrrd_file.AxisSize(0));
+    this->vec = nrrd_file.DataPtr<VCTYPE>();
+
+    return(true);
+  }
+
+}
+
+#endif
@@ -290,6 +290,235 @@ namespace IJK {
                     list1_nodup, &(list0_map.front()),int_list);
   }
 
+  // **************************************************
+  // TEMPLATE merge_identical_by_sorting
+  // **************************************************
+
+  /// Apply f(j) to each j in [0,num_blocks), in order, in the calling thread.
+  /// Sequential apply_to_blocks argument of merge_identical_by_sorting.
+  class APPLY_TO_BLOCKS_IN_ORDER {
+  public:
+    template <typename NTYPE, typename FTYPE>
+    void operator () (const NTYPE num_blocks, FTYPE f) const
+    { for (NTYPE j = 0; j < num_blocks; j++) { f(j); } };
+  };
+
+  /// Merge identical values in an integer list by sorting.
+  /// Sorts (value, location) pairs with a least significant digit
+  ///   radix sort and compacts runs of identical values.
+  /// Uses memory proportional to list0_length, not to the largest value,
+  ///   so it suits short lists of large integers.
+  /// Output is identical to merge_identical using an INTEGER_LIST:
+  ///   list1_nodup is in order of first occurrence in list0.
+  /// Splits list0 into at most num_blocks contiguous blocks.
+  ///   Radix histograms, scatters and compaction are computed 
+  ///   on each block by calling apply_to_blocks(num_blocks, f), 
+  ///   which must call f(j) for each block j, possibly concurrently.
+  /// Output does not depend on num_blocks.
+  /// @param list0 List of non-negative integers.
+  /// @param list0_length Length of list0.
+  /// @param[out] list1_nodup List without any duplicate values.
+  /// @param[out] list0_map Mapping from list0 to locations in list1_nodup.
+  /// @pre Array list0_map is preallocated to length at least list0_length.
+  /// @param num_blocks Maximum number of blocks.
+  ///   Each block has at least MIN_BLOCK_LENGTH entries.
+  template <typename ITYPE, typename NTYPE, typename MTYPE,
+            typename APPLY_TYPE>
+  void merge_identical_by_sorting
+  (const ITYPE * list0, const NTYPE list0_length,
+   std::vector<ITYPE> & list1_nodup, MTYPE * list0_map,
+   const int num_blocks, APPLY_TYPE apply_to_blocks)
+  {
+    const int RADIX_BITS = 11;
+    const NTYPE RADIX = (NTYPE(1) << RADIX_BITS);
+    // Minimum block length.  Each block has its own histogram.
+    const NTYPE MIN_BLOCK_LENGTH = 8*RADIX;
+
+    list1_nodup.clear();
+    if (list0_length <= 0) { return; }
+
+    NTYPE numb = list0_length/MIN_BLOCK_LENGTH;
+    if (numb > NTYPE(num_blocks)) { numb = num_blocks; }
+    if (numb < 1) { numb = 1; }
+
+    // Block j is [block_start[j],block_start[j+1]).
+    std::vector<NTYPE> block_start(numb+1);
+    for (NTYPE j = 0; j <= numb; j++) {
+      const NTYPE r = list0_length%numb;
+      block_start[j] = (list0_length/numb)*j + (j < r ? j : r);
+    }
+
+    std::vector<ITYPE> key(list0_length);
+    std::vector<ITYPE> key2(list0_length);
+    std::vector<NTYPE> loc(list0_length);
+    std::vector<NTYPE> loc2(list0_length);
+    std::vector<ITYPE> block_max(numb);
+
+    apply_to_blocks(numb, [&](const NTYPE j) {
+        ITYPE max_int = list0[block_start[j]];
+        for (NTYPE i = block_start[j]; i < block_start[j+1]; i++) {
+          key[i] = list0[i];
+          loc[i] = i;
+          if (max_int < list0[i]) { max_int = list0[i]; }
+        }
+        block_max[j] = max_int;
+      });
+
+    ITYPE max_int = block_max[0];
+    for (NTYPE j = 1; j < numb; j++)
+      { if (max_int < block_max[j]) { max_int = block_max[j]; } }
+
+    int num_bits = 0;
+    while ((max_int >> num_bits) > 0 &&
+           num_bits < int(8*sizeof(ITYPE)))
+      { num_bits++; }
+
+    // first[j*RADIX+d] = location in sorted list of next entry 
+    //   from block j with digit d.
+    std::vector<NTYPE> first(numb*RADIX);
+
+    // Stable counting sort on each digit.
+    for (int shift = 0; shift < num_bits; shift += RADIX_BITS) {
+
+      apply_to_blocks(numb, [&](const NTYPE j) {
+          NTYPE * block_first = &(first[j*RADIX]);
+          std::fill(block_first, block_first+RADIX, 0);
+          for (NTYPE i = block_start[j]; i < block_start[j+1]; i++)
+            { block_first[(key[i] >> shift) & (RADIX-1)]++; }
+        });
+
+      // Entries with digit d precede entries with digit d+1.
+      // Entries from block j precede entries from block j+1.
+      NTYPE num = 0;
+      for (NTYPE d = 0; d < RADIX; d++) {
+        for (NTYPE j = 0; j < numb; j++) {
+          const NTYPE count = first[j*RADIX+d];
+          first[j*RADIX+d] = num;
+          num += count;
+        }
+      }
+
+      apply_to_blocks(numb, [&](const NTYPE j) {
+          NTYPE * block_first = &(first[j*RADIX]);
+          for (NTYPE i = block_start[j]; i < block_start[j+1]; i++) {
+            const NTYPE k = block_first[(key[i] >> shift) & (RADIX-1)]++;
+            key2[k] = key[i];
+            loc2[k] = loc[i];
+          }
+        });
+
+      key.swap(key2);
+      loc.swap(loc2);
+    }
+
+    // Sort is stable, so each run of identical values starts with
+    //   the first occurrence of the value in list0.
+    // Set loc2[i] to the location of the first occurrence of list0[i].
+    // Block j processes the runs which start in block j.
+    apply_to_blocks(numb, [&](const NTYPE j) {
+        NTYPE i0 = block_start[j];
+        while (i0 > 0 && i0 < block_start[j+1] && key[i0] == key[i0-1])
+          { i0++; }
+        while (i0 < block_start[j+1]) {
+          NTYPE i1 = i0+1;
+          while (i1 < list0_length && key[i1] == key[i0]) { i1++; }
+          for (NTYPE i = i0; i < i1; i++) { loc2[loc[i]] = loc[i0]; }
+          i0 = i1;
+        }
+      });
+
+    // Number first occurrences in order.
+    // num_first[j] = number of first occurrences before block j.
+    std::vector<NTYPE> num_first(numb);
+    apply_to_blocks(numb, [&](const NTYPE j) {
+        NTYPE num = 0;
+        for (NTYPE i = block_start[j]; i < block_start[j+1]; i++)
+          { if (loc2[i] == i) { num++; } }
+        num_first[j] = num;
+      });
+
+    NTYPE num_distinct = 0;
+    for (NTYPE j = 0; j < numb; j++) {
+      const NTYPE num = num_first[j];
+      num_first[j] = num_distinct;
+      num_distinct += num;
+    }
+
+    list1_nodup.resize(num_distinct);
+    apply_to_blocks(numb, [&](const NTYPE j) {
+        NTYPE k = num_first[j];
+        for (NTYPE i = block_start[j]; i < block_start[j+1]; i++) {
+          if (loc2[i] == i) {
+            list0_map[i] = k;
+            list1_nodup[k] = list0[i];
+            k++;
+          }
+        }
+      });
+
+    // Map other occurrences after all first occurrences are mapped.
+    apply_to_blocks(numb, [&](const NTYPE j) {
+        for (NTYPE i = block_start[j]; i < block_start[j+1]; i++) {
+          if (loc2[i] != i) { list0_map[i] = list0_map[loc2[i]]; }
+        }
+      });
+  }
+
+  /// Merge identical values in an integer list by sorting.
+  /// Version using a single block in the calling thread.
+  /// @param list0 List of non-negative integers.
+  /// @param list0_length Length of list0.
+  /// @param[out] list1_nodup List without any duplicate values.
+  /// @param[out] list0_map Mapping from list0 to locations in list1_nodup.
+  /// @pre Array list0_map is preallocated to length at least list0_length.
+  template <typename ITYPE, typename NTYPE, typename MTYPE>
+  void merge_identical_by_sorting
+  (const ITYPE * list0, const NTYPE list0_length,
+   std::vector<ITYPE> & list1_nodup, MTYPE * list0_map)
+  {
+    merge_identical_by_sorting
+      (list0, list0_length, list1_nodup, list0_map, 1,
+       APPLY_TO_BLOCKS_IN_ORDER());
+  }
+
+  /// Merge identical values in an integer list by sorting.
+  /// Version using std::vector and num_blocks blocks.
+  /// @param list0 List of non-negative integers.
+  /// @param[out] list1_nodup List without any duplicate values.
+  /// @param[out] list0_map Mapping from list0 to locations in list1_nodup.
+  /// @param num_blocks Maximum number of blocks.
+  /// @param apply_to_blocks Apply function to blocks.
+  ///   See merge_identical_by_sorting.
+  template <typename ITYPE, typename MTYPE, typename APPLY_TYPE>
+  void merge_identical_by_sorting
+  (const std::vector<ITYPE> & list0, std::vector<ITYPE> & list1_nodup,
+   std::vector<MTYPE> & list0_map, 
+   const int num_blocks, APPLY_TYPE apply_to_blocks)
+  {
+    list0_map.resize(list0.size());
+    list1_nodup.clear();
+
+    if (list0.size() == 0) { return; };
+
+    merge_identical_by_sorting
+      (vector2pointer(list0), list0.size(), list1_nodup, &(list0_map.front()),
+       num_blocks, apply_to_blocks);
+  }
+
+  /// Merge identical values in an integer list by sorting.
+  /// Version using std::vector.
+  /// @param list0 List of non-negative integers.
+  /// @param[out] list1_nodup List without any duplicate values.
+  /// @param[out] list0_map Mapping from list0 to locations in list1_nodup.
+  template <typename ITYPE, typename MTYPE>
+  void merge_identical_by_sorting
+  (const std::vector<ITYPE> & list0, std::vector<ITYPE> & list1_nodup,
+   std::vector<MTYPE> & list0_map)
+  {
+    merge_identical_by_sorting
+      (list0, list1_nodup, list0_map, 1, APPLY_TO_BLOCKS_IN_ORDER());
+  }
+
   // **************************************************
   // TEMPLATE ARRAY_LESS_THAN
   // **************************************************
@@ -1621,12 +1621,12 @@ namespace IJK {
         (this->dimension, this->axis_size, elength.PtrConst(), vlist.Ptr());
 
       ATYPE num_subsample_vertices_along_axis =
-        compute_subsample_size(AxisSize(d), region_edge_length);
+        compute_subsample_size(this->AxisSize(d), region_edge_length);
 
       for (ATYPE j = 0; j < num_subsample_vertices_along_axis; j++) {
         ATYPE num_edges = region_edge_length;
-        if ((j+1)*region_edge_length +1 > AxisSize(d)) {
-          num_edges = AxisSize(d) - j*region_edge_length - 1;
+        if ((j+1)*region_edge_length +1 > this->AxisSize(d)) {
+          num_edges = this->AxisSize(d) - j*region_edge_length - 1;
         }
 
         VTYPE facet_increment = (j*region_edge_length)*axis_increment[d];
@@ -1863,7 +1863,7 @@ namespace IJK {
         compute_num_regions_along_axis(axis_size[d], region_edge_length);
     }
 
-    SetSize(dimension, num_regions_along_axis.PtrConst());
+    this->SetSize(dimension, num_regions_along_axis.PtrConst());
 
     compute_region_minmax
       (dimension, axis_size, scalar, region_edge_length,
@@ -1886,7 +1886,7 @@ namespace IJK {
         compute_num_regions_along_axis(axis_size[d], region_edge_length);
     }
 
-    SetSize(dimension, num_regions_along_axis.PtrConst());
+    this->SetSize(dimension, num_regions_along_axis.PtrConst());
 
     compute_region_minmax
       (dimension, axis_size, scalar, region_edge_length, offset_edge_length,
@@ -28,6 +28,7 @@
 
 #include "sharpiso_types.h"
 
+#include "ijkbit_grid.txx"
 #include "ijkgrid.txx"
 #include "ijkobject_grid.txx"
 #include "ijkscalar_grid.txx"
@@ -57,17 +58,17 @@ namespace SHARPISO {
   typedef IJK::GRID_SPACING<COORD_TYPE, GRID_NEIGHBORS>
     SHARPISO_GRID_NEIGHBORS;        ///< Grid with neighbor and spacing info.
 
-  typedef IJK::SCALAR_GRID_BASE<SHARPISO_GRID, SCALAR_TYPE>
+  typedef IJK::SCALAR_GRID_BASE<SHARPISO_GRID, SCALAR_STORAGE_TYPE>
     SHARPISO_SCALAR_GRID_BASE;              ///< sharpiso base scalar grid.
-  typedef IJK::SCALAR_GRID_WRAPPER<SHARPISO_GRID, SCALAR_TYPE>
+  typedef IJK::SCALAR_GRID_WRAPPER<SHARPISO_GRID, SCALAR_STORAGE_TYPE>
     SHARPISO_SCALAR_GRID_WRAPPER;   ///< sharpiso scalar grid wrapper.
-  typedef IJK::SCALAR_GRID<SHARPISO_GRID, SCALAR_TYPE>
+  typedef IJK::SCALAR_GRID<SHARPISO_GRID, SCALAR_STORAGE_TYPE>
     SHARPISO_SCALAR_GRID;           ///< sharpiso scalar grid.
   typedef IJK::VECTOR_GRID_BASE
-    <SHARPISO_GRID, GRADIENT_LENGTH_TYPE, GRADIENT_COORD_TYPE>
+    <SHARPISO_GRID, GRADIENT_LENGTH_TYPE, GRADIENT_STORAGE_TYPE>
     GRADIENT_GRID_BASE;             ///<  sharpiso base gradient grid
   typedef IJK::VECTOR_GRID
-    <SHARPISO_GRID, GRADIENT_LENGTH_TYPE, GRADIENT_COORD_TYPE>
+    <SHARPISO_GRID, GRADIENT_LENGTH_TYPE, GRADIENT_STORAGE_TYPE>
     GRADIENT_GRID;                  ///< sharpiso gradient grid
 
   /// Index grid.  Signed to allow for -1.
@@ -82,6 +83,61 @@ namespace SHARPISO {
     SHARPISO_BOOL_GRID_BASE;        ///< Boolean grid base.
   typedef IJK::BOOL_GRID<SHARPISO_GRID> 
     SHARPISO_BOOL_GRID;             ///< Boolean grid.
+  typedef IJK::BIT_GRID<SHARPISO_GRID> 
+    SHARPISO_BIT_GRID;              ///< Boolean grid with one bit per vertex.
+
+
+  // **************************************************
+  // GRADIENT ACCESS
+  // **************************************************
+
+  /// Return pointer to gradient at vertex iv.
+  /// Gradient is stored as GRADIENT_COORD_TYPE, so no conversion is needed.
+  inline const GRADIENT_COORD_TYPE * get_vertex_gradient
+  (const IJK::VECTOR_GRID_BASE
+   <SHARPISO_GRID, GRADIENT_LENGTH_TYPE, GRADIENT_COORD_TYPE> & gradient_grid,
+   const VERTEX_INDEX iv, GRADIENT_COORD_TYPE /* gradient_buffer */[DIM3])
+  {
+    return(gradient_grid.VectorPtrConst(iv));
+  }
+
+  /// Return pointer to gradient at vertex iv.
+  /// Convert gradient to GRADIENT_COORD_TYPE and store in gradient_buffer[].
+  template <typename VCTYPE>
+  inline const GRADIENT_COORD_TYPE * get_vertex_gradient
+  (const IJK::VECTOR_GRID_BASE
+   <SHARPISO_GRID, GRADIENT_LENGTH_TYPE, VCTYPE> & gradient_grid,
+   const VERTEX_INDEX iv, GRADIENT_COORD_TYPE gradient_buffer[DIM3])
+  {
+    const VCTYPE * gradient = gradient_grid.VectorPtrConst(iv);
+    for (int d = 0; d < DIM3; d++)
+      { gradient_buffer[d] = GRADIENT_COORD_TYPE(gradient[d]); }
+    return(gradient_buffer);
+  }
+
+  /// Return magnitude squared of gradient at vertex iv.
+  /// Computed in GRADIENT_COORD_TYPE, not in the gradient storage type.
+  inline GRADIENT_COORD_TYPE compute_gradient_magnitude_squared
+  (const GRADIENT_GRID_BASE & gradient_grid, const VERTEX_INDEX iv)
+  {
+    GRADIENT_COORD_TYPE gradient_buffer[DIM3];
+    const GRADIENT_COORD_TYPE * gradient =
+      get_vertex_gradient(gradient_grid, iv, gradient_buffer);
+
+    GRADIENT_COORD_TYPE magnitude_squared = 0;
+    for (int d = 0; d < DIM3; d++)
+      { magnitude_squared += gradient[d]*gradient[d]; }
+
+    return(magnitude_squared);
+  }
+
+  /// Return true if magnitude of gradient at vertex iv is greater than mag.
+  inline bool is_gradient_magnitude_gt
+  (const GRADIENT_GRID_BASE & gradient_grid, const VERTEX_INDEX iv,
+   const GRADIENT_COORD_TYPE mag)
+  {
+    return(compute_gradient_magnitude_squared(gradient_grid, iv) > mag*mag);
+  }
 
 
   // **************************************************
@@ -131,6 +187,391 @@ namespace SHARPISO {
     { return (this->object[iv].list.size()); }
   };
 
+  // **************************************************
+  // INDEX HASH TABLE
+  // **************************************************
+
+  /// Hash table mapping non-negative keys to indices.
+  /// Keys are grouped in blocks of BLOCK_SIZE consecutive keys.
+  /// Only blocks containing a key are stored, using open addressing 
+  ///   with linear probing on the block number.
+  /// Lookups of nearby keys (such as grid neighbors along the x-axis)
+  ///   read the same block.
+  /// Memory is proportional to the number of stored blocks.
+  template <typename KTYPE>
+  class INDEX_HASH_TABLE {
+
+  public:
+    static const int NUM_BLOCK_BITS = 3;
+    static const int BLOCK_SIZE = (1 << NUM_BLOCK_BITS);
+
+  protected:
+
+    /// Block of BLOCK_SIZE indices.  Index -1 represents no key.
+    class BLOCK {
+    public:
+      KTYPE block_key;
+      INDEX_DIFF_TYPE index[BLOCK_SIZE];
+    };
+
+    /// Table size is a power of two, at least twice num_blocks.
+    std::vector<BLOCK> table;
+    NUM_TYPE num_blocks;
+    NUM_TYPE num_keys;
+
+    static KTYPE EmptyKey() { return(KTYPE(-1)); }
+
+    static KTYPE BlockKey(const KTYPE k)
+    { return(k >> NUM_BLOCK_BITS); }
+
+    static int BlockOffset(const KTYPE k)
+    { return(int(k & (BLOCK_SIZE-1))); }
+
+    /// Return first table location for block key bk.
+    NUM_TYPE Hash(const KTYPE bk) const
+    {
+      const unsigned long long h = 
+        (unsigned long long)(bk)*0x9E3779B97F4A7C15ULL;
+      return(NUM_TYPE((h >> 32) & (table.size()-1)));
+    }
+
+    /// Return location of block bk or of empty slot where bk belongs.
+    NUM_TYPE Locate(const KTYPE bk) const
+    {
+      NUM_TYPE i = Hash(bk);
+      while (table[i].block_key != EmptyKey() && table[i].block_key != bk)
+        { i = ((i+1) & (table.size()-1)); }
+      return(i);
+    }
+
+    /// Resize table to table_size and reinsert all blocks.
+    void Rehash(const NUM_TYPE table_size)
+    {
+      std::vector<BLOCK> old_table;
+      BLOCK empty_block;
+
+      empty_block.block_key = EmptyKey();
+      std::fill(empty_block.index, empty_block.index+BLOCK_SIZE, -1);
+
+      table.swap(old_table);
+      table.assign(table_size, empty_block);
+      for (std::size_t j = 0; j < old_table.size(); j++) {
+        if (old_table[j].block_key != EmptyKey()) 
+          { table[Locate(old_table[j].block_key)] = old_table[j]; }
+      }
+    }
+
+  public:
+    INDEX_HASH_TABLE() { Clear(); };
+
+    /// Remove all keys.
+    void Clear()
+    {
+      table.clear();
+      Rehash(2);
+      num_blocks = 0;
+      num_keys = 0;
+    }
+
+    /// Allocate table for num keys with distinct block keys.
+    void Reserve(const NUM_TYPE num)
+    {
+      NUM_TYPE table_size = table.size();
+      while (table_size < 2*num) { table_size = 2*table_size; }
+      if (table_size > NUM_TYPE(table.size())) { Rehash(table_size); }
+    }
+
+    /// Set index of key k.  Overwrite any previous index.
+    /// @pre k >= 0.
+    void Insert(const KTYPE k, const INDEX_DIFF_TYPE index)
+    {
+      const KTYPE bk = BlockKey(k);
+      NUM_TYPE i = Locate(bk);
+
+      if (table[i].block_key == EmptyKey()) {
+        if (2*(num_blocks+1) > NUM_TYPE(table.size())) {
+          Rehash(2*table.size());
+          i = Locate(bk);
+        }
+        table[i].block_key = bk;
+        num_blocks++;
+      }
+
+      INDEX_DIFF_TYPE & block_index = table[i].index[BlockOffset(k)];
+      if (block_index < 0 && index >= 0) { num_keys++; }
+      else if (block_index >= 0 && index < 0) { num_keys--; }
+      block_index = index;
+    }
+
+    /// Return index of key k or -1 if k is not stored.
+    INDEX_DIFF_TYPE Find(const KTYPE k) const
+    { return(table[Locate(BlockKey(k))].index[BlockOffset(k)]); }
+
+    /// Return number of stored keys.
+    NUM_TYPE NumKeys() const
+    { return(num_keys); }
+
+    /// Return number of bytes allocated for the table.
+    long long NumBytes() const
+    { return((long long)(table.capacity())*sizeof(BLOCK)); }
+  };
+
+
+  // **************************************************
+  // EDGE INDEX HASH TABLE
+  // **************************************************
+
+  /// Sparse edge index.
+  /// Map grid edge (iv0, edge_dir) to an index using INDEX_HASH_TABLE.
+  /// Memory is proportional to the number of stored edges,
+  ///   not to the number of grid vertices.
+  /// Set() and Vector() match SHARPISO_EDGE_INDEX_GRID.
+  class SHARPISO_EDGE_INDEX_HASH:public SHARPISO_GRID {
+
+  public:
+    typedef long long EDGE_KEY_TYPE;
+
+  protected:
+    typedef SHARPISO_GRID::DIMENSION_TYPE DTYPE;
+    typedef SHARPISO_GRID::AXIS_SIZE_TYPE ATYPE;
+
+    INDEX_HASH_TABLE<EDGE_KEY_TYPE> edge_table;
+
+    EDGE_KEY_TYPE EdgeKey(const VERTEX_INDEX iv0, const int edge_dir) const
+    { return(EDGE_KEY_TYPE(iv0)*this->Dimension()+edge_dir); }
+
+  public:
+    SHARPISO_EDGE_INDEX_HASH() {};
+    SHARPISO_EDGE_INDEX_HASH(const DTYPE dimension, const ATYPE * axis_size):
+      SHARPISO_GRID(dimension, axis_size) {};
+
+    /// Remove all edges.
+    void Clear()
+    { edge_table.Clear(); }
+
+    /// Allocate table for num edges.
+    void Reserve(const NUM_TYPE num)
+    { edge_table.Reserve(num); }
+
+    /// Set index of edge (iv0, edge_dir).
+    void Set(const VERTEX_INDEX iv0, const int edge_dir, 
+             const INDEX_DIFF_TYPE index)
+    { edge_table.Insert(EdgeKey(iv0, edge_dir), index); }
+
+    /// Return index of edge (iv0, edge_dir) or -1 if edge is not stored.
+    INDEX_DIFF_TYPE Vector(const VERTEX_INDEX iv0, const int edge_dir) const
+    { return(edge_table.Find(EdgeKey(iv0, edge_dir))); }
+
+    /// Return number of stored edges.
+    NUM_TYPE NumEdges() const
+    { return(edge_table.NumKeys()); }
+  };
+
+  // **************************************************
+  // ACTIVE BRICKS
+  // **************************************************
+
+  /// Grid of flags indicating which bricks may intersect the isosurface.
+  /// Brick with coordinates (b0,b1,b2) contains grid cubes
+  ///   with coordinates (c0,c1,c2) where bd = cd/BrickEdgeLength().
+  /// If not set, every brick is considered active.
+  class SHARPISO_ACTIVE_BRICKS:public SHARPISO_BOOL_GRID {
+
+  protected:
+    AXIS_SIZE_TYPE brick_edge_length;
+
+  public:
+    SHARPISO_ACTIVE_BRICKS() { brick_edge_length = 0; };
+
+    /// Set brick edge length.  Set size of grid of bricks.
+    void SetBricks
+    (const SHARPISO_GRID & brick_grid, const AXIS_SIZE_TYPE brick_edge_length)
+    {
+      this->brick_edge_length = brick_edge_length;
+      SetSize(brick_grid);
+    }
+
+    /// Return true if active bricks are set.
+    bool IsSet() const
+    { return(brick_edge_length > 0); }
+
+    /// Return number of grid edges along each brick edge.
+    AXIS_SIZE_TYPE BrickEdgeLength() const
+    { return(brick_edge_length); }
+
+    /// Return true if brick containing grid cube with coordinates 
+    ///   cube_coord[] is active.
+    /// @pre IsSet().
+    template <typename GTYPE>
+    bool IsCubeInActiveBrick(const GTYPE cube_coord[DIM3]) const
+    {
+      AXIS_SIZE_TYPE brick_coord[DIM3];
+      for (int d = 0; d < DIM3; d++)
+        { brick_coord[d] = cube_coord[d]/brick_edge_length; }
+      return(Scalar(ComputeVertexIndex(brick_coord)));
+    }
+  };
+
+
+  // **************************************************
+  // MINMAX BRICKS
+  // **************************************************
+
+  /// Min and max scalar values of grid bricks and superbricks.
+  /// A brick is a region of brick_edge_length^3 grid cubes.
+  /// A superbrick is a region of superbrick_factor^3 bricks.
+  /// Regions include the grid vertices on their boundaries, 
+  ///   so every grid cube and every grid edge lies in some brick.
+  /// Computed once per scalar grid and reused for each isovalue.
+  class SHARPISO_MINMAX_BRICKS {
+
+  public:
+    typedef IJK::MINMAX_REGIONS<SHARPISO_GRID, SCALAR_STORAGE_TYPE> 
+    MINMAX_REGIONS_TYPE;
+
+    static const AXIS_SIZE_TYPE DEFAULT_BRICK_EDGE_LENGTH = 8;
+    static const AXIS_SIZE_TYPE DEFAULT_SUPERBRICK_FACTOR = 8;
+
+  protected:
+
+    /// Min and max of each brick.  Grid of bricks.
+    MINMAX_REGIONS_TYPE brick;
+
+    /// Grid of superbricks.
+    SHARPISO_GRID superbrick_grid;
+    std::vector<SCALAR_TYPE> superbrick_min;
+    std::vector<SCALAR_TYPE> superbrick_max;
+
+    AXIS_SIZE_TYPE superbrick_factor;
+    bool is_set;
+
+    /// Return true if isovalue is in range (min,max].
+    static bool ContainsIsovalue
+    (const SCALAR_TYPE smin, const SCALAR_TYPE smax,
+     const SCALAR_TYPE isovalue)
+    { return(smin < isovalue && smax >= isovalue); }
+
+  public:
+    SHARPISO_MINMAX_BRICKS() { Clear(); };
+
+    /// Remove all bricks.
+    void Clear()
+    {
+      superbrick_min.clear();
+      superbrick_max.clear();
+      superbrick_factor = 0;
+      is_set = false;
+    }
+
+    /// Compute min and max of each brick and superbrick.
+    void Set(const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
+             const AXIS_SIZE_TYPE brick_edge_length,
+             const AXIS_SIZE_TYPE superbrick_factor)
+    {
+      const int dimension = scalar_grid.Dimension();
+      IJK::PROCEDURE_ERROR error("SHARPISO_MINMAX_BRICKS::Set");
+
+      Clear();
+
+      if (superbrick_factor < 1) {
+        error.AddMessage("Programming error.  Illegal superbrick factor ",
+                         superbrick_factor, ".");
+        throw error;
+      }
+
+      if (dimension != DIM3 || scalar_grid.ComputeNumCubes() < 1) 
+        { return; }
+
+      brick.ComputeMinMax(scalar_grid, brick_edge_length);
+      this->superbrick_factor = superbrick_factor;
+
+      AXIS_SIZE_TYPE num_superbricks[DIM3];
+      for (int d = 0; d < DIM3; d++) {
+        num_superbricks[d] = 
+          (brick.AxisSize(d) + superbrick_factor - 1)/superbrick_factor;
+      }
+      superbrick_grid.SetSize(DIM3, num_superbricks);
+      superbrick_min.resize(superbrick_grid.NumVertices());
+      superbrick_max.resize(superbrick_grid.NumVertices());
+
+      std::vector<bool> is_superbrick_set(superbrick_grid.NumVertices(), false);
+      AXIS_SIZE_TYPE brick_coord[DIM3], superbrick_coord[DIM3];
+      for (VERTEX_INDEX ib = 0; ib < brick.NumRegions(); ib++) {
+        brick.ComputeCoord(ib, brick_coord);
+        for (int d = 0; d < DIM3; d++) 
+          { superbrick_coord[d] = brick_coord[d]/superbrick_factor; }
+        const VERTEX_INDEX js = 
+          superbrick_grid.ComputeVertexIndex(superbrick_coord);
+        if (!is_superbrick_set[js] || brick.Min(ib) < superbrick_min[js]) 
+          { superbrick_min[js] = brick.Min(ib); }
+        if (!is_superbrick_set[js] || brick.Max(ib) > superbrick_max[js]) 
+          { superbrick_max[js] = brick.Max(ib); }
+        is_superbrick_set[js] = true;
+      }
+
+      is_set = true;
+    }
+
+    /// Return true if bricks are set.
+    bool IsSet() const
+    { return(is_set); }
+
+    /// Return number of grid edges along each brick edge.
+    AXIS_SIZE_TYPE BrickEdgeLength() const
+    { return(brick.RegionEdgeLength()); }
+
+    /// Return grid of bricks.
+    const SHARPISO_GRID & BrickGrid() const
+    { return(brick); }
+
+    /// Set active_brick[ib] to true if the range of brick ib 
+    ///   contains isovalue.
+    /// If bricks are not set, active_brick is not modified.
+    /// Only bricks in superbricks whose range contains isovalue 
+    ///   are examined.
+    /// Bricks which are not active contain no bipolar grid edge
+    ///   and no active cube.
+    void ComputeActiveBricks
+    (const SCALAR_TYPE isovalue, SHARPISO_ACTIVE_BRICKS & active_brick) const
+    {
+      AXIS_SIZE_TYPE superbrick_coord[DIM3], brick_coord[DIM3];
+      AXIS_SIZE_TYPE brick_end[DIM3];
+
+      if (!IsSet()) { return; }
+
+      active_brick.SetBricks(brick, brick.RegionEdgeLength());
+      active_brick.SetAll(false);
+
+      for (VERTEX_INDEX js = 0; js < superbrick_grid.NumVertices(); js++) {
+
+        if (!ContainsIsovalue
+            (superbrick_min[js], superbrick_max[js], isovalue)) 
+          { continue; }
+
+        superbrick_grid.ComputeCoord(js, superbrick_coord);
+        for (int d = 0; d < DIM3; d++) {
+          brick_end[d] = (superbrick_coord[d]+1)*superbrick_factor;
+          if (brick_end[d] > brick.AxisSize(d)) 
+            { brick_end[d] = brick.AxisSize(d); }
+        }
+
+        brick_coord[2] = superbrick_coord[2]*superbrick_factor;
+        for (; brick_coord[2] < brick_end[2]; brick_coord[2]++) {
+          brick_coord[1] = superbrick_coord[1]*superbrick_factor;
+          for (; brick_coord[1] < brick_end[1]; brick_coord[1]++) {
+            brick_coord[0] = superbrick_coord[0]*superbrick_factor;
+            VERTEX_INDEX ib = brick.ComputeVertexIndex(brick_coord);
+            for (; brick_coord[0] < brick_end[0]; brick_coord[0]++) {
+              if (ContainsIsovalue(brick.Min(ib), brick.Max(ib), isovalue))
+                { active_brick.Set(ib, true); }
+              ib++;
+            }
+          }
+        }
+      }
+    }
+  };
+
 };
 
 #endif
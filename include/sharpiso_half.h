@@ -0,0 +1,134 @@
+/// \file sharpiso_half.h
+/// Half precision floating point storage type.
+/// Version v0.1.0
+
+/*
+  IJK: Isosurface Jeneration Code
+  Copyright (C) 2015 Rephael Wenger
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License
+  (LGPL) as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#ifndef _SHARPISO_HALF_
+#define _SHARPISO_HALF_
+
+#include <cstring>
+
+namespace SHARPISO {
+
+  // **************************************************
+  // HALF PRECISION CONVERSION
+  // **************************************************
+
+  /// Convert float to IEEE 754 binary16 bits.
+  /// Rounds to nearest, ties to even.  Overflow converts to infinity.
+  inline unsigned short float2half_bits(const float x)
+  {
+    unsigned int f;
+    std::memcpy(&f, &x, sizeof(f));
+
+    const unsigned int sign = (f >> 16) & 0x8000;
+    const unsigned int exponent = (f >> 23) & 0xff;
+    unsigned int mantissa = f & 0x7fffff;
+
+    if (exponent == 0xff) {
+      // Infinity or nan.  Keep nan quiet.
+      if (mantissa == 0) { return(sign | 0x7c00); }
+      else { return(sign | 0x7e00 | (mantissa >> 13)); }
+    }
+
+    const int e = int(exponent) - 127 + 15;
+
+    if (e >= 0x1f) { return(sign | 0x7c00); }   // Overflow.
+
+    if (e <= 0) {
+      // Denormalized half or zero.
+      if (e < -10) { return(sign); }
+      mantissa |= 0x800000;
+      const unsigned int shift = 14 - e;
+      unsigned int h = mantissa >> shift;
+      const unsigned int remainder = mantissa & ((1u << shift) - 1);
+      const unsigned int halfway = 1u << (shift-1);
+      if (remainder > halfway || (remainder == halfway && (h & 1)))
+        { h++; }
+      return(sign | h);
+    }
+
+    unsigned int h = (unsigned int)(e << 10) | (mantissa >> 13);
+    const unsigned int remainder = mantissa & 0x1fff;
+    // Carry into exponent correctly rounds up to next power of two
+    //   or to infinity.
+    if (remainder > 0x1000 || (remainder == 0x1000 && (h & 1)))
+      { h++; }
+    return(sign | h);
+  }
+
+  /// Convert IEEE 754 binary16 bits to float.
+  inline float half_bits2float(const unsigned short h)
+  {
+    const unsigned int sign = (unsigned int)(h & 0x8000) << 16;
+    const unsigned int exponent = (h >> 10) & 0x1f;
+    unsigned int mantissa = h & 0x3ff;
+    unsigned int f;
+
+    if (exponent == 0) {
+      if (mantissa == 0) { f = sign; }
+      else {
+        // Normalize denormalized half.
+        int e = -1;
+        do { mantissa <<= 1; e++; } while ((mantissa & 0x400) == 0);
+        f = sign | ((unsigned int)(127 - 15 - e) << 23) |
+          ((mantissa & 0x3ff) << 13);
+      }
+    }
+    else if (exponent == 0x1f)
+      { f = sign | 0x7f800000 | (mantissa << 13); }
+    else
+      { f = sign | ((exponent + 127 - 15) << 23) | (mantissa << 13); }
+
+    float x;
+    std::memcpy(&x, &f, sizeof(x));
+    return(x);
+  }
+
+  // **************************************************
+  // CLASS HALF_FLOAT
+  // **************************************************
+
+  /// IEEE 754 half precision (binary16) floating point number.
+  /// Storage type only.  Converts to float for all computations.
+  class HALF_FLOAT {
+
+  protected:
+    unsigned short bits;
+
+  public:
+    HALF_FLOAT() {};
+    HALF_FLOAT(const float x) { bits = float2half_bits(x); };
+
+    operator float() const
+    { return(half_bits2float(bits)); };
+
+    const HALF_FLOAT & operator *= (const float s)
+    { bits = float2half_bits(float(*this)*s); return(*this); };
+
+    /// Return binary16 bits.
+    unsigned short Bits() const
+    { return(bits); };
+  };
+
+}
+
+#endif
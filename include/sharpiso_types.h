@@ -26,6 +26,8 @@
 
 #include <utility>
 
+#include "sharpiso_half.h"
+
 /// Definitions for sharp isosurface processing.
 namespace SHARPISO {
 
@@ -34,8 +36,30 @@ namespace SHARPISO {
   // **************************************************
 
   typedef float SCALAR_TYPE;
+
+  /// Type of scalar values stored in scalar grids.
+  /// Scalar values are converted to SCALAR_TYPE when used in computations.
+  /// Define SHARPISO_SCALAR_STORAGE_UINT8 or SHARPISO_SCALAR_STORAGE_UINT16
+  ///   to store 8 or 16 bit volumes without conversion to float.
+#if defined(SHARPISO_SCALAR_STORAGE_UINT8)
+  typedef unsigned char SCALAR_STORAGE_TYPE;
+#elif defined(SHARPISO_SCALAR_STORAGE_UINT16)
+  typedef unsigned short SCALAR_STORAGE_TYPE;
+#else
+  typedef float SCALAR_STORAGE_TYPE;
+#endif
   typedef float COORD_TYPE;
   typedef float GRADIENT_COORD_TYPE;
+
+  /// Type of gradient coordinates stored in gradient grids.
+  /// Gradients are converted to GRADIENT_COORD_TYPE when used.
+  /// Define SHARPISO_GRADIENT_STORAGE_HALF to store half precision
+  ///   gradient coordinates.
+#if defined(SHARPISO_GRADIENT_STORAGE_HALF)
+  typedef HALF_FLOAT GRADIENT_STORAGE_TYPE;
+#else
+  typedef float GRADIENT_STORAGE_TYPE;
+#endif
   typedef int GRID_COORD_TYPE;
   typedef GRADIENT_COORD_TYPE ANGLE_TYPE;
   typedef double WEIGHT_TYPE;
@@ -68,6 +92,16 @@ namespace SHARPISO {
                  UNKNOWN_GRAD_SELECTION_METHOD }
     GRAD_SELECTION_METHOD;
 
+  /// Solver for the 3x3 Lindstrom quadratic error function (QEF).
+  /// QEF_SOLVER_SVD: Eigen JacobiSVD of the 3x3 matrix.
+  /// QEF_SOLVER_JACOBI: Jacobi eigen-decomposition of the symmetric
+  ///   3x3 matrix.  No dynamic allocation.
+  /// QEF_SOLVER_BATCH: Jacobi eigen-decomposition applied to batches 
+  ///   of cubes stored as structure of arrays.
+  typedef enum { QEF_SOLVER_SVD, QEF_SOLVER_JACOBI, QEF_SOLVER_BATCH,
+                 UNKNOWN_QEF_SOLVER }
+    QEF_SOLVER_TYPE;
+
   /// Isosurface vertex types
   typedef enum 
   { CORNER_ISOVERT, EDGE_ISOVERT, SHARP_ISOVERT, SMOOTH_ISOVERT, ALL_ISOVERT }
@@ -27,8 +27,7 @@
 
 // local type definition
 namespace {
-typedef IJK::BOOL_GRID_BASE<SHARPISO_GRID> BOOL_GRID_BASE;
-typedef IJK::BOOL_GRID<SHARPISO_GRID> BOOL_GRID;
+typedef IJK::BIT_GRID<SHARPISO_GRID> BIT_GRID;
 
 };
 
@@ -46,7 +45,7 @@ void compute_gradient_central_difference
 
 	gradient_grid.SetSize(scalar_grid, dimension);
 
-	BOOL_GRID boundary_grid;
+	BIT_GRID boundary_grid;
 	boundary_grid.SetSize(scalar_grid);
 	compute_boundary_grid(boundary_grid);
 
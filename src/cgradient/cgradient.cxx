@@ -23,6 +23,7 @@
 
 #include "cgradient.h"
 #include "ijkscalar_grid.txx"
+#include "ijkbit_grid.txx"
 #include "isodual3D_datastruct.h"
 
 using namespace ISODUAL3D;
@@ -30,8 +31,7 @@ using namespace ISODUAL3D;
 // local type definition
 namespace {
 
-  typedef IJK::BOOL_GRID_BASE<ISODUAL_GRID> BOOL_GRID_BASE;
-  typedef IJK::BOOL_GRID<ISODUAL_GRID> BOOL_GRID;
+  typedef IJK::BIT_GRID<ISODUAL_GRID> BIT_GRID;
 
 };
 
@@ -51,7 +51,7 @@ void compute_gradient_central_difference
 
   gradient_grid.SetSize(scalar_grid, dimension);
 
-  BOOL_GRID boundary_grid;
+  BIT_GRID boundary_grid;
   boundary_grid.SetSize(scalar_grid);
   compute_boundary_grid(boundary_grid);
 
@@ -39,7 +39,7 @@ void get_edgeI_sharp_gradients
   CUBE cube;
   GRADIENT_COORD_TYPE cube_gradient[NUM_CUBE_VERTICES3D*DIM3];
   SCALAR_TYPE cube_scalar[NUM_CUBE_VERTICES3D];
-  static COORD_TYPE cube_coord[DIM3];
+  COORD_TYPE cube_coord[DIM3];
 
   point_coord.clear();
   gradient_coord.clear();
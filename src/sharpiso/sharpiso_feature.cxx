@@ -26,6 +26,7 @@
 #include "sharpiso_closest.h"
 #include "sharpiso_intersect.h"
 #include "sharpiso_svd.h"
+#include "sharpiso_qef_batch.h"
 
 #include "ijkcoord.txx"
 #include "ijkgrid.txx"
@@ -75,6 +76,32 @@ void SHARPISO::svd_compute_sharp_vertex_for_cube_lindstrom
 	NUM_TYPE & num_large_eigenvalues,
 	SVD_INFO & svd_info)
 {
+  GET_GRADIENTS_SCRATCH scratch;
+
+  svd_compute_sharp_vertex_for_cube_lindstrom
+    (scalar_grid, gradient_grid, cube_index, isovalue, 
+     sharpiso_param, voxel, scratch, 
+     sharp_coord, edge_direction, orth_direction,
+     eigenvalues, num_large_eigenvalues, svd_info);
+}
+
+/// Compute sharp isosurface vertex using singular valued decomposition.
+/// Version using scratch memory for gradients.
+void SHARPISO::svd_compute_sharp_vertex_for_cube_lindstrom
+	(const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
+	const GRADIENT_GRID_BASE & gradient_grid,
+	const VERTEX_INDEX cube_index,
+	const SCALAR_TYPE isovalue,
+	const SHARP_ISOVERT_PARAM & sharpiso_param,
+	const OFFSET_VOXEL & voxel,
+	GET_GRADIENTS_SCRATCH & scratch,
+	COORD_TYPE sharp_coord[DIM3],
+  COORD_TYPE edge_direction[DIM3],
+  COORD_TYPE orth_direction[DIM3],
+	EIGENVALUE_TYPE eigenvalues[DIM3],
+	NUM_TYPE & num_large_eigenvalues,
+	SVD_INFO & svd_info)
+{
 
 	COORD_TYPE central_point[DIM3];
 	compute_central_point
@@ -83,7 +110,7 @@ void SHARPISO::svd_compute_sharp_vertex_for_cube_lindstrom
 
   svd_compute_sharp_vertex_for_cube_lindstrom
     (scalar_grid, gradient_grid, cube_index, isovalue, 
-     sharpiso_param, voxel, central_point, 
+     sharpiso_param, voxel, central_point, scratch,
      sharp_coord, edge_direction, orth_direction,
      eigenvalues, num_large_eigenvalues, svd_info);
 }
@@ -106,14 +133,43 @@ void SHARPISO::svd_compute_sharp_vertex_for_cube_lindstrom
 	EIGENVALUE_TYPE eigenvalues[DIM3],
 	NUM_TYPE & num_large_eigenvalues,
 	SVD_INFO & svd_info)
+{
+  GET_GRADIENTS_SCRATCH scratch;
+
+  svd_compute_sharp_vertex_for_cube_lindstrom
+    (scalar_grid, gradient_grid, cube_index, isovalue, 
+     sharpiso_param, voxel, pointX, scratch,
+     sharp_coord, edge_direction, orth_direction,
+     eigenvalues, num_large_eigenvalues, svd_info);
+}
+
+/// Compute sharp isosurface vertex using singular valued decomposition.
+/// Version using scratch memory for gradients.
+/// @param pointX Compute vertex closest to pointX.
+void SHARPISO::svd_compute_sharp_vertex_for_cube_lindstrom
+ (const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
+  const GRADIENT_GRID_BASE & gradient_grid,
+  const VERTEX_INDEX cube_index,
+  const SCALAR_TYPE isovalue,
+  const SHARP_ISOVERT_PARAM & sharpiso_param,
+  const OFFSET_VOXEL & voxel,
+  const COORD_TYPE pointX[DIM3],
+  GET_GRADIENTS_SCRATCH & scratch,
+	COORD_TYPE sharp_coord[DIM3],
+  COORD_TYPE edge_direction[DIM3],
+  COORD_TYPE orth_direction[DIM3],
+	EIGENVALUE_TYPE eigenvalues[DIM3],
+	NUM_TYPE & num_large_eigenvalues,
+	SVD_INFO & svd_info)
 {
 	const EIGENVALUE_TYPE max_small_eigenvalue =
 		sharpiso_param.max_small_eigenvalue;
+	const std::vector<COORD_TYPE> & point_coord = scratch.point_coord;
+	const std::vector<GRADIENT_COORD_TYPE> & gradient_coord = 
+		scratch.gradient_coord;
+	const std::vector<SCALAR_TYPE> & scalar = scratch.scalar;
 
 	NUM_TYPE num_gradients = 0;
-	std::vector<COORD_TYPE> point_coord;
-	std::vector<GRADIENT_COORD_TYPE> gradient_coord;
-	std::vector<SCALAR_TYPE> scalar;
 
 	// Scale cube coord by spacings
 	COORD_TYPE cube_coord[DIM3];
@@ -122,7 +178,7 @@ void SHARPISO::svd_compute_sharp_vertex_for_cube_lindstrom
 	get_gradients
 		(scalar_grid, gradient_grid, cube_index, isovalue,
 		sharpiso_param, voxel, sharpiso_param.flag_sort_gradients,
-		point_coord, gradient_coord, scalar, num_gradients);
+		scratch, num_gradients);
 
 	if(num_gradients == 0)
 	{
@@ -140,7 +196,8 @@ void SHARPISO::svd_compute_sharp_vertex_for_cube_lindstrom
 	svd_info.flag_Linf_iso_vertex_location = false;
 
   svd_calculate_sharpiso_vertex_using_lindstrom_fast
-    (num_gradients, max_small_eigenvalue,isovalue, &(scalar[0]), 
+    (num_gradients, max_small_eigenvalue, sharpiso_param.qef_solver,
+     isovalue, &(scalar[0]), 
      &(point_coord[0]), &(gradient_coord[0]), pointX,
      num_large_eigenvalues, eigenvalues, 
      sharp_coord, edge_direction, orth_direction);
@@ -151,6 +208,102 @@ void SHARPISO::svd_compute_sharp_vertex_for_cube_lindstrom
 		sharpiso_param, sharp_coord, svd_info);
 }
 
+/// Gather step of batched version of 
+///   svd_compute_sharp_vertex_for_cube_lindstrom.
+void SHARPISO::svd_gather_sharp_vertex_for_cube_lindstrom
+ (const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
+  const GRADIENT_GRID_BASE & gradient_grid,
+  const VERTEX_INDEX cube_index,
+  const SCALAR_TYPE isovalue,
+  const SHARP_ISOVERT_PARAM & sharpiso_param,
+  const OFFSET_VOXEL & voxel,
+  GET_GRADIENTS_SCRATCH & scratch,
+  QEF_BATCH & qef_batch,
+  NUM_TYPE & ilane,
+  COORD_TYPE sharp_coord[DIM3],
+  SVD_INFO & svd_info)
+{
+	const EIGENVALUE_TYPE max_small_eigenvalue =
+		sharpiso_param.max_small_eigenvalue;
+	const std::vector<COORD_TYPE> & point_coord = scratch.point_coord;
+	const std::vector<GRADIENT_COORD_TYPE> & gradient_coord = 
+		scratch.gradient_coord;
+	const std::vector<SCALAR_TYPE> & scalar = scratch.scalar;
+
+	NUM_TYPE num_gradients = 0;
+	COORD_TYPE central_point[DIM3];
+
+	compute_central_point
+		(scalar_grid, gradient_grid, isovalue, cube_index,
+		sharpiso_param, central_point, svd_info);
+
+	get_gradients
+		(scalar_grid, gradient_grid, cube_index, isovalue,
+		sharpiso_param, voxel, sharpiso_param.flag_sort_gradients,
+		scratch, num_gradients);
+
+	if (num_gradients == 0) {
+
+		compute_edgeI_centroid
+			(scalar_grid, isovalue, cube_index, sharp_coord);
+
+		svd_info.location = CENTROID;
+    ilane = qef_batch.AddEmptySystem(central_point);
+		return;
+	}
+
+	svd_info.location = LOC_SVD;
+	svd_info.flag_conflict = false;
+	svd_info.flag_Linf_iso_vertex_location = false;
+
+  COORD_TYPE A[DIM3*DIM3];
+  COORD_TYPE B[DIM3];
+  compute_A_B(num_gradients, max_small_eigenvalue, isovalue, &(scalar[0]),
+              &(point_coord[0]), &(gradient_coord[0]), A, B);
+
+  ilane = qef_batch.AddSystem(A, B, central_point);
+}
+
+/// Scatter step of batched version of 
+///   svd_compute_sharp_vertex_for_cube_lindstrom.
+void SHARPISO::svd_scatter_sharp_vertex_for_cube_lindstrom
+ (const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
+  const GRADIENT_GRID_BASE & gradient_grid,
+  const VERTEX_INDEX cube_index,
+  const SCALAR_TYPE isovalue,
+  const SHARP_ISOVERT_PARAM & sharpiso_param,
+  const QEF_BATCH & qef_batch,
+  const NUM_TYPE ilane,
+  COORD_TYPE sharp_coord[DIM3],
+  COORD_TYPE edge_direction[DIM3],
+  COORD_TYPE orth_direction[DIM3],
+	EIGENVALUE_TYPE eigenvalues[DIM3],
+	NUM_TYPE & num_large_eigenvalues,
+	SVD_INFO & svd_info)
+{
+  if (svd_info.location == CENTROID) {
+    // No gradients.  sharp_coord was set in the gather step.
+    num_large_eigenvalues = 0;
+    IJK::set_coord_3D(0, eigenvalues);
+    IJK::set_coord_3D(0, edge_direction);
+    IJK::set_coord_3D(0, orth_direction);
+    return;
+  }
+
+  qef_batch.GetSolution
+    (ilane, num_large_eigenvalues, eigenvalues, sharp_coord, 
+     edge_direction, orth_direction);
+
+	// Scale cube coord by spacings
+	COORD_TYPE cube_coord[DIM3];
+	scalar_grid.ComputeScaledCoord(cube_index, cube_coord);
+
+	// post process the isovertex. 
+	postprocess_isovert_location
+		(scalar_grid, gradient_grid, cube_index, cube_coord, isovalue,
+		sharpiso_param, sharp_coord, svd_info);
+}
+
 /// Compute sharp isosurface vertex using singular valued decomposition.
 /// Use Lindstrom's formula.
 /// If num_large_eigenvalues == 2, position vertex on plane.
@@ -203,7 +356,8 @@ void SHARPISO::svd_compute_sharp_vertex_on_plane_lindstrom
 
   bool flag_coord_on_plane;
   svd_calculate_sharpiso_vertex_on_plane_using_lindstrom_fast
-    (num_gradients, max_small_eigenvalue,isovalue, &(scalar[0]), 
+    (num_gradients, max_small_eigenvalue, sharpiso_param.qef_solver,
+     isovalue, &(scalar[0]), 
      &(point_coord[0]), &(gradient_coord[0]), pointX, plane_normal,
      num_large_eigenvalues, eigenvalues, sharp_coord, flag_coord_on_plane);
 
@@ -223,11 +377,14 @@ void SHARPISO::svd_compute_sharp_vertex_on_plane_lindstrom
 // Compute sharp isosurface vertex using singular valued decomposition.
 // Use input edge-isosurface intersections and normals
 //   to position isosurface vertices on sharp features.
-void SHARPISO::svd_compute_sharp_vertex_for_cube_hermite
+// @tparam EDGE_INDEX_TYPE SHARPISO_EDGE_INDEX_GRID 
+//   or SHARPISO_EDGE_INDEX_HASH.
+template <typename EDGE_INDEX_TYPE>
+void svd_compute_sharp_vertex_for_cube_hermite_T
 (const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
  const std::vector<COORD_TYPE> & edgeI_coord,
  const std::vector<GRADIENT_COORD_TYPE> & edgeI_normal_coord,
- const SHARPISO_EDGE_INDEX_GRID & edge_index,
+ const EDGE_INDEX_TYPE & edge_index,
  const VERTEX_INDEX cube_index,
  const SCALAR_TYPE isovalue,
  const SHARP_ISOVERT_PARAM & sharpiso_param,
@@ -239,7 +396,6 @@ void SHARPISO::svd_compute_sharp_vertex_for_cube_hermite
   const EIGENVALUE_TYPE max_small_eigenvalue =
     sharpiso_param.max_small_eigenvalue;
   const COORD_TYPE max_dist = sharpiso_param.max_dist;
-  IJK::PROCEDURE_ERROR error("svd_compute_sharp_vertex_for_cube");
 
   NUM_TYPE num_gradients = 0;
   std::vector<COORD_TYPE> point_coord;
@@ -247,6 +403,7 @@ void SHARPISO::svd_compute_sharp_vertex_for_cube_hermite
   std::vector<SCALAR_TYPE> scalar;
 
   if (!sharpiso_param.use_lindstrom) {
+    IJK::PROCEDURE_ERROR error("svd_compute_sharp_vertex_for_cube");
     error.AddMessage("Programming error.  Normal based computation only implemented with Lindstrom.");
     throw error;
   }
@@ -278,7 +435,8 @@ void SHARPISO::svd_compute_sharp_vertex_for_cube_hermite
 
   // use the sharp version with the Garland-Heckbert way of storing normals
   svd_calculate_sharpiso_vertex_using_lindstrom_fast
-    (num_gradients, max_small_eigenvalue, isovalue, &(scalar[0]), 
+    (num_gradients, max_small_eigenvalue, sharpiso_param.qef_solver,
+     isovalue, &(scalar[0]), 
      &(point_coord[0]), &(gradient_coord[0]), central_point,
      num_large_eigenvalues, eigenvalues, sharp_coord);
 
@@ -292,6 +450,49 @@ void SHARPISO::svd_compute_sharp_vertex_for_cube_hermite
   }
 }
 
+// Compute sharp isosurface vertex using singular valued decomposition.
+// Use input edge-isosurface intersections and normals
+//   to position isosurface vertices on sharp features.
+void SHARPISO::svd_compute_sharp_vertex_for_cube_hermite
+(const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
+ const std::vector<COORD_TYPE> & edgeI_coord,
+ const std::vector<GRADIENT_COORD_TYPE> & edgeI_normal_coord,
+ const SHARPISO_EDGE_INDEX_GRID & edge_index,
+ const VERTEX_INDEX cube_index,
+ const SCALAR_TYPE isovalue,
+ const SHARP_ISOVERT_PARAM & sharpiso_param,
+ COORD_TYPE sharp_coord[DIM3],
+ EIGENVALUE_TYPE eigenvalues[DIM3],
+ NUM_TYPE & num_large_eigenvalues,
+ SVD_INFO & svd_info)
+{
+  svd_compute_sharp_vertex_for_cube_hermite_T
+    (scalar_grid, edgeI_coord, edgeI_normal_coord, edge_index, 
+     cube_index, isovalue, sharpiso_param, sharp_coord, 
+     eigenvalues, num_large_eigenvalues, svd_info);
+}
+
+// Compute sharp isosurface vertex using singular valued decomposition.
+// Version using sparse edge index.
+void SHARPISO::svd_compute_sharp_vertex_for_cube_hermite
+(const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
+ const std::vector<COORD_TYPE> & edgeI_coord,
+ const std::vector<GRADIENT_COORD_TYPE> & edgeI_normal_coord,
+ const SHARPISO_EDGE_INDEX_HASH & edge_index,
+ const VERTEX_INDEX cube_index,
+ const SCALAR_TYPE isovalue,
+ const SHARP_ISOVERT_PARAM & sharpiso_param,
+ COORD_TYPE sharp_coord[DIM3],
+ EIGENVALUE_TYPE eigenvalues[DIM3],
+ NUM_TYPE & num_large_eigenvalues,
+ SVD_INFO & svd_info)
+{
+  svd_compute_sharp_vertex_for_cube_hermite_T
+    (scalar_grid, edgeI_coord, edgeI_normal_coord, edge_index, 
+     cube_index, isovalue, sharpiso_param, sharp_coord, 
+     eigenvalues, num_large_eigenvalues, svd_info);
+}
+
 
 // ********************************************************************
 // COMPUTE SHARP VERTEX/EDGE USING SVD & EDGE-ISOSURFACE INTERSECTIONS
@@ -435,9 +636,9 @@ void SHARPISO::svd_compute_sharp_vertex_near_facet
   std::vector<COORD_TYPE> point_coord;
   std::vector<GRADIENT_COORD_TYPE> gradient_coord;
   std::vector<SCALAR_TYPE> scalar;
-  static COORD_TYPE v0_coord[DIM3];
-  static COORD_TYPE end[2][DIM3];
-  static COORD_TYPE endc[2];
+  COORD_TYPE v0_coord[DIM3];
+  COORD_TYPE end[2][DIM3];
+  COORD_TYPE endc[2];
 
   // Initialize
   sharp_vertex_location = 0;
@@ -661,12 +862,12 @@ void SHARPISO::compute_edgeI_centroid
 {
   const int dimension = scalar_grid.Dimension();
   
-  IJK::ARRAY<COORD_TYPE> vcoord(dimension);
-  IJK::ARRAY<COORD_TYPE> coord0(dimension);
-  IJK::ARRAY<COORD_TYPE> coord1(dimension);
-  IJK::ARRAY<COORD_TYPE> coord2(dimension);
+  COORD_TYPE vcoord[DIM3];
+  COORD_TYPE coord0[DIM3];
+  COORD_TYPE coord1[DIM3];
+  COORD_TYPE coord2[DIM3];
   int num_intersected_edges = 0;
-  IJK::set_coord(dimension, 0.0, vcoord.Ptr());
+  IJK::set_coord(dimension, 0.0, vcoord);
 
   for (int edge_dir = 0; edge_dir < dimension; edge_dir++)
     for (int k = 0; k < scalar_grid.NumFacetVertices(); k++) {
@@ -677,13 +878,13 @@ void SHARPISO::compute_edgeI_centroid
         SCALAR_TYPE s0 = scalar_grid.Scalar(iend0);
         SCALAR_TYPE s1 = scalar_grid.Scalar(iend1);
 
-        scalar_grid.ComputeScaledCoord(iend0, coord0.Ptr());
-        scalar_grid.ComputeScaledCoord(iend1, coord1.Ptr());
+        scalar_grid.ComputeScaledCoord(iend0, coord0);
+        scalar_grid.ComputeScaledCoord(iend1, coord1);
 
         IJK::linear_interpolate_coord
-          (dimension, s0, coord0.Ptr(), s1, coord1.Ptr(), isovalue, coord2.Ptr());
+          (dimension, s0, coord0, s1, coord1, isovalue, coord2);
 
-        IJK::add_coord(dimension, vcoord.Ptr(), coord2.Ptr(), vcoord.Ptr());
+        IJK::add_coord(dimension, vcoord, coord2, vcoord);
 
         num_intersected_edges++;
       }
@@ -691,31 +892,34 @@ void SHARPISO::compute_edgeI_centroid
 
   if (num_intersected_edges > 0) {
     IJK::multiply_coord
-      (dimension, 1.0/num_intersected_edges, vcoord.Ptr(), vcoord.Ptr());
+      (dimension, 1.0/num_intersected_edges, vcoord, vcoord);
   }
   else {
-    scalar_grid.ComputeCubeCenterScaledCoord(iv, vcoord.Ptr());
+    scalar_grid.ComputeCubeCenterScaledCoord(iv, vcoord);
   }
 
-  IJK::copy_coord(dimension, vcoord.Ptr(), coord);
+  IJK::copy_coord(dimension, vcoord, coord);
 
 }
 
 // Compute centroid of intersections of isosurface and grid edges.
 //   Edge-isosurface intersections are given in an input list.
-void SHARPISO::compute_edgeI_centroid
+// @tparam EDGE_INDEX_TYPE SHARPISO_EDGE_INDEX_GRID 
+//   or SHARPISO_EDGE_INDEX_HASH.
+template <typename EDGE_INDEX_TYPE>
+void compute_edgeI_centroid_T
 (const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
  const std::vector<COORD_TYPE> & edgeI_coord,
- const SHARPISO_EDGE_INDEX_GRID & edge_index,
+ const EDGE_INDEX_TYPE & edge_index,
  const SCALAR_TYPE isovalue, const VERTEX_INDEX cube_index,
  COORD_TYPE * coord)
 {
   const int dimension = scalar_grid.Dimension();
-  IJK::ARRAY<COORD_TYPE> vcoord(dimension);
+  COORD_TYPE vcoord[DIM3];
   IJK::PROCEDURE_ERROR error("compute_edgeI_centroid");
 
   int num_intersected_edges = 0;
-  IJK::set_coord(dimension, 0.0, vcoord.Ptr());
+  IJK::set_coord(dimension, 0.0, vcoord);
 
   for (int edge_dir = 0; edge_dir < dimension; edge_dir++)
     for (int k = 0; k < scalar_grid.NumFacetVertices(); k++) {
@@ -733,7 +937,7 @@ void SHARPISO::compute_edgeI_centroid
           throw error;
         }
 
-        IJK::add_coord(dimension, vcoord.Ptr(), &(edgeI_coord[j*DIM3]), vcoord.Ptr());
+        IJK::add_coord(dimension, vcoord, &(edgeI_coord[j*DIM3]), vcoord);
 
         num_intersected_edges++;
       }
@@ -741,13 +945,39 @@ void SHARPISO::compute_edgeI_centroid
 
   if (num_intersected_edges > 0) {
     IJK::multiply_coord
-      (dimension, 1.0/num_intersected_edges, vcoord.Ptr(), vcoord.Ptr());
+      (dimension, 1.0/num_intersected_edges, vcoord, vcoord);
   }
   else {
-    scalar_grid.ComputeCubeCenterScaledCoord(cube_index, vcoord.Ptr());
+    scalar_grid.ComputeCubeCenterScaledCoord(cube_index, vcoord);
   }
 
-  IJK::copy_coord(dimension, vcoord.Ptr(), coord);
+  IJK::copy_coord(dimension, vcoord, coord);
+}
+
+// Compute centroid of intersections of isosurface and grid edges.
+//   Edge-isosurface intersections are given in an input list.
+void SHARPISO::compute_edgeI_centroid
+(const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
+ const std::vector<COORD_TYPE> & edgeI_coord,
+ const SHARPISO_EDGE_INDEX_GRID & edge_index,
+ const SCALAR_TYPE isovalue, const VERTEX_INDEX cube_index,
+ COORD_TYPE * coord)
+{
+  compute_edgeI_centroid_T
+    (scalar_grid, edgeI_coord, edge_index, isovalue, cube_index, coord);
+}
+
+// Compute centroid of intersections of isosurface and grid edges.
+// Version using sparse edge index.
+void SHARPISO::compute_edgeI_centroid
+(const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
+ const std::vector<COORD_TYPE> & edgeI_coord,
+ const SHARPISO_EDGE_INDEX_HASH & edge_index,
+ const SCALAR_TYPE isovalue, const VERTEX_INDEX cube_index,
+ COORD_TYPE * coord)
+{
+  compute_edgeI_centroid_T
+    (scalar_grid, edgeI_coord, edge_index, isovalue, cube_index, coord);
 }
 
 /// Compute centroid of intersections of isosurface and grid edges.
@@ -759,13 +989,12 @@ void SHARPISO::compute_edgeI_sharp_centroid
  COORD_TYPE * coord)
 {
   const int dimension = scalar_grid.Dimension();
-  IJK::ARRAY<GRID_COORD_TYPE> grid_coord(dimension);
-  IJK::ARRAY<COORD_TYPE> vcoord(dimension);
-  IJK::ARRAY<COORD_TYPE> coord2(dimension);
+  COORD_TYPE vcoord[DIM3];
+  COORD_TYPE coord2[DIM3];
 
   int num_intersected_edges = 0;
 
-  IJK::set_coord(dimension, 0.0, vcoord.Ptr());
+  IJK::set_coord(dimension, 0.0, vcoord);
 
   for (int edge_dir = 0; edge_dir < dimension; edge_dir++)
     for (int k = 0; k < scalar_grid.NumFacetVertices(); k++) {
@@ -776,9 +1005,9 @@ void SHARPISO::compute_edgeI_sharp_centroid
 
         compute_isosurface_grid_edge_intersection
           (scalar_grid, gradient_grid, isovalue,
-           iend0, iend1, edge_dir, coord2.Ptr());
+           iend0, iend1, edge_dir, coord2);
 
-        IJK::add_coord(dimension, vcoord.Ptr(), coord2.Ptr(), vcoord.Ptr());
+        IJK::add_coord(dimension, vcoord, coord2, vcoord);
 
         num_intersected_edges++;
       }
@@ -786,13 +1015,13 @@ void SHARPISO::compute_edgeI_sharp_centroid
 
   if (num_intersected_edges > 0) {
     IJK::multiply_coord
-      (dimension, 1.0/num_intersected_edges, vcoord.Ptr(), vcoord.Ptr());
+      (dimension, 1.0/num_intersected_edges, vcoord, vcoord);
   }
   else {
-    scalar_grid.ComputeCubeCenterScaledCoord(iv, vcoord.Ptr());
+    scalar_grid.ComputeCubeCenterScaledCoord(iv, vcoord);
   }
 
-  IJK::copy_coord(dimension, vcoord.Ptr(), coord);
+  IJK::copy_coord(dimension, vcoord, coord);
 }
 
 
@@ -858,7 +1087,7 @@ void SHARPISO::get_cube_containing_point
  VERTEX_INDEX & cube_index, bool & flag_boundary)
 {
   const COORD_TYPE * spacing = grid.SpacingPtrConst();
-  static COORD_TYPE coord2[DIM3];
+  COORD_TYPE coord2[DIM3];
 
   flag_boundary = false;
   for (int d = 0; d < DIM3; d++) {
@@ -907,7 +1136,7 @@ void get_all_cubes_containing_point
  std::vector<VERTEX_INDEX> & cube_list)
 {
   const COORD_TYPE * spacing = grid.SpacingPtrConst();
-  static COORD_TYPE coord2[DIM3];
+  COORD_TYPE coord2[DIM3];
 
   cube_list.clear();
 
@@ -1255,6 +1484,9 @@ void SHARPISO::SHARP_ISOVERT_PARAM::Init()
   flag_map_extended = false;
   flag_select_mod3 = false;
   flag_select_mod6 = false;
+  qef_solver = QEF_SOLVER_SVD;
+  num_threads = 1;
+  flag_sparse_index_grid = false;
 }
 
 // **************************************************
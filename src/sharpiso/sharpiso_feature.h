@@ -44,6 +44,7 @@ namespace SHARPISO {
 
   class SHARP_ISOVERT_PARAM;
   class SVD_INFO;
+  class QEF_BATCH;
   
   // **************************************************
   // SVD ROUTINES TO COMPUTE SHARP VERTEX/EDGE
@@ -85,6 +86,84 @@ namespace SHARPISO {
    NUM_TYPE & num_large_eigenvalues,
    SVD_INFO & svd_info);
 
+  /// Compute sharp isosurface vertex using singular valued decomposition.
+  /// Version using scratch memory for gradients.
+  /// Reusing scratch for many cubes avoids allocating memory for each cube.
+  void svd_compute_sharp_vertex_for_cube_lindstrom
+  (const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
+   const GRADIENT_GRID_BASE & gradient_grid,
+   const VERTEX_INDEX cube_index,
+   const SCALAR_TYPE isovalue,
+   const SHARP_ISOVERT_PARAM & sharpiso_param,
+   const OFFSET_VOXEL & voxel,
+   GET_GRADIENTS_SCRATCH & scratch,
+   COORD_TYPE sharp_coord[DIM3],
+   COORD_TYPE edge_direction[DIM3],
+   COORD_TYPE orth_direction[DIM3],
+   EIGENVALUE_TYPE eigenvalues[DIM3],
+   NUM_TYPE & num_large_eigenvalues,
+   SVD_INFO & svd_info);
+
+  /// Compute sharp isosurface vertex using singular valued decomposition.
+  /// Version using scratch memory for gradients.
+  /// @param pointX Compute vertex closest to pointX.
+  void svd_compute_sharp_vertex_for_cube_lindstrom
+  (const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
+   const GRADIENT_GRID_BASE & gradient_grid,
+   const VERTEX_INDEX cube_index,
+   const SCALAR_TYPE isovalue,
+   const SHARP_ISOVERT_PARAM & sharpiso_param,
+   const OFFSET_VOXEL & voxel,
+   const COORD_TYPE pointX[DIM3],
+   GET_GRADIENTS_SCRATCH & scratch,
+   COORD_TYPE sharp_coord[DIM3],
+   COORD_TYPE edge_direction[DIM3],
+   COORD_TYPE orth_direction[DIM3],
+   EIGENVALUE_TYPE eigenvalues[DIM3],
+   NUM_TYPE & num_large_eigenvalues,
+   SVD_INFO & svd_info);
+
+  /// Gather step of batched version of 
+  ///   svd_compute_sharp_vertex_for_cube_lindstrom.
+  /// Get gradients of cube and add the Lindstrom system to qef_batch.
+  /// If the cube has no selected gradients, set sharp_coord to the
+  ///   centroid of the edge-isosurface intersections, set svd_info.location
+  ///   to CENTROID and add an empty system to qef_batch.
+  /// @param scratch Scratch memory for gradients.
+  /// @param[out] ilane Lane of qef_batch containing the system.
+  /// @pre qef_batch is not full.
+  void svd_gather_sharp_vertex_for_cube_lindstrom
+  (const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
+   const GRADIENT_GRID_BASE & gradient_grid,
+   const VERTEX_INDEX cube_index,
+   const SCALAR_TYPE isovalue,
+   const SHARP_ISOVERT_PARAM & sharpiso_param,
+   const OFFSET_VOXEL & voxel,
+   GET_GRADIENTS_SCRATCH & scratch,
+   QEF_BATCH & qef_batch,
+   NUM_TYPE & ilane,
+   COORD_TYPE sharp_coord[DIM3],
+   SVD_INFO & svd_info);
+
+  /// Scatter step of batched version of 
+  ///   svd_compute_sharp_vertex_for_cube_lindstrom.
+  /// Copy solution in lane ilane of qef_batch and post process vertex.
+  /// @pre solve_qef_batch() has been called on qef_batch.
+  void svd_scatter_sharp_vertex_for_cube_lindstrom
+  (const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
+   const GRADIENT_GRID_BASE & gradient_grid,
+   const VERTEX_INDEX cube_index,
+   const SCALAR_TYPE isovalue,
+   const SHARP_ISOVERT_PARAM & sharpiso_param,
+   const QEF_BATCH & qef_batch,
+   const NUM_TYPE ilane,
+   COORD_TYPE sharp_coord[DIM3],
+   COORD_TYPE edge_direction[DIM3],
+   COORD_TYPE orth_direction[DIM3],
+   EIGENVALUE_TYPE eigenvalues[DIM3],
+   NUM_TYPE & num_large_eigenvalues,
+   SVD_INFO & svd_info);
+
   /// Compute sharp isosurface vertex using singular valued decomposition.
   /// Use Lindstrom's formula.
   /// If num_large_eigenvalues == 2, position vertex on plane.
@@ -120,6 +199,21 @@ namespace SHARPISO {
    NUM_TYPE & num_large_eigenvalues,
    SVD_INFO & svd_info);
 
+  /// Compute sharp isosurface vertex using singular valued decomposition.
+  /// Version using sparse edge index.
+  void svd_compute_sharp_vertex_for_cube_hermite
+  (const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
+   const std::vector<COORD_TYPE> & edgeI_coord,
+   const std::vector<GRADIENT_COORD_TYPE> & edgeI_normal_coord,
+   const SHARPISO_EDGE_INDEX_HASH & edge_index,
+   const VERTEX_INDEX cube_index,
+   const SCALAR_TYPE isovalue,
+   const SHARP_ISOVERT_PARAM & sharpiso_param,
+   COORD_TYPE sharp_coord[DIM3],
+   EIGENVALUE_TYPE eigenvalues[DIM3],
+   NUM_TYPE & num_large_eigenvalues,
+   SVD_INFO & svd_info);
+
 
   // ********************************************************************
   // COMPUTE SHARP VERTEX/EDGE USING SVD & EDGE-ISOSURFACE INTERSECTIONS
@@ -262,6 +356,15 @@ namespace SHARPISO {
    const SCALAR_TYPE isovalue, const VERTEX_INDEX cube_index,
    COORD_TYPE * coord);
 
+  /// Compute centroid of intersections of isosurface and grid edges.
+  /// Version using sparse edge index.
+  void compute_edgeI_centroid
+  (const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
+   const std::vector<COORD_TYPE> & edgeI_coord,
+   const SHARPISO_EDGE_INDEX_HASH & edge_index,
+   const SCALAR_TYPE isovalue, const VERTEX_INDEX cube_index,
+   COORD_TYPE * coord);
+
 
   // **************************************************
   // POINT LOCATION/CONFLICT ROUTINES
@@ -454,6 +557,21 @@ namespace SHARPISO {
     /// Round to nearest 1/round_denominator
     int round_denominator;
 
+    /// Solver for the 3x3 Lindstrom matrix.
+    QEF_SOLVER_TYPE qef_solver;
+
+    /// Number of threads used in extracting isosurface polygons,
+    ///   in computing isosurface vertex positions,
+    ///   in checking cubes for sharp vertex selection
+    ///   and in checking merged isopatches for disks.
+    /// If num_threads is 1, compute all positions in the calling thread.
+    int num_threads;
+
+    /// If true, store only active cubes in the grid mapping
+    ///   cube indices to isosurface vertex data.
+    /// Memory is proportional to the number of active cubes.
+    bool flag_sparse_index_grid;
+
     /// Constructor
     SHARP_ISOVERT_PARAM() { Init(); };
 
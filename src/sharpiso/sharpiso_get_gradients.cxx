@@ -100,7 +100,7 @@ namespace {
 		NUM_TYPE & num_gradients)
 	{
 		GRADIENT_COORD_TYPE magnitude_squared =
-			gradient_grid.ComputeMagnitudeSquared(iv);
+			compute_gradient_magnitude_squared(gradient_grid, iv);
 
 		if (magnitude_squared > max_small_mag_squared) {
 			add_gradient(scalar_grid, gradient_grid, iv,
@@ -147,12 +147,11 @@ namespace {
 	{
 		typedef SHARPISO_SCALAR_GRID::DIMENSION_TYPE DTYPE;
 
-		// static so not reallocated at each call
-		static GRID_COORD_TYPE vertex_coord[DIM3];
-		static SIGNED_COORD_TYPE coord[DIM3];
+		GRID_COORD_TYPE vertex_coord[DIM3];
+		SIGNED_COORD_TYPE coord[DIM3];
 
 		GRADIENT_COORD_TYPE magnitude_squared =
-			gradient_grid.ComputeMagnitudeSquared(iv);
+			compute_gradient_magnitude_squared(gradient_grid, iv);
 
 		if (magnitude_squared > max_small_mag_squared) {
 
@@ -161,8 +160,9 @@ namespace {
 				coord[d] = vertex_coord[d] - cube_coord[d] + 
 					voxel.OffsetFactor()*scalar_grid.Spacing(d); 
 			}
+			GRADIENT_COORD_TYPE gradient_buffer[DIM3];
 			const GRADIENT_COORD_TYPE * vertex_gradient_coord =
-				gradient_grid.VectorPtrConst(iv);
+				get_vertex_gradient(gradient_grid, iv, gradient_buffer);
 			SCALAR_TYPE s = scalar_grid.Scalar(iv);
 
 			if (iso_intersects_cube
@@ -191,6 +191,8 @@ namespace {
 	}
 
 	/// Get selected vertices
+	/// @param vertex_flag[] Work array.
+	/// @pre vertex_flag[] has length at least num_vertices.
 	void get_selected_vertices
 		(const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
 		const GRADIENT_GRID_BASE & gradient_grid,
@@ -200,6 +202,7 @@ namespace {
 		const OFFSET_VOXEL & voxel,
 		const int num_vertices,
 		VERTEX_INDEX vertex_list[],
+		bool vertex_flag[],
 		NUM_TYPE & num_selected)
 	{
 		const GRADIENT_COORD_TYPE max_small_mag = 
@@ -207,14 +210,13 @@ namespace {
 		const GRADIENT_COORD_TYPE max_small_mag_squared = 
 			max_small_mag * max_small_mag;
 
-		// static so not reallocated at each call
-		static GRID_COORD_TYPE cube_coord[DIM3];
+		GRID_COORD_TYPE cube_coord[DIM3];
 
-		IJK::ARRAY<bool> vertex_flag(num_vertices, true);
+		std::fill(vertex_flag, vertex_flag+num_vertices, true);
 
 		deselect_vertices_with_small_gradients
 			(gradient_grid, vertex_list, num_vertices, max_small_mag_squared,
-			vertex_flag.Ptr());
+			vertex_flag);
 
 		if (sharpiso_param.use_selected_gradients &&
 			!sharpiso_param.select_based_on_grad_dir) {
@@ -223,16 +225,17 @@ namespace {
 
 				deselect_vertices_based_on_isoplanes
 					(scalar_grid, gradient_grid, cube_coord, voxel,
-					isovalue, vertex_list, num_vertices, vertex_flag.Ptr());
+					isovalue, vertex_list, num_vertices, vertex_flag);
 		}
 
 		num_selected = num_vertices;
 		get_flagged_list_elements
-			(vertex_flag.PtrConst(), vertex_list, num_selected);
+			(vertex_flag, vertex_list, num_selected);
 	}
 
 	/// Get selected vertices.
 	/// Resizes vector vertex_list.
+	/// @param scratch Scratch memory for vertex flags.
 	void get_selected_vertices
 		(const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
 		const GRADIENT_GRID_BASE & gradient_grid,
@@ -240,13 +243,16 @@ namespace {
 		const SCALAR_TYPE isovalue,
 		const GET_GRADIENTS_PARAM & sharpiso_param,
 		const OFFSET_VOXEL & voxel,
+		GET_GRADIENTS_SCRATCH & scratch,
 		std::vector<VERTEX_INDEX> & vertex_list)
 	{
+		const NUM_TYPE num_vertices = vertex_list.size();
 		int num_selected;
 
 		get_selected_vertices
 			(scalar_grid, gradient_grid, cube_index, isovalue, sharpiso_param, voxel,
-			vertex_list.size(), &(vertex_list[0]), num_selected);
+			num_vertices, &(vertex_list[0]), scratch.VertexFlag(num_vertices),
+			num_selected);
 		vertex_list.resize(num_selected);
 	}
 
@@ -264,7 +270,7 @@ namespace {
 
 			VERTEX_INDEX iv = vertex_list[i];
 			GRADIENT_COORD_TYPE magnitude_squared =
-				gradient_grid.ComputeMagnitudeSquared(iv);
+				compute_gradient_magnitude_squared(gradient_grid, iv);
 
 			if (magnitude_squared > max_small_mag_squared) {
 				vertex_list[num_selected] = vertex_list[i];
@@ -288,11 +294,9 @@ namespace {
 		NUM_TYPE & num_selected)
 	{
 		// NOTE: cube_vertex_list is an array.
-		// static so not reallocated at each call
-		static GRID_COORD_TYPE cube_coord[DIM3];
 
 		NUM_TYPE num_vertices(0);
-		IJK::ARRAY<bool> vertex_flag(NUM_CUBE_VERTICES3D, true);
+		bool vertex_flag[NUM_CUBE_VERTICES3D];
 
 		if (sharpiso_param.use_intersected_edge_endpoint_gradients) {
 
@@ -319,7 +323,7 @@ namespace {
 
 		get_selected_vertices
 			(scalar_grid, gradient_grid, cube_index, isovalue, sharpiso_param,
-			voxel, num_vertices, cube_vertex_list, num_selected);
+			voxel, num_vertices, cube_vertex_list, vertex_flag, num_selected);
 	}
 
 }
@@ -483,6 +487,34 @@ void SHARPISO::get_gradients
 	std::vector<SCALAR_TYPE> & scalar,
 	NUM_TYPE & num_gradients)
 {
+	GET_GRADIENTS_SCRATCH scratch;
+
+	get_gradients
+		(scalar_grid, gradient_grid, cube_index, isovalue, sharpiso_param,
+		voxel, flag_sort_gradients, scratch, num_gradients);
+
+	point_coord.swap(scratch.point_coord);
+	gradient_coord.swap(scratch.gradient_coord);
+	scalar.swap(scratch.scalar);
+}
+
+/// Get gradients in cube and neighboring cubes.
+/// Version using scratch memory.
+void SHARPISO::get_gradients
+	(const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
+	const GRADIENT_GRID_BASE & gradient_grid,
+	const VERTEX_INDEX cube_index,
+	const SCALAR_TYPE isovalue,
+	const GET_GRADIENTS_PARAM & sharpiso_param,
+	const OFFSET_VOXEL & voxel,
+	const bool flag_sort_gradients,
+	GET_GRADIENTS_SCRATCH & scratch,
+	NUM_TYPE & num_gradients)
+{
+	std::vector<COORD_TYPE> & point_coord = scratch.point_coord;
+	std::vector<GRADIENT_COORD_TYPE> & gradient_coord = scratch.gradient_coord;
+	std::vector<SCALAR_TYPE> & scalar = scratch.scalar;
+
 	//DEBUG
 	using namespace std;
 
@@ -511,7 +543,9 @@ void SHARPISO::get_gradients
 	{
 
 		// NOTE: vertex_list is a C++ vector.
-		std::vector<VERTEX_INDEX> vertex_list;
+		std::vector<VERTEX_INDEX> & vertex_list = scratch.vertex_list;
+
+		vertex_list.clear();
 		//cube gradients
 		if (sharpiso_param.use_only_cube_gradients) 
 		{
@@ -529,7 +563,7 @@ void SHARPISO::get_gradients
         if (sharpiso_param.use_new_version) {
           get_ie_endpoints_in_large_neighborhood
             (scalar_grid, gradient_grid, isovalue, cube_index,
-             sharpiso_param, vertex_list);
+             sharpiso_param, scratch, vertex_list);
         }
         else {
           get_ie_endpoints_in_large_neighborhood_old_version
@@ -558,7 +592,7 @@ void SHARPISO::get_gradients
 
 		get_selected_vertices
 			(scalar_grid, gradient_grid, cube_index, isovalue, sharpiso_param,
-			voxel, vertex_list);
+			voxel, scratch, vertex_list);
 
 		if (flag_sort_gradients) {
 			sort_vertices_by_isoplane_dist2cc
@@ -1161,15 +1195,19 @@ void SHARPISO::get_intersected_neighbor_edge_endpoint_gradients
 
 }
 
-/// Get gradients from list of edge-isosurface intersections.
-/// @param sharpiso_param Determines which gradients are selected.
-/// @param flag_sort_gradients If true, sort gradients.  
-///        Overrides flag_sort_gradients in sharpiso_param.
-void SHARPISO::get_gradients_from_list
+namespace {
+
+  using namespace SHARPISO;
+
+  // Get gradients from list of edge-isosurface intersections.
+  // @tparam EDGE_INDEX_TYPE SHARPISO_EDGE_INDEX_GRID 
+  //   or SHARPISO_EDGE_INDEX_HASH.
+  template <typename EDGE_INDEX_TYPE>
+  void get_gradients_from_list_T
 	(const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
 	const std::vector<COORD_TYPE> & edgeI_coord,
 	const std::vector<GRADIENT_COORD_TYPE> & edgeI_normal_coord,
-	const SHARPISO_EDGE_INDEX_GRID & edge_index,
+	const EDGE_INDEX_TYPE & edge_index,
 	const VERTEX_INDEX cube_index,
 	const SCALAR_TYPE isovalue,
 	const GET_GRADIENTS_PARAM & sharpiso_param,
@@ -1182,7 +1220,6 @@ void SHARPISO::get_gradients_from_list
 		sharpiso_param.max_small_magnitude;
 	const GRADIENT_COORD_TYPE max_small_mag_squared =
 		max_small_mag*max_small_mag;
-	IJK::PROCEDURE_ERROR error("get_gradients_from_list");
 
 	for (NUM_TYPE edge_dir = 0; edge_dir < DIM3; edge_dir++) {
 
@@ -1194,6 +1231,7 @@ void SHARPISO::get_gradients_from_list
 				INDEX_DIFF_TYPE j = edge_index.Vector(iv0, edge_dir);
 
 				if (j < 0) {
+					IJK::PROCEDURE_ERROR error("get_gradients_from_list");
 					error.AddMessage
 						("Error.  Missing edge-isosurface intersection for edge (",
 						iv0, ",", iv1, ").");
@@ -1208,6 +1246,52 @@ void SHARPISO::get_gradients_from_list
 	}
 }
 
+}
+
+/// Get gradients from list of edge-isosurface intersections.
+/// @param sharpiso_param Determines which gradients are selected.
+/// @param flag_sort_gradients If true, sort gradients.  
+///        Overrides flag_sort_gradients in sharpiso_param.
+void SHARPISO::get_gradients_from_list
+	(const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
+	const std::vector<COORD_TYPE> & edgeI_coord,
+	const std::vector<GRADIENT_COORD_TYPE> & edgeI_normal_coord,
+	const SHARPISO_EDGE_INDEX_GRID & edge_index,
+	const VERTEX_INDEX cube_index,
+	const SCALAR_TYPE isovalue,
+	const GET_GRADIENTS_PARAM & sharpiso_param,
+	std::vector<COORD_TYPE> & point_coord,
+	std::vector<GRADIENT_COORD_TYPE> & gradient_coord,
+	std::vector<SCALAR_TYPE> & scalar,
+	NUM_TYPE & num_gradients)
+{
+	get_gradients_from_list_T
+		(scalar_grid, edgeI_coord, edgeI_normal_coord, edge_index, 
+		cube_index, isovalue, sharpiso_param, 
+		point_coord, gradient_coord, scalar, num_gradients);
+}
+
+/// Get gradients from list of edge-isosurface intersections.
+/// Version using sparse edge index.
+void SHARPISO::get_gradients_from_list
+	(const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
+	const std::vector<COORD_TYPE> & edgeI_coord,
+	const std::vector<GRADIENT_COORD_TYPE> & edgeI_normal_coord,
+	const SHARPISO_EDGE_INDEX_HASH & edge_index,
+	const VERTEX_INDEX cube_index,
+	const SCALAR_TYPE isovalue,
+	const GET_GRADIENTS_PARAM & sharpiso_param,
+	std::vector<COORD_TYPE> & point_coord,
+	std::vector<GRADIENT_COORD_TYPE> & gradient_coord,
+	std::vector<SCALAR_TYPE> & scalar,
+	NUM_TYPE & num_gradients)
+{
+	get_gradients_from_list_T
+		(scalar_grid, edgeI_coord, edgeI_normal_coord, edge_index, 
+		cube_index, isovalue, sharpiso_param, 
+		point_coord, gradient_coord, scalar, num_gradients);
+}
+
 
 // **************************************************
 // GET VERTICES
@@ -1360,8 +1444,7 @@ void SHARPISO::get_cube_neighbor_vertices
 {
 	typedef SHARPISO_SCALAR_GRID::DIMENSION_TYPE DTYPE;
 
-	// static so not reallocated at each call
-	static GRID_COORD_TYPE cube_coord[DIM3];
+	GRID_COORD_TYPE cube_coord[DIM3];
 
 	vertex_list.resize(NUM_CUBE_VERTICES3D);
 	get_cube_vertices(grid, cube_index, &vertex_list[0]);
@@ -1551,7 +1634,7 @@ void SHARPISO::get_cube_vertices_with_large_gradients
 	for (NUM_TYPE i = 0; i < NUM_CUBE_VERTICES3D; i++) {
 		VERTEX_INDEX iv = scalar_grid.CubeVertex(cube_index, i);
 
-		if (gradient_grid.IsMagnitudeGT(iv, max_small_magnitude)) 
+		if (is_gradient_magnitude_gt(gradient_grid, iv, max_small_magnitude)) 
 		{ vertex_list.push_back(iv); }
 	}
 }
@@ -1583,7 +1666,7 @@ void SHARPISO::get_vertices_with_large_gradient_magnitudes
 				iv = scalar_grid.PrevVertex(iv, d);
 				k++;
 
-				if (gradient_grid.IsMagnitudeGT(iv, max_small_magnitude)) {
+				if (is_gradient_magnitude_gt(gradient_grid, iv, max_small_magnitude)) {
 					vertex_list.push_back(iv);
 					// Don't get any other vertices in this direction.
 					break;
@@ -1596,7 +1679,7 @@ void SHARPISO::get_vertices_with_large_gradient_magnitudes
 				iv = scalar_grid.NextVertex(iv, d);
 				k++;
 
-				if (gradient_grid.IsMagnitudeGT(iv, max_small_magnitude)) {
+				if (is_gradient_magnitude_gt(gradient_grid, iv, max_small_magnitude)) {
 					vertex_list.push_back(iv);
 					// Don't get any other vertices in this direction.
 					break;
@@ -1656,7 +1739,7 @@ void SHARPISO::get_vertices_with_large_gradient_magnitudes
 						VERTEX_INDEX iv = iv0 + vertex_increment;
 						k++;
 
-						if (gradient_grid.IsMagnitudeGT(iv, max_small_magnitude)) {
+						if (is_gradient_magnitude_gt(gradient_grid, iv, max_small_magnitude)) {
 							vertex_list.push_back(iv);
 							// Don't get any other vertices in this direction.
 							break;
@@ -1800,7 +1883,7 @@ void SHARPISO::get_ie_endpoints_in_large_neighborhood_old_version
 				VERTEX_INDEX kv2 = subgrid.PrevVertex(kv, d);
 				if (!visited.Scalar(kv2)) {
 					VERTEX_INDEX iv2 = subgrid.Scalar(kv2);
-					if (!gradient_grid.IsMagnitudeGT(iv2, max_small_magnitude)) {
+					if (!is_gradient_magnitude_gt(gradient_grid, iv2, max_small_magnitude)) {
 						visited.Set(kv2, true);
 						vlist2.push_back(kv2);
 					}
@@ -1813,7 +1896,7 @@ void SHARPISO::get_ie_endpoints_in_large_neighborhood_old_version
 				VERTEX_INDEX kv2 = subgrid.NextVertex(kv, d);
 				if (!visited.Scalar(kv2)) {
 					VERTEX_INDEX iv2 = subgrid.Scalar(kv2);
-					if (!gradient_grid.IsMagnitudeGT(iv2, max_small_magnitude)) {
+					if (!is_gradient_magnitude_gt(gradient_grid, iv2, max_small_magnitude)) {
 						visited.Set(kv2, true);
 						vlist2.push_back(kv2);
 					}
@@ -1853,112 +1936,152 @@ void SHARPISO::get_ie_endpoints_in_large_neighborhood
 	const VERTEX_INDEX cube_index,
 	const GET_GRADIENTS_PARAM & gradient_param,
 	std::vector<VERTEX_INDEX> & vertex_list)
+{
+	GET_GRADIENTS_SCRATCH scratch;
+
+	get_ie_endpoints_in_large_neighborhood
+		(scalar_grid, gradient_grid, isovalue, cube_index, gradient_param,
+		scratch, vertex_list);
+}
+
+// Get intersected edge endpoints in large neighborhood.
+// Version using scratch memory.
+// Search the region around the cube directly in scalar_grid.
+// Region vertices are indexed by scratch.region_visited.
+void SHARPISO::get_ie_endpoints_in_large_neighborhood
+	(const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
+	const GRADIENT_GRID_BASE & gradient_grid,
+	const SCALAR_TYPE isovalue,
+	const VERTEX_INDEX cube_index,
+	const GET_GRADIENTS_PARAM & gradient_param,
+	GET_GRADIENTS_SCRATCH & scratch,
+	std::vector<VERTEX_INDEX> & vertex_list)
 {
 	typedef SHARPISO_SCALAR_GRID_BASE::DIMENSION_TYPE DTYPE;
 
-	const DTYPE dimension = scalar_grid.Dimension();
 	const NUM_TYPE max_grad_dist = gradient_param.max_grad_dist;
 	const GRADIENT_COORD_TYPE max_small_magnitude =
 		gradient_param.max_small_magnitude;
-	VERTEX_INDEX region_iv0, subgrid_cube_index;
-	IJK::ARRAY<AXIS_SIZE_TYPE> region_axis_size(dimension);
-	std::vector<VERTEX_INDEX> vlist2;
+	SHARPISO_BOOL_GRID & visited = scratch.region_visited;
+	std::vector<VERTEX_INDEX> & vlist2 = scratch.vertex_stack;
+	AXIS_SIZE_TYPE cube_coord[DIM3];
+	AXIS_SIZE_TYPE region_iv0_coord[DIM3];
+	AXIS_SIZE_TYPE region_axis_size[DIM3];
+	AXIS_SIZE_TYPE region_cube_coord[DIM3];
 	long boundary_bits, boundary_bits2;
 
 	vertex_list.clear();
+	vlist2.clear();
 
 	get_cube_vertices_with_large_gradients
 		(scalar_grid, gradient_grid, cube_index, max_small_magnitude,
 		vertex_list);
 
-	IJK::compute_region_around_cube
-		(cube_index, dimension, scalar_grid.AxisSize(), max_grad_dist,
-		region_iv0, region_axis_size.Ptr());
-
-	SHARPISO_INDEX_GRID subgrid(dimension, region_axis_size.PtrConst());
-	subgrid.SetToVertexIndices(scalar_grid, region_iv0);
+	// Compute region around cube as in IJK::compute_region_around_cube.
+	scalar_grid.ComputeCoord(cube_index, cube_coord);
+	for (DTYPE d = 0; d < DIM3; d++) {
+		if (cube_coord[d] > max_grad_dist) 
+			{ region_iv0_coord[d] = cube_coord[d]-max_grad_dist; }
+		else
+			{ region_iv0_coord[d] = 0; }
+
+		AXIS_SIZE_TYPE c = cube_coord[d]+max_grad_dist+2;
+		if (c <= scalar_grid.AxisSize(d)) 
+			{ region_axis_size[d] = c-region_iv0_coord[d]; }
+		else 
+			{ region_axis_size[d] = scalar_grid.AxisSize(d)-region_iv0_coord[d]; }
 
-	// Locate subgrid_cube_index
-	subgrid_cube_index = 0;
-	for (VERTEX_INDEX iv = 0; iv < subgrid.NumVertices(); iv++) {
-		if (subgrid.Scalar(iv) == cube_index)
-		{ subgrid_cube_index = iv; }
+		region_cube_coord[d] = cube_coord[d]-region_iv0_coord[d];
 	}
 
-	SHARPISO_BOOL_GRID visited;
-	visited.SetSize(subgrid);
+	const VERTEX_INDEX region_iv0 = 
+		scalar_grid.ComputeVertexIndex(region_iv0_coord);
 
+	// Reallocates only if region size changes.
+	visited.SetSize(DIM3, region_axis_size);
 	visited.SetAll(false);
 
+	const VERTEX_INDEX region_cube_index = 
+		visited.ComputeVertexIndex(region_cube_coord);
+
 	for (NUM_TYPE k = 0; k < NUM_CUBE_VERTICES3D; k++) {
-		VERTEX_INDEX kv = subgrid.CubeVertex(subgrid_cube_index, k);
+		VERTEX_INDEX kv = visited.CubeVertex(region_cube_index, k);
+		VERTEX_INDEX iv = scalar_grid.CubeVertex(cube_index, k);
 		visited.Set(kv, true);
 		vlist2.push_back(kv);
+		vlist2.push_back(iv);
 	}
 
-	SHARPISO_SCALAR_GRID scalar_subgrid;
-	scalar_subgrid.SetSize(subgrid);
-
-	scalar_subgrid.CopyRegion
-		(scalar_grid, region_iv0, scalar_subgrid.AxisSize(), 0);
-
 	while (vlist2.size() != 0) {
+		VERTEX_INDEX iv = vlist2.back();
+		vlist2.pop_back();
 		VERTEX_INDEX kv = vlist2.back();
 		vlist2.pop_back();
 
-		subgrid.ComputeBoundaryBits(kv, boundary_bits);
+		visited.ComputeBoundaryBits(kv, boundary_bits);
 
-		for (DTYPE d = 0; d < dimension; d++) {
+		for (DTYPE d = 0; d < DIM3; d++) {
 
 			long mask = (1L << (2*d));
 			long bit = (boundary_bits & mask);
 			if (bit == 0) {
-				VERTEX_INDEX kv2 = subgrid.PrevVertex(kv, d);
+				VERTEX_INDEX kv2 = visited.PrevVertex(kv, d);
 				if (!visited.Scalar(kv2)) {
-          subgrid.ComputeBoundaryBits(kv2, boundary_bits2);
-          if (is_adjacent_to_bipolar_edge
-              (scalar_subgrid, isovalue, kv2, boundary_bits2)) {
-
-            VERTEX_INDEX iv2 = subgrid.Scalar(kv2);
-            if (!gradient_grid.IsMagnitudeGT(iv2, max_small_magnitude)) {
-              visited.Set(kv2, true);
-              vlist2.push_back(kv2);
-            }
-          }
+					VERTEX_INDEX iv2 = scalar_grid.PrevVertex(iv, d);
+					visited.ComputeBoundaryBits(kv2, boundary_bits2);
+					if (is_adjacent_to_bipolar_edge
+						(scalar_grid, isovalue, iv2, boundary_bits2)) {
+
+						if (!is_gradient_magnitude_gt(gradient_grid, iv2, max_small_magnitude)) {
+							visited.Set(kv2, true);
+							vlist2.push_back(kv2);
+							vlist2.push_back(iv2);
+						}
+					}
 				}
 			}
 
 			mask = (1L << (2*d+1));
 			bit = (boundary_bits & mask);
 			if (bit == 0) {
-				VERTEX_INDEX kv2 = subgrid.NextVertex(kv, d);
-        subgrid.ComputeBoundaryBits(kv2, boundary_bits2);
+				VERTEX_INDEX kv2 = visited.NextVertex(kv, d);
 				if (!visited.Scalar(kv2)) {
-          subgrid.ComputeBoundaryBits(kv2, boundary_bits2);
-          if (is_adjacent_to_bipolar_edge
-              (scalar_subgrid, isovalue, kv2, boundary_bits2)) {
-
-            VERTEX_INDEX iv2 = subgrid.Scalar(kv2);
-            if (!gradient_grid.IsMagnitudeGT(iv2, max_small_magnitude)) {
-              visited.Set(kv2, true);
-              vlist2.push_back(kv2);
-            }
+					VERTEX_INDEX iv2 = scalar_grid.NextVertex(iv, d);
+					visited.ComputeBoundaryBits(kv2, boundary_bits2);
+					if (is_adjacent_to_bipolar_edge
+						(scalar_grid, isovalue, iv2, boundary_bits2)) {
+
+						if (!is_gradient_magnitude_gt(gradient_grid, iv2, max_small_magnitude)) {
+							visited.Set(kv2, true);
+							vlist2.push_back(kv2);
+							vlist2.push_back(iv2);
+						}
 					}
 				}
 			}
 		}
 	}
 
-	for (VERTEX_INDEX kv = 0; kv < subgrid.NumVertices(); kv++) {
-		if (!visited.Scalar(kv)) {
-			subgrid.ComputeBoundaryBits(kv, boundary_bits);
+	// Visit region vertices in order of region vertex index.
+	VERTEX_INDEX kv = 0;
+	for (AXIS_SIZE_TYPE z = 0; z < region_axis_size[2]; z++) {
+		for (AXIS_SIZE_TYPE y = 0; y < region_axis_size[1]; y++) {
+			VERTEX_INDEX iv = region_iv0 + z*scalar_grid.AxisIncrement(2)
+				+ y*scalar_grid.AxisIncrement(1);
+			for (AXIS_SIZE_TYPE x = 0; x < region_axis_size[0]; x++) {
 
-			if (is_adjacent_to_visited(visited, kv, boundary_bits) &&
-				is_adjacent_to_bipolar_edge
-				(scalar_subgrid, isovalue, kv, boundary_bits)) {
+				if (!visited.Scalar(kv)) {
+					visited.ComputeBoundaryBits(kv, boundary_bits);
 
-					VERTEX_INDEX iv = subgrid.Scalar(kv);
-					vertex_list.push_back(iv);
+					if (is_adjacent_to_visited(visited, kv, boundary_bits) &&
+						is_adjacent_to_bipolar_edge
+						(scalar_grid, isovalue, iv, boundary_bits)) {
+							vertex_list.push_back(iv);
+					}
+				}
+
+				kv++;
+				iv++;
 			}
 		}
 	}
@@ -2029,8 +2152,7 @@ void SHARPISO::sort_vertices_by_isoplane_dist2cc
 {
 	typedef SHARPISO_SCALAR_GRID::DIMENSION_TYPE DTYPE;
 
-	// static so not reallocated at each call
-	static COORD_TYPE cube_center[DIM3];
+	COORD_TYPE cube_center[DIM3];
 
 	scalar_grid.ComputeCoord(cube_index, cube_center);
 
@@ -2108,7 +2230,7 @@ void SHARPISO::deselect_vertices_with_small_gradients
 
 			VERTEX_INDEX iv = vertex_list[i];
 			GRADIENT_COORD_TYPE mag_squared = 
-				gradient_grid.ComputeMagnitudeSquared(iv);
+				compute_gradient_magnitude_squared(gradient_grid, iv);
 
 			if (mag_squared <= max_small_mag_squared) 
 			{ vertex_flag[i] = false; }
@@ -2149,9 +2271,8 @@ void SHARPISO::deselect_vertices_based_on_isoplanes
 {
 	typedef SHARPISO_SCALAR_GRID::DIMENSION_TYPE DTYPE;
 
-	// static so not reallocated at each call
-	static COORD_TYPE vertex_coord[DIM3];
-	static COORD_TYPE coord[DIM3];
+	COORD_TYPE vertex_coord[DIM3];
+	COORD_TYPE coord[DIM3];
 
 	for (NUM_TYPE i = 0; i < num_vertices; i++) {
 
@@ -2164,8 +2285,9 @@ void SHARPISO::deselect_vertices_based_on_isoplanes
 				coord[d] = vertex_coord[d] - cube_coord[d] + voxel.OffsetFactor();
 				coord[d] *= scalar_grid.Spacing(d); 
 			}
+			GRADIENT_COORD_TYPE gradient_buffer[DIM3];
 			const GRADIENT_COORD_TYPE * vertex_gradient_coord =
-				gradient_grid.VectorPtrConst(iv);
+				get_vertex_gradient(gradient_grid, iv, gradient_buffer);
 			SCALAR_TYPE s = scalar_grid.Scalar(iv);
 
 			if (!iso_intersects_cube
@@ -2278,6 +2400,38 @@ void SHARPISO::OFFSET_VOXEL::SetVertexCoord
 }
 
 
+// **************************************************
+// GET_GRADIENTS_SCRATCH
+// **************************************************
+
+void SHARPISO::GET_GRADIENTS_SCRATCH::Init()
+{
+	vertex_flag = NULL;
+	vertex_flag_length = 0;
+}
+
+void SHARPISO::GET_GRADIENTS_SCRATCH::FreeAll()
+{
+	delete [] vertex_flag;
+	vertex_flag = NULL;
+	vertex_flag_length = 0;
+}
+
+/// Return array of at least num_vertices flags.
+/// Reallocate only if num_vertices is larger than any previous request.
+bool * SHARPISO::GET_GRADIENTS_SCRATCH::VertexFlag
+	(const NUM_TYPE num_vertices)
+{
+	if (num_vertices > vertex_flag_length) {
+		delete [] vertex_flag;
+		vertex_flag = new bool[num_vertices];
+		vertex_flag_length = num_vertices;
+	}
+
+	return(vertex_flag);
+}
+
+
 // **************************************************
 // GET_GRADIENTS_PARAM
 // **************************************************
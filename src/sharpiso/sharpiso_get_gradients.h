@@ -44,6 +44,7 @@ namespace SHARPISO {
 
   class OFFSET_VOXEL;
   class GET_GRADIENTS_PARAM;
+  class GET_GRADIENTS_SCRATCH;
   
   // **************************************************
   // ROUTINES TO GET GRADIENTS
@@ -132,6 +133,21 @@ namespace SHARPISO {
    std::vector<SCALAR_TYPE> & scalar,
    NUM_TYPE & num_gradients);
 
+  /// Get gradients in cube and neighboring cubes.
+  /// Version using scratch memory.  Gradients are returned in
+  ///   scratch.point_coord, scratch.gradient_coord and scratch.scalar.
+  /// Reusing scratch for many cubes avoids allocating memory for each cube.
+  void get_gradients
+  (const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
+   const GRADIENT_GRID_BASE & gradient_grid,
+   const VERTEX_INDEX cube_index,
+   const SCALAR_TYPE isovalue,
+   const GET_GRADIENTS_PARAM & sharpiso_param,
+   const OFFSET_VOXEL & voxel,
+   const bool flag_sort_gradients,
+   GET_GRADIENTS_SCRATCH & scratch,
+   NUM_TYPE & num_gradients);
+
   /// Get gradients from two cubes sharing a facet.
   /// Used in getting gradients around a facet.
   /// @param sharpiso_param Determines which gradients are selected.
@@ -242,6 +258,21 @@ namespace SHARPISO {
    std::vector<SCALAR_TYPE> & scalar,
    NUM_TYPE & num_gradients);
 
+  /// Get gradients from list of edge-isosurface intersections.
+  /// Version using sparse edge index.
+  void get_gradients_from_list
+  (const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
+   const std::vector<COORD_TYPE> & edgeI_coord,
+   const std::vector<GRADIENT_COORD_TYPE> & edgeI_normal_coord,
+   const SHARPISO_EDGE_INDEX_HASH & edge_index,
+   const VERTEX_INDEX cube_index,
+   const SCALAR_TYPE isovalue,
+   const GET_GRADIENTS_PARAM & sharpiso_param,
+   std::vector<COORD_TYPE> & point_coord,
+   std::vector<GRADIENT_COORD_TYPE> & gradient_coord,
+   std::vector<SCALAR_TYPE> & scalar,
+   NUM_TYPE & num_gradients);
+
   // **************************************************
   // GET VERTICES
   // **************************************************
@@ -370,6 +401,18 @@ namespace SHARPISO {
    const GET_GRADIENTS_PARAM & gradient_param,
    std::vector<VERTEX_INDEX> & vertex_list);
 
+  /// Get intersected edge endpoints in large neighborhood.
+  /// Version using scratch memory.
+  /// @pre vertex_list is not scratch.vertex_stack.
+  void get_ie_endpoints_in_large_neighborhood
+	(const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
+   const GRADIENT_GRID_BASE & gradient_grid,
+   const SCALAR_TYPE isovalue,
+   const VERTEX_INDEX cube_index,
+   const GET_GRADIENTS_PARAM & gradient_param,
+   GET_GRADIENTS_SCRATCH & scratch,
+   std::vector<VERTEX_INDEX> & vertex_list);
+
   // **************************************************
   // SORT VERTICES
   // **************************************************
@@ -527,6 +570,55 @@ namespace SHARPISO {
       (const GRAD_SELECTION_METHOD grad_selection_method);
   };
 
+  // **************************************************
+  // GET_GRADIENTS_SCRATCH
+  // **************************************************
+
+  /// Scratch memory for getting gradients.
+  /// Arrays grow to fit the largest neighborhood and are never shrunk,
+  ///   so reusing the scratch for many cubes avoids allocating
+  ///   memory for each cube.
+  /// Not thread safe.  Use a separate scratch in each thread.
+  class GET_GRADIENTS_SCRATCH {
+
+  protected:
+    bool * vertex_flag;
+    NUM_TYPE vertex_flag_length;
+
+    void Init();
+    void FreeAll();
+
+  public:
+
+    /// Gradients returned by get_gradients.
+    std::vector<COORD_TYPE> point_coord;
+    std::vector<GRADIENT_COORD_TYPE> gradient_coord;
+    std::vector<SCALAR_TYPE> scalar;
+
+    /// List of vertices whose gradients are selected.
+    std::vector<VERTEX_INDEX> vertex_list;
+
+    /// Stack of (region vertex, grid vertex) pairs
+    ///   used in large neighborhood search.
+    std::vector<VERTEX_INDEX> vertex_stack;
+
+    /// Visited flags for region around cube.
+    SHARPISO_BOOL_GRID region_visited;
+
+  public:
+    GET_GRADIENTS_SCRATCH() { Init(); };
+    ~GET_GRADIENTS_SCRATCH() { FreeAll(); };
+
+    /// Return array of at least num_vertices flags.
+    /// Contents of the array are undefined.
+    bool * VertexFlag(const NUM_TYPE num_vertices);
+
+  private:
+    GET_GRADIENTS_SCRATCH(const GET_GRADIENTS_SCRATCH &);  // do not implement
+    const GET_GRADIENTS_SCRATCH & operator =
+      (const GET_GRADIENTS_SCRATCH &);                     // do not implement
+  };
+
   // **************************************************
   // VOXEL
   // **************************************************
@@ -0,0 +1,406 @@
+/// \file sharpiso_qef_batch.cxx
+/// Solve batches of Lindstrom 3x3 systems.
+/// Systems are stored as structure of arrays.
+/// Version v0.1.1
+
+/*
+ Copyright (C) 2015 Arindam Bhattacharya and Rephael Wenger
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public License
+ (LGPL) as published by the Free Software Foundation; either
+ version 2.1 of the License, or any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+
+#include <cmath>
+
+#include "sharpiso_qef_batch.h"
+
+using namespace SHARPISO;
+
+
+// Runtime selection of instruction set is only implemented
+//   for gcc/clang on x86.  Other compilers use the generic version.
+#if (defined(__GNUC__) || defined(__clang__)) && \
+  (defined(__x86_64__) || defined(__i386__))
+#define SHARPISO_QEF_BATCH_X86_DISPATCH
+#define QEF_BATCH_INLINE inline __attribute__((always_inline))
+#else
+#define QEF_BATCH_INLINE inline
+#endif
+
+
+// **************************************************
+// CLASS QEF_BATCH MEMBER FUNCTIONS
+// **************************************************
+
+NUM_TYPE QEF_BATCH::AddSystem
+(const COORD_TYPE A3x3[DIM3*DIM3], const COORD_TYPE b3[DIM3],
+ const COORD_TYPE pointX3[DIM3])
+{
+  const NUM_TYPE k = num_systems;
+
+  A[0][k] = A3x3[0];
+  A[1][k] = A3x3[1];
+  A[2][k] = A3x3[2];
+  A[3][k] = A3x3[4];
+  A[4][k] = A3x3[5];
+  A[5][k] = A3x3[8];
+
+  for (int d = 0; d < DIM3; d++) {
+    b[d][k] = b3[d];
+    pointX[d][k] = pointX3[d];
+  }
+
+  num_systems++;
+  return(k);
+}
+
+NUM_TYPE QEF_BATCH::AddEmptySystem(const COORD_TYPE pointX3[DIM3])
+{
+  const NUM_TYPE k = num_systems;
+
+  for (int i = 0; i < NUM_SYM_ENTRIES; i++)
+    { A[i][k] = 0; }
+
+  for (int d = 0; d < DIM3; d++) {
+    b[d][k] = 0;
+    pointX[d][k] = pointX3[d];
+  }
+
+  num_systems++;
+  return(k);
+}
+
+void QEF_BATCH::GetSolution
+(const NUM_TYPE k, NUM_TYPE & num_sval,
+ EIGENVALUE_TYPE sval[DIM3], COORD_TYPE x[DIM3],
+ COORD_TYPE edge_dir[DIM3], COORD_TYPE orth_dir[DIM3]) const
+{
+  num_sval = num_singular_vals[k];
+  for (int d = 0; d < DIM3; d++) {
+    sval[d] = singular_vals[d][k];
+    x[d] = coord[d][k];
+    edge_dir[d] = edge_direction[d][k];
+    orth_dir[d] = orth_direction[d][k];
+  }
+}
+
+
+// **************************************************
+// SOLVE QEF BATCH
+// **************************************************
+
+namespace {
+
+  const int N = QEF_BATCH::BATCH_SIZE;
+
+  /// Number of sweeps of Jacobi rotations.
+  /// Four sweeps reduce off-diagonal entries of 3x3 matrices
+  ///   below float precision.
+  const int NUM_JACOBI_SWEEPS_3x3 = 5;
+
+  /// Apply Jacobi rotation zeroing apq in all lanes.
+  /// @param arp, arq Entries (r,p) and (r,q) where r is the third index.
+  /// @param vp, vq Columns p and q of the eigenvector matrix.
+  QEF_BATCH_INLINE void jacobi_rotate_batch
+  (float * app, float * aqq, float * apq, float * arp, float * arq,
+   float * vp[DIM3], float * vq[DIM3])
+  {
+    for (int k = 0; k < N; k++) {
+      const float x = apq[k];
+      const float denom = ((x == 0) ? 1.0f : 2.0f*x);
+      const float theta = (aqq[k] - app[k])/denom;
+      float t = 1.0f/(std::abs(theta) + std::sqrt(theta*theta+1.0f));
+      t = ((theta < 0) ? -t : t);
+      t = ((x == 0) ? 0.0f : t);
+      const float c = 1.0f/std::sqrt(t*t+1.0f);
+      const float s = t*c;
+
+      app[k] -= t*x;
+      aqq[k] += t*x;
+      apq[k] = 0;
+
+      const float rp = arp[k];
+      const float rq = arq[k];
+      arp[k] = c*rp - s*rq;
+      arq[k] = s*rp + c*rq;
+
+      for (int i = 0; i < DIM3; i++) {
+        const float ip = vp[i][k];
+        const float iq = vq[i][k];
+        vp[i][k] = c*ip - s*iq;
+        vq[i][k] = s*ip + c*iq;
+      }
+    }
+  }
+
+  /// Swap eigenvalues (and eigenvectors) j0 and j1 in lanes
+  ///   where |eigenvalue j1| > |eigenvalue j0|.
+  QEF_BATCH_INLINE void compare_and_swap_batch
+  (const int j0, const int j1, float lambda[DIM3][N], float V[DIM3][DIM3][N])
+  {
+    for (int k = 0; k < N; k++) {
+      const bool flag_swap =
+        (std::abs(lambda[j1][k]) > std::abs(lambda[j0][k]));
+      const float x0 = lambda[j0][k];
+      const float x1 = lambda[j1][k];
+      lambda[j0][k] = (flag_swap ? x1 : x0);
+      lambda[j1][k] = (flag_swap ? x0 : x1);
+
+      for (int i = 0; i < DIM3; i++) {
+        const float v0 = V[i][j0][k];
+        const float v1 = V[i][j1][k];
+        V[i][j0][k] = (flag_swap ? v1 : v0);
+        V[i][j1][k] = (flag_swap ? v0 : v1);
+      }
+    }
+  }
+
+  /// Normalize vectors in all lanes.  Zero vectors are unchanged.
+  QEF_BATCH_INLINE void normalize_batch(COORD_TYPE w[DIM3][N])
+  {
+    for (int k = 0; k < N; k++) {
+      const float mag_squared =
+        w[0][k]*w[0][k] + w[1][k]*w[1][k] + w[2][k]*w[2][k];
+      const float scale =
+        ((mag_squared > 0) ? 1.0f/std::sqrt(mag_squared) : 1.0f);
+      w[0][k] *= scale;
+      w[1][k] *= scale;
+      w[2][k] *= scale;
+    }
+  }
+
+  /// Solve all systems in qef_batch.
+  /// Every step is applied to all lanes, without lane dependent branches,
+  ///   so that loops over lanes can be vectorized.
+  QEF_BATCH_INLINE void solve_qef_batch_body
+  (const EIGENVALUE_TYPE err_tolerance, QEF_BATCH & qef_batch)
+  {
+    alignas(64) float a00[N], a01[N], a02[N], a11[N], a12[N], a22[N];
+    alignas(64) float lambda[DIM3][N];
+    alignas(64) float V[DIM3][DIM3][N];
+    alignas(64) float inv_lambda[DIM3][N];
+    alignas(64) float P[DIM3][DIM3][N];
+    alignas(64) float r[DIM3][N];
+
+    for (int k = 0; k < N; k++) {
+      a00[k] = qef_batch.A[0][k];
+      a01[k] = qef_batch.A[1][k];
+      a02[k] = qef_batch.A[2][k];
+      a11[k] = qef_batch.A[3][k];
+      a12[k] = qef_batch.A[4][k];
+      a22[k] = qef_batch.A[5][k];
+    }
+
+    for (int i = 0; i < DIM3; i++) {
+      for (int j = 0; j < DIM3; j++) {
+        for (int k = 0; k < N; k++)
+          { V[i][j][k] = ((i == j) ? 1.0f : 0.0f); }
+      }
+    }
+
+    float * vcol[DIM3][DIM3];
+    for (int j = 0; j < DIM3; j++) {
+      for (int i = 0; i < DIM3; i++)
+        { vcol[j][i] = V[i][j]; }
+    }
+
+    for (int isweep = 0; isweep < NUM_JACOBI_SWEEPS_3x3; isweep++) {
+      jacobi_rotate_batch(a00, a11, a01, a02, a12, vcol[0], vcol[1]);
+      jacobi_rotate_batch(a00, a22, a02, a01, a12, vcol[0], vcol[2]);
+      jacobi_rotate_batch(a11, a22, a12, a01, a02, vcol[1], vcol[2]);
+    }
+
+    for (int k = 0; k < N; k++) {
+      lambda[0][k] = a00[k];
+      lambda[1][k] = a11[k];
+      lambda[2][k] = a22[k];
+    }
+
+    // Sort by decreasing absolute value.
+    compare_and_swap_batch(0, 1, lambda, V);
+    compare_and_swap_batch(1, 2, lambda, V);
+    compare_and_swap_batch(0, 1, lambda, V);
+
+    // Set small singular values to zero.
+    for (int k = 0; k < N; k++) {
+      const float max_small = err_tolerance * std::abs(lambda[0][k]);
+      NUM_TYPE num_sval = 0;
+
+      for (int j = 0; j < DIM3; j++) {
+        const float s = std::abs(lambda[j][k]);
+        const bool flag_large = (s > 0 && s > max_small);
+        const float x = (flag_large ? lambda[j][k] : 1.0f);
+        inv_lambda[j][k] = (flag_large ? 1.0f/x : 0.0f);
+        qef_batch.singular_vals[j][k] = (flag_large ? s : 0.0f);
+        num_sval += (flag_large ? 1 : 0);
+      }
+      qef_batch.num_singular_vals[k] = num_sval;
+    }
+
+    // P = A pseudo-inverse = V * diag(inv_lambda) * V^T.
+    for (int i = 0; i < DIM3; i++) {
+      for (int j = 0; j < DIM3; j++) {
+        for (int k = 0; k < N; k++) {
+          P[i][j][k] =
+            V[i][0][k]*inv_lambda[0][k]*V[j][0][k] +
+            V[i][1][k]*inv_lambda[1][k]*V[j][1][k] +
+            V[i][2][k]*inv_lambda[2][k]*V[j][2][k];
+        }
+      }
+    }
+
+    // coord = pointX + P*(b - A*pointX).
+    const float * Aij[DIM3][DIM3] =
+      { { qef_batch.A[0], qef_batch.A[1], qef_batch.A[2] },
+        { qef_batch.A[1], qef_batch.A[3], qef_batch.A[4] },
+        { qef_batch.A[2], qef_batch.A[4], qef_batch.A[5] } };
+
+    for (int i = 0; i < DIM3; i++) {
+      for (int k = 0; k < N; k++) {
+        r[i][k] = qef_batch.b[i][k]
+          - Aij[i][0][k]*qef_batch.pointX[0][k]
+          - Aij[i][1][k]*qef_batch.pointX[1][k]
+          - Aij[i][2][k]*qef_batch.pointX[2][k];
+      }
+    }
+
+    for (int i = 0; i < DIM3; i++) {
+      for (int k = 0; k < N; k++) {
+        qef_batch.coord[i][k] = qef_batch.pointX[i][k]
+          + P[i][0][k]*r[0][k] + P[i][1][k]*r[1][k] + P[i][2][k]*r[2][k];
+      }
+    }
+
+    // Orthogonal direction is the eigenvector of the largest eigenvalue.
+    for (int i = 0; i < DIM3; i++) {
+      for (int k = 0; k < N; k++) {
+        const bool flag_one = (qef_batch.num_singular_vals[k] == 1);
+        qef_batch.orth_direction[i][k] = (flag_one ? V[i][0][k] : 0.0f);
+      }
+    }
+    normalize_batch(qef_batch.orth_direction);
+
+    // Edge direction is the row of (I - P*A) with largest magnitude.
+    for (int k = 0; k < N; k++) {
+      float max_magnitude_squared = -1;
+      float edge_dir[DIM3] = { 0, 0, 0 };
+
+      for (int i = 0; i < DIM3; i++) {
+        float row[DIM3];
+        for (int j = 0; j < DIM3; j++) {
+          row[j] = ((i == j) ? 1.0f : 0.0f)
+            - P[i][0][k]*Aij[0][j][k] - P[i][1][k]*Aij[1][j][k]
+            - P[i][2][k]*Aij[2][j][k];
+        }
+        const float mag_squared =
+          row[0]*row[0] + row[1]*row[1] + row[2]*row[2];
+        const bool flag_max = (mag_squared > max_magnitude_squared);
+        max_magnitude_squared =
+          (flag_max ? mag_squared : max_magnitude_squared);
+        for (int j = 0; j < DIM3; j++)
+          { edge_dir[j] = (flag_max ? row[j] : edge_dir[j]); }
+      }
+
+      const bool flag_two = (qef_batch.num_singular_vals[k] == 2);
+      for (int j = 0; j < DIM3; j++) {
+        qef_batch.edge_direction[j][k] = (flag_two ? edge_dir[j] : 0.0f);
+      }
+    }
+    normalize_batch(qef_batch.edge_direction);
+  }
+
+  typedef void (*SOLVE_QEF_BATCH_FUNCTION)
+  (const EIGENVALUE_TYPE, QEF_BATCH &);
+
+  void solve_qef_batch_generic
+  (const EIGENVALUE_TYPE err_tolerance, QEF_BATCH & qef_batch)
+  {
+    solve_qef_batch_body(err_tolerance, qef_batch);
+  }
+
+#ifdef SHARPISO_QEF_BATCH_X86_DISPATCH
+
+  __attribute__((target("avx2,fma")))
+  void solve_qef_batch_avx2
+  (const EIGENVALUE_TYPE err_tolerance, QEF_BATCH & qef_batch)
+  {
+    solve_qef_batch_body(err_tolerance, qef_batch);
+  }
+
+  __attribute__((target("avx512f")))
+  void solve_qef_batch_avx512
+  (const EIGENVALUE_TYPE err_tolerance, QEF_BATCH & qef_batch)
+  {
+    solve_qef_batch_body(err_tolerance, qef_batch);
+  }
+
+#endif
+
+  /// Instruction set selected at run time.
+  class QEF_BATCH_SOLVER {
+
+  public:
+    SOLVE_QEF_BATCH_FUNCTION solve;
+    const char * isa;
+
+    QEF_BATCH_SOLVER()
+    {
+      solve = solve_qef_batch_generic;
+      isa = "generic";
+
+#ifdef SHARPISO_QEF_BATCH_X86_DISPATCH
+      __builtin_cpu_init();
+      if (__builtin_cpu_supports("avx512f")) {
+        solve = solve_qef_batch_avx512;
+        isa = "avx512f";
+      }
+      else if (__builtin_cpu_supports("avx2") &&
+               __builtin_cpu_supports("fma")) {
+        solve = solve_qef_batch_avx2;
+        isa = "avx2";
+      }
+#endif
+    }
+  };
+
+  const QEF_BATCH_SOLVER & qef_batch_solver()
+  {
+    // Initialized once, on first call.
+    static const QEF_BATCH_SOLVER solver;
+    return(solver);
+  }
+
+}
+
+void SHARPISO::solve_qef_batch
+(const EIGENVALUE_TYPE err_tolerance, QEF_BATCH & qef_batch)
+{
+  // Unused lanes hold empty systems.
+  for (NUM_TYPE k = qef_batch.NumSystems(); k < QEF_BATCH::BATCH_SIZE; k++) {
+    for (int i = 0; i < QEF_BATCH::NUM_SYM_ENTRIES; i++)
+      { qef_batch.A[i][k] = 0; }
+    for (int d = 0; d < DIM3; d++) {
+      qef_batch.b[d][k] = 0;
+      qef_batch.pointX[d][k] = 0;
+    }
+  }
+
+  qef_batch_solver().solve(err_tolerance, qef_batch);
+}
+
+const char * SHARPISO::get_qef_batch_isa()
+{
+  return(qef_batch_solver().isa);
+}
@@ -0,0 +1,122 @@
+/// \file sharpiso_qef_batch.h
+/// Solve batches of Lindstrom 3x3 systems.
+/// Systems are stored as structure of arrays.
+/// Version v0.1.1
+
+/*
+ Copyright (C) 2015 Arindam Bhattacharya and Rephael Wenger
+
+ This library is free software; you can redistribute it and/or
+ modify it under the terms of the GNU Lesser General Public License
+ (LGPL) as published by the Free Software Foundation; either
+ version 2.1 of the License, or any later version.
+
+ This library is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ Lesser General Public License for more details.
+
+ You should have received a copy of the GNU Lesser General Public
+ License along with this library; if not, write to the Free Software
+ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#ifndef _SHARPISO_QEF_BATCH_
+#define _SHARPISO_QEF_BATCH_
+
+#include "sharpiso_types.h"
+#include "sharpiso_eigen.h"
+
+
+namespace SHARPISO {
+
+  // **************************************************
+  // CLASS QEF_BATCH
+  // **************************************************
+
+  /// Batch of Lindstrom 3x3 systems A x = b, stored as structure of arrays.
+  /// A is symmetric.  Only the upper triangle of A is stored.
+  /// Array [i][k] holds component i of system (lane) k.
+  class QEF_BATCH {
+
+  public:
+
+    /// Number of systems in a full batch.
+    /// 16 floats fill one AVX-512 register or two AVX2 registers.
+    static const int BATCH_SIZE = 16;
+
+    /// Number of stored entries of symmetric 3x3 matrix.
+    static const int NUM_SYM_ENTRIES = 6;
+
+  protected:
+    NUM_TYPE num_systems;
+
+  public:
+
+    // Input.
+
+    /// Upper triangle of A, in order a00, a01, a02, a11, a12, a22.
+    alignas(64) COORD_TYPE A[NUM_SYM_ENTRIES][BATCH_SIZE];
+    alignas(64) COORD_TYPE b[DIM3][BATCH_SIZE];
+
+    /// Compute solution closest to pointX.
+    alignas(64) COORD_TYPE pointX[DIM3][BATCH_SIZE];
+
+    // Output.
+
+    alignas(64) COORD_TYPE coord[DIM3][BATCH_SIZE];
+    alignas(64) EIGENVALUE_TYPE singular_vals[DIM3][BATCH_SIZE];
+    alignas(64) COORD_TYPE edge_direction[DIM3][BATCH_SIZE];
+    alignas(64) COORD_TYPE orth_direction[DIM3][BATCH_SIZE];
+    alignas(64) NUM_TYPE num_singular_vals[BATCH_SIZE];
+
+  public:
+    QEF_BATCH() { Clear(); };
+
+    /// Set number of systems to zero.
+    void Clear() { num_systems = 0; };
+
+    NUM_TYPE NumSystems() const
+    { return(num_systems); }
+
+    bool IsFull() const
+    { return(num_systems >= BATCH_SIZE); }
+
+    /// Add system A x = b.  Return lane of new system.
+    /// @param A3x3[] 3x3 symmetric matrix, stored in row major order.
+    /// @pre Batch is not full.
+    NUM_TYPE AddSystem
+    (const COORD_TYPE A3x3[DIM3*DIM3], const COORD_TYPE b3[DIM3],
+     const COORD_TYPE pointX3[DIM3]);
+
+    /// Add empty system (A = 0).  Solution is pointX.
+    /// Used as a placeholder for cubes without gradients.
+    NUM_TYPE AddEmptySystem(const COORD_TYPE pointX3[DIM3]);
+
+    /// Copy solution of system in lane k.
+    void GetSolution
+    (const NUM_TYPE k, NUM_TYPE & num_sval,
+     EIGENVALUE_TYPE sval[DIM3], COORD_TYPE x[DIM3],
+     COORD_TYPE edge_dir[DIM3], COORD_TYPE orth_dir[DIM3]) const;
+  };
+
+
+  // **************************************************
+  // SOLVE QEF BATCH
+  // **************************************************
+
+  /// Solve all systems in qef_batch.
+  /// Use Jacobi eigen-decomposition of the symmetric matrices with
+  ///   a fixed number of sweeps, applied to all lanes at once.
+  /// Instruction set (AVX-512, AVX2 or generic) is selected at run time.
+  /// @param err_tolerance Singular values less than or equal to
+  ///    err_tolerance times the largest singular value are set to zero.
+  void solve_qef_batch
+  (const EIGENVALUE_TYPE err_tolerance, QEF_BATCH & qef_batch);
+
+  /// Return name of instruction set used by solve_qef_batch.
+  const char * get_qef_batch_isa();
+
+};
+
+#endif
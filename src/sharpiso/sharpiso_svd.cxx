@@ -233,12 +233,257 @@ void compute_sharp_point_lindstrom_3x3
 }
 
 
+// **************************************************
+// SYMMETRIC 3x3 EIGEN-DECOMPOSITION
+// **************************************************
+
+// Compute eigenvalues and eigenvectors of symmetric 3x3 matrix A
+//   using cyclic Jacobi rotations.
+bool compute_sym_eigen_jacobi_3x3
+(const SCALAR_TYPE A[DIM3*DIM3], 
+ double eigenvalues[DIM3], double V[DIM3*DIM3], int & num_sweeps)
+{
+  double a[DIM3][DIM3];
+  bool flag_converged = false;
+
+  for (int i = 0; i < DIM3; i++) {
+    for (int j = i; j < DIM3; j++) {
+      a[i][j] = a[j][i] = A[i*DIM3+j];
+    }
+  }
+
+  for (int i = 0; i < DIM3; i++) {
+    for (int j = 0; j < DIM3; j++) 
+      { V[i*DIM3+j] = ((i == j) ? 1.0 : 0.0); }
+  }
+
+  num_sweeps = 0;
+  while (true) {
+
+    const double off_diag = 
+      std::abs(a[0][1]) + std::abs(a[0][2]) + std::abs(a[1][2]);
+    const double diag = 
+      std::abs(a[0][0]) + std::abs(a[1][1]) + std::abs(a[2][2]);
+
+    if (off_diag == 0 || off_diag <= 1.0e-15*diag) { 
+      flag_converged = true;
+      break; 
+    }
+
+    if (num_sweeps >= MAX_JACOBI_SWEEPS_3x3) { break; }
+    num_sweeps++;
+
+    for (int p = 0; p+1 < DIM3; p++) {
+      for (int q = p+1; q < DIM3; q++) {
+
+        const double apq = a[p][q];
+        if (apq == 0) { continue; }
+
+        // Rotation which zeroes a[p][q].
+        const double theta = (a[q][q] - a[p][p])/(2.0*apq);
+        double t = 1.0/(std::abs(theta) + std::sqrt(theta*theta+1.0));
+        if (theta < 0) { t = -t; }
+        const double c = 1.0/std::sqrt(t*t+1.0);
+        const double sn = t*c;
+
+        a[p][p] -= t*apq;
+        a[q][q] += t*apq;
+        a[p][q] = a[q][p] = 0;
+
+        const int r = DIM3-p-q;       // Third index.
+        const double arp = a[r][p];
+        const double arq = a[r][q];
+        a[r][p] = a[p][r] = c*arp - sn*arq;
+        a[r][q] = a[q][r] = sn*arp + c*arq;
+
+        for (int i = 0; i < DIM3; i++) {
+          const double vip = V[i*DIM3+p];
+          const double viq = V[i*DIM3+q];
+          V[i*DIM3+p] = c*vip - sn*viq;
+          V[i*DIM3+q] = sn*vip + c*viq;
+        }
+      }
+    }
+  }
+
+  for (int k = 0; k < DIM3; k++) 
+    { eigenvalues[k] = a[k][k]; }
+
+  // Sort by decreasing absolute value.
+  for (int k0 = 0; k0+1 < DIM3; k0++) {
+    int kmax = k0;
+    for (int k1 = k0+1; k1 < DIM3; k1++) {
+      if (std::abs(eigenvalues[k1]) > std::abs(eigenvalues[kmax])) 
+        { kmax = k1; }
+    }
+
+    if (kmax != k0) {
+      std::swap(eigenvalues[k0], eigenvalues[kmax]);
+      for (int i = 0; i < DIM3; i++) 
+        { std::swap(V[i*DIM3+k0], V[i*DIM3+kmax]); }
+    }
+  }
+
+  return(flag_converged);
+}
+
+
+/// Compute sharp point using a Jacobi eigen-decomposition
+///   of the symmetric 3x3 matrix A.
+/// Same output as compute_sharp_point_lindstrom_3x3 (up to
+///   floating point error and the sign of the returned directions.)
+/// Does not allocate any memory.
+/// @pre A is symmetric.
+/// @param pointX Compute sharp point closest to pointX.
+/// @param edge_direction[] If num_singular_vals = 2, return sharp edge direction.
+/// @param orth_direction[] If num_singular_vals = 1, return direction orthogonal to surface.
+void compute_sharp_point_lindstrom_3x3_jacobi
+(		const SCALAR_TYPE * A,
+		const SCALAR_TYPE b[3],
+		const EIGENVALUE_TYPE err_tolerance,
+		const COORD_TYPE pointX[DIM3],
+		NUM_TYPE & num_singular_vals,
+		EIGENVALUE_TYPE singular_vals[DIM3],
+		COORD_TYPE isoVertCoords[DIM3],
+    COORD_TYPE edge_direction[DIM3],
+    COORD_TYPE orth_direction[DIM3])
+{
+  double eigenvalues[DIM3];
+  double V[DIM3*DIM3];
+  double sval[DIM3];
+  double inv_sval[DIM3] = { 0, 0, 0 };
+  double A_pseudo_inv[DIM3*DIM3];
+  double r[DIM3];
+  int num_sweeps;
+
+  // Use eigenvalues after MAX_JACOBI_SWEEPS_3x3 sweeps,
+  //   even if off-diagonal entries have not converged.
+  compute_sym_eigen_jacobi_3x3(A, eigenvalues, V, num_sweeps);
+
+  // Singular values of a symmetric matrix are the absolute values
+  //   of its eigenvalues.
+  for (int k = 0; k < DIM3; k++) 
+    { sval[k] = std::abs(eigenvalues[k]); }
+
+  // Set small singular values to zero, 
+  //   as in compute_pseudo_inverse_sigma.
+  const double max_small_singular_value = err_tolerance * sval[0];
+  num_singular_vals = 0;
+  IJK::set_coord_3D(0, singular_vals);
+  for (int k = 0; k < DIM3; k++) {
+    if (sval[k] > 0 && sval[k] > max_small_singular_value) {
+      singular_vals[k] = sval[k];
+      // Sign of eigenvalue accounts for U = V*sign(eigenvalue).
+      inv_sval[k] = 1.0/eigenvalues[k];
+      num_singular_vals++;
+    }
+  }
+
+  // A_pseudo_inv = V * diag(inv_sval) * V^T.
+  for (int i = 0; i < DIM3; i++) {
+    for (int j = 0; j < DIM3; j++) {
+      double x = 0;
+      for (int k = 0; k < DIM3; k++) 
+        { x += V[i*DIM3+k]*inv_sval[k]*V[j*DIM3+k]; }
+      A_pseudo_inv[i*DIM3+j] = x;
+    }
+  }
+
+  // sharp point = pointX + A_pseudo_inv * (b - A*pointX).
+  for (int i = 0; i < DIM3; i++) {
+    double x = b[i];
+    for (int j = 0; j < DIM3; j++) 
+      { x -= double(A[i*DIM3+j])*pointX[j]; }
+    r[i] = x;
+  }
+
+  for (int i = 0; i < DIM3; i++) {
+    double x = pointX[i];
+    for (int j = 0; j < DIM3; j++) 
+      { x += A_pseudo_inv[i*DIM3+j]*r[j]; }
+    isoVertCoords[i] = x;
+  }
+
+  if (num_singular_vals == 1) {
+
+    for (int d = 0; d < DIM3; d++) 
+      { orth_direction[d] = V[d*DIM3+0]; }
+		normalize(orth_direction, orth_direction);
+
+    IJK::set_coord_3D(0, edge_direction);
+  }
+  else if (num_singular_vals == 2) {
+
+    // Edge direction is the row of (I - A_pseudo_inv*A) 
+    //   with largest magnitude, as in compute_edge_direction.
+    double M[DIM3*DIM3];
+    int index = 0;
+    double max_magnitude_squared = -1;
+    for (int i = 0; i < DIM3; i++) {
+      double magnitude_squared = 0;
+      for (int j = 0; j < DIM3; j++) {
+        double x = ((i == j) ? 1.0 : 0.0);
+        for (int k = 0; k < DIM3; k++) 
+          { x -= A_pseudo_inv[i*DIM3+k]*A[k*DIM3+j]; }
+        M[i*DIM3+j] = x;
+        magnitude_squared += x*x;
+      }
+
+      if (magnitude_squared > max_magnitude_squared) {
+        max_magnitude_squared = magnitude_squared;
+        index = i;
+      }
+    }
+
+    for (int d = 0; d < DIM3; d++) 
+      { edge_direction[d] = M[index*DIM3+d]; }
+		normalize(edge_direction, edge_direction);
+
+    IJK::set_coord_3D(0, orth_direction);
+  }
+  else {
+    IJK::set_coord_3D(0, edge_direction);
+    IJK::set_coord_3D(0, orth_direction);
+  }
+}
+
+
+/// Compute sharp point using solver qef_solver.
+/// @param pointX Compute sharp point closest to pointX.
+/// @param edge_direction[] If num_singular_vals = 2, return sharp edge direction.
+/// @param orth_direction[] If num_singular_vals = 1, return direction orthogonal to surface.
+void compute_sharp_point_lindstrom_3x3
+(		const QEF_SOLVER_TYPE qef_solver,
+		SCALAR_TYPE * A,
+		const SCALAR_TYPE b[3],
+		const EIGENVALUE_TYPE err_tolerance,
+		const COORD_TYPE pointX[DIM3],
+		NUM_TYPE & num_singular_vals,
+		EIGENVALUE_TYPE singular_vals[DIM3],
+		COORD_TYPE isoVertCoords[DIM3],
+    COORD_TYPE edge_direction[DIM3],
+    COORD_TYPE orth_direction[DIM3])
+{
+  if (qef_solver == QEF_SOLVER_JACOBI) {
+    compute_sharp_point_lindstrom_3x3_jacobi
+      (A, b, err_tolerance, pointX, num_singular_vals, singular_vals,
+       isoVertCoords, edge_direction, orth_direction);
+  }
+  else {
+    compute_sharp_point_lindstrom_3x3
+      (A, b, err_tolerance, pointX, num_singular_vals, singular_vals,
+       isoVertCoords, edge_direction, orth_direction);
+  }
+}
+
+
 /// Compute sharp point closest to pointX.
 /// If num_singular_vals == 2, compute sharp point on plane
 ///   through pointX with normal plan_normal
 /// @param edge_direction If num_singular_vals = 2, return sharp edge direction.
 void compute_sharp_point_on_plane_lindstrom_3x3
-(		SCALAR_TYPE * A,
+(		const QEF_SOLVER_TYPE qef_solver,
+		SCALAR_TYPE * A,
 		const SCALAR_TYPE _b[3],
 		const EIGENVALUE_TYPE err_tolerance,
 		const COORD_TYPE pointX[DIM3],
@@ -256,8 +501,8 @@ void compute_sharp_point_on_plane_lindstrom_3x3
   COORD_TYPE diff[DIM3];
 
   compute_sharp_point_lindstrom_3x3
-    (A, _b, err_tolerance, pointX, num_singular_vals, singular_vals,
-     isovert_coord, edge_direction, orth_direction);
+    (qef_solver, A, _b, err_tolerance, pointX, num_singular_vals, 
+     singular_vals, isovert_coord, edge_direction, orth_direction);
 
   flag_coord_on_plane = false;
   if (num_singular_vals == 2) {
@@ -294,9 +539,9 @@ void compute_A_B
  COORD_TYPE A[DIM3*DIM3],
  COORD_TYPE B[DIM3])
 {
-	IJK::PROCEDURE_ERROR error("compute_A_B");
-
 	if (num_vert < 1) {
+		// Construct error only when needed.  Avoids allocation for each cube.
+		IJK::PROCEDURE_ERROR error("compute_A_B");
 		error.AddMessage("Programming error. Number of gradients is 0.");
 		throw error;
 	}
@@ -342,6 +587,7 @@ void compute_A_B
 void svd_calculate_sharpiso_vertex_using_lindstrom_fast
 (		const NUM_TYPE num_vert,
 		const EIGENVALUE_TYPE err_tolerance,
+		const QEF_SOLVER_TYPE qef_solver,
 		const SCALAR_TYPE isovalue,
 		const SCALAR_TYPE * vert_scalars,
 		const COORD_TYPE * vert_coords,
@@ -356,9 +602,19 @@ void svd_calculate_sharpiso_vertex_using_lindstrom_fast
   compute_A_B(num_vert, err_tolerance, isovalue, vert_scalars, vert_coords,
               vert_grads, A, B);
 
-	compute_sharp_point_lindstrom_3x3
-    (A, B, err_tolerance, pointX, num_singular_vals, 
-     singular_vals, isovert_coords);
+  if (qef_solver == QEF_SOLVER_JACOBI) {
+    COORD_TYPE edge_direction[DIM3];
+    COORD_TYPE orth_direction[DIM3];
+
+    compute_sharp_point_lindstrom_3x3_jacobi
+      (A, B, err_tolerance, pointX, num_singular_vals, 
+       singular_vals, isovert_coords, edge_direction, orth_direction);
+  }
+  else {
+    compute_sharp_point_lindstrom_3x3
+      (A, B, err_tolerance, pointX, num_singular_vals, 
+       singular_vals, isovert_coords);
+  }
 }
 
 /// Calculate the sharp vertex using svd and the faster garland heckbert way
@@ -367,6 +623,7 @@ void svd_calculate_sharpiso_vertex_using_lindstrom_fast
 void svd_calculate_sharpiso_vertex_using_lindstrom_fast
 (		const NUM_TYPE num_vert,
 		const EIGENVALUE_TYPE err_tolerance,
+		const QEF_SOLVER_TYPE qef_solver,
 		const SCALAR_TYPE isovalue,
 		const SCALAR_TYPE * vert_scalars,
 		const COORD_TYPE * vert_coords,
@@ -383,7 +640,7 @@ void svd_calculate_sharpiso_vertex_using_lindstrom_fast
   compute_A_B(num_vert, err_tolerance, isovalue, vert_scalars, vert_coords,
               vert_grads, A, B);
 	compute_sharp_point_lindstrom_3x3
-    (A, B, err_tolerance, pointX, num_singular_vals, 
+    (qef_solver, A, B, err_tolerance, pointX, num_singular_vals, 
      singular_vals, isovert_coords, edge_direction, orth_direction);
 }
 
@@ -394,6 +651,7 @@ void svd_calculate_sharpiso_vertex_using_lindstrom_fast
 void svd_calculate_sharpiso_vertex_on_plane_using_lindstrom_fast
 (		const NUM_TYPE num_vert,
 		const EIGENVALUE_TYPE err_tolerance,
+		const QEF_SOLVER_TYPE qef_solver,
 		const SCALAR_TYPE isovalue,
 		const SCALAR_TYPE * vert_scalars,
 		const COORD_TYPE * vert_coords,
@@ -411,7 +669,7 @@ void svd_calculate_sharpiso_vertex_on_plane_using_lindstrom_fast
               vert_grads, A, B);
 
 	compute_sharp_point_on_plane_lindstrom_3x3
-    (A, B, err_tolerance, pointX, plane_normal, num_singular_vals, 
+    (qef_solver, A, B, err_tolerance, pointX, plane_normal, num_singular_vals, 
      singular_vals, isovert_coords, flag_coord_on_plane);
 }
 
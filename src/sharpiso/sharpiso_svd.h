@@ -114,9 +114,41 @@ void svd_calculate_sharpiso_vertex_using_lindstrom(
 		NUM_TYPE & num_singular_vals, EIGENVALUE_TYPE singular_vals[DIM3],
     COORD_TYPE isoVertcoords[DIM3]);
 
+/// Compute 3x3 Lindstrom matrix A and vector B from gradients.
+void compute_A_B
+(const NUM_TYPE num_vert,
+ const EIGENVALUE_TYPE err_tolerance,
+ const SCALAR_TYPE isovalue,
+ const SCALAR_TYPE * vert_scalars,
+ const COORD_TYPE * vert_coords,
+ const GRADIENT_COORD_TYPE * vert_grads,
+ COORD_TYPE A[DIM3*DIM3],
+ COORD_TYPE B[DIM3]);
+
+/// Maximum number of sweeps of Jacobi rotations.
+/// Cyclic Jacobi converges quadratically.  
+/// Three or four sweeps are usually enough for 3x3 matrices.
+const int MAX_JACOBI_SWEEPS_3x3 = 12;
+
+/// Compute eigenvalues and eigenvectors of symmetric 3x3 matrix A
+///   using cyclic Jacobi rotations.
+/// Does not allocate any memory.
+/// @param A[] Symmetric matrix.  Only A[i*DIM3+j] for i <= j is used.
+/// @param eigenvalues[] Eigenvalues, sorted in decreasing order
+///   of absolute value.
+/// @param V[] Eigenvectors.  Column k, V[i*DIM3+k], is the eigenvector
+///   of eigenvalues[k].
+/// @param[out] num_sweeps Number of sweeps of Jacobi rotations.
+/// @return True if off-diagonal entries converged to zero
+///   in at most MAX_JACOBI_SWEEPS_3x3 sweeps.
+bool compute_sym_eigen_jacobi_3x3
+(const SCALAR_TYPE A[DIM3*DIM3], 
+ double eigenvalues[DIM3], double V[DIM3*DIM3], int & num_sweeps);
+
 void svd_calculate_sharpiso_vertex_using_lindstrom_fast(
 		const NUM_TYPE num_vert,
 		const EIGENVALUE_TYPE err_tolerance,
+		const QEF_SOLVER_TYPE qef_solver,
 		const SCALAR_TYPE isovalue,
 		const SCALAR_TYPE * vert_scalars,
 		const COORD_TYPE * vert_coords,
@@ -129,6 +161,7 @@ void svd_calculate_sharpiso_vertex_using_lindstrom_fast(
 void svd_calculate_sharpiso_vertex_using_lindstrom_fast(
 		const NUM_TYPE num_vert,
 		const EIGENVALUE_TYPE err_tolerance,
+		const QEF_SOLVER_TYPE qef_solver,
 		const SCALAR_TYPE isovalue,
 		const SCALAR_TYPE * vert_scalars,
 		const COORD_TYPE * vert_coords,
@@ -147,6 +180,7 @@ void svd_calculate_sharpiso_vertex_using_lindstrom_fast(
 void svd_calculate_sharpiso_vertex_on_plane_using_lindstrom_fast
 (		const NUM_TYPE num_vert,
 		const EIGENVALUE_TYPE err_tolerance,
+		const QEF_SOLVER_TYPE qef_solver,
 		const SCALAR_TYPE isovalue,
 		const SCALAR_TYPE * vert_scalars,
 		const COORD_TYPE * vert_coords,
@@ -48,11 +48,64 @@ using namespace std;
 // DUAL CONTOURING
 // **************************************************
 
+/// Set grid region which may intersect the isosurface.
+/// Use the span space index if it is set.
+/// Otherwise, flag bricks whose scalar range contains isovalue.
+void SHREC::set_active_region
+(const SHREC_DATA & shrec_data, const SCALAR_TYPE isovalue,
+ ACTIVE_GRID_REGION & active_region)
+{
+	if (shrec_data.SpanSpaceIndex().IsSet()) {
+		shrec_data.SpanSpaceIndex().GetActiveCubes
+			(isovalue, active_region.cube_list);
+		active_region.is_cube_list_set = true;
+	}
+	else {
+		shrec_data.MinMaxBricks().ComputeActiveBricks
+			(isovalue, active_region.active_brick);
+	}
+}
+
+/// Get active cubes for each isovalue.
+/// Use the span space index if it is set.
+/// Otherwise, find active cubes for all isovalues 
+///   in a single pass over the scalar grid.
+void SHREC::get_active_cubes
+(const SHREC_DATA & shrec_data, const std::vector<SCALAR_TYPE> & isovalue,
+ std::vector< std::vector<VERTEX_INDEX> > & cube_list)
+{
+	if (shrec_data.SpanSpaceIndex().IsSet()) {
+		cube_list.resize(isovalue.size());
+		for (std::size_t i = 0; i < isovalue.size(); i++) {
+			shrec_data.SpanSpaceIndex().GetActiveCubes
+				(isovalue[i], cube_list[i]);
+		}
+	}
+	else {
+		get_active_cubes(shrec_data.ScalarGrid(), isovalue, cube_list);
+	}
+}
+
 /// Dual Contouring Algorithm.
 void SHREC::dual_contouring
 (const SHREC_DATA & shrec_data, const SCALAR_TYPE isovalue,
  DUAL_ISOSURFACE & dual_isosurface, ISOVERT & isovert, 
  SHREC_INFO & shrec_info)
+{
+	ACTIVE_GRID_REGION active_region;
+
+	set_active_region(shrec_data, isovalue, active_region);
+	dual_contouring
+		(shrec_data, isovalue, active_region, dual_isosurface, isovert,
+		shrec_info);
+}
+
+/// Dual Contouring Algorithm.
+void SHREC::dual_contouring
+(const SHREC_DATA & shrec_data, const SCALAR_TYPE isovalue,
+ const ACTIVE_GRID_REGION & active_region,
+ DUAL_ISOSURFACE & dual_isosurface, ISOVERT & isovert, 
+ SHREC_INFO & shrec_info)
 {
 	const int dimension = shrec_data.ScalarGrid().Dimension();
 	const AXIS_SIZE_TYPE * axis_size = shrec_data.ScalarGrid().AxisSize();
@@ -66,6 +119,7 @@ void SHREC::dual_contouring
 	shrec_info.time.Clear();
 
 	ISO_MERGE_DATA merge_data(dimension, axis_size);
+	merge_data.SetNumThreads(shrec_data.num_threads);
 
 	if (shrec_data.IsGradientGridSet() &&
 		(shrec_data.flag_grad2hermite || shrec_data.flag_grad2hermiteI)) {
@@ -88,7 +142,7 @@ void SHREC::dual_contouring
 
 			dual_contouring_merge_sharp_from_hermite
 				(shrec_data.ScalarGrid(), edgeI_coord, edgeI_normal_coord,
-				isovalue, shrec_data, dual_isosurface, isovert,
+				isovalue, active_region, shrec_data, dual_isosurface, isovert,
 				shrec_info);
 	}
 	else if (shrec_data.IsGradientGridSet() &&
@@ -99,13 +153,13 @@ void SHREC::dual_contouring
 			if (shrec_data.flag_merge) {
 				dual_contouring_merge_sharp_from_grad
 					(shrec_data.ScalarGrid(), shrec_data.GradientGrid(),
-					isovalue, shrec_data, dual_isosurface, isovert,
+					isovalue, active_region, shrec_data, dual_isosurface, isovert,
 					shrec_info);
 			}
 			else {
 				dual_contouring_sharp_from_grad
 					(shrec_data.ScalarGrid(), shrec_data.GradientGrid(),
-					isovalue, shrec_data, dual_isosurface,
+					isovalue, active_region, shrec_data, dual_isosurface,
 					isovert, shrec_info);
 			}
 	}
@@ -115,12 +169,12 @@ void SHREC::dual_contouring
 			dual_contouring_merge_sharp_from_hermite
 				(shrec_data.ScalarGrid(), 
 				shrec_data.EdgeICoord(), shrec_data.EdgeINormalCoord(),
-				isovalue, shrec_data, dual_isosurface, isovert,
+				isovalue, active_region, shrec_data, dual_isosurface, isovert,
 				shrec_info);
 	}
 	else {
 		dual_contouring
-			(shrec_data.ScalarGrid(), isovalue, shrec_data,
+			(shrec_data.ScalarGrid(), isovalue, active_region, shrec_data,
 			dual_isosurface.quad_vert, dual_isosurface.vertex_coord,
 			merge_data, shrec_info);
 	}
@@ -149,6 +203,7 @@ void SHREC::dual_contouring
 void SHREC::dual_contouring
 	(const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
 	const SCALAR_TYPE isovalue,
+	const ACTIVE_GRID_REGION & active_region,
 	const SHREC_PARAM & shrec_param,
 	std::vector<VERTEX_INDEX> & isoquad_vert,
 	std::vector<COORD_TYPE> & vertex_coord,
@@ -168,20 +223,21 @@ void SHREC::dual_contouring
 {
 	if (shrec_param.VertexPositionMethod() == CUBECENTER) {
 		dual_contouring_cube_center
-			(scalar_grid, isovalue, isoquad_vert, vertex_coord, 
+			(scalar_grid, isovalue, active_region, isoquad_vert, vertex_coord, 
 			merge_data, shrec_info);
 	}
 	else {
 		// Default: Position iso vertices at centroid.
 		if (shrec_param.allow_multiple_iso_vertices) {
 			dual_contouring_centroid_multiv
-				(scalar_grid, isovalue, shrec_param.flag_separate_neg,
+				(scalar_grid, isovalue, active_region, 
+				shrec_param.flag_separate_neg,
 				isoquad_vert, vertex_coord, merge_data, shrec_info);
 		}
 		else {
 
 			dual_contouring_centroid
-				(scalar_grid, isovalue, isoquad_vert, vertex_coord, 
+				(scalar_grid, isovalue, active_region, isoquad_vert, vertex_coord, 
 				merge_data, shrec_info);
 		}
 	}
@@ -192,6 +248,7 @@ void SHREC::dual_contouring
 void SHREC::dual_contouring_cube_center
 	(const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
 	const SCALAR_TYPE isovalue,
+	const ACTIVE_GRID_REGION & active_region,
 	std::vector<VERTEX_INDEX> & isoquad_vert,
 	std::vector<COORD_TYPE> & vertex_coord,
 	MERGE_DATA & merge_data,
@@ -207,11 +264,11 @@ void SHREC::dual_contouring_cube_center
 
 	std::vector<ISO_VERTEX_INDEX> isoquad_vert2;
 	extract_dual_isopoly
-		(scalar_grid, isovalue, isoquad_vert2, shrec_info);
+		(scalar_grid, isovalue, active_region, isoquad_vert2, shrec_info);
 	clock_t t1 = clock();
 
 	std::vector<ISO_VERTEX_INDEX> iso_vlist;
-	merge_identical(isoquad_vert2, iso_vlist, isoquad_vert, merge_data);
+	merge_identical_vertices(isoquad_vert2, iso_vlist, isoquad_vert, merge_data);
 	clock_t t2 = clock();
 
 	position_dual_isovertices_cube_center
@@ -231,6 +288,7 @@ void SHREC::dual_contouring_cube_center
 void SHREC::dual_contouring_centroid
 	(const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
 	const SCALAR_TYPE isovalue,
+	const ACTIVE_GRID_REGION & active_region,
 	std::vector<VERTEX_INDEX> & isoquad_vert,
 	std::vector<COORD_TYPE> & vertex_coord,
 	MERGE_DATA & merge_data,
@@ -247,11 +305,11 @@ void SHREC::dual_contouring_centroid
 	std::vector<ISO_VERTEX_INDEX> isoquad_vert2;
 
 	extract_dual_isopoly
-		(scalar_grid, isovalue, isoquad_vert2, shrec_info);
+		(scalar_grid, isovalue, active_region, isoquad_vert2, shrec_info);
 	clock_t t1 = clock();
 
 	std::vector<ISO_VERTEX_INDEX> iso_vlist;
-	merge_identical(isoquad_vert2, iso_vlist, isoquad_vert, merge_data);
+	merge_identical_vertices(isoquad_vert2, iso_vlist, isoquad_vert, merge_data);
 	clock_t t2 = clock();
 
 	position_dual_isovertices_centroid
@@ -272,6 +330,7 @@ void SHREC::dual_contouring_centroid
 void SHREC::dual_contouring_centroid_multiv
 	(const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
 	const SCALAR_TYPE isovalue,
+	const ACTIVE_GRID_REGION & active_region,
 	const bool flag_separate_neg,
 	std::vector<VERTEX_INDEX> & isoquad_vert,
 	std::vector<COORD_TYPE> & vertex_coord,
@@ -296,13 +355,13 @@ void SHREC::dual_contouring_centroid_multiv
 	std::vector<ISO_VERTEX_INDEX> isoquad_vert2;
 	std::vector<FACET_VERTEX_INDEX> facet_vertex;
 	extract_dual_isopoly
-		(scalar_grid, isovalue, isoquad_vert2, facet_vertex, shrec_info);
+		(scalar_grid, isovalue, active_region, isoquad_vert2, facet_vertex, shrec_info);
 
 	clock_t t1 = clock();
 
 	std::vector<ISO_VERTEX_INDEX> cube_list;
 	std::vector<ISO_VERTEX_INDEX> isoquad_cube;      
-	merge_identical(isoquad_vert2, cube_list, isoquad_cube, merge_data);
+	merge_identical_vertices(isoquad_vert2, cube_list, isoquad_cube, merge_data);
 
 	std::vector<DUAL_ISOVERT> iso_vlist;
 	VERTEX_INDEX num_split;
@@ -342,6 +401,7 @@ void SHREC::dual_contouring_sharp_from_grad
 	(const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
 	const GRADIENT_GRID_BASE & gradient_grid,
 	const SCALAR_TYPE isovalue,
+	const ACTIVE_GRID_REGION & active_region,
 	const SHREC_PARAM & shrec_param,
 	DUAL_ISOSURFACE & dual_isosurface,
 	ISOVERT & isovert,
@@ -362,7 +422,7 @@ void SHREC::dual_contouring_sharp_from_grad
 	t0 = clock();
 
 	compute_dual_isovert
-		(scalar_grid, gradient_grid, isovalue, shrec_param, 
+		(scalar_grid, gradient_grid, isovalue, active_region, shrec_param, 
      shrec_param.vertex_position_method, isovert);
 
 	select_non_smooth(isovert);
@@ -378,22 +438,25 @@ void SHREC::dual_contouring_sharp_from_grad
 
 			get_cube_list(isovert, cube_list);
 			set_cube_ambiguity(scalar_grid, gradient_grid, isovalue,
-				cube_list, shrec_param, cube_ambig);
+				isovert.sign_grid, cube_list, shrec_param, cube_ambig);
 			set_ambiguity_info(cube_ambig, shrec_info.sharpiso);
 
 			dual_contouring_extract_isopoly_multi
-				(scalar_grid, isovalue, shrec_param, dual_isosurface, isovert,
+				(scalar_grid, isovalue, active_region, shrec_param, 
+         dual_isosurface, isovert,
 				cube_ambig, shrec_info, isovert_info);
 		}
 		else {
 			dual_contouring_extract_isopoly_multi
-				(scalar_grid, isovalue, shrec_param, dual_isosurface, isovert,
+				(scalar_grid, isovalue, active_region, shrec_param, 
+         dual_isosurface, isovert,
 				shrec_info, isovert_info);
 		}
 	}
 	else {
 		dual_contouring_extract_isopoly
-			(scalar_grid, isovalue, shrec_param, dual_isosurface, isovert,
+			(scalar_grid, active_region, shrec_param, 
+         dual_isosurface, isovert,
 			shrec_info, isovert_info);
 	}
 
@@ -416,7 +479,7 @@ void SHREC::dual_contouring_sharp_from_grad
 // @pre isovert contains isovert locations.
 void SHREC::dual_contouring_extract_isopoly
 	(const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
-	const SCALAR_TYPE isovalue,
+	const ACTIVE_GRID_REGION & active_region,
 	const SHREC_PARAM & shrec_param,
 	DUAL_ISOSURFACE & dual_isosurface,
 	ISOVERT & isovert,
@@ -430,8 +493,8 @@ void SHREC::dual_contouring_extract_isopoly
 
 	std::vector<DUAL_ISOVERT> iso_vlist;
 
-	extract_dual_isopoly(scalar_grid, isovalue, 
-		dual_isosurface.quad_vert, shrec_info);
+	extract_dual_isopoly(scalar_grid, isovert.sign_grid, active_region,
+		shrec_param.num_threads, dual_isosurface.quad_vert, shrec_info);
 
 	map_isopoly_vert(isovert, dual_isosurface.quad_vert);
 
@@ -461,6 +524,7 @@ void SHREC::dual_contouring_extract_isopoly
 void SHREC::dual_contouring_extract_isopoly_multi
 	(const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
 	const SCALAR_TYPE isovalue,
+	const ACTIVE_GRID_REGION & active_region,
 	const SHREC_PARAM & shrec_param,
 	DUAL_ISOSURFACE & dual_isosurface,
 	ISOVERT & isovert,
@@ -483,12 +547,14 @@ void SHREC::dual_contouring_extract_isopoly_multi
 	std::vector<FACET_VERTEX_INDEX> facet_vertex;
 
 	extract_dual_isopoly
-		(scalar_grid, isovalue, isoquad_cube, facet_vertex, shrec_info);
+		(scalar_grid, isovert.sign_grid, active_region, shrec_param.num_threads,
+     isoquad_cube, facet_vertex, 
+     shrec_info);
 
 	map_isopoly_vert(isovert, isoquad_cube);
 
 	full_split_dual_isovert
-		(scalar_grid, isodual_table, isovalue,
+		(scalar_grid, isodual_table,
 		isovert, isoquad_cube, facet_vertex, shrec_param,
 		iso_vlist, dual_isosurface.quad_vert, shrec_info.sharpiso);
 
@@ -521,6 +587,7 @@ void SHREC::dual_contouring_extract_isopoly_multi
 void SHREC::dual_contouring_extract_isopoly_multi
 	(const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
 	const SCALAR_TYPE isovalue,
+	const ACTIVE_GRID_REGION & active_region,
 	const SHREC_PARAM & shrec_param,
 	DUAL_ISOSURFACE & dual_isosurface,
 	ISOVERT & isovert,
@@ -542,22 +609,22 @@ void SHREC::dual_contouring_extract_isopoly_multi
 
 	std::vector<VERTEX_INDEX> isoquad_cube;
 	std::vector<FACET_VERTEX_INDEX> facet_vertex;
-	std::vector<VERTEX_INDEX> cube_list;
 
 	extract_dual_isopoly
-		(scalar_grid, isovalue, isoquad_cube, facet_vertex, shrec_info);
+		(scalar_grid, isovert.sign_grid, active_region, shrec_param.num_threads,
+     isoquad_cube, facet_vertex, 
+     shrec_info);
 
 	map_isopoly_vert(isovert, isoquad_cube);
 
-	get_cube_list(isovert, cube_list);
-
 	VERTEX_INDEX num_split;
 	split_dual_isovert_ambig
-		(scalar_grid, isodual_table, isovalue, 
-		cube_list, cube_ambig, isoquad_cube, facet_vertex, 
+		(scalar_grid, isodual_table, isovert, cube_ambig, 
+		isoquad_cube, facet_vertex, 
 		iso_vlist, dual_isosurface.quad_vert, num_split);
 	shrec_info.sharpiso.num_cube_multi_isov = num_split;
-	shrec_info.sharpiso.num_cube_single_isov = cube_list.size() - num_split;
+	shrec_info.sharpiso.num_cube_single_isov = 
+		isovert.gcube_list.size() - num_split;
 
 	t1 = clock();
 
@@ -594,6 +661,7 @@ void SHREC::dual_contouring_merge_sharp_from_grad
 	(const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
 	const GRADIENT_GRID_BASE & gradient_grid,
 	const SCALAR_TYPE isovalue,
+	const ACTIVE_GRID_REGION & active_region,
 	const SHREC_PARAM & shrec_param,
 	DUAL_ISOSURFACE & dual_isosurface,
 	ISOVERT & isovert,
@@ -614,7 +682,7 @@ void SHREC::dual_contouring_merge_sharp_from_grad
 	t0 = clock();
 
 	compute_dual_isovert
-		(scalar_grid, gradient_grid, isovalue, shrec_param, 
+		(scalar_grid, gradient_grid, isovalue, active_region, shrec_param, 
      shrec_param.vertex_position_method, isovert);
 
 	t1 = clock();
@@ -645,7 +713,8 @@ void SHREC::dual_contouring_merge_sharp_from_grad
 
 	shrec_info.time.merge_sharp = 0;
 	dual_contouring_merge_sharp
-		(scalar_grid, isovalue, shrec_param, dual_isosurface, isovert,
+		(scalar_grid, isovalue, active_region, shrec_param, 
+         dual_isosurface, isovert,
 		shrec_info, isovert_info);
 
 	t4 = clock();
@@ -670,6 +739,7 @@ void SHREC::dual_contouring_merge_sharp_from_hermite
 	const std::vector<COORD_TYPE> & edgeI_coord,
 	const std::vector<GRADIENT_COORD_TYPE> & edgeI_normal_coord,
 	const SCALAR_TYPE isovalue,
+	const ACTIVE_GRID_REGION & active_region,
 	const SHREC_PARAM & shrec_param,
 	DUAL_ISOSURFACE & dual_isosurface,
 	ISOVERT & isovert,
@@ -687,7 +757,7 @@ void SHREC::dual_contouring_merge_sharp_from_hermite
 
 	compute_dual_isovert
 		(scalar_grid, edgeI_coord, edgeI_normal_coord, 
-		isovalue, shrec_param, isovert);
+		isovalue, active_region, shrec_param, isovert);
 
 	t1 = clock();
 
@@ -706,7 +776,8 @@ void SHREC::dual_contouring_merge_sharp_from_hermite
 
 	shrec_info.time.merge_sharp = 0;
 	dual_contouring_merge_sharp
-		(scalar_grid, isovalue, shrec_param, dual_isosurface, isovert,
+		(scalar_grid, isovalue, active_region, shrec_param, 
+         dual_isosurface, isovert,
 		shrec_info, isovert_info);
 
 	t4 = clock();
@@ -727,6 +798,7 @@ void SHREC::dual_contouring_merge_sharp_from_hermite
 void SHREC::dual_contouring_merge_sharp
 	(const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
 	const SCALAR_TYPE isovalue,
+	const ACTIVE_GRID_REGION & active_region,
 	const SHREC_PARAM & shrec_param,
 	DUAL_ISOSURFACE & dual_isosurface,
 	ISOVERT & isovert,
@@ -766,13 +838,14 @@ void SHREC::dual_contouring_merge_sharp
 		std::vector<FACET_VERTEX_INDEX> facet_vertex;
 
 		extract_dual_isopoly
-			(scalar_grid, isovalue, isoquad_cube, facet_vertex, shrec_info);
+			(scalar_grid, isovert.sign_grid, active_region, shrec_param.num_threads,
+     isoquad_cube, facet_vertex, 
+     shrec_info);
 
 		map_isopoly_vert(isovert, isoquad_cube);
 		t1 = clock();
 
-		compute_cube_isotable_index
-			(scalar_grid, isodual_table, isovalue, cube_list, table_index);
+		get_table_index(isovert.gcube_list, table_index);
 
 		if (flag_split_non_manifold || flag_select_split) {
 
@@ -821,7 +894,9 @@ void SHREC::dual_contouring_merge_sharp
 	}
 	else {
 
-		extract_dual_isopoly(scalar_grid, isovalue, quad_vert, shrec_info);
+		extract_dual_isopoly
+			(scalar_grid, isovert.sign_grid, active_region, shrec_param.num_threads,
+       quad_vert, shrec_info);
 
 		map_isopoly_vert(isovert, quad_vert);
 		t1 = clock();
@@ -64,17 +64,47 @@ namespace SHREC {
      DUAL_ISOSURFACE & dual_isosurface, ISOVERT & isovert,
      SHREC_INFO & shrec_info);
 
+  /// Dual Contouring Algorithm.
+  /// @param active_region Grid region which may intersect the isosurface.
+  ///   Set by set_active_region() or from get_active_cubes().
+  void dual_contouring
+    (const SHREC_DATA & shrec_data, const SCALAR_TYPE isovalue,
+     const ACTIVE_GRID_REGION & active_region,
+     DUAL_ISOSURFACE & dual_isosurface, ISOVERT & isovert,
+     SHREC_INFO & shrec_info);
+
+  /// Set grid region which may intersect the isosurface.
+  /// Use span space index if it is set.
+  /// Otherwise, flag bricks whose scalar range contains isovalue.
+  void set_active_region
+    (const SHREC_DATA & shrec_data, const SCALAR_TYPE isovalue,
+     ACTIVE_GRID_REGION & active_region);
+
+  /// Get active cubes for each isovalue.
+  /// Use span space index if it is set.
+  /// Otherwise, find active cubes for all isovalues
+  ///   in a single pass over the scalar grid.
+  /// @param[out] cube_list[i] Active cubes for isovalue[i]
+  ///   in increasing order.
+  void get_active_cubes
+    (const SHREC_DATA & shrec_data, const std::vector<SCALAR_TYPE> & isovalue,
+     std::vector< std::vector<VERTEX_INDEX> > & cube_list);
+
   // **************************************************
   // DUAL CONTOURING USING SCALAR DATA
   // **************************************************
 
   /// Dual Contouring Algorithm using only scalar data.
   /// Represents each grid edge by a single integer.
+  /// @param active_region = Bricks or cubes which may intersect isosurface.
+  ///   Grid edges and cubes outside active_region are skipped.
+  ///   If active_region is not set, all grid edges and cubes are processed.
   /// @param merge_data = Data structure for merging edges.
   /// Requires memory of size(MERGE_INDEX) for each grid edge.
   void dual_contouring
   (const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
    const SCALAR_TYPE isovalue,
+   const ACTIVE_GRID_REGION & active_region,
    const SHREC_PARAM & shrec_param,
    std::vector<VERTEX_INDEX> & isoquad_vert,
    std::vector<COORD_TYPE> & vertex_coord,
@@ -87,6 +117,7 @@ namespace SHREC {
   void dual_contouring_cube_center
   (const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
    const SCALAR_TYPE isovalue,
+   const ACTIVE_GRID_REGION & active_region,
    std::vector<VERTEX_INDEX> & isoquad_vert,
    std::vector<COORD_TYPE> & vertex_coord,
    MERGE_DATA & merge_data,
@@ -97,6 +128,7 @@ namespace SHREC {
   void dual_contouring_centroid
   (const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
    const SCALAR_TYPE isovalue,
+   const ACTIVE_GRID_REGION & active_region,
    std::vector<VERTEX_INDEX> & isoquad_vert,
    std::vector<COORD_TYPE> & vertex_coord,
    MERGE_DATA & merge_data,
@@ -108,6 +140,7 @@ namespace SHREC {
   void dual_contouring_centroid_multiv
   (const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
    const SCALAR_TYPE isovalue,
+   const ACTIVE_GRID_REGION & active_region,
    const bool flag_separate_neg,
    std::vector<VERTEX_INDEX> & isoquad_vert,
    std::vector<COORD_TYPE> & vertex_coord,
@@ -127,6 +160,7 @@ namespace SHREC {
   (const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
    const GRADIENT_GRID_BASE & gradient_grid,
    const SCALAR_TYPE isovalue,
+   const ACTIVE_GRID_REGION & active_region,
    const SHREC_PARAM & shrec_param,
    DUAL_ISOSURFACE & dual_isosurface,
    ISOVERT & isovert,
@@ -138,7 +172,7 @@ namespace SHREC {
   /// @pre isovert contains isovert locations.
   void dual_contouring_extract_isopoly
   (const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
-   const SCALAR_TYPE isovalue,
+   const ACTIVE_GRID_REGION & active_region,
    const SHREC_PARAM & shrec_param,
    DUAL_ISOSURFACE & dual_isosurface,
    ISOVERT & isovert,
@@ -155,6 +189,7 @@ namespace SHREC {
   void dual_contouring_extract_isopoly_multi
   (const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
    const SCALAR_TYPE isovalue,
+   const ACTIVE_GRID_REGION & active_region,
    const SHREC_PARAM & shrec_param,
    DUAL_ISOSURFACE & dual_isosurface,
    ISOVERT & isovert,
@@ -172,6 +207,7 @@ namespace SHREC {
   void dual_contouring_extract_isopoly_multi
   (const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
    const SCALAR_TYPE isovalue,
+   const ACTIVE_GRID_REGION & active_region,
    const SHREC_PARAM & shrec_param,
    DUAL_ISOSURFACE & dual_isosurface,
    ISOVERT & isovert,
@@ -194,6 +230,7 @@ namespace SHREC {
     (const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
      const GRADIENT_GRID_BASE & gradient_grid,
      const SCALAR_TYPE isovalue,
+     const ACTIVE_GRID_REGION & active_region,
      const SHREC_PARAM & shrec_param,
      DUAL_ISOSURFACE & dual_isosurface,
      ISOVERT & isovert,
@@ -210,6 +247,7 @@ namespace SHREC {
    const std::vector<COORD_TYPE> & edgeI_coord,
    const std::vector<GRADIENT_COORD_TYPE> & edgeI_normal_coord,
    const SCALAR_TYPE isovalue,
+   const ACTIVE_GRID_REGION & active_region,
    const SHREC_PARAM & shrec_param,
    DUAL_ISOSURFACE & dual_isosurface,
    ISOVERT & isovert,
@@ -223,6 +261,7 @@ namespace SHREC {
   void dual_contouring_merge_sharp
   (const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
    const SCALAR_TYPE isovalue,
+   const ACTIVE_GRID_REGION & active_region,
    const SHREC_PARAM & shrec_param,
    DUAL_ISOSURFACE & dual_isosurface,
    ISOVERT & isovert,
@@ -34,9 +34,11 @@
 #include "ijkmesh.txx"
 #include "ijkprint.txx"
 #include "ijkstring.txx"
+#include "ijktime.txx"
 
 #include "sharpiso_array.txx"
 #include "sharpiso_get_gradients.h"
+#include "sharpiso_qef_batch.h"
 
 #include "shrecIO.h"
 
@@ -60,6 +62,9 @@ namespace {
     MAX_EIGEN_PARAM, MAX_DIST_PARAM, 
     GRAD_S_OFFSET_PARAM, MIN_GRAD_S_OFFSET_PARAM,
     MAX_MAG_PARAM, SNAP_DIST_PARAM, MAX_GRAD_DIST_PARAM,
+    THREADS_PARAM, QEF_SOLVER_PARAM, SPARSE_INDEX_PARAM, SPAN_SPACE_PARAM,
+    SHARED_ACTIVE_CUBES_PARAM, ISOVALUE_THREADS_PARAM, 
+    MMAP_PARAM, LAZY_GRAD_PARAM,
     MIN_TRIANGLE_ANGLE_PARAM, MIN_NORMAL_ANGLE_PARAM,
     SHARP_EDGEI_PARAM, INTERPOLATE_EDGEI_PARAM,
     ALLOW_CONFLICT_PARAM,
@@ -109,6 +114,8 @@ namespace {
       "-grad2hermite", "-grad2hermiteI",
       "-max_eigen", "-max_dist", "-gradS_offset", "-min_gradS_offset", 
       "-max_mag", "-snap_dist", "-max_grad_dist",
+      "-threads", "-qef_solver", "-sparse_index", "-span_space",
+      "-shared_active_cubes", "-isovalue_threads", "-mmap", "-lazy_grad",
       "-min_triangle_angle", "-min_normal_angle",
       "-sharp_edgeI", "-interpolate_edgeI",
       "-allow_conflict", "-clamp_conflict", "-centroid_conflict", 
@@ -286,6 +293,27 @@ namespace {
     }
   }
 
+  // Set solver for the 3x3 Lindstrom matrix.
+  void set_qef_solver(const char * s, INPUT_INFO & input_info)
+  {
+    const string str = s;
+
+    if (str == "svd") {
+      input_info.qef_solver = QEF_SOLVER_SVD;
+    }
+    else if (str == "jacobi") {
+      input_info.qef_solver = QEF_SOLVER_JACOBI;
+    }
+    else if (str == "batch") {
+      input_info.qef_solver = QEF_SOLVER_BATCH;
+    }
+    else {
+      cerr << "Error in input parameter -qef_solver.  Illegal solver: "
+           << str << "." << endl;
+      exit(1030);
+    }
+  }
+
   void lindstrom_deprecated()
   {
     cerr << "*** Warning: Options -lindstrom -lindstrom2 -lindstrom_fast -no_lindstrom are all deprecated." << endl;
@@ -366,6 +394,26 @@ namespace {
       input_info.quad_tri_method = UNIFORM_TRI;
       break;
 
+    case SPARSE_INDEX_PARAM:
+      input_info.flag_sparse_index_grid = true;
+      break;
+
+    case SPAN_SPACE_PARAM:
+      input_info.flag_span_space_index = true;
+      break;
+
+    case SHARED_ACTIVE_CUBES_PARAM:
+      input_info.flag_shared_active_cubes = true;
+      break;
+
+    case MMAP_PARAM:
+      input_info.flag_mmap = true;
+      break;
+
+    case LAZY_GRAD_PARAM:
+      input_info.flag_lazy_gradients = true;
+      break;
+
     case GRAD2HERMITE_PARAM:
       input_info.flag_grad2hermite = true;
       input_info.vertex_position_method = EDGEI_GRADIENT;
@@ -717,6 +765,20 @@ namespace {
         { input_info.use_large_neighborhood = true; }
       break;
 
+    case THREADS_PARAM:
+      input_info.num_threads =
+        get_option_int(option_string, value_string);
+      break;
+
+    case ISOVALUE_THREADS_PARAM:
+      input_info.num_isovalue_threads =
+        get_option_int(option_string, value_string);
+      break;
+
+    case QEF_SOLVER_PARAM:
+      set_qef_solver(value_string, input_info);
+      break;
+
     case GRAD_S_OFFSET_PARAM:
       input_info.grad_selection_cube_offset = 
         get_option_float(option_string, value_string);
@@ -1057,6 +1119,16 @@ void SHREC::check_input_info(const INPUT_INFO & input_info)
       exit(560);
     }
   }
+
+  if (input_info.num_threads < 1) {
+    cerr << "Error.  Illegal -threads <N> parameter. Integer <N> must be positive." << endl;
+    exit(560);
+  }
+
+  if (input_info.num_isovalue_threads < 1) {
+    cerr << "Error.  Illegal -isovalue_threads <N> parameter. Integer <N> must be positive." << endl;
+    exit(560);
+  }
 }
 
 // Parse the command line.
@@ -1124,6 +1196,25 @@ bool SHREC::check_input
     return(false);
   }
 
+  if (input_info.flag_lazy_gradients && input_info.flag_subsample) {
+    error.AddMessage
+      ("Error.  Cannot use -lazy_grad with -subsample.");
+    return(false);
+  }
+
+#if defined(SHARPISO_SCALAR_STORAGE_UINT8) || \
+  defined(SHARPISO_SCALAR_STORAGE_UINT16)
+  // Supersampled values are interpolated and would be rounded
+  //   to integers when stored.
+  if (input_info.flag_supersample) {
+    error.AddMessage
+      ("Error.  Cannot use -supersample with 8 or 16 bit scalar storage.");
+    error.AddMessage
+      ("  Rebuild with cmake option -DSHREC_SCALAR_STORAGE=float.");
+    return(false);
+  }
+#endif
+
   return(true);
 }
 
@@ -1131,6 +1222,100 @@ bool SHREC::check_input
 // READ NEARLY RAW RASTER DATA (nrrd) FILE
 // **************************************************
 
+namespace {
+
+#if defined(SHARPISO_SCALAR_STORAGE_UINT8) || \
+  defined(SHARPISO_SCALAR_STORAGE_UINT16)
+
+  /// Return true if values of nrrd_type can be stored
+  ///   in SCALAR_STORAGE_TYPE without loss.
+  bool is_storable_nrrd_type(const int nrrd_type)
+  {
+#if defined(SHARPISO_SCALAR_STORAGE_UINT8)
+    return(nrrd_type == nrrdTypeUChar);
+#else
+    return(nrrd_type == nrrdTypeUChar || nrrd_type == nrrdTypeUShort);
+#endif
+  }
+
+  /// Return SHREC_SCALAR_STORAGE value used to build shrec.
+  const char * built_scalar_storage()
+  {
+#if defined(SHARPISO_SCALAR_STORAGE_UINT8)
+    return("uint8");
+#else
+    return("uint16");
+#endif
+  }
+
+  /// Return SHREC_SCALAR_STORAGE value which stores values of nrrd_type
+  ///   without loss.
+  const char * required_scalar_storage(const int nrrd_type)
+  {
+    if (nrrd_type == nrrdTypeUChar) { return("uint8"); }
+    else if (nrrd_type == nrrdTypeUShort) { return("uint16"); }
+    else { return("float"); }
+  }
+
+  /// Return nrrd type name as in the nrrd header.
+  const char * nrrd_type_name(const int nrrd_type)
+  {
+    switch(nrrd_type) {
+    case nrrdTypeChar: return("signed char");
+    case nrrdTypeUChar: return("uchar");
+    case nrrdTypeShort: return("short");
+    case nrrdTypeUShort: return("ushort");
+    case nrrdTypeInt: return("int");
+    case nrrdTypeUInt: return("uint");
+    case nrrdTypeLLong: return("longlong");
+    case nrrdTypeULLong: return("ulonglong");
+    case nrrdTypeFloat: return("float");
+    case nrrdTypeDouble: return("double");
+    default: return("unknown");
+    }
+  }
+
+  /// Convert nrrd to 8 or 16 bit unsigned integer data and store in sdata.
+  /// Values must be in the range of SCALAR_STORAGE_TYPE.
+  template <> void nrrd2scalar<SCALAR_STORAGE_TYPE>
+  ( Nrrd *nrrd, SCALAR_STORAGE_TYPE * sdata )
+  {
+    unsigned int (*lup) (const void *, size_t iv);
+
+    void * nrrd_data = nrrd->data;
+    int numv = nrrdElementNumber(nrrd);
+    lup = nrrdUILookup[nrrd->type];
+
+    nrrd_check_null(numv, sdata);
+
+    for (int iv = 0; iv < numv; iv++)
+      sdata[iv] = (SCALAR_STORAGE_TYPE) lup(nrrd_data, iv);
+  }
+
+#endif
+
+#ifdef SHARPISO_GRADIENT_STORAGE_HALF
+
+  /// Convert nrrd to half precision data and store in sdata.
+  /// Used to read gradient grids with half precision storage.
+  template <> void nrrd2scalar<HALF_FLOAT>( Nrrd *nrrd, HALF_FLOAT * sdata )
+  {
+    float (*lup) (const void *, size_t iv);
+
+    void * nrrd_data = nrrd->data;
+    int numv = nrrdElementNumber(nrrd);
+    lup = nrrdFLookup[nrrd->type];
+
+    nrrd_check_null(numv, sdata);
+
+    for (int iv = 0; iv < numv; iv++)
+      sdata[iv] = HALF_FLOAT(lup(nrrd_data, iv));
+  }
+
+#endif
+
+}
+
 void SHREC::read_nrrd_file
 (const char * input_filename, SHARPISO_SCALAR_GRID & scalar_grid,
  NRRD_INFO & nrrd_info)
@@ -1143,6 +1328,24 @@ void SHREC::read_nrrd_file
   nrrd_in.ReadScalarGrid(input_filename, scalar_grid, nrrd_header, error);
   if (nrrd_in.ReadFailed()) { throw error; }
 
+#if defined(SHARPISO_SCALAR_STORAGE_UINT8) || \
+  defined(SHARPISO_SCALAR_STORAGE_UINT16)
+  // Scalar storage type is set when shrec is built.
+  if (!is_storable_nrrd_type(nrrd_in.NrrdType())) {
+    const int nrrd_type = nrrd_in.NrrdType();
+    error.AddMessage("Input error.  Scalar values in ", input_filename,
+                     " have nrrd type ", nrrd_type_name(nrrd_type), ".");
+    error.AddMessage
+      ("  shrec was built with SHREC_SCALAR_STORAGE=", 
+       built_scalar_storage(), " which cannot store ", 
+       nrrd_type_name(nrrd_type), " values.");
+    error.AddMessage
+      ("  Rebuild with cmake option -DSHREC_SCALAR_STORAGE=",
+       required_scalar_storage(nrrd_type), ".");
+    throw error;
+  }
+#endif
+
   if (scalar_grid.Dimension() < 1) {
     cerr << "Illegal scalar grid dimension.  Dimension must be at least 1." 
          << endl;
@@ -1201,6 +1404,41 @@ void SHREC::read_nrrd_file
   io_time.read_nrrd_time = wall_time.getElapsed();
 }
 
+bool SHREC::mmap_nrrd_file
+(const char * input_filename, SHARPISO_SCALAR_GRID_MMAP & scalar_grid,
+ NRRD_INFO & nrrd_info, IO_TIME & io_time, std::string & message)
+{
+  ELAPSED_TIME wall_time;
+
+  if (!scalar_grid.Map(input_filename, message)) { return(false); }
+
+  nrrd_info.dimension = scalar_grid.Dimension();
+  for (int d = 0; d < scalar_grid.Dimension(); d++) {
+    const COORD_TYPE spacing = scalar_grid.NrrdFile().Spacing(d);
+    nrrd_info.grid_spacing.push_back(spacing); 
+    scalar_grid.SetSpacing(d, spacing);
+  };
+
+  io_time.read_nrrd_time = wall_time.getElapsed();
+  return(true);
+}
+
+bool SHREC::mmap_nrrd_file
+(const char * input_filename, GRADIENT_GRID_MMAP & gradient_grid,
+ NRRD_INFO & nrrd_info, std::string & message)
+{
+  if (!gradient_grid.Map(input_filename, message)) { return(false); }
+
+  nrrd_info.dimension = gradient_grid.Dimension();
+  for (int d = 0; d < gradient_grid.Dimension(); d++) {
+    const COORD_TYPE spacing = gradient_grid.NrrdFile().Spacing(d+1);
+    nrrd_info.grid_spacing.push_back(spacing); 
+    gradient_grid.SetSpacing(d, spacing);
+  };
+
+  return(true);
+}
+
 // **************************************************
 // READ OFF FILE
 // **************************************************
@@ -1853,6 +2091,14 @@ void SHREC::report_num_cubes
       // use full_scalar_grid
       cout << num_grid_cubes << " grid cubes." << endl;
     }
+
+    if (shrec_data.SpanSpaceIndex().IsSet()) {
+      const SPAN_SPACE_INDEX & span_space_index = shrec_data.SpanSpaceIndex();
+      cout << "Span space index: "
+           << span_space_index.NumCubes() << " cubes, "
+           << span_space_index.NumNodes() << " nodes, "
+           << span_space_index.NumBytes()/(1024.0*1024.0) << " MB." << endl;
+    }
   }
 
 }
@@ -1929,6 +2175,39 @@ void SHREC::report_shrec_param
       cout << "Using Lindstrom formula." << endl;
     }
 
+    if (shrec_param.qef_solver == QEF_SOLVER_JACOBI) {
+      cout << "Using Jacobi eigen-decomposition to solve Lindstrom formula."
+           << endl;
+    }
+    else if (shrec_param.qef_solver == QEF_SOLVER_BATCH) {
+      cout << "Using batched Jacobi eigen-decomposition (" 
+           << get_qef_batch_isa() << ") to solve Lindstrom formula."
+           << endl;
+    }
+
+    if (shrec_param.num_threads > 1) {
+      cout << "Computing isosurface vertex positions using "
+           << shrec_param.num_threads << " threads." << endl;
+    }
+
+    if (shrec_param.num_isovalue_threads > 1) {
+      cout << "Processing isovalues using "
+           << shrec_param.num_isovalue_threads << " threads." << endl;
+    }
+
+    if (shrec_param.flag_sparse_index_grid) {
+      cout << "Storing only active cubes in cube index grid." << endl;
+    }
+
+    if (shrec_param.flag_span_space_index) {
+      cout << "Using span space index to find active cubes." << endl;
+    }
+
+    if (shrec_param.flag_shared_active_cubes) {
+      cout << "Finding active cubes for all isovalues in a single pass"
+           << " (shared active cube discovery)." << endl;
+    }
+
     if (shrec_param.flag_dist2centroid) {
       cout << "Using distance to centroid." << endl;
     }
@@ -2182,7 +2461,7 @@ void report_isovert_cube_info
     (cout, isovert.gcube_list[gcube_index].isovert_coord);
   cout << " B: ";
   IJK::print_coord3D
-    (cout, isovert.gcube_list[gcube_index].isovert_coordB);
+    (cout, isovert.gcube_info[gcube_index].isovert_coordB);
   cout << endl;
 
   if (num_eigenvalues == 1) {
@@ -2209,31 +2488,31 @@ void report_isovert_cube_info
   output_yes_no("    Conflict? ", 
                 isovert.gcube_list[gcube_index].flag_conflict);
   output_yes_no("  SVD coord far? ", 
-                isovert.gcube_list[gcube_index].flag_far);
+                isovert.gcube_info[gcube_index].flag_far);
   output_yes_no("  Centroid coord? ", 
                 isovert.gcube_list[gcube_index].flag_centroid_location);
   cout << endl;
   if (output_info.flag_recompute_using_adjacent) {
     output_yes_no("    Recomputed using adjacent? ",
-                  isovert.gcube_list[gcube_index].flag_recomputed_using_adjacent);
+                  isovert.gcube_info[gcube_index].flag_recomputed_using_adjacent);
     cout << endl;
   }
-  if (isovert.gcube_list[gcube_index].cover_type != NO_ADJACENT_CUBE) {
-    convert2string(isovert.gcube_list[gcube_index].cover_type, s);
+  if (isovert.gcube_info[gcube_index].cover_type != NO_ADJACENT_CUBE) {
+    convert2string(isovert.gcube_info[gcube_index].cover_type, s);
     cout << "    Cover type: " << s << endl;
   }
 
   cout << "    ";
-  if (isovert.gcube_list[gcube_index].flag_using_substitute_coord)
+  if (isovert.gcube_info[gcube_index].flag_using_substitute_coord)
     { cout << "Substitute coord.  "; }
-  if (isovert.gcube_list[gcube_index].flag_coord_from_other_cube) 
+  if (isovert.gcube_info[gcube_index].flag_coord_from_other_cube) 
     { cout << "Coord from other cube.  "; }
-  else if (isovert.gcube_list[gcube_index].flag_coord_from_vertex)
+  else if (isovert.gcube_info[gcube_index].flag_coord_from_vertex)
     { cout << "Coord from vertex.  "; }
-  else if (isovert.gcube_list[gcube_index].flag_coord_from_edge)
+  else if (isovert.gcube_info[gcube_index].flag_coord_from_edge)
     { cout << "Coord from edge.  "; }
 
-  if (isovert.gcube_list[gcube_index].flag_ignore_mismatch) 
+  if (isovert.gcube_info[gcube_index].flag_ignore_mismatch) 
     { cout << "Mismatch ignored.  ";  }
 
   cout << "Isotable index: " 
@@ -2393,6 +2672,16 @@ void SHREC::report_shrec_time
   cout << "CPU time to run Marching Cubes: "
        << shrec_time.total << " seconds." << endl;
 
+  if (input_info.flag_span_space_index || input_info.flag_shared_active_cubes) {
+    cout << "    Time to find active cubes before extraction: "
+         << shrec_time.preprocessing << " seconds." << endl;
+  }
+
+  if (input_info.flag_lazy_gradients) {
+    cout << "    Time to set up lazy gradients: "
+         << shrec_time.gradient << " seconds." << endl;
+  }
+
   if ((input_info.VertexPositionMethod() != CUBECENTER &&
        input_info.VertexPositionMethod() != CENTROID_EDGE_ISO) &&
       input_info.flag_merge) {
@@ -2534,7 +2823,8 @@ namespace {
          << endl;
     cerr << "  [-gradient {gradient_nrrd_filename}]"
          << " [-normal {normal_off_filename}]" << endl;
-    cerr << "  [-subsample S] [-max_eigen {max}]" << endl;
+    cerr << "  [-subsample S] [-max_eigen {max}] [-threads N]" << endl;
+    cerr << "  [-isovalue_threads N]" << endl;
     cerr << "  [-trimesh] [-keepv] [-o {output_filename}] [-usev_in_outfname] [-stdout]"
          << endl;
     cerr << "  [-s] [-out_param] [-info] [-nowrite] [-time]"
@@ -2553,6 +2843,9 @@ namespace {
     cerr << "  [-merge | -no_merge] [-merge_linf_th <D>]" << endl;
     cerr << "  [-grad2hermite | -grad2hermiteI]" << endl;
     cerr << "  [-select_split]" << endl;
+    cerr << "  [-qef_solver {svd|jacobi|batch}]" << endl;
+    cerr << "  [-sparse_index] [-span_space] [-shared_active_cubes]" << endl;
+    cerr << "  [-mmap] [-lazy_grad]" << endl;
     cerr << "  [-select_mod6 | -select_by_dist]" << endl;
     cerr << "  [-max_dist {D}] [-max_mag {M}] [-snap_dist {D}]" << endl;    
     cerr << "  [-min_triangle_angle {A}] [-min_normal_angle {A}]" << endl;
@@ -2638,6 +2931,25 @@ void help_main_options()
        << endl;
   cout << "                  Eigenvalues at or below E are clamped to 0." 
        << endl;
+  cout << "  -threads N: Use N threads to extract isosurface polygons,"
+       << endl
+       << "              to compute isosurface vertex positions"
+       << endl
+       << "              and to check cubes for sharp vertex selection"
+       << endl
+       << "              and isopatches for disks (-check_disk)."
+       << endl
+       << "              Merge mapping with N > 1 maps slabs of the grid"
+       << endl
+       << "              in parallel, followed by the slab seams."
+       << endl
+       << "              (Default: 1.)" << endl;
+  cout << "  -isovalue_threads N: Use N threads to construct isosurfaces"
+       << endl
+       << "              for different isovalues concurrently."
+       << endl
+       << "              Output is written in isovalue order.  (Default: 1.)"
+       << endl;
   cout << "  -trimesh: Output triangle mesh." << endl;
   cout << "  -keepv:   Keep isosurface vertices.  Do not remove isosurface vertices"
        << endl
@@ -2796,6 +3108,37 @@ void help_testing_options()
        << endl;
   cout << "  -lindstrom:   Use Lindstrom's equation to compute sharp point."
        << endl;
+  cout << "  -qef_solver svd:    Solve Lindstrom's 3x3 system using svd."
+       << " (Default.)" << endl;
+  cout << "  -qef_solver jacobi: Solve Lindstrom's 3x3 system using Jacobi"
+       << endl
+       << "                      eigen-decomposition of the symmetric matrix."
+       << endl;
+  cout << "  -qef_solver batch:  Solve Lindstrom's 3x3 systems of "
+       << QEF_BATCH::BATCH_SIZE << " cubes at a time" << endl
+       << "                      using vectorized Jacobi eigen-decomposition."
+       << endl;
+  cout << "  -sparse_index: Store only active cubes in cube index grid."
+       << endl
+       << "             Reduces memory on large volumes." << endl;
+  cout << "  -span_space: Build span space index of grid cubes once"
+       << endl
+       << "             and use it to find active cubes for each isovalue."
+       << endl;
+  cout << "  -shared_active_cubes: Find active cubes for all isovalues"
+       << endl
+       << "             in a single pass over the scalar grid." << endl
+       << "             Only active cube discovery is shared.  Isosurface"
+       << endl
+       << "             extraction and vertex positioning still run"
+       << " once per isovalue." << endl;
+  cout << "  -mmap: Memory map raw nrrd scalar and gradient files"
+       << endl
+       << "             instead of reading them." << endl;
+  cout << "  -lazy_grad: Compute gradients from the scalar grid"
+       << " by central difference" << endl
+       << "             when they are first read.  Do not read gradient file."
+       << endl;
   cout << "  -allow_conflict:  Allow more than one isosurface vertex in a cube."
        << endl;
   cout << "  -clamp_conflict:  Settle conflicts by clamping to cube."
@@ -2896,6 +3239,8 @@ void SHREC::IO_INFO::Init()
   subsample_resolution = 2;
   flag_supersample = false;
   supersample_resolution = 2;
+  flag_mmap = false;
+  flag_lazy_gradients = false;
   flag_color_alternating = false;  // color simplices in alternating cubes
   region_length = 1;
   max_small_eigenvalue = 0.1;
@@ -3021,6 +3366,15 @@ void SHREC::set_shrec_data
 
   // Set data structures in shrec_data
   shrec_data.Set(input_info);
+
+  if (input_info.flag_span_space_index) {
+    float build_time;
+    clock_t t0 = clock();
+    shrec_data.SetSpanSpaceIndex();
+    clock_t t1 = clock();
+    clock2seconds(t1-t0, build_time);
+    shrec_time.preprocessing += build_time;
+  }
 }
 
 void SHREC::set_input_info
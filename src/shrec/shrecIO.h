@@ -31,6 +31,20 @@
 #include "shrec_datastruct.h"
 #include "sharpiso_eigen.h"
 #include "ijkNrrd.h"
+#include "ijkgrid_nrrd_mmap.txx"
+
+namespace SHARPISO {
+
+#ifdef SHARPISO_GRADIENT_STORAGE_HALF
+
+  /// Nrrd has no half precision type.  Half precision grids are read
+  ///   and converted, not memory mapped.
+  inline bool is_nrrd_type_name(const std::string &, const HALF_FLOAT *)
+  { return(false); }
+
+#endif
+
+}
 
 namespace SHREC {
 
@@ -40,6 +54,15 @@ namespace SHREC {
 
   typedef float COLOR_TYPE;           /// Color type.
 
+  /// Scalar grid memory mapped from a raw nrrd file.
+  typedef IJK::SCALAR_GRID_MMAP<SHARPISO_GRID, SCALAR_STORAGE_TYPE>
+    SHARPISO_SCALAR_GRID_MMAP;
+
+  /// Gradient grid memory mapped from a raw nrrd file.
+  typedef IJK::VECTOR_GRID_MMAP
+    <SHARPISO_GRID, GRADIENT_LENGTH_TYPE, GRADIENT_STORAGE_TYPE>
+    GRADIENT_GRID_MMAP;
+
   // **************************************************
   // NRRD INFORMATION
   // **************************************************
@@ -99,6 +122,8 @@ namespace SHREC {
     int subsample_resolution;
     bool flag_supersample;
     int supersample_resolution;
+    bool flag_mmap;              ///< Memory map raw nrrd input files.
+    bool flag_lazy_gradients;    ///< Compute gradients when first read.
     bool flag_color_alternating; ///< Color simplices in alternating cubes
     int region_length;
     bool flag_output_param;      ///< Output algorithm parameters.
@@ -309,6 +334,19 @@ namespace SHREC {
   (const char * input_filename, GRADIENT_GRID & gradient_grid, 
    NRRD_INFO & nrrd_info);
 
+  /// Memory map a raw nearly raw raster data (nrrd) file.
+  /// @return False if file cannot be mapped.
+  ///   Caller should read the file with read_nrrd_file instead.
+  bool mmap_nrrd_file
+  (const char * input_filename, SHARPISO_SCALAR_GRID_MMAP & scalar_grid, 
+   NRRD_INFO & nrrd_info, IO_TIME & io_time, std::string & message);
+
+  /// Memory map a raw nearly raw raster gradient data (nrrd) file.
+  /// @return False if file cannot be mapped.
+  bool mmap_nrrd_file
+  (const char * input_filename, GRADIENT_GRID_MMAP & gradient_grid, 
+   NRRD_INFO & nrrd_info, std::string & message);
+
   // **************************************************
   // READ OFF FILE
   // **************************************************
@@ -27,6 +27,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "ijkbits.txx"
 #include "ijkisopoly.txx"
 
+#include <algorithm>
 #include <queue>
 
 using namespace IJK;
@@ -81,21 +82,43 @@ bool SHREC::is_grid_facet_ambiguous
   }
 }
 
+/// Return true if facet is ambiguous.
+/// Version using signs of grid vertices.
+bool SHREC::is_grid_facet_ambiguous
+(const SHARPISO_BIT_GRID & sign_grid,
+ const VERTEX_INDEX facet_v0,
+ const NUM_TYPE orth_dir)
+{
+  const NUM_TYPE dim1 = (orth_dir+1)%DIM3;
+  const NUM_TYPE dim2 = (orth_dir+2)%DIM3;
+
+  const VERTEX_INDEX v1 = sign_grid.NextVertex(facet_v0, dim1);
+  const VERTEX_INDEX v2 = sign_grid.NextVertex(facet_v0, dim2);
+  const VERTEX_INDEX v3 = sign_grid.NextVertex(v1, dim2);
+
+  const bool sign0 = sign_grid.Scalar(facet_v0);
+
+  // Diagonally opposite vertices have the same sign,
+  //   and adjacent vertices have different signs.
+  return(sign_grid.Scalar(v1) != sign0 && sign_grid.Scalar(v2) != sign0 &&
+         sign_grid.Scalar(v3) == sign0);
+}
+
 /// Decide and return ambiguity status of facet ifacet.
 AMBIGUITY_STATUS SHREC::decide_ambiguous_facet
 (const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
  const GRADIENT_GRID_BASE & gradient_grid,
  const AMBIG_TABLE & ambig_table,
  const SCALAR_TYPE isovalue,
+ const SHARPISO_BIT_GRID & sign_grid,
  const VERTEX_INDEX facet_v0,
  const int facet_orth_dir,
  const SHREC_PARAM & shrec_param)
 {
   NUM_TYPE sharp_vertex_location;
-  static COORD_TYPE coord[DIM3];
+  COORD_TYPE coord[DIM3];
 
-  if (!is_grid_facet_ambiguous
-      (scalar_grid, facet_v0, facet_orth_dir, isovalue)) 
+  if (!is_grid_facet_ambiguous(sign_grid, facet_v0, facet_orth_dir)) 
     { return(NOT_AMBIGUOUS); }
 
   scalar_grid.ComputeCoord(facet_v0, coord);
@@ -120,9 +143,7 @@ AMBIGUITY_STATUS SHREC::decide_ambiguous_facet
   }
 
   IJKTABLE::AMBIG_TABLE_INDEX it;
-  compute_isotable_index
-    (scalar_grid.ScalarPtrConst(), isovalue, icube,
-     scalar_grid.CubeVertexIncrement(), NUM_CUBE_VERTICES3D, it);
+  compute_cube_bit_index(sign_grid, icube, it);
 
   if (ambig_table.NumPosComponents(it) == 1) 
     { return(SEPARATE_POS); }
@@ -135,20 +156,58 @@ AMBIGUITY_STATUS SHREC::decide_ambiguous_facet
 
 namespace {
 
+  // Return ambiguity status of facet ifacet.
+  inline AMBIGUITY_TYPE get_facet_ambig_status
+  (const std::vector<AMBIGUITY_TYPE> & facet_ambig_status,
+   const VERTEX_INDEX ifacet)
+  { return(facet_ambig_status[ifacet]); }
+
+  inline AMBIGUITY_TYPE get_facet_ambig_status
+  (const FACET_AMBIG_LIST & facet_ambig, const VERTEX_INDEX ifacet)
+  { return(facet_ambig.Status(ifacet)); }
+
+  // Set status of facet ifacet to ambig_status if it is undecided.
+  // Return true if status is changed.
+  inline bool set_facet_if_undecided_ambig
+  (const VERTEX_INDEX ifacet, const AMBIGUITY_TYPE ambig_status,
+   std::vector<AMBIGUITY_TYPE> & facet_ambig_status)
+  {
+    if (facet_ambig_status[ifacet] != UNDECIDED_AMBIGUITY) 
+      { return(false); }
+
+    facet_ambig_status[ifacet] = ambig_status; 
+    return(true);
+  }
+
+  inline bool set_facet_if_undecided_ambig
+  (const VERTEX_INDEX ifacet, const AMBIGUITY_TYPE ambig_status,
+   FACET_AMBIG_LIST & facet_ambig)
+  {
+    const INDEX_DIFF_TYPE k = facet_ambig.Locate(ifacet);
+    if (k < 0 || facet_ambig.StatusAt(k) != UNDECIDED_AMBIGUITY) 
+      { return(false); }
+
+    facet_ambig.SetStatusAt(k, ambig_status);
+    return(true);
+  }
+
   // Return true if cube has facet with a given ambig_status.
+  template <typename FACET_AMBIG_TYPE>
   bool cube_has_facet_with_ambig_status
   (const SHARPISO_GRID & grid,
    const VERTEX_INDEX icube,
    const AMBIGUITY_STATUS ambig_status,
-   const std::vector<AMBIGUITY_TYPE> & facet_ambig_status)
+   const FACET_AMBIG_TYPE & facet_ambig_status)
   {
     for (int orth_dir = 0; orth_dir < DIM3; orth_dir++) {
-      if (facet_ambig_status[icube*DIM3+orth_dir] == ambig_status) 
+      if (get_facet_ambig_status
+          (facet_ambig_status, icube*DIM3+orth_dir) == ambig_status) 
         { return(true); }
 
       VERTEX_INDEX iv1 = grid.NextVertex(icube, orth_dir);
 
-      if (facet_ambig_status[iv1*DIM3+orth_dir] == ambig_status) 
+      if (get_facet_ambig_status
+          (facet_ambig_status, iv1*DIM3+orth_dir) == ambig_status) 
         { return(true); }
     }
 
@@ -157,12 +216,13 @@ namespace {
 
   // Return true if some facet of two cubes have a given ambig_status.
   // @pre facet is internal grid facet.
+  template <typename FACET_AMBIG_TYPE>
   bool two_cubes_have_facet_with_ambig_status
   (const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
    const VERTEX_INDEX facet_v0,
    const int facet_orth_dir,
    const AMBIGUITY_STATUS ambig_status,
-   const std::vector<AMBIGUITY_TYPE> & facet_ambig_status)
+   const FACET_AMBIG_TYPE & facet_ambig_status)
   {
     const VERTEX_INDEX icube1 = facet_v0;
 
@@ -180,36 +240,36 @@ namespace {
     return(false);
   }
 
+  template <typename FACET_AMBIG_TYPE>
   void set_cube_facets_undecided_ambig
   (const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
    const VERTEX_INDEX icube,
    const AMBIGUITY_TYPE ambig_status,
-   std::vector<AMBIGUITY_TYPE> & facet_ambig_status,
+   FACET_AMBIG_TYPE & facet_ambig_status,
    std::queue<VERTEX_INDEX> facet_list)
   {
     for (int orth_dir = 0; orth_dir < DIM3; orth_dir++) {
       VERTEX_INDEX ifacet = icube*DIM3+orth_dir;
-      if (facet_ambig_status[ifacet] == UNDECIDED_AMBIGUITY) {
-        facet_ambig_status[ifacet] = ambig_status; 
-        facet_list.push(ifacet);
-      }
+      if (set_facet_if_undecided_ambig
+          (ifacet, ambig_status, facet_ambig_status)) 
+        { facet_list.push(ifacet); }
 
       VERTEX_INDEX iv1 = scalar_grid.NextVertex(icube, orth_dir);
       ifacet = iv1*DIM3+orth_dir;
 
-      if (facet_ambig_status[ifacet] == UNDECIDED_AMBIGUITY) {
-        facet_ambig_status[ifacet] = ambig_status; 
-        facet_list.push(ifacet);
-      }
+      if (set_facet_if_undecided_ambig
+          (ifacet, ambig_status, facet_ambig_status)) 
+        { facet_list.push(ifacet); }
     }
   }
 
+  template <typename FACET_AMBIG_TYPE>
   void set_two_cube_facets_undecided_ambig
   (const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
    const VERTEX_INDEX facet_v0,
    const int facet_orth_dir,
    const AMBIGUITY_STATUS ambig_status,
-   std::vector<AMBIGUITY_TYPE> & facet_ambig_status,
+   FACET_AMBIG_TYPE & facet_ambig_status,
    std::queue<VERTEX_INDEX> & facet_list)
   {
     const VERTEX_INDEX icube1 = facet_v0;
@@ -224,6 +284,77 @@ namespace {
       (scalar_grid, icube0, ambig_status, facet_ambig_status, facet_list);
   }
 
+  // Propagate SEPARATE_POS and SEPARATE_NEG from facets in facet_list.
+  template <typename FACET_AMBIG_TYPE>
+  void propagate_sep_T
+  (const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
+   std::queue<VERTEX_INDEX> & facet_list,
+   FACET_AMBIG_TYPE & facet_ambig_status)
+  {
+    COORD_TYPE coord[DIM3];
+
+    while (facet_list.size() != 0) {
+      VERTEX_INDEX ifacet = facet_list.front();
+      facet_list.pop();
+
+      VERTEX_INDEX facet_v0 = ifacet/DIM3;
+      VERTEX_INDEX facet_orth_dir = ifacet%DIM3;
+
+      scalar_grid.ComputeCoord(facet_v0, coord);
+      if (coord[facet_orth_dir] != 0 &&
+          coord[facet_orth_dir]+1 != scalar_grid.AxisSize(facet_orth_dir)) {
+        // Internal facet.
+      
+        AMBIGUITY_STATUS fambig = AMBIGUITY_STATUS
+          (get_facet_ambig_status(facet_ambig_status, ifacet));
+        AMBIGUITY_STATUS fambig_complement = SEPARATE_POS;
+
+        if (fambig == SEPARATE_POS) 
+          { fambig_complement = SEPARATE_NEG; }
+
+        if (!two_cubes_have_facet_with_ambig_status
+            (scalar_grid, facet_v0, facet_orth_dir, fambig_complement, 
+             facet_ambig_status)) {
+
+          set_two_cube_facets_undecided_ambig
+            (scalar_grid, facet_v0, facet_orth_dir, fambig, 
+             facet_ambig_status, facet_list);
+        }
+      }
+    }
+  }
+
+  // Set ambiguity of cubes in cube_list[].
+  template <typename FACET_AMBIG_TYPE>
+  void set_cube_ambiguity_T
+  (const SHARPISO_GRID & grid,
+   const std::vector<ISO_VERTEX_INDEX> & cube_list,
+   const FACET_AMBIG_TYPE & facet_ambig_status,
+   std::vector<AMBIGUITY_TYPE> & cube_ambig)
+  {
+    cube_ambig.resize(cube_list.size());
+
+    for (std::size_t i = 0; i < cube_list.size(); i++) {
+      bool flag_pos = 
+        cube_has_facet_with_ambig_status
+        (grid, cube_list[i], SEPARATE_POS, facet_ambig_status);
+      bool flag_neg = 
+        cube_has_facet_with_ambig_status
+        (grid, cube_list[i], SEPARATE_NEG, facet_ambig_status);
+
+      if (flag_pos) {
+        if (flag_neg) 
+          { cube_ambig[i] = CONFLICTING_SEPARATION; }
+        else 
+          { cube_ambig[i] = SEPARATE_POS; }
+      }
+      else if (flag_neg) 
+        { cube_ambig[i] = SEPARATE_NEG; }
+      else 
+        { cube_ambig[i] = NOT_AMBIGUOUS; }
+    }
+  }
+
 };
 
 
@@ -239,7 +370,6 @@ void SHREC::propagate_sep
  std::vector<AMBIGUITY_TYPE> & facet_ambig_status)
 {
   std::queue<VERTEX_INDEX> facet_list;
-  static COORD_TYPE coord[DIM3];
 
   for (int i = 0; i < facet_ambig_status.size(); i++) {
     if (facet_ambig_status[i] == SEPARATE_POS ||
@@ -247,34 +377,36 @@ void SHREC::propagate_sep
       { facet_list.push(i); }
   }
 
-  while (facet_list.size() != 0) {
-    VERTEX_INDEX ifacet = facet_list.front();
-    facet_list.pop();
+  propagate_sep(scalar_grid, facet_list, facet_ambig_status);
+}
 
-    VERTEX_INDEX facet_v0 = ifacet/DIM3;
-    VERTEX_INDEX facet_orth_dir = ifacet%DIM3;
 
-    scalar_grid.ComputeCoord(facet_v0, coord);
-    if (coord[facet_orth_dir] != 0 &&
-        coord[facet_orth_dir]+1 != scalar_grid.AxisSize(facet_orth_dir)) {
-      // Internal facet.
-      
-      AMBIGUITY_STATUS fambig = AMBIGUITY_STATUS(facet_ambig_status[ifacet]);
-      AMBIGUITY_STATUS fambig_complement = SEPARATE_POS;
+/// Propagate SEPARATE_POS and SEPARATE_NEG across cube facets.
+/// Version using ambiguity of facets in facet_ambig.
+/// Facets are processed in increasing order, as in the previous version.
+void SHREC::propagate_sep
+(const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
+ FACET_AMBIG_LIST & facet_ambig)
+{
+  std::queue<VERTEX_INDEX> facet_list;
 
-      if (fambig == SEPARATE_POS) 
-        { fambig_complement = SEPARATE_NEG; }
+  for (NUM_TYPE k = 0; k < facet_ambig.NumFacets(); k++) {
+    if (facet_ambig.StatusAt(k) == SEPARATE_POS ||
+        facet_ambig.StatusAt(k) == SEPARATE_NEG) 
+      { facet_list.push(facet_ambig.Facet(k)); }
+  }
 
-      if (!two_cubes_have_facet_with_ambig_status
-          (scalar_grid, facet_v0, facet_orth_dir, fambig_complement, 
-           facet_ambig_status)) {
+  propagate_sep_T(scalar_grid, facet_list, facet_ambig);
+}
 
-        set_two_cube_facets_undecided_ambig
-          (scalar_grid, facet_v0, facet_orth_dir, fambig, 
-           facet_ambig_status, facet_list);
-      }
-    }
-  }
+
+/// Propagate SEPARATE_POS and SEPARATE_NEG from facets in facet_list.
+void SHREC::propagate_sep
+(const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
+ std::queue<VERTEX_INDEX> & facet_list,
+ std::vector<AMBIGUITY_TYPE> & facet_ambig_status)
+{
+  propagate_sep_T(scalar_grid, facet_list, facet_ambig_status);
 }
 
 
@@ -285,76 +417,49 @@ void SHREC::set_cube_ambiguity
  const std::vector<AMBIGUITY_TYPE> & facet_ambig_status,
  std::vector<AMBIGUITY_TYPE> & cube_ambig)
 {
-  cube_ambig.resize(cube_list.size());
-
-  for (int i = 0; i < cube_list.size(); i++) {
-    bool flag_pos = 
-      cube_has_facet_with_ambig_status
-      (grid, cube_list[i], SEPARATE_POS, facet_ambig_status);
-    bool flag_neg = 
-      cube_has_facet_with_ambig_status
-      (grid, cube_list[i], SEPARATE_NEG, facet_ambig_status);
-
-    if (flag_pos) {
-      if (flag_neg) 
-        { cube_ambig[i] = CONFLICTING_SEPARATION; }
-      else 
-        { cube_ambig[i] = SEPARATE_POS; }
-    }
-    else if (flag_neg) 
-      { cube_ambig[i] = SEPARATE_NEG; }
-    else 
-      { cube_ambig[i] = NOT_AMBIGUOUS; }
+  set_cube_ambiguity_T(grid, cube_list, facet_ambig_status, cube_ambig);
+}
 
-  }
+// Set ambiguity of cubes in cube_list[].
+// Version using ambiguity of facets in facet_ambig.
+void SHREC::set_cube_ambiguity
+(const SHARPISO_GRID & grid,
+ const std::vector<ISO_VERTEX_INDEX> & cube_list,
+ const FACET_AMBIG_LIST & facet_ambig,
+ std::vector<AMBIGUITY_TYPE> & cube_ambig)
+{
+  set_cube_ambiguity_T(grid, cube_list, facet_ambig, cube_ambig);
 }
 
 /// Set ambiguity of cubes in cube_list[].
+/// Facet ambiguity is stored only for facets of cubes in cube_list[].
 void SHREC::set_cube_ambiguity    
 (const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
  const GRADIENT_GRID_BASE & gradient_grid,
  const SCALAR_TYPE isovalue,
+ const SHARPISO_BIT_GRID & sign_grid,
  const std::vector<ISO_VERTEX_INDEX> & cube_list,
  const SHREC_PARAM & shrec_param,
  std::vector<AMBIGUITY_TYPE> & cube_ambig)
 {
-  const VERTEX_INDEX num_gridv = scalar_grid.NumVertices();
-  const VERTEX_INDEX num_gridf = DIM3 * num_gridv;
-  std::vector<AMBIGUITY_TYPE> 
-    facet_ambig_status(num_gridf, AMBIGUITY_TYPE(AMBIGUITY_NOT_SET));
   AMBIG_TABLE ambig_table;
+  FACET_AMBIG_LIST facet_ambig;
 
   ambig_table.SetCubeAmbiguityTable();
-
-  // Set facet_ambig_status[].
-  for (VERTEX_INDEX i = 0; i < cube_list.size(); i++) {
-    VERTEX_INDEX iv0 = cube_list[i];
-
-    for (int facet_orth_dir = 0; facet_orth_dir < DIM3; facet_orth_dir++) {
-      VERTEX_INDEX ifacet0 = iv0*DIM3 + facet_orth_dir;
-      if (facet_ambig_status[ifacet0] == AMBIGUITY_TYPE(AMBIGUITY_NOT_SET)) {
-        AMBIGUITY_STATUS ambig_status = 
-          decide_ambiguous_facet
-          (scalar_grid, gradient_grid, ambig_table,
-           isovalue, iv0, facet_orth_dir, shrec_param);
-        facet_ambig_status[ifacet0] = AMBIGUITY_TYPE(ambig_status);
-      }
-
-      VERTEX_INDEX iv1 = scalar_grid.NextVertex(iv0, facet_orth_dir);
-      VERTEX_INDEX ifacet1 = iv1*DIM3 + facet_orth_dir;
-      if (facet_ambig_status[ifacet1] == AMBIGUITY_TYPE(AMBIGUITY_NOT_SET)) {
-        AMBIGUITY_STATUS ambig_status = 
-          decide_ambiguous_facet
-          (scalar_grid, gradient_grid, ambig_table,
-           isovalue, iv1, facet_orth_dir, shrec_param);
-        facet_ambig_status[ifacet1] = AMBIGUITY_TYPE(ambig_status);
-      }
-    }
+  facet_ambig.SetFacets(scalar_grid, cube_list);
+
+  for (NUM_TYPE k = 0; k < facet_ambig.NumFacets(); k++) {
+    const VERTEX_INDEX ifacet = facet_ambig.Facet(k);
+    AMBIGUITY_STATUS ambig_status = 
+      decide_ambiguous_facet
+      (scalar_grid, gradient_grid, ambig_table,
+       isovalue, sign_grid, ifacet/DIM3, ifacet%DIM3, shrec_param);
+    facet_ambig.SetStatusAt(k, AMBIGUITY_TYPE(ambig_status));
   }
 
-  propagate_sep(scalar_grid, ambig_table, facet_ambig_status);
+  propagate_sep(scalar_grid, facet_ambig);
 
-  set_cube_ambiguity(scalar_grid, cube_list, facet_ambig_status, cube_ambig);
+  set_cube_ambiguity(scalar_grid, cube_list, facet_ambig, cube_ambig);
 }
 
 // Set ambiguity information.
@@ -381,6 +486,48 @@ void SHREC::set_ambiguity_info
 }
 
 
+// **************************************************
+// FACET_AMBIG_LIST
+// **************************************************
+
+// Set facets to all facets of cubes in cube_list[].
+void SHREC::FACET_AMBIG_LIST::SetFacets
+(const SHARPISO_GRID & grid,
+ const std::vector<ISO_VERTEX_INDEX> & cube_list)
+{
+  facet.clear();
+  facet.reserve(2*DIM3*cube_list.size());
+
+  for (std::size_t i = 0; i < cube_list.size(); i++) {
+    const VERTEX_INDEX iv0 = cube_list[i];
+
+    for (int orth_dir = 0; orth_dir < DIM3; orth_dir++) {
+      const VERTEX_INDEX iv1 = grid.NextVertex(iv0, orth_dir);
+      facet.push_back(iv0*DIM3 + orth_dir);
+      facet.push_back(iv1*DIM3 + orth_dir);
+    }
+  }
+
+  // Adjacent cubes share facets.
+  std::sort(facet.begin(), facet.end());
+  facet.erase(std::unique(facet.begin(), facet.end()), facet.end());
+
+  ambig_status.assign(facet.size(), AMBIGUITY_TYPE(AMBIGUITY_NOT_SET));
+}
+
+// Return location of ifacet in facet list.
+INDEX_DIFF_TYPE SHREC::FACET_AMBIG_LIST::Locate
+(const VERTEX_INDEX ifacet) const
+{
+  std::vector<VERTEX_INDEX>::const_iterator pos =
+    std::lower_bound(facet.begin(), facet.end(), ifacet);
+
+  if (pos == facet.end() || *pos != ifacet) { return(-1); }
+
+  return(pos - facet.begin());
+}
+
+
 // **************************************************
 // AMBIG_TABLE
 // **************************************************
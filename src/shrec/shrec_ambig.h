@@ -22,6 +22,7 @@
 #ifndef _SHREC_AMBIG_
 #define _SHREC_AMBIG_
 
+#include <queue>
 #include <string>
 #include <vector>
 
@@ -42,6 +43,7 @@ namespace SHREC {
   typedef unsigned char NUM_COMPONENTS_TYPE;
 
   class AMBIG_TABLE;
+  class FACET_AMBIG_LIST;
 
   // **************************************************
   // DETERMINE AMBIGUOUS FACETS
@@ -54,17 +56,28 @@ namespace SHREC {
    const NUM_TYPE orth_dir,
    const SCALAR_TYPE isovalue);
 
+  /// Return true if facet is ambiguous.
+  /// Version using signs of grid vertices.
+  /// @param sign_grid sign_grid.Scalar(iv) is true if the scalar value
+  ///   at vertex iv is greater than or equal to the isovalue.
+  bool is_grid_facet_ambiguous
+  (const SHARPISO_BIT_GRID & sign_grid,
+   const VERTEX_INDEX facet_v0,
+   const NUM_TYPE orth_dir);
+
   /// Decide and return ambiguity status of facet ifacet.
   /// @param facet_ambig_status[] Array containing facet ambiguity.
   ///        facet_ambig_status[iv*DIM3+d] is the ambiguity of the facet
   ///          containing primary vertex v and orthodonal direction d.
   ///        Note: When iv is on the upper-rightmost grid boundary,
   ///          the facet iv*DIM3+d may not actually be contained in the grid.
+  /// @param sign_grid Signs of scalar grid vertices.
   AMBIGUITY_STATUS decide_ambiguous_facet
   (const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
    const GRADIENT_GRID_BASE & gradient_grid,
    const AMBIG_TABLE & ambig_table,
    const SCALAR_TYPE isovalue,
+   const SHARPISO_BIT_GRID & sign_grid,
    const VERTEX_INDEX facet_v0,
    const int facet_orth_dir,
    const SHREC_PARAM & shrec_param);
@@ -80,6 +93,18 @@ namespace SHREC {
    const AMBIG_TABLE & ambig_table,
    std::vector<AMBIGUITY_TYPE> & facet_ambig_status);
 
+  /// Propagate SEPARATE_POS and SEPARATE_NEG across cube facets.
+  /// Version using ambiguity of facets in facet_ambig.
+  void propagate_sep
+  (const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
+   FACET_AMBIG_LIST & facet_ambig);
+
+  /// Propagate SEPARATE_POS and SEPARATE_NEG from facets in facet_list.
+  void propagate_sep
+  (const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
+   std::queue<VERTEX_INDEX> & facet_list,
+   std::vector<AMBIGUITY_TYPE> & facet_ambig_status);
+
   /// Set ambiguity of cubes in cube_list[].
   void set_cube_ambiguity
   (const SHARPISO_GRID & grid,
@@ -88,10 +113,20 @@ namespace SHREC {
    std::vector<AMBIGUITY_TYPE> & cube_ambig);
 
   /// Set ambiguity of cubes in cube_list[].
+  /// Version using ambiguity of facets in facet_ambig.
+  void set_cube_ambiguity
+  (const SHARPISO_GRID & grid,
+   const std::vector<ISO_VERTEX_INDEX> & cube_list,
+   const FACET_AMBIG_LIST & facet_ambig,
+   std::vector<AMBIGUITY_TYPE> & cube_ambig);
+
+  /// Set ambiguity of cubes in cube_list[].
+  /// @param sign_grid Signs of scalar grid vertices.
   void set_cube_ambiguity    
   (const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
    const GRADIENT_GRID_BASE & gradient_grid,
    const SCALAR_TYPE isovalue,
+   const SHARPISO_BIT_GRID & sign_grid,
    const std::vector<ISO_VERTEX_INDEX> & cube_list,
    const SHREC_PARAM & shrec_param,
    std::vector<AMBIGUITY_TYPE> & cube_ambig);
@@ -144,6 +179,60 @@ namespace SHREC {
   };
 
 
+  // **************************************************
+  // FACET_AMBIG_LIST
+  // **************************************************
+
+  /// Ambiguity status of the facets of a list of cubes.
+  /// Facet iv*DIM3+d is the facet containing primary vertex iv
+  ///   and orthogonal to direction d.
+  /// Facets are stored in a sorted list, so memory is proportional
+  ///   to the number of cubes, not to the number of grid facets.
+  class FACET_AMBIG_LIST {
+
+  protected:
+
+    /// Sorted list of facets.
+    std::vector<VERTEX_INDEX> facet;
+
+    /// ambig_status[k] is the ambiguity status of facet[k].
+    std::vector<AMBIGUITY_TYPE> ambig_status;
+
+  public:
+
+    /// Set facets to all facets of cubes in cube_list[].
+    /// Set status of each facet to AMBIGUITY_NOT_SET.
+    void SetFacets
+    (const SHARPISO_GRID & grid,
+     const std::vector<ISO_VERTEX_INDEX> & cube_list);
+
+    // Get functions.
+    NUM_TYPE NumFacets() const
+    { return(facet.size()); }
+    VERTEX_INDEX Facet(const NUM_TYPE k) const
+    { return(facet[k]); }
+    AMBIGUITY_TYPE StatusAt(const NUM_TYPE k) const
+    { return(ambig_status[k]); }
+
+    /// Return location of ifacet in facet list.
+    /// Return -1 if ifacet is not in list.
+    INDEX_DIFF_TYPE Locate(const VERTEX_INDEX ifacet) const;
+
+    /// Return ambiguity status of facet ifacet.
+    /// Return AMBIGUITY_NOT_SET if ifacet is not in list.
+    AMBIGUITY_TYPE Status(const VERTEX_INDEX ifacet) const
+    {
+      const INDEX_DIFF_TYPE k = Locate(ifacet);
+      if (k < 0) { return(AMBIGUITY_TYPE(AMBIGUITY_NOT_SET)); }
+      return(ambig_status[k]);
+    }
+
+    // Set functions.
+    void SetStatusAt(const NUM_TYPE k, const AMBIGUITY_TYPE s)
+    { ambig_status[k] = s; }
+  };
+
+
   // **************************************************
   // AMBIGUITY ROUTINES
   // **************************************************
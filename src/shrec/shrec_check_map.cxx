@@ -1171,7 +1171,7 @@ bool SHREC::check_edge_manifold
  const std::vector<SHARPISO::VERTEX_INDEX> & gcube_map,
  const bool flag_extended)
 {
-  static CUBE_CONNECTED_ARRAY connected_sharp;
+  static thread_local CUBE_CONNECTED_ARRAY connected_sharp;
 
   find_connected_sharp
     (scalar_grid, isovalue, from_cube, isovert, gcube_map, connected_sharp);
@@ -1286,7 +1286,7 @@ bool SHREC::check_edge_manifoldII
  const bool flag_extended)
 {
   IJK::PROCEDURE_ERROR error("check_edge_between_sharp_cubesII");
-  static CUBE_CONNECTED_ARRAY connected_sharp;
+  static thread_local CUBE_CONNECTED_ARRAY connected_sharp;
   INDEX_DIFF_TYPE from_gcube0_index = 
     isovert.GCubeIndex(from_cube0_index, error);
   INDEX_DIFF_TYPE from_gcube1_index = 
@@ -1503,7 +1503,7 @@ bool SHREC::check_edge_manifoldIII
  const bool flag_extended)
 {
   INDEX_DIFF_TYPE gcube_index[3], to_gcube_index;
-  static CUBE_CONNECTED_ARRAY connected_sharp;
+  static thread_local CUBE_CONNECTED_ARRAY connected_sharp;
   IJK::PROCEDURE_ERROR error("check_edge_between_sharp_cubesIII");
 
   to_gcube_index = isovert.GCubeIndex(to_cube, error);
@@ -2176,12 +2176,20 @@ namespace {
         VERTEX_INDEX v1 = v0;
         for (GRID_COORD_TYPE x1 = rmin[d1]; x1 <= rmax[d1]; x1++) {
 
-          if (x1 == 0 || x1 >= scalar_grid.AxisSize(d1)) { continue; }
+          // Skip boundary edges.
+          if (x1 == 0 || x1+1 >= scalar_grid.AxisSize(d1)) {
+            v1 = scalar_grid.NextVertex(v1, d1);
+            continue;
+          }
 
           VERTEX_INDEX v2 = v1;
           for (GRID_COORD_TYPE x2 = rmin[d2]; x2 <= rmax[d2]; x2++) {
 
-            if (x2 == 0 || x2 >= scalar_grid.AxisSize(d2)) { continue; }
+            // Skip boundary edges.
+            if (x2 == 0 || x2+1 >= scalar_grid.AxisSize(d2)) {
+              v2 = scalar_grid.NextVertex(v2, d2);
+              continue;
+            }
 
             const VERTEX_INDEX iend0 = v2;
             const VERTEX_INDEX iend1 = scalar_grid.NextVertex(iend0, edge_dir);
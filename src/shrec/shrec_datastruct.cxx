@@ -29,6 +29,7 @@
 
 #include "shrec_types.h"
 #include "shrec_datastruct.h"
+#include "shrec_thread.txx"
 
 using namespace IJK;
 using namespace SHREC;
@@ -69,6 +70,9 @@ void SHREC_PARAM::Init()
   flag_store_isovert_info = false;
   flag_grad2hermite = false;
   flag_grad2hermiteI = false;
+  flag_span_space_index = false;
+  flag_shared_active_cubes = false;
+  num_isovalue_threads = 1;
   min_grad_selection_cube_offset = 0;
 }
 
@@ -142,6 +146,8 @@ bool SHREC_PARAM::NormalsRequired() const
 // Initialize SHREC_DATA
 void SHREC_DATA::Init()
 {
+  scalar_grid_ptr = &scalar_grid;
+  gradient_grid_ptr = &gradient_grid;
   is_scalar_grid_set = false;
   is_gradient_grid_set = false;
   are_edgeI_set = false;
@@ -149,8 +155,33 @@ void SHREC_DATA::Init()
 
 void SHREC_DATA::FreeAll()
 {
+  scalar_grid_ptr = &scalar_grid;
+  gradient_grid_ptr = &gradient_grid;
   is_scalar_grid_set = false;
   is_gradient_grid_set = false;
+  minmax_bricks.Clear();
+  span_space_index.Clear();
+}
+
+// Compute min and max of bricks of scalar grid.
+void SHREC_DATA::SetMinMaxBricks()
+{
+  minmax_bricks.Set
+    (ScalarGrid(), SHARPISO_MINMAX_BRICKS::DEFAULT_BRICK_EDGE_LENGTH,
+     SHARPISO_MINMAX_BRICKS::DEFAULT_SUPERBRICK_FACTOR);
+}
+
+// Build span space index of cubes of scalar grid.
+void SHREC_DATA::SetSpanSpaceIndex()
+{
+  PROCEDURE_ERROR error("SHREC_DATA::SetSpanSpaceIndex");
+
+  if (!IsScalarGridSet()) {
+    error.AddMessage("Programming error. Scalar grid must be set before span space index.");
+    throw error;
+  }
+
+  span_space_index.Set(ScalarGrid());
 }
 
 
@@ -159,7 +190,9 @@ void SHREC_DATA::CopyScalarGrid
 (const SHARPISO_SCALAR_GRID_BASE & scalar_grid2)
 {
   scalar_grid.Copy(scalar_grid2);
+  scalar_grid_ptr = &scalar_grid;
   scalar_grid.SetSpacing(scalar_grid2.SpacingPtrConst());
+  SetMinMaxBricks();
   is_scalar_grid_set = true;
 }
 
@@ -168,6 +201,7 @@ void SHREC_DATA::CopyGradientGrid
 (const GRADIENT_GRID_BASE & gradient_grid2)
 {
   gradient_grid.Copy(gradient_grid2);
+  gradient_grid_ptr = &gradient_grid;
   gradient_grid.SetSpacing(gradient_grid2.SpacingPtrConst());
   is_gradient_grid_set = true;
 }
@@ -177,7 +211,9 @@ void SHREC_DATA::SubsampleScalarGrid
 (const SHARPISO_SCALAR_GRID_BASE & scalar_grid2, const int subsample_resolution)
 {
   scalar_grid.Subsample(scalar_grid2, subsample_resolution);
+  scalar_grid_ptr = &scalar_grid;
   scalar_grid.SetSpacing(subsample_resolution, scalar_grid2.SpacingPtrConst());
+  SetMinMaxBricks();
   is_scalar_grid_set = true;
 }
 
@@ -186,18 +222,49 @@ void SHREC_DATA::SupersampleScalarGrid
 (const SHARPISO_SCALAR_GRID_BASE & scalar_grid2, 
  const int supersample_resolution)
 {
+#if defined(SHARPISO_SCALAR_STORAGE_UINT8) || \
+  defined(SHARPISO_SCALAR_STORAGE_UINT16)
+  // Interpolated values would be rounded to integers.
+  PROCEDURE_ERROR error("SHREC_DATA::SupersampleScalarGrid");
+  error.AddMessage
+    ("Programming error. Supersampling requires floating point scalar storage.");
+  throw error;
+#endif
+
   scalar_grid.Supersample(scalar_grid2, supersample_resolution);
+  scalar_grid_ptr = &scalar_grid;
   scalar_grid.SetSpacing(float(1.0/supersample_resolution),
                          scalar_grid2.SpacingPtrConst());
+  SetMinMaxBricks();
  is_scalar_grid_set = true;
 }
 
+// Use scalar grid without copying.
+void SHREC_DATA::WrapScalarGrid
+(const SHARPISO_SCALAR_GRID_BASE & scalar_grid2)
+{
+  scalar_grid_ptr = &scalar_grid2;
+  SetMinMaxBricks();
+  is_scalar_grid_set = true;
+}
+
+// Use scalar and gradient grids without copying.
+void SHREC_DATA::WrapGrids
+(const SHARPISO_SCALAR_GRID_BASE & scalar_grid2,
+ const GRADIENT_GRID_BASE & gradient_grid2)
+{
+  WrapScalarGrid(scalar_grid2);
+  gradient_grid_ptr = &gradient_grid2;
+  is_gradient_grid_set = true;
+}
+
 /// Subsample gradient grid
 /// Rescale gradients by multiplying them by the subsample_resolution.
 void SHREC_DATA::SubsampleGradientGrid
 (const GRADIENT_GRID_BASE & gradient_grid2, const int subsample_resolution)
 {
   gradient_grid.Subsample(gradient_grid2, subsample_resolution);
+  gradient_grid_ptr = &gradient_grid;
   gradient_grid.ScalarMultiply(subsample_resolution);
   gradient_grid.SetSpacing(subsample_resolution,
                            gradient_grid2.SpacingPtrConst());
@@ -314,6 +381,7 @@ SHREC::SHREC_TIME::SHREC_TIME()
 void SHREC::SHREC_TIME::Clear()
 {
   preprocessing = 0.0;
+  gradient = 0.0;
   extract = 0.0;
   merge_identical = 0.0;
   position = 0.0;
@@ -324,6 +392,7 @@ void SHREC::SHREC_TIME::Clear()
 void SHREC::SHREC_TIME::Add(const SHREC_TIME & isodual_time)
 {
   preprocessing += isodual_time.preprocessing;
+  gradient += isodual_time.gradient;
   extract += isodual_time.extract;
   merge_identical += isodual_time.merge_identical;
   position += isodual_time.position;
@@ -559,11 +628,22 @@ void SHREC::MERGE_DATA::Init
   compute_num_grid_vertices(dimension, axis_size, num_vertices);
   num_edges = dimension*num_vertices;
   vertex_id0 = num_obj_per_edge*num_edges;
-  MERGE_INDEX num_obj =
-    num_obj_per_vertex*num_vertices + num_obj_per_edge*num_edges;
-  INTEGER_LIST<MERGE_INDEX,MERGE_INDEX>::Init(num_obj);
+  num_obj = num_obj_per_vertex*num_vertices + num_obj_per_edge*num_edges;
+  num_threads = 1;
+
+  // Integer list is allocated on first use by AllocateIntegerList().
+  INTEGER_LIST<MERGE_INDEX,MERGE_INDEX>::Init(0);
 }
 
+void SHREC::MERGE_DATA::AllocateIntegerList()
+{
+  if (MaxNumInt() < num_obj) {
+    FreeListLoc();
+    INTEGER_LIST<MERGE_INDEX,MERGE_INDEX>::Init(num_obj);
+  }
+}
+
+// Check integer list allocated by AllocateIntegerList().
 bool SHREC::MERGE_DATA::Check(ERROR & error) const
 {
   if (MaxNumInt() <
@@ -575,3 +655,34 @@ bool SHREC::MERGE_DATA::Check(ERROR & error) const
   return(true);
 }
 
+// Merge identical values in list0.
+void SHREC::merge_identical_vertices
+(const std::vector<ISO_VERTEX_INDEX> & list0,
+ std::vector<ISO_VERTEX_INDEX> & list1_nodup,
+ std::vector<VERTEX_INDEX> & list0_map, MERGE_DATA & merge_data)
+{
+  // Sorting takes a few linear passes over list0.  Allocating and
+  //   clearing the integer list takes time proportional to the grid.
+  // Sorting is faster when list0 is less than about 1/20 
+  //   the number of grid objects.
+  const MERGE_INDEX SORT_RATIO = 20;
+
+  if (merge_data.MaxNumInt() == 0 &&
+      MERGE_INDEX(list0.size()) < merge_data.NumObj()/SORT_RATIO) {
+    const int num_threads = merge_data.NumThreads();
+
+    merge_identical_by_sorting
+      (list0, list1_nodup, list0_map, num_threads,
+       [num_threads](const std::size_t num_blocks, auto f)
+       { apply_in_parallel(num_threads, num_blocks, f); });
+  }
+  else {
+    merge_data.AllocateIntegerList();
+
+    IJK::PROCEDURE_ERROR error("merge_identical_vertices");
+    if (!merge_data.Check(error)) { throw error; }
+
+    merge_identical(list0, list1_nodup, list0_map, merge_data);
+  }
+}
+
@@ -176,6 +176,19 @@ namespace SHREC {
     /// If true, convert gradient to hermite data using linear interpolation.
     bool flag_grad2hermiteI;
 
+    /// If true, build span space index of grid cubes
+    ///   to find active cubes for each isovalue.
+    bool flag_span_space_index;
+
+    /// If true, find active cubes for all isovalues
+    ///   in a single pass over the scalar grid.
+    /// Only active cube discovery is shared.  Isosurface extraction
+    ///   and vertex positioning still run once per isovalue.
+    bool flag_shared_active_cubes;
+
+    /// Number of threads processing different isovalues concurrently.
+    int num_isovalue_threads;
+
 
   public:
 
@@ -221,6 +234,20 @@ namespace SHREC {
     SHARPISO_SCALAR_GRID scalar_grid;  ///< Regular grid of scalar values.
     GRADIENT_GRID gradient_grid;       ///< Regular grid of vertex gradients.
 
+    /// Scalar grid used by SHREC_DATA.
+    /// Points to scalar_grid or to a wrapped grid owned by the caller.
+    const SHARPISO_SCALAR_GRID_BASE * scalar_grid_ptr;
+
+    /// Gradient grid used by SHREC_DATA.
+    /// Points to gradient_grid or to a wrapped grid owned by the caller.
+    const GRADIENT_GRID_BASE * gradient_grid_ptr;
+
+    /// Min and max scalar values of bricks of scalar_grid.
+    SHARPISO_MINMAX_BRICKS minmax_bricks;
+
+    /// Span space index of cubes of scalar_grid.
+    SPAN_SPACE_INDEX span_space_index;
+
     /// Coordinate of edge-isosurface intersections
     std::vector<COORD_TYPE> edgeI_coord;  
 
@@ -236,6 +263,9 @@ namespace SHREC {
     void Init();
     void FreeAll();
 
+    /// Compute min and max of bricks of scalar_grid.
+    void SetMinMaxBricks();
+
   public:
     SHREC_DATA() { Init(); };
     ~SHREC_DATA() { FreeAll(); };
@@ -271,6 +301,21 @@ namespace SHREC {
        const bool flag_subsample, const int subsample_resolution,
        const bool flag_supersample, const int supersample_resolution);
 
+    /// Use scalar_grid2 without copying.
+    /// scalar_grid2 must not be modified or deleted
+    ///   while SHREC_DATA is in use.
+    void WrapScalarGrid(const SHARPISO_SCALAR_GRID_BASE & scalar_grid2);
+
+    /// Use scalar_grid2 and gradient_grid2 without copying.
+    /// Grids must not be modified or deleted while SHREC_DATA is in use.
+    void WrapGrids
+      (const SHARPISO_SCALAR_GRID_BASE & scalar_grid2,
+       const GRADIENT_GRID_BASE & gradient_grid2);
+
+    /// Build span space index of cubes of scalar_grid.
+    /// Precondition: Scalar grid is set.
+    void SetSpanSpaceIndex();
+
     /// Set edge-isosurface intersections and normals.
     void SetEdgeI(const std::vector<COORD_TYPE> & edgeI_coord,
                   const std::vector<GRADIENT_COORD_TYPE> & edgeI_normal_coord);
@@ -287,11 +332,19 @@ namespace SHREC {
 
     /// Return scalar_grid.
     const SHARPISO_SCALAR_GRID_BASE & ScalarGrid() const
-      { return(scalar_grid); };
+      { return(*scalar_grid_ptr); };
 
     /// Return gradient_grid.
     const GRADIENT_GRID_BASE & GradientGrid() const     
-      { return(gradient_grid); };
+      { return(*gradient_grid_ptr); };
+
+    /// Return min and max of bricks of scalar_grid.
+    const SHARPISO_MINMAX_BRICKS & MinMaxBricks() const
+      { return(minmax_bricks); };
+
+    /// Return span space index of cubes of scalar_grid.
+    const SPAN_SPACE_INDEX & SpanSpaceIndex() const
+      { return(span_space_index); };
 
     /// Return edgeI coordinates.
     const std::vector<COORD_TYPE> & EdgeICoord() const
@@ -320,6 +373,7 @@ namespace SHREC {
     // all times are in seconds
     float preprocessing;  
     // time to create data structure for faster isosurface extraction
+    float gradient;         // time to compute gradients (-lazy_grad)
     float extract;          // time to extract isosurface mesh
     float merge_identical;  // time to merge identical vertices
     float position;         // time to position isosurface vertices
@@ -473,6 +527,8 @@ namespace SHREC {
     MERGE_INDEX num_obj_per_edge;      ///< Number of objects per edge.
     MERGE_INDEX num_obj_per_grid_vertex; ///< Number of objects per grid vertex.
     MERGE_INDEX vertex_id0;            ///< First vertex identifier.
+    MERGE_INDEX num_obj;               ///< Number of objects.
+    int num_threads;                   ///< Number of threads for sorting.
 
     /// Initialize.
     void Init(const int dimension, const AXIS_SIZE_TYPE * axis_size,
@@ -496,6 +552,10 @@ namespace SHREC {
     MERGE_INDEX NumObjPerEdge() const { return(num_obj_per_edge); };
     MERGE_INDEX NumObjPerGridVertex() const
       { return(num_obj_per_grid_vertex); };
+    MERGE_INDEX NumObj() const          /// Number of objects.
+      { return(num_obj); };
+    int NumThreads() const              /// Number of threads for sorting.
+      { return(num_threads); };
     MERGE_INDEX VertexIdentifier       /// Vertex identifier.
       (const MERGE_INDEX iv) const { return(vertex_id0 + iv); };
     MERGE_INDEX VertexIdentifier       /// Vertex identifier.
@@ -515,9 +575,30 @@ namespace SHREC {
     inline MERGE_INDEX GetEdgeDir(const MERGE_INDEX isov) const
       { return(isov%NumObjPerGridVertex()); };
 
+    // set functions
+    void SetNumThreads(const int num_threads)
+      { this->num_threads = num_threads; };
+
+    /// Allocate integer list for all objects, if not already allocated.
+    /// Integer list memory is proportional to the number of grid objects.
+    void AllocateIntegerList();
+
     bool Check(IJK::ERROR & error) const;     ///< Check allocated memory.
   };
 
+  /// Merge identical values in list0.
+  /// Sorts list0 if list0 is short relative to the number of objects
+  ///   in merge_data.  Otherwise, uses the merge_data integer list,
+  ///   allocating it if necessary.
+  /// Sorting uses merge_data.NumThreads() threads.
+  /// Both methods return the same list1_nodup and list0_map.
+  /// @param[out] list1_nodup List without any duplicate values.
+  /// @param[out] list0_map Mapping from list0 to locations in list1_nodup.
+  void merge_identical_vertices
+  (const std::vector<ISO_VERTEX_INDEX> & list0,
+   std::vector<ISO_VERTEX_INDEX> & list1_nodup,
+   std::vector<VERTEX_INDEX> & list0_map, MERGE_DATA & merge_data);
+
   /// Merge data structure for isosurface vertices.
   /// Vertices are identified by a single integer.
   class ISO_MERGE_DATA: public MERGE_DATA {
@@ -28,7 +28,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #endif
 
 //Flag to help with debugging
-extern bool flag_debug;
+extern thread_local bool flag_debug;
 
 //Identify debug statements 
 #define MSDEBUG() using namespace std;
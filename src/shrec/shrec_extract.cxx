@@ -19,16 +19,341 @@
   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 */
 
+#include <algorithm>
+
 #include "ijkgrid_macros.h"
 #include "ijkisopoly.txx"
 #include "ijktime.txx"
 
 #include "shrec_extract.h"
+#include "shrec_thread.txx"
 
 using namespace IJK;
 using namespace SHREC;
 
 
+// **************************************************
+// LOCAL ROUTINES
+// **************************************************
+
+namespace {
+
+  /// Apply f(iend0, edge_dir) to each interior grid edge along edge_dir
+  ///   in an active brick on the lines of edges starting 
+  ///   at vlist.VertexIndex(i) for i in [i0,i1).
+  /// Lines are visited in increasing order of i.
+  /// If active_brick is not set, visit every edge on the lines.
+  /// @param vlist Interior vertices of facet orthogonal to edge_dir.
+  template <typename FTYPE>
+  void for_each_interior_edge_in_active_brick_on_lines
+  (const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
+   const SHARPISO_ACTIVE_BRICKS & active_brick, const int edge_dir,
+   const IJK::FACET_INTERIOR_VERTEX_LIST<VERTEX_INDEX> & vlist,
+   const VERTEX_INDEX i0, const VERTEX_INDEX i1, FTYPE f)
+  {
+    const VERTEX_INDEX axis_increment = scalar_grid.AxisIncrement(edge_dir);
+    const GRID_COORD_TYPE num_edges = scalar_grid.AxisSize(edge_dir)-1;
+    GRID_COORD_TYPE coord[DIM3];
+
+    if (!active_brick.IsSet()) {
+      for (VERTEX_INDEX i = i0; i < i1; i++) {
+        VERTEX_INDEX iend0 = vlist.VertexIndex(i);
+        for (GRID_COORD_TYPE c = 0; c < num_edges; c++) {
+          f(iend0, edge_dir);
+          iend0 += axis_increment;
+        }
+      }
+      return;
+    }
+
+    const AXIS_SIZE_TYPE brick_edge_length = active_brick.BrickEdgeLength();
+
+    for (VERTEX_INDEX i = i0; i < i1; i++) {
+
+      const VERTEX_INDEX iv0 = vlist.VertexIndex(i);
+      scalar_grid.ComputeCoord(iv0, coord);
+
+      // Process edges along edge_dir one brick at a time.
+      for (GRID_COORD_TYPE c0 = 0; c0 < num_edges; 
+           c0 += brick_edge_length) {
+
+        coord[edge_dir] = c0;
+        if (!active_brick.IsCubeInActiveBrick(coord)) { continue; }
+
+        GRID_COORD_TYPE c1 = c0 + brick_edge_length;
+        if (c1 > num_edges) { c1 = num_edges; }
+
+        VERTEX_INDEX iend0 = iv0 + c0*axis_increment;
+        for (GRID_COORD_TYPE c = c0; c < c1; c++) {
+          f(iend0, edge_dir);
+          iend0 += axis_increment;
+        }
+      }
+    }
+  }
+
+  /// Apply f(iend0, edge_dir) to each interior grid edge 
+  ///   in an active brick.
+  /// Edges are visited in the same order as IJK_FOR_EACH_INTERIOR_GRID_EDGE.
+  /// If active_brick is not set, visit every interior grid edge.
+  template <typename FTYPE>
+  void for_each_interior_edge_in_active_brick
+  (const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
+   const SHARPISO_ACTIVE_BRICKS & active_brick, FTYPE f)
+  {
+    if (!active_brick.IsSet() || scalar_grid.Dimension() != DIM3) {
+      IJK_FOR_EACH_INTERIOR_GRID_EDGE
+        (iend0, edge_dir, scalar_grid, VERTEX_INDEX) 
+        { f(iend0, edge_dir); }
+      return;
+    }
+
+    IJK::FACET_INTERIOR_VERTEX_LIST<VERTEX_INDEX> vlist(scalar_grid, 0, true);
+
+    for (int edge_dir = 0; edge_dir < DIM3; edge_dir++) {
+      vlist.GetVertices(scalar_grid, edge_dir);
+      for_each_interior_edge_in_active_brick_on_lines
+        (scalar_grid, active_brick, edge_dir, vlist, 0, vlist.NumVertices(), f);
+    }
+  }
+
+  /// Get keys of bipolar interior grid edges along edge_dir
+  ///   whose lower endpoint iend0 is the primary vertex of a cube 
+  ///   in cube_list.
+  /// Every bipolar interior edge has such a cube, and that cube is active.
+  /// Edge key is iv0*AxisSize(edge_dir)+c where iend0 = iv0 + c*increment
+  ///   and iv0 is on the facet orthogonal to edge_dir.
+  /// Keys are sorted to match the order of IJK_FOR_EACH_INTERIOR_GRID_EDGE.
+  /// @param cube_list[] List of active cubes.
+  /// @param sign_grid Signs of scalar grid vertices.
+  void get_bipolar_edge_keys
+  (const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
+   const SHARPISO_BIT_GRID & sign_grid,
+   const std::vector<VERTEX_INDEX> & cube_list, const int edge_dir,
+   std::vector<long long> & edge_key)
+  {
+    const VERTEX_INDEX axis_increment = scalar_grid.AxisIncrement(edge_dir);
+    const long long axis_size = scalar_grid.AxisSize(edge_dir);
+    GRID_COORD_TYPE coord[DIM3];
+
+    edge_key.clear();
+    for (std::size_t i = 0; i < cube_list.size(); i++) {
+      const VERTEX_INDEX iend0 = cube_list[i];
+      const VERTEX_INDEX iend1 = iend0 + axis_increment;
+
+      if (sign_grid.Scalar(iend0) == sign_grid.Scalar(iend1)) { continue; }
+
+      scalar_grid.ComputeCoord(iend0, coord);
+
+      bool is_interior = true;
+      for (int d = 1; d < DIM3; d++) {
+        if (coord[(edge_dir+d)%DIM3] == 0) { is_interior = false; }
+      }
+      if (!is_interior) { continue; }
+
+      const VERTEX_INDEX iv0 = iend0 - coord[edge_dir]*axis_increment;
+      edge_key.push_back(iv0*axis_size + coord[edge_dir]);
+    }
+
+    std::sort(edge_key.begin(), edge_key.end());
+  }
+
+  /// Return lower endpoint of edge along edge_dir with key edge_key.
+  inline VERTEX_INDEX get_edge_key_endpoint
+  (const SHARPISO_SCALAR_GRID_BASE & scalar_grid, const int edge_dir,
+   const long long edge_key)
+  {
+    const long long axis_size = scalar_grid.AxisSize(edge_dir);
+    const VERTEX_INDEX iv0 = edge_key/axis_size;
+    const VERTEX_INDEX c = edge_key%axis_size;
+    return(iv0 + c*scalar_grid.AxisIncrement(edge_dir));
+  }
+
+  /// Apply f(iend0, edge_dir) to each bipolar interior grid edge
+  ///   whose lower endpoint iend0 is the primary vertex of a cube 
+  ///   in cube_list.
+  /// Every bipolar interior edge has such a cube, and that cube is active.
+  /// Edges are visited in the same order as IJK_FOR_EACH_INTERIOR_GRID_EDGE.
+  /// @param cube_list[] List of active cubes.
+  /// @param sign_grid Signs of scalar grid vertices.
+  template <typename FTYPE>
+  void for_each_bipolar_edge_of_cube_list
+  (const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
+   const SHARPISO_BIT_GRID & sign_grid,
+   const std::vector<VERTEX_INDEX> & cube_list, FTYPE f)
+  {
+    std::vector<long long> edge_key;
+
+    for (int edge_dir = 0; edge_dir < DIM3; edge_dir++) {
+
+      get_bipolar_edge_keys
+        (scalar_grid, sign_grid, cube_list, edge_dir, edge_key);
+
+      for (std::size_t i = 0; i < edge_key.size(); i++) {
+        f(get_edge_key_endpoint(scalar_grid, edge_dir, edge_key[i]), 
+          edge_dir);
+      }
+    }
+  }
+
+  /// Apply f(iend0, edge_dir) to interior grid edges in active_region.
+  /// Edges are visited in the same order as IJK_FOR_EACH_INTERIOR_GRID_EDGE.
+  /// All bipolar interior edges are visited.
+  /// Some edges which are not bipolar may be visited.
+  template <typename FTYPE>
+  void for_each_interior_edge_in_active_region
+  (const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
+   const SHARPISO_BIT_GRID & sign_grid,
+   const ACTIVE_GRID_REGION & active_region, FTYPE f)
+  {
+    if (active_region.IsCubeListSet() && scalar_grid.Dimension() == DIM3) {
+      for_each_bipolar_edge_of_cube_list
+        (scalar_grid, sign_grid, active_region.cube_list, f);
+    }
+    else {
+      for_each_interior_edge_in_active_brick
+        (scalar_grid, active_region.active_brick, f);
+    }
+  }
+
+  /// Extract dual isosurface polytope around edge (iend0, iend1)
+  ///   if edge is bipolar.
+  /// Read signs of edge endpoints from sign_grid.
+  inline void extract_dual_isopoly_around_bipolar_edge
+  (const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
+   const SHARPISO_BIT_GRID & sign_grid,
+   const VERTEX_INDEX iend0, const int edge_dir,
+   std::vector<ISO_VERTEX_INDEX> & iso_poly)
+  {
+    const VERTEX_INDEX iend1 = scalar_grid.NextVertex(iend0, edge_dir);
+    const bool is_end0_positive = sign_grid.Scalar(iend0);
+    const bool is_end1_positive = sign_grid.Scalar(iend1);
+
+    if (!is_end0_positive && is_end1_positive) {
+      extract_dual_isopoly_around_edge
+        (scalar_grid, iend0, iend1, edge_dir, iso_poly);
+    }
+    else if (is_end0_positive && !is_end1_positive) {
+      extract_dual_isopoly_around_edge_reverse_orient
+        (scalar_grid, iend0, iend1, edge_dir, iso_poly);
+    }
+  }
+
+  /// Extract dual isosurface polytope around edge (iend0, iend1)
+  ///   if edge is bipolar.
+  /// Return location of isosurface vertices on facets.
+  /// Read signs of edge endpoints from sign_grid.
+  inline void extract_dual_isopoly_around_bipolar_edge
+  (const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
+   const SHARPISO_BIT_GRID & sign_grid,
+   const VERTEX_INDEX iend0, const int edge_dir,
+   std::vector<ISO_VERTEX_INDEX> & iso_poly,
+   std::vector<FACET_VERTEX_INDEX> & facet_vertex)
+  {
+    const VERTEX_INDEX iend1 = scalar_grid.NextVertex(iend0, edge_dir);
+    const bool is_end0_positive = sign_grid.Scalar(iend0);
+    const bool is_end1_positive = sign_grid.Scalar(iend1);
+
+    if (!is_end0_positive && is_end1_positive) {
+      extract_dual_isopoly_around_edge
+        (scalar_grid, iend0, iend1, edge_dir, iso_poly, facet_vertex);
+    }
+    else if (is_end0_positive && !is_end1_positive) {
+      extract_dual_isopoly_around_edge_reverse_orient
+        (scalar_grid, iend0, iend1, edge_dir, iso_poly, facet_vertex);
+    }
+  }
+
+  /// Isosurface polytopes extracted from one slab of grid edges.
+  class SLAB_ISOPOLY {
+  public:
+    std::vector<ISO_VERTEX_INDEX> iso_poly;
+    std::vector<FACET_VERTEX_INDEX> facet_vertex;
+  };
+
+  /// Apply extract(iend0, edge_dir, slab_isopoly) to interior grid edges 
+  ///   in active_region using num_threads threads.
+  /// Edges in each direction are split into slabs of consecutive lines
+  ///   of edges, i.e., consecutive facet vertices or edge keys.
+  /// Each slab is extracted into its own SLAB_ISOPOLY.  Slabs are 
+  ///   appended to iso_poly and facet_vertex in the order visited 
+  ///   by for_each_interior_edge_in_active_region,
+  ///   so output is identical to sequential extraction.
+  /// @pre scalar_grid.Dimension() == DIM3.
+  template <typename FTYPE>
+  void extract_dual_isopoly_in_slabs
+  (const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
+   const SHARPISO_BIT_GRID & sign_grid,
+   const ACTIVE_GRID_REGION & active_region, const int num_threads,
+   FTYPE extract, 
+   std::vector<ISO_VERTEX_INDEX> & iso_poly,
+   std::vector<FACET_VERTEX_INDEX> & facet_vertex)
+  {
+    // More slabs than threads balances slabs with large isosurface patches.
+    const NUM_TYPE num_slabs_per_dir = 4*num_threads;
+    const NUM_TYPE num_slabs = DIM3*num_slabs_per_dir;
+    const bool flag_cube_list = active_region.IsCubeListSet();
+    std::vector<long long> edge_key[DIM3];
+    IJK::FACET_INTERIOR_VERTEX_LIST<VERTEX_INDEX> 
+      vlist0(scalar_grid, 0, false), vlist1(scalar_grid, 1, false), 
+      vlist2(scalar_grid, 2, false);
+    const IJK::FACET_INTERIOR_VERTEX_LIST<VERTEX_INDEX> * vlist[DIM3] =
+      { &vlist0, &vlist1, &vlist2 };
+    std::vector<SLAB_ISOPOLY> slab_isopoly(num_slabs);
+
+    if (flag_cube_list) {
+      for (int edge_dir = 0; edge_dir < DIM3; edge_dir++) {
+        get_bipolar_edge_keys
+          (scalar_grid, sign_grid, active_region.cube_list, edge_dir, 
+           edge_key[edge_dir]);
+      }
+    }
+
+    compute_in_parallel_output_in_order
+      (num_threads, num_slabs, 2*num_threads,
+       [&](const NUM_TYPE k) {
+        const int edge_dir = k/num_slabs_per_dir;
+        const NUM_TYPE j = k%num_slabs_per_dir;
+        SLAB_ISOPOLY & slab = slab_isopoly[k];
+
+        if (flag_cube_list) {
+          const NUM_TYPE n = edge_key[edge_dir].size();
+          const NUM_TYPE i0 = (n*j)/num_slabs_per_dir;
+          const NUM_TYPE i1 = (n*(j+1))/num_slabs_per_dir;
+          for (NUM_TYPE i = i0; i < i1; i++) {
+            extract(get_edge_key_endpoint
+                    (scalar_grid, edge_dir, edge_key[edge_dir][i]),
+                    edge_dir, slab);
+          }
+        }
+        else {
+          const NUM_TYPE n = vlist[edge_dir]->NumVertices();
+          for_each_interior_edge_in_active_brick_on_lines
+            (scalar_grid, active_region.active_brick, edge_dir,
+             *vlist[edge_dir], (n*j)/num_slabs_per_dir,
+             (n*(j+1))/num_slabs_per_dir,
+             [&](const VERTEX_INDEX iend0, const int edge_dir) {
+              extract(iend0, edge_dir, slab);
+            });
+        }
+      },
+       [&](const NUM_TYPE k) {
+        SLAB_ISOPOLY & slab = slab_isopoly[k];
+        iso_poly.insert
+          (iso_poly.end(), slab.iso_poly.begin(), slab.iso_poly.end());
+        facet_vertex.insert
+          (facet_vertex.end(), slab.facet_vertex.begin(), 
+           slab.facet_vertex.end());
+
+        // Free slab memory.
+        SLAB_ISOPOLY empty_slab;
+        std::swap(slab, empty_slab);
+      });
+  }
+
+}
+
+
 // **************************************************
 // EXTRACT ISOPOLY
 // **************************************************
@@ -37,13 +362,37 @@ using namespace SHREC;
 /// Returns list of isosurface polytope vertices.
 /// @param scalar_grid = scalar grid data
 /// @param isovalue = isosurface scalar value
+/// @param active_region = Bricks or cubes which may intersect isosurface.
+///   Skip edges outside active_region.
 /// @param iso_poly[] = vector of isosurface polygope vertices
 ///   iso_simplices[numv_per_poly*ip+k] = 
 ///     cube containing k'th vertex of polytope ip.
 void SHREC::extract_dual_isopoly
 (const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
- const SCALAR_TYPE isovalue, std::vector<ISO_VERTEX_INDEX> & iso_poly,
- SHREC_INFO & shrec_info)
+ const SCALAR_TYPE isovalue, const ACTIVE_GRID_REGION & active_region,
+ std::vector<ISO_VERTEX_INDEX> & iso_poly, SHREC_INFO & shrec_info)
+{
+  clock_t t0 = std::clock();
+
+  SHARPISO_BIT_GRID sign_grid;
+  set_sign_grid(scalar_grid, isovalue, active_region, sign_grid);
+
+  extract_dual_isopoly
+    (scalar_grid, sign_grid, active_region, 1, iso_poly, shrec_info);
+
+  clock_t t1 = clock();
+  clock2seconds(t1-t0, shrec_info.time.extract);
+}
+
+
+/// Extract dual isosurface polytopes.
+/// Returns list of isosurface polytope vertices.
+/// Version using signs of scalar grid vertices.
+void SHREC::extract_dual_isopoly
+(const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
+ const SHARPISO_BIT_GRID & sign_grid, const ACTIVE_GRID_REGION & active_region,
+ const int num_threads,
+ std::vector<ISO_VERTEX_INDEX> & iso_poly, SHREC_INFO & shrec_info)
 {
   shrec_info.time.extract = 0;
 
@@ -54,10 +403,25 @@ void SHREC::extract_dual_isopoly
 
   if (scalar_grid.NumCubeVertices() < 1) { return; }
 
-  IJK_FOR_EACH_INTERIOR_GRID_EDGE(iend0, edge_dir, scalar_grid, VERTEX_INDEX) {
-
-    extract_dual_isopoly_around_bipolar_edge
-      (scalar_grid, isovalue, iend0, edge_dir, iso_poly);
+  if (num_threads > 1 && scalar_grid.Dimension() == DIM3) {
+    std::vector<FACET_VERTEX_INDEX> facet_vertex;
+
+    extract_dual_isopoly_in_slabs
+      (scalar_grid, sign_grid, active_region, num_threads,
+       [&](const VERTEX_INDEX iend0, const int edge_dir, 
+           SLAB_ISOPOLY & slab) {
+        extract_dual_isopoly_around_bipolar_edge
+          (scalar_grid, sign_grid, iend0, edge_dir, slab.iso_poly);
+      },
+       iso_poly, facet_vertex);
+  }
+  else {
+    for_each_interior_edge_in_active_region
+      (scalar_grid, sign_grid, active_region,
+       [&](const VERTEX_INDEX iend0, const int edge_dir) {
+        extract_dual_isopoly_around_bipolar_edge
+          (scalar_grid, sign_grid, iend0, edge_dir, iso_poly);
+      });
   }
 
   clock_t t1 = clock();
@@ -70,12 +434,41 @@ void SHREC::extract_dual_isopoly
 /// Return locations of isosurface vertices on each facet.
 /// @param scalar_grid = scalar grid data
 /// @param isovalue = isosurface scalar value
+/// @param active_region = Bricks or cubes which may intersect isosurface.
+///   Skip edges outside active_region.
 /// @param iso_poly[] = vector of isosurface polygope vertices
 ///   iso_simplices[numv_per_poly*ip+k] = 
 ///     cube containing k'th vertex of polytope ip.
 void SHREC::extract_dual_isopoly
 (const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
- const SCALAR_TYPE isovalue, std::vector<ISO_VERTEX_INDEX> & iso_poly,
+ const SCALAR_TYPE isovalue, const ACTIVE_GRID_REGION & active_region,
+ std::vector<ISO_VERTEX_INDEX> & iso_poly,
+ std::vector<FACET_VERTEX_INDEX> & facet_vertex,
+ SHREC_INFO & shrec_info)
+{
+  clock_t t0 = clock();
+
+  SHARPISO_BIT_GRID sign_grid;
+  set_sign_grid(scalar_grid, isovalue, active_region, sign_grid);
+
+  extract_dual_isopoly
+    (scalar_grid, sign_grid, active_region, 1, iso_poly, facet_vertex,
+     shrec_info);
+
+  clock_t t1 = clock();
+  clock2seconds(t1-t0, shrec_info.time.extract);
+}
+
+
+/// Extract dual isosurface polytopes.
+/// Returns list of isosurface polytope vertices.
+/// Return locations of isosurface vertices on each facet.
+/// Version using signs of scalar grid vertices.
+void SHREC::extract_dual_isopoly
+(const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
+ const SHARPISO_BIT_GRID & sign_grid, const ACTIVE_GRID_REGION & active_region,
+ const int num_threads,
+ std::vector<ISO_VERTEX_INDEX> & iso_poly,
  std::vector<FACET_VERTEX_INDEX> & facet_vertex,
  SHREC_INFO & shrec_info)
 {
@@ -88,10 +481,24 @@ void SHREC::extract_dual_isopoly
 
   if (scalar_grid.NumCubeVertices() < 1) { return; }
 
-  IJK_FOR_EACH_INTERIOR_GRID_EDGE(iend0, edge_dir, scalar_grid, VERTEX_INDEX) {
-
-    extract_dual_isopoly_around_bipolar_edge
-      (scalar_grid, isovalue, iend0, edge_dir, iso_poly, facet_vertex);
+  if (num_threads > 1 && scalar_grid.Dimension() == DIM3) {
+    extract_dual_isopoly_in_slabs
+      (scalar_grid, sign_grid, active_region, num_threads,
+       [&](const VERTEX_INDEX iend0, const int edge_dir, 
+           SLAB_ISOPOLY & slab) {
+        extract_dual_isopoly_around_bipolar_edge
+          (scalar_grid, sign_grid, iend0, edge_dir, 
+           slab.iso_poly, slab.facet_vertex);
+      },
+       iso_poly, facet_vertex);
+  }
+  else {
+    for_each_interior_edge_in_active_region
+      (scalar_grid, sign_grid, active_region,
+       [&](const VERTEX_INDEX iend0, const int edge_dir) {
+        extract_dual_isopoly_around_bipolar_edge
+          (scalar_grid, sign_grid, iend0, edge_dir, iso_poly, facet_vertex);
+      });
   }
 
   clock_t t1 = clock();
@@ -33,26 +33,62 @@ namespace SHREC {
   /// Returns list of isosurface polytope vertices.
   /// @param scalar_grid = scalar grid data
   /// @param isovalue = isosurface scalar value
+  /// @param active_region = Bricks or cubes which may intersect isosurface.
+  ///   Skip edges outside active_region.
+  ///   If active_region is not set, process all grid edges.
   /// @param iso_poly[] = vector of isosurface polytope vertices
   ///   iso_simplices[numv_per_poly*ip+k] = 
   ///     cube containing k'th vertex of polytope ip.
   void extract_dual_isopoly
     (const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
-     const SCALAR_TYPE isovalue, std::vector<ISO_VERTEX_INDEX> & iso_poly,
-     SHREC_INFO & shrec_info);
+     const SCALAR_TYPE isovalue, const ACTIVE_GRID_REGION & active_region,
+     std::vector<ISO_VERTEX_INDEX> & iso_poly, SHREC_INFO & shrec_info);
 
   /// Extract dual isosurface polytopes.
   /// Returns list of isosurface polytope vertices.
   /// Return locations of isosurface vertices on each facet.
   /// @param scalar_grid = scalar grid data
   /// @param isovalue = isosurface scalar value
+  /// @param active_region = Bricks or cubes which may intersect isosurface.
   /// @param iso_cube[] = cubes containing isosurface polytope vertices.
   ///   iso_cube[numv_per_poly*ip+k] = 
   ///     cube containing k'th vertex of polytope ip.
   /// @param facet_vertex = Location of iso vertex on facet.
   void extract_dual_isopoly
   (const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
-   const SCALAR_TYPE isovalue, std::vector<ISO_VERTEX_INDEX> & iso_cube,
+   const SCALAR_TYPE isovalue, const ACTIVE_GRID_REGION & active_region,
+   std::vector<ISO_VERTEX_INDEX> & iso_cube,
+   std::vector<FACET_VERTEX_INDEX> & facet_vertex,
+   SHREC_INFO & shrec_info);
+
+  /// Extract dual isosurface polytopes.
+  /// Version using signs of scalar grid vertices.
+  /// @param sign_grid sign_grid.Scalar(iv) is true if the scalar value
+  ///   at vertex iv is greater than or equal to the isovalue.
+  /// @param num_threads Number of threads.  If num_threads > 1,
+  ///   slabs of grid edges are extracted in parallel and concatenated
+  ///   in order.  Output is identical for any number of threads.
+  void extract_dual_isopoly
+    (const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
+     const SHARPISO_BIT_GRID & sign_grid,
+     const ACTIVE_GRID_REGION & active_region,
+     const int num_threads,
+     std::vector<ISO_VERTEX_INDEX> & iso_poly, SHREC_INFO & shrec_info);
+
+  /// Extract dual isosurface polytopes.
+  /// Return locations of isosurface vertices on each facet.
+  /// Version using signs of scalar grid vertices.
+  /// @param sign_grid sign_grid.Scalar(iv) is true if the scalar value
+  ///   at vertex iv is greater than or equal to the isovalue.
+  /// @param num_threads Number of threads.  If num_threads > 1,
+  ///   slabs of grid edges are extracted in parallel and concatenated
+  ///   in order.  Output is identical for any number of threads.
+  void extract_dual_isopoly
+  (const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
+   const SHARPISO_BIT_GRID & sign_grid,
+   const ACTIVE_GRID_REGION & active_region,
+   const int num_threads,
+   std::vector<ISO_VERTEX_INDEX> & iso_cube,
    std::vector<FACET_VERTEX_INDEX> & facet_vertex,
    SHREC_INFO & shrec_info);
 
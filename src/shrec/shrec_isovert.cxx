@@ -38,8 +38,10 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "shrec_types.h"
 #include "shrec_isovert.h"
 #include "shrec_position.h"
+#include "shrec_thread.txx"
 
 #include "sharpiso_closest.h"
+#include "sharpiso_qef_batch.h"
 
 #include "shrec_debug.h"
 
@@ -51,7 +53,7 @@ using namespace IJK;
 
 // *** DEBUG ***
 #include "ijkprint.txx"
-bool flag_debug(false);
+thread_local bool flag_debug(false);
 
 
 namespace {
@@ -128,10 +130,6 @@ namespace {
    const SVD_INFO svd_info,
    ISOVERT & isovert);
 
-  void set_cube_containing_isovert
-  (const SHARPISO_SCALAR_GRID_BASE & scalar_grid, 
-   const SCALAR_TYPE isovalue, ISOVERT & isovert);
-
   void set_cube_containing_isovert
   (const SHARPISO_SCALAR_GRID_BASE & scalar_grid, 
    const SCALAR_TYPE isovalue, const NUM_TYPE gcube_index,
@@ -147,19 +145,19 @@ namespace {
 
   // *** MOVED TO shrec_select ***
   bool check_covered_point
-  (const SHARPISO_BOOL_GRID & covered_grid,
+  (const SHARPISO_BIT_GRID & covered_grid,
    const ISOVERT & isovert,
    const VERTEX_INDEX & gcube0_index);
 
   // *** MOVED TO shrec_select ***
   void check_and_set_covered_point
-  (const SHARPISO_BOOL_GRID & covered_grid,
+  (const SHARPISO_BIT_GRID & covered_grid,
    ISOVERT & isovert,
    const VERTEX_INDEX & gcube_index);
 
   void check_covered_and_substitute
   (const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
-   const SHARPISO_BOOL_GRID & covered_grid,
+   const SHARPISO_BIT_GRID & covered_grid,
    const SCALAR_TYPE isovalue,
    const NUM_TYPE gcube_index,
    ISOVERT & isovert);
@@ -170,7 +168,7 @@ namespace {
    ISOVERT & isovert);
 
   void set_covered_grid
-  (const ISOVERT & isovert, SHARPISO_BOOL_GRID & covered_grid);
+  (const ISOVERT & isovert, SHARPISO_BIT_GRID & covered_grid);
 }
 
 void replace_with_substitute_coord
@@ -196,10 +194,90 @@ void set_isovert_position_from_other_cube
 // ISOVERT ROUTINES
 // **************************************************
 
+/// Store isosurface vertex position, direction and svd information
+///   computed by svd_compute_sharp_vertex_for_cube_lindstrom.
+/// Also compute substitute coordinate isovert_coordB.
+void store_isovert_position_lindstrom
+(const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
+ const SHARP_ISOVERT_PARAM & isovert_param,
+ const VERTEX_INDEX cube_index,
+ const NUM_TYPE gcube_index,
+ const COORD_TYPE edge_dir[DIM3],
+ const COORD_TYPE orth_dir[DIM3],
+ const NUM_TYPE num_large_eigenvalues,
+ const SVD_INFO & svd_info,
+ ISOVERT & isovert)
+{
+  const GRADIENT_COORD_TYPE max_small_magnitude =
+    isovert_param.max_small_magnitude;
+
+  if (num_large_eigenvalues == 1) {
+    IJK::copy_coord_3D(orth_dir, isovert.gcube_list[gcube_index].direction);
+  }
+  else if (num_large_eigenvalues == 2) {
+    IJK::copy_coord_3D(edge_dir, isovert.gcube_list[gcube_index].direction);
+  }
+  else {
+    IJK::set_coord_3D(0, isovert.gcube_list[gcube_index].direction);
+  }
+
+  const COORD_TYPE * isovert_coord =
+    isovert.gcube_list[gcube_index].isovert_coord;
+  const COORD_TYPE * direction =
+    isovert.gcube_list[gcube_index].direction;
+
+  if (num_large_eigenvalues > 2 ||
+      cube_contains_point(scalar_grid, cube_index, isovert_coord)) {
+
+    IJK::copy_coord_3D
+      (isovert_coord, isovert.gcube_info[gcube_index].isovert_coordB);
+  }
+  else if (num_large_eigenvalues == 2) {
+    COORD_TYPE cube_center_coord[DIM3];
+    COORD_TYPE closest_point[DIM3];
+
+    scalar_grid.ComputeCubeCenterScaledCoord
+      (cube_index, cube_center_coord);
+
+    // Compute point on line closest (L2) to cube center.
+    compute_closest_point_on_line
+      (cube_center_coord, isovert_coord, direction, max_small_magnitude, 
+       closest_point);
+
+    if (cube_contains_point(scalar_grid, cube_index, isovert_coord)) {
+      IJK::copy_coord_3D
+        (closest_point, isovert.gcube_info[gcube_index].isovert_coordB);
+    }
+    else {
+
+      // Compute point on line closest (Linf) to cube center.
+      compute_closest_point_on_line_unscaled_linf
+        (cube_center_coord, isovert_coord,  direction, max_small_magnitude,
+         scalar_grid.SpacingPtrConst(),
+         isovert.gcube_info[gcube_index].isovert_coordB);
+    }
+  }
+  else if (num_large_eigenvalues == 1) {
+    COORD_TYPE cube_center_coord[DIM3];
+
+    scalar_grid.ComputeCubeCenterScaledCoord
+      (cube_index, cube_center_coord);
+
+    // Compute point on plane closest (L2) to cube center.
+    compute_closest_point_on_plane
+      (cube_center_coord, isovert_coord, direction, 
+       isovert.gcube_info[gcube_index].isovert_coordB);
+  }
+
+  store_svd_info(scalar_grid, cube_index, gcube_index, 
+                 num_large_eigenvalues, svd_info, isovert);
+}
+
 /// Compute isosurface vertex positions from gradients 
 ///   using lindstrom algorithm.
 /// Use voxel for gradient cube offset, 
 ///   not isovert_param.grad_selection_cube_offset.
+/// @param scratch Scratch memory for gradients.
 void compute_isovert_position_lindstrom
 (const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
  const GRADIENT_GRID_BASE & gradient_grid,
@@ -207,11 +285,10 @@ void compute_isovert_position_lindstrom
  const SHARP_ISOVERT_PARAM & isovert_param,
  const OFFSET_VOXEL & voxel,
  const VERTEX_INDEX & cube_index,
+ GET_GRADIENTS_SCRATCH & scratch,
  ISOVERT & isovert)
 {
   const INDEX_DIFF_TYPE gcube_index = isovert.GCubeIndex(cube_index);
-  const GRADIENT_COORD_TYPE max_small_magnitude =
-    isovert_param.max_small_magnitude;
 	SVD_INFO svd_info;
 
   if (gcube_index != ISOVERT::NO_INDEX) {
@@ -226,69 +303,91 @@ void compute_isovert_position_lindstrom
 
     svd_compute_sharp_vertex_for_cube_lindstrom
       (scalar_grid, gradient_grid, cube_index, isovalue, isovert_param, 
-       voxel, isovert.gcube_list[gcube_index].isovert_coord,
+       voxel, scratch, isovert.gcube_list[gcube_index].isovert_coord,
        edge_dir, orth_dir, eigenvalues, num_large_eigenvalues, svd_info);
 
-    if (num_large_eigenvalues == 1) {
-      IJK::copy_coord_3D(orth_dir, isovert.gcube_list[gcube_index].direction);
-    }
-    else if (num_large_eigenvalues == 2) {
-      IJK::copy_coord_3D(edge_dir, isovert.gcube_list[gcube_index].direction);
-    }
-    else {
-      IJK::set_coord_3D(0, isovert.gcube_list[gcube_index].direction);
-    }
-
-    const COORD_TYPE * isovert_coord =
-      isovert.gcube_list[gcube_index].isovert_coord;
-    const COORD_TYPE * direction =
-      isovert.gcube_list[gcube_index].direction;
-
-    if (num_large_eigenvalues > 2 ||
-        cube_contains_point(scalar_grid, cube_index, isovert_coord)) {
-
-      IJK::copy_coord_3D
-        (isovert_coord, isovert.gcube_list[gcube_index].isovert_coordB);
-    }
-    else if (num_large_eigenvalues == 2) {
-      COORD_TYPE cube_center_coord[DIM3];
-      COORD_TYPE closest_point[DIM3];
-
-      scalar_grid.ComputeCubeCenterScaledCoord
-        (cube_index, cube_center_coord);
+    store_isovert_position_lindstrom
+      (scalar_grid, isovert_param, cube_index, gcube_index, 
+       edge_dir, orth_dir, num_large_eigenvalues, svd_info, isovert);
+  }
+}
 
-      // Compute point on line closest (L2) to cube center.
-      compute_closest_point_on_line
-        (cube_center_coord, isovert_coord, direction, max_small_magnitude, 
-         closest_point);
+/// Compute isosurface vertex positions from gradients 
+///   using lindstrom algorithm.
+/// Version allocating its own scratch memory.
+void compute_isovert_position_lindstrom
+(const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
+ const GRADIENT_GRID_BASE & gradient_grid,
+ const SCALAR_TYPE isovalue,
+ const SHARP_ISOVERT_PARAM & isovert_param,
+ const OFFSET_VOXEL & voxel,
+ const VERTEX_INDEX & cube_index,
+ ISOVERT & isovert)
+{
+  GET_GRADIENTS_SCRATCH scratch;
 
-      if (cube_contains_point(scalar_grid, cube_index, isovert_coord)) {
-        IJK::copy_coord_3D
-          (closest_point, isovert.gcube_list[gcube_index].isovert_coordB);
-      }
-      else {
+  compute_isovert_position_lindstrom
+    (scalar_grid, gradient_grid, isovalue, isovert_param, voxel, 
+     cube_index, scratch, isovert);
+}
 
-        // Compute point on line closest (Linf) to cube center.
-        compute_closest_point_on_line_unscaled_linf
-          (cube_center_coord, isovert_coord,  direction, max_small_magnitude,
-           scalar_grid.SpacingPtrConst(),
-           isovert.gcube_list[gcube_index].isovert_coordB);
-      }
+/// Compute isosurface vertex positions of gcube_list[k] for k in [k0,k1)
+///   using batched Lindstrom solver.
+/// Gather the Lindstrom systems of QEF_BATCH::BATCH_SIZE cubes,
+///   solve them together and scatter the solutions to isovert.gcube_list.
+void compute_isovert_positions_lindstrom_batch
+(const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
+ const GRADIENT_GRID_BASE & gradient_grid,
+ const SCALAR_TYPE isovalue,
+ const SHARP_ISOVERT_PARAM & isovert_param,
+ const OFFSET_VOXEL & voxel,
+ const NUM_TYPE k0, const NUM_TYPE k1,
+ ISOVERT & isovert)
+{
+  const int BATCH_SIZE = QEF_BATCH::BATCH_SIZE;
+  GET_GRADIENTS_SCRATCH scratch;
+  QEF_BATCH qef_batch;
+  SVD_INFO svd_info[BATCH_SIZE];
+  NUM_TYPE ilane[BATCH_SIZE];
+
+  for (NUM_TYPE kstart = k0; kstart < k1; kstart += BATCH_SIZE) {
+    const NUM_TYPE kend = std::min(kstart+BATCH_SIZE, k1);
+
+    // Gather.
+    qef_batch.Clear();
+    for (NUM_TYPE gcube_index = kstart; gcube_index < kend; gcube_index++) {
+      const NUM_TYPE j = gcube_index - kstart;
+      const VERTEX_INDEX cube_index = isovert.CubeIndex(gcube_index);
+
+      isovert.gcube_list[gcube_index].flag_centroid_location = false;
+      svd_info[j] = SVD_INFO();
+      svd_gather_sharp_vertex_for_cube_lindstrom
+        (scalar_grid, gradient_grid, cube_index, isovalue, isovert_param,
+         voxel, scratch, qef_batch, ilane[j], 
+         isovert.gcube_list[gcube_index].isovert_coord, svd_info[j]);
     }
-    else if (num_large_eigenvalues == 1) {
-      COORD_TYPE cube_center_coord[DIM3];
-
-      scalar_grid.ComputeCubeCenterScaledCoord
-        (cube_index, cube_center_coord);
 
-      // Compute point on plane closest (L2) to cube center.
-      compute_closest_point_on_plane
-        (cube_center_coord, isovert_coord, direction, 
-         isovert.gcube_list[gcube_index].isovert_coordB);
+    // Solve.
+    solve_qef_batch(isovert_param.max_small_eigenvalue, qef_batch);
+
+    // Scatter.
+    for (NUM_TYPE gcube_index = kstart; gcube_index < kend; gcube_index++) {
+      const NUM_TYPE j = gcube_index - kstart;
+      const VERTEX_INDEX cube_index = isovert.CubeIndex(gcube_index);
+      EIGENVALUE_TYPE eigenvalues[DIM3];
+      COORD_TYPE edge_dir[DIM3], orth_dir[DIM3];
+      NUM_TYPE num_large_eigenvalues;
+
+      svd_scatter_sharp_vertex_for_cube_lindstrom
+        (scalar_grid, gradient_grid, cube_index, isovalue, isovert_param,
+         qef_batch, ilane[j], isovert.gcube_list[gcube_index].isovert_coord,
+         edge_dir, orth_dir, eigenvalues, num_large_eigenvalues, 
+         svd_info[j]);
+
+      store_isovert_position_lindstrom
+        (scalar_grid, isovert_param, cube_index, gcube_index, 
+         edge_dir, orth_dir, num_large_eigenvalues, svd_info[j], isovert);
     }
-
-    store_svd_info(scalar_grid, cube_index, gcube_index, 
-                   num_large_eigenvalues, svd_info, isovert);
   }
 }
 
@@ -302,21 +401,50 @@ void compute_all_isovert_positions
 {
   const SIGNED_COORD_TYPE grad_selection_cube_offset =
     isovert_param.grad_selection_cube_offset;
+  const int num_threads = isovert_param.num_threads;
   OFFSET_VOXEL voxel;
-  SVD_INFO svd_info;
 
   voxel.SetVertexCoord
     (scalar_grid.SpacingPtrConst(), grad_selection_cube_offset);
 
-  IJK_FOR_EACH_GRID_CUBE(cube_index, scalar_grid, VERTEX_INDEX) {
+  // Each active cube is processed independently and writes only
+  //   its own entry in isovert.gcube_list.
+  // Each block of cubes reuses one GET_GRADIENTS_SCRATCH.
+  if (isovert_param.qef_solver == QEF_SOLVER_BATCH) {
+    apply_to_blocks_in_parallel
+      (num_threads, isovert.gcube_list.size(),
+       [&](const NUM_TYPE k0, const NUM_TYPE k1) {
+        compute_isovert_positions_lindstrom_batch
+          (scalar_grid, gradient_grid, isovalue, isovert_param, voxel,
+           k0, k1, isovert);
+      });
+  }
+  else {
+    apply_to_blocks_in_parallel
+      (num_threads, isovert.gcube_list.size(),
+       [&](const NUM_TYPE k0, const NUM_TYPE k1) {
+        GET_GRADIENTS_SCRATCH scratch;
+
+        for (NUM_TYPE gcube_index = k0; gcube_index < k1; gcube_index++) {
+          const VERTEX_INDEX cube_index = isovert.CubeIndex(gcube_index);
 
-    compute_isovert_position_lindstrom
-      (scalar_grid, gradient_grid, isovalue, isovert_param, voxel,
-       cube_index, isovert);
+          compute_isovert_position_lindstrom
+            (scalar_grid, gradient_grid, isovalue, isovert_param, voxel,
+             cube_index, scratch, isovert);
+        }
+      });
   }
 
-  store_boundary_bits(scalar_grid, isovert.gcube_list);
-  set_cube_containing_isovert(scalar_grid, isovalue, isovert);
+  apply_in_parallel
+    (num_threads, isovert.gcube_list.size(),
+     [&](const NUM_TYPE gcube_index) {
+      const VERTEX_INDEX cube_index = isovert.CubeIndex(gcube_index);
+
+      scalar_grid.ComputeBoundaryCubeBits
+        (cube_index, isovert.gcube_list[gcube_index].boundary_bits);
+      set_cube_containing_isovert
+        (scalar_grid, isovalue, gcube_index, isovert);
+    });
 }
 
 // Compute isosurface vertex positions using isosurface-edge intersections.
@@ -334,51 +462,46 @@ void compute_all_isovert_positions_edgeI
 
   if (vertex_position_method == EDGEI_GRADIENT) {
 
-    IJK_FOR_EACH_GRID_CUBE(iv, scalar_grid, VERTEX_INDEX) {
-      NUM_TYPE index = isovert.GCubeIndex(iv);
+    // Visit only active cubes.
+    for (std::size_t index = 0; index < isovert.gcube_list.size(); index++) {
+      const VERTEX_INDEX iv = isovert.CubeIndex(index);
 
-      if (index != ISOVERT::NO_INDEX) {
-        // this is an active cube
-        isovert.gcube_list[index].flag_centroid_location = false;
+      isovert.gcube_list[index].flag_centroid_location = false;
 
-        // compute the sharp vertex for this cube
-        EIGENVALUE_TYPE eigenvalues[DIM3]={0.0};
-        NUM_TYPE num_large_eigenvalues;
+      // compute the sharp vertex for this cube
+      EIGENVALUE_TYPE eigenvalues[DIM3]={0.0};
+      NUM_TYPE num_large_eigenvalues;
 
-        svd_compute_sharp_vertex_edgeI_sharp_gradient
-          (scalar_grid, gradient_grid, iv, isovalue, isovert_param,
-           isovert.gcube_list[index].isovert_coord,
-           eigenvalues, num_large_eigenvalues, svd_info);
+      svd_compute_sharp_vertex_edgeI_sharp_gradient
+        (scalar_grid, gradient_grid, iv, isovalue, isovert_param,
+         isovert.gcube_list[index].isovert_coord,
+         eigenvalues, num_large_eigenvalues, svd_info);
 
 
-        store_svd_info(scalar_grid, iv, index, num_large_eigenvalues,
-                       svd_info, isovert);
-      }
+      store_svd_info(scalar_grid, iv, index, num_large_eigenvalues,
+                     svd_info, isovert);
     }
   }
   else {
     // vertex_position_method == EDGEI_INTERPOLATE
 
-    IJK_FOR_EACH_GRID_CUBE(iv, scalar_grid, VERTEX_INDEX) {
-      NUM_TYPE index = isovert.GCubeIndex(iv);
-
-      if (index != ISOVERT::NO_INDEX) {
-        // this is an active cube
-        isovert.gcube_list[index].flag_centroid_location = false;
+    // Visit only active cubes.
+    for (std::size_t index = 0; index < isovert.gcube_list.size(); index++) {
+      const VERTEX_INDEX iv = isovert.CubeIndex(index);
 
-        // compute the sharp vertex for this cube
-        EIGENVALUE_TYPE eigenvalues[DIM3]={0.0};
-        NUM_TYPE num_large_eigenvalues;
+      isovert.gcube_list[index].flag_centroid_location = false;
 
-        svd_compute_sharp_vertex_edgeI_interpolate_gradients
-          (scalar_grid, gradient_grid, iv, isovalue, isovert_param,
-           isovert.gcube_list[index].isovert_coord,
-           eigenvalues, num_large_eigenvalues, svd_info);
+      // compute the sharp vertex for this cube
+      EIGENVALUE_TYPE eigenvalues[DIM3]={0.0};
+      NUM_TYPE num_large_eigenvalues;
 
-        store_svd_info(scalar_grid, iv, index, num_large_eigenvalues,
-                       svd_info, isovert);
+      svd_compute_sharp_vertex_edgeI_interpolate_gradients
+        (scalar_grid, gradient_grid, iv, isovalue, isovert_param,
+         isovert.gcube_list[index].isovert_coord,
+         eigenvalues, num_large_eigenvalues, svd_info);
 
-      }
+      store_svd_info(scalar_grid, iv, index, num_large_eigenvalues,
+                     svd_info, isovert);
     }
   }
 
@@ -430,8 +553,8 @@ void recompute_isovert_position_lindstrom
     (scalar_grid, gradient_grid, isovalue, isovert_param, voxel,
      cube_index, isovert);
 
-  isovert.gcube_list[gcube_index].flag_recomputed_coord = true;
-  isovert.gcube_list[gcube_index].flag_recomputed_coord_min_offset = 
+  isovert.gcube_info[gcube_index].flag_recomputed_coord = true;
+  isovert.gcube_info[gcube_index].flag_recomputed_coord_min_offset = 
     flag_min_offset;
 
   set_cube_containing_isovert(scalar_grid, isovalue, gcube_index, isovert);
@@ -442,7 +565,7 @@ void recompute_isovert_position_lindstrom
     cerr << "    New coord: ";
     IJK::print_coord3D(cerr, isovert.gcube_list[gcube_index].isovert_coord);
     cerr << "  B: ";
-    IJK::print_coord3D(cerr, isovert.gcube_list[gcube_index].isovert_coordB);
+    IJK::print_coord3D(cerr, isovert.gcube_info[gcube_index].isovert_coordB);
     cerr << " num eigenvalues: " 
          << int(isovert.gcube_list[gcube_index].num_eigenvalues);
     cerr << "  flag: "
@@ -468,8 +591,8 @@ void recompute_far_points
 
     GRID_CUBE_FLAG cube_flag = isovert.gcube_list[i].flag;
     bool flag_recomputed_coord_min_offset =
-      isovert.gcube_list[i].flag_recomputed_coord_min_offset;
-    if (isovert.gcube_list[i].flag_far) {
+      isovert.gcube_info[i].flag_recomputed_coord_min_offset;
+    if (isovert.gcube_info[i].flag_far) {
       if (!flag_recomputed_coord_min_offset) {
 
         recompute_isovert_position_lindstrom
@@ -523,7 +646,7 @@ void recompute_far_points
 void SHREC::recompute_covered_point_positions
 (const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
  const GRADIENT_GRID_BASE & gradient_grid,
- const SHARPISO_BOOL_GRID & covered_grid,
+ const SHARPISO_BIT_GRID & covered_grid,
  const SCALAR_TYPE isovalue,
  const SHARP_ISOVERT_PARAM & isovert_param,
  const OFFSET_VOXEL & voxel,
@@ -534,7 +657,7 @@ void SHREC::recompute_covered_point_positions
 
     GRID_CUBE_FLAG cube_flag = isovert.gcube_list[i].flag;
     bool flag_recomputed_coord_min_offset =
-      isovert.gcube_list[i].flag_recomputed_coord_min_offset;
+      isovert.gcube_info[i].flag_recomputed_coord_min_offset;
     if (cube_flag == COVERED_POINT) {
       if (!flag_recomputed_coord_min_offset) {
 
@@ -559,7 +682,7 @@ void SHREC::recompute_covered_point_positions
 void SHREC::recompute_covered_point_positions
 (const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
  const GRADIENT_GRID_BASE & gradient_grid,
- const SHARPISO_BOOL_GRID & covered_grid,
+ const SHARPISO_BIT_GRID & covered_grid,
  const SCALAR_TYPE isovalue,
  const std::vector<NUM_TYPE> gcube_index_list,
  const SHARP_ISOVERT_PARAM & isovert_param,
@@ -572,7 +695,7 @@ void SHREC::recompute_covered_point_positions
     NUM_TYPE gcube_index = gcube_index_list[i];
     GRID_CUBE_FLAG cube_flag = isovert.gcube_list[gcube_index].flag;
     bool flag_recomputed_coord_min_offset =
-      isovert.gcube_list[gcube_index].flag_recomputed_coord_min_offset;
+      isovert.gcube_info[gcube_index].flag_recomputed_coord_min_offset;
     if (cube_flag == COVERED_POINT) {
       if (!flag_recomputed_coord_min_offset) {
 
@@ -593,7 +716,7 @@ void SHREC::recompute_covered_point_positions
 void SHREC::recompute_covered_point_positions
 (const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
  const GRADIENT_GRID_BASE & gradient_grid,
- const SHARPISO_BOOL_GRID & covered_grid,
+ const SHARPISO_BIT_GRID & covered_grid,
  const SCALAR_TYPE isovalue,
  const SHARP_ISOVERT_PARAM & isovert_param,
  ISOVERT & isovert)
@@ -629,7 +752,7 @@ void SHREC::recompute_covered_point_positions
 void SHREC::recompute_covered_point_positions
 (const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
  const GRADIENT_GRID_BASE & gradient_grid,
- const SHARPISO_BOOL_GRID & covered_grid,
+ const SHARPISO_BIT_GRID & covered_grid,
  const SCALAR_TYPE isovalue,
  const std::vector<NUM_TYPE> gcube_index_list,
  const SHARP_ISOVERT_PARAM & isovert_param,
@@ -669,7 +792,7 @@ void SHREC::recompute_covered_point_positions
 void recompute_unselected_uncovered_lindstrom
 (const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
  const GRADIENT_GRID_BASE & gradient_grid,
- const SHARPISO_BOOL_GRID & covered_grid,
+ const SHARPISO_BIT_GRID & covered_grid,
  const SCALAR_TYPE isovalue,
  const SHARP_ISOVERT_PARAM & isovert_param,
  const OFFSET_VOXEL & voxel,
@@ -707,7 +830,7 @@ void recompute_unselected_uncovered_lindstrom
 void recompute_unselected_uncovered_lindstrom
 (const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
  const GRADIENT_GRID_BASE & gradient_grid,
- const SHARPISO_BOOL_GRID & covered_grid,
+ const SHARPISO_BIT_GRID & covered_grid,
  const SCALAR_TYPE isovalue,
  const SHARP_ISOVERT_PARAM & isovert_param,
  ISOVERT & isovert)
@@ -746,7 +869,7 @@ void SHREC::recompute_isovert_positions
     isovert_param.linf_dist_thresh_merge_sharp;
 
   // covered_grid.Scalar(iv) == true, if iv is covered (or selected).
-  SHARPISO_BOOL_GRID covered_grid;
+  SHARPISO_BIT_GRID covered_grid;
   covered_grid.SetSize(scalar_grid);
   set_covered_grid(isovert, covered_grid);
 
@@ -806,7 +929,7 @@ void SHREC::recompute_isovert_positions
  const SHARP_ISOVERT_PARAM & isovert_param,
  ISOVERT & isovert)
 {
-  SHARPISO_EDGE_INDEX_GRID edge_index(DIM3, scalar_grid.AxisSize(), DIM3);
+  SHARPISO_EDGE_INDEX_HASH edge_index(DIM3, scalar_grid.AxisSize());
 
   set_edge_index(edgeI_coord, edge_index);
 
@@ -936,7 +1059,7 @@ void SHREC::recompute_using_adjacent
     }
 
     IJK::copy_coord_3D(new_coord, isovert.gcube_list[gcube_index].isovert_coord);
-    isovert.gcube_list[gcube_index].flag_recomputed_using_adjacent = true;
+    isovert.gcube_info[gcube_index].flag_recomputed_using_adjacent = true;
     isovert.gcube_list[gcube_index].flag_centroid_location = false;
   }
   else {
@@ -987,12 +1110,12 @@ void set_isovert_position_from_face
   // Corrected - May, 2015 - R. Wenger
   set_cube_containing_isovert(scalar_grid, isovalue, gcube_index, isovert);
 
-  isovert.gcube_list[gcube_index].flag_using_substitute_coord = false;
+  isovert.gcube_info[gcube_index].flag_using_substitute_coord = false;
 
   if (flag_from_vertex) 
-    { isovert.gcube_list[gcube_index].flag_coord_from_vertex = true; }
+    { isovert.gcube_info[gcube_index].flag_coord_from_vertex = true; }
   else
-    { isovert.gcube_list[gcube_index].flag_coord_from_edge = true; }
+    { isovert.gcube_info[gcube_index].flag_coord_from_edge = true; }
 
   flag_set = true;
 }
@@ -1055,12 +1178,12 @@ void set_isovert_position_and_direction_from_face
   // Corrected - May, 2015 - R. Wenger
   set_cube_containing_isovert(scalar_grid, isovalue, gcube_index, isovert);
 
-  isovert.gcube_list[gcube_index].flag_using_substitute_coord = false;
+  isovert.gcube_info[gcube_index].flag_using_substitute_coord = false;
 
   if (flag_from_vertex) 
-    { isovert.gcube_list[gcube_index].flag_coord_from_vertex = true; }
+    { isovert.gcube_info[gcube_index].flag_coord_from_vertex = true; }
   else
-    { isovert.gcube_list[gcube_index].flag_coord_from_edge = true; }
+    { isovert.gcube_info[gcube_index].flag_coord_from_edge = true; }
 
   flag_set = true;
 }
@@ -1751,11 +1874,12 @@ void round_down(const COORD_TYPE * coord, GRID_COORD_TYPE min_coord[DIM3])
 
 void SHREC::set_edge_index
 (const std::vector<COORD_TYPE> & edgeI_coord,
- SHARPISO_EDGE_INDEX_GRID & edge_index)
+ SHARPISO_EDGE_INDEX_HASH & edge_index)
 {
   GRID_COORD_TYPE min_coord[DIM3];
 
-  edge_index.SetAllCoord(ISOVERT::NO_INDEX);
+  edge_index.Clear();
+  edge_index.Reserve(edgeI_coord.size()/DIM3);
 
   for (NUM_TYPE i = 0; i < edgeI_coord.size()/DIM3; i++) {
     round_down(&(edgeI_coord[i*DIM3]), min_coord);
@@ -1805,42 +1929,41 @@ void compute_all_isovert_positions
 {
   const SIGNED_COORD_TYPE grad_selection_cube_offset =
     isovert_param.grad_selection_cube_offset;
-  SHARPISO_EDGE_INDEX_GRID edge_index(DIM3, scalar_grid.AxisSize(), DIM3);
+  SHARPISO_EDGE_INDEX_HASH edge_index(DIM3, scalar_grid.AxisSize());
   SVD_INFO svd_info;
 
   set_edge_index(edgeI_coord, edge_index);
 
-  IJK_FOR_EACH_GRID_CUBE(iv, scalar_grid, VERTEX_INDEX) {
-    NUM_TYPE index = isovert.GCubeIndex(iv);
-    if (index!=ISOVERT::NO_INDEX) {
-      // this is an active cube
-      // compute the sharp vertex for this cube
-      EIGENVALUE_TYPE eigenvalues[DIM3]={0.0};
-      VERTEX_INDEX num_large_eigenvalues;
-
-      svd_compute_sharp_vertex_for_cube_hermite
-        (scalar_grid, edgeI_coord, edgeI_normal_coord, edge_index,
-         iv, isovalue, isovert_param,
-         isovert.gcube_list[index].isovert_coord,
-         eigenvalues, num_large_eigenvalues, svd_info);
+  // Visit only active cubes.
+  for (std::size_t index = 0; index < isovert.gcube_list.size(); index++) {
+    const VERTEX_INDEX iv = isovert.CubeIndex(index);
 
-      //set num eigen
-      isovert.gcube_list[index].num_eigenvalues =  
-        (unsigned char)num_large_eigenvalues;
-      //set the sharp vertex type to be *AVAILABLE*
-      if(num_large_eigenvalues > 1)
-        { isovert.gcube_list[index].flag=AVAILABLE_GCUBE; }
-      else
-        { isovert.gcube_list[index].flag=SMOOTH_GCUBE; }
+    // compute the sharp vertex for this cube
+    EIGENVALUE_TYPE eigenvalues[DIM3]={0.0};
+    VERTEX_INDEX num_large_eigenvalues;
+
+    svd_compute_sharp_vertex_for_cube_hermite
+      (scalar_grid, edgeI_coord, edgeI_normal_coord, edge_index,
+       iv, isovalue, isovert_param,
+       isovert.gcube_list[index].isovert_coord,
+       eigenvalues, num_large_eigenvalues, svd_info);
+
+    //set num eigen
+    isovert.gcube_list[index].num_eigenvalues =  
+      (unsigned char)num_large_eigenvalues;
+    //set the sharp vertex type to be *AVAILABLE*
+    if(num_large_eigenvalues > 1)
+      { isovert.gcube_list[index].flag=AVAILABLE_GCUBE; }
+    else
+      { isovert.gcube_list[index].flag=SMOOTH_GCUBE; }
 
-      // store L1 and Linf distance
-      compute_Linf_distance_from_cube_center
-        (scalar_grid, iv, isovert.IsoVertCoord(index),
-         isovert.gcube_list[index].linf_dist);
-      compute_L1_distance_from_cube
-        (scalar_grid, iv, isovert.IsoVertCoord(index),
-         isovert.gcube_list[index].L1_dist_to_cube);
-    }
+    // store L1 and Linf distance
+    compute_Linf_distance_from_cube_center
+      (scalar_grid, iv, isovert.IsoVertCoord(index),
+       isovert.gcube_list[index].linf_dist);
+    compute_L1_distance_from_cube
+      (scalar_grid, iv, isovert.IsoVertCoord(index),
+       isovert.gcube_list[index].L1_dist_to_cube);
   }
 
   store_boundary_bits(scalar_grid, isovert.gcube_list);
@@ -1898,7 +2021,7 @@ void set_isovert_position_from_other_cube
 {
   set_isovert_position
     (grid, gcube_index, new_coord, num_eigenvalues, isovert);
-  isovert.gcube_list[gcube_index].flag_coord_from_other_cube = true;
+  isovert.gcube_info[gcube_index].flag_coord_from_other_cube = true;
 }
 
 /// Set isovert position and direction from other cube
@@ -1911,7 +2034,7 @@ void set_isovert_position_and_direction_from_other_cube
 {
   set_isovert_position_and_direction
     (grid, gcube_index, new_coord, new_direction, num_eigenvalues, isovert);
-  isovert.gcube_list[gcube_index].flag_coord_from_other_cube = true;
+  isovert.gcube_info[gcube_index].flag_coord_from_other_cube = true;
 }
 
 // Swap isovert positions of gcubeA and gcubeB
@@ -2034,7 +2157,7 @@ void swap_isovert_positions
               cerr << "  isovert_coord: ";
               IJK::print_coord3D(cerr, isovert.gcube_list[gcubeB_index].isovert_coord, "\n");
               cerr << "    flag_far: "
-                   << int(isovert.gcube_list[gcubeB_index].flag_far);
+                   << int(isovert.gcube_info[gcubeB_index].flag_far);
               cerr << " flag_conflict: "
                    << int(isovert.gcube_list[gcubeB_index].flag_conflict);
               cerr << " flag_conflict: "
@@ -2042,7 +2165,7 @@ void swap_isovert_positions
               cerr << endl;
               cerr << "    Cube: " << cubeA_index;
               cerr << "  flag_far: "
-                   << int(isovert.gcube_list[gcubeA_index].flag_far);
+                   << int(isovert.gcube_info[gcubeA_index].flag_far);
               cerr << "  flag_centroid: "
                    << int(isovert.gcube_list[gcubeA_index].flag_centroid_location)
                    << endl;
@@ -2105,7 +2228,7 @@ void replace_with_substitute_coord
 (const SHARPISO_GRID & grid, const NUM_TYPE gcube_index, ISOVERT & isovert)
 {
   const COORD_TYPE * isovert_coordB =
-    isovert.gcube_list[gcube_index].isovert_coordB;
+    isovert.gcube_info[gcube_index].isovert_coordB;
 
   MSDEBUG();
   if (flag_debug) {
@@ -2127,7 +2250,7 @@ void replace_with_substitute_coord
     isovert.gcube_list[gcube_index].num_eigenvalues;
   set_isovert_position
     (grid, gcube_index, isovert_coordB, num_eigenvalues, isovert);
-  isovert.gcube_list[gcube_index].flag_using_substitute_coord = true;
+  isovert.gcube_info[gcube_index].flag_using_substitute_coord = true;
 }
 
 // Apply secondary isovert positions
@@ -2145,7 +2268,7 @@ void apply_secondary_isovert_positions
     if (isovert.gcube_list[gcubeA_index].flag_conflict) {
 
       const COORD_TYPE * isovert_coordB =
-        isovert.gcube_list[gcubeA_index].isovert_coordB;
+        isovert.gcube_info[gcubeA_index].isovert_coordB;
       VERTEX_INDEX cubeA_index = isovert.CubeIndex(gcubeA_index);
 
       if (cube_contains_point(grid, cubeA_index, isovert_coordB)) {
@@ -2207,7 +2330,7 @@ void apply_secondary_isovert_positions
                 (grid, gcubeB_index, isovert_coordB, directionB, 
                  num_eigenvalues, isovert);
             }
-            isovert.gcube_list[gcubeB_index].flag_using_substitute_coord = true;
+            isovert.gcube_info[gcubeB_index].flag_using_substitute_coord = true;
           }
         }
       }
@@ -2556,38 +2679,118 @@ bool SHREC::creates_triangle_new
 }
 
 
-/// Set the index_grid, grid and gcube_list.
+/// Add active cubes in a row segment to isovert.gcube_list.
+/// Row segment contains cubes icube0, icube0+1, ..., icube0+num_cubes-1
+///   along axis 0.  Cube icube0 has coordinates coord0[].
+/// Tests BITS_PER_BIT_GRID_WORD cubes at a time using isovert.sign_grid.
+void add_active_cubes_in_row
+(const VERTEX_INDEX icube0, const GRID_COORD_TYPE coord0[DIM3],
+ const GRID_COORD_TYPE num_cubes, ISOVERT & isovert)
+{
+  const SHARPISO_BIT_GRID & sign_grid = isovert.sign_grid;
+
+  for (GRID_COORD_TYPE x = 0; x < num_cubes; 
+       x += IJK::BITS_PER_BIT_GRID_WORD) {
+
+    const int num_bits = 
+      std::min(GRID_COORD_TYPE(IJK::BITS_PER_BIT_GRID_WORD), num_cubes-x);
+    IJK::BIT_GRID_WORD w = 
+      IJK::compute_mixed_cube_word(sign_grid, icube0+x) &
+      IJK::bit_range_mask(0, num_bits);
+
+    while (w != 0) {
+      const int k = IJK::lowest_bit_in_word(w);
+      w &= (w-1);
+
+      const VERTEX_INDEX icube = icube0+x+k;
+      GRID_CUBE_DATA gc;
+      gc.cube_index = icube;
+      IJK::copy_coord_3D(coord0, gc.cube_coord);
+      gc.cube_coord[0] += x+k;
+      IJK::compute_cube_bit_index(sign_grid, icube, gc.table_index);
+      isovert.index_grid.Set(icube, isovert.gcube_list.size());
+      isovert.gcube_list.push_back(gc);
+    }
+  }
+}
+
+/// Set the index_grid, grid, sign_grid and gcube_list.
 /// Traverse the scalar grid.
-/// If cube icube is not active, set index_grid[icube] to ISOVERT::NO_INDEX.
+/// Cubes which are not active have index ISOVERT::NO_INDEX.
 /// If cube icube is active, then set index_grid[icube] to index.
 /// Push the corresponding *grid_cube_data* into the *gcube_list*.
+/// Set the table_index of each active cube from sign_grid.
+/// @param active_region Bricks or cubes which may intersect isosurface.
+///   If active_region.cube_list[] is set, use only cubes in cube_list[].
+///   Otherwise, skip cubes in bricks which are not active.
+///   Cubes are visited in increasing order, as in IJK_FOR_EACH_GRID_CUBE.
+/// @param flag_sparse_index If true, store only active cubes
+///   in index_grid.
 void create_active_cubes
 (const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
  const SCALAR_TYPE isovalue,
+ const ACTIVE_GRID_REGION & active_region,
+ const bool flag_sparse_index,
  ISOVERT &isovert)
 {
-  NUM_TYPE index = 0;
 
   // Set the size and spacing of index_grid and grid.
-  isovert.index_grid.SetSize(scalar_grid);
+  isovert.index_grid.SetGrid(scalar_grid, flag_sparse_index);
   isovert.grid.SetSize(scalar_grid);
-  isovert.index_grid.SetSpacing(scalar_grid.SpacingPtrConst());
   isovert.grid.SetSpacing(scalar_grid.SpacingPtrConst());
 
-  IJK_FOR_EACH_GRID_CUBE(icube, scalar_grid, VERTEX_INDEX) {
-    if (is_gt_cube_min_le_cube_max(scalar_grid, icube, isovalue)) {
-      index = isovert.gcube_list.size();
-      isovert.index_grid.Set(icube,index);
+  // Compare scalar values with isovalue only in active_region.
+  // All later sign tests read isovert.sign_grid.
+  set_sign_grid(scalar_grid, isovalue, active_region, isovert.sign_grid);
+
+  const SHARPISO_ACTIVE_BRICKS & active_brick = active_region.active_brick;
+
+  if (active_region.IsCubeListSet()) {
+    const std::vector<VERTEX_INDEX> & cube_list = active_region.cube_list;
+    isovert.gcube_list.reserve(cube_list.size());
+    for (std::size_t i = 0; i < cube_list.size(); i++) {
+      const VERTEX_INDEX icube = cube_list[i];
+      isovert.index_grid.Set(icube, i);
       GRID_CUBE_DATA gc;
       gc.cube_index = icube;
       scalar_grid.ComputeCoord(icube, gc.cube_coord);
+      IJK::compute_cube_bit_index(isovert.sign_grid, icube, gc.table_index);
       isovert.gcube_list.push_back(gc);
-		}
-    else {
-      // if it is not intersected then mark as ISOVERT::NO_INDEX
-      isovert.index_grid.Set(icube,ISOVERT::NO_INDEX);
-		}
-	}
+    }
+  }
+  else {
+    // If active_brick is not set, process each row as a single segment.
+    const AXIS_SIZE_TYPE brick_edge_length = 
+      (active_brick.IsSet() ? 
+       active_brick.BrickEdgeLength() : scalar_grid.AxisSize(0));
+    GRID_COORD_TYPE num_cubes[DIM3];
+    GRID_COORD_TYPE coord[DIM3];
+
+    for (int d = 0; d < DIM3; d++)
+      { num_cubes[d] = scalar_grid.AxisSize(d)-1; }
+
+    for (coord[2] = 0; coord[2] < num_cubes[2]; coord[2]++) {
+      for (coord[1] = 0; coord[1] < num_cubes[1]; coord[1]++) {
+
+        // Process cubes along x-axis one brick at a time.
+        for (GRID_COORD_TYPE x0 = 0; x0 < num_cubes[0]; 
+             x0 += brick_edge_length) {
+
+          coord[0] = x0;
+          if (active_brick.IsSet() && 
+              !active_brick.IsCubeInActiveBrick(coord)) { continue; }
+
+          GRID_COORD_TYPE x1 = x0 + brick_edge_length;
+          if (x1 > num_cubes[0]) { x1 = num_cubes[0]; }
+
+          const VERTEX_INDEX icube = scalar_grid.ComputeVertexIndex(coord);
+          add_active_cubes_in_row(icube, coord, x1-x0, isovert);
+        }
+      }
+    }
+  }
+
+  isovert.gcube_info.resize(isovert.gcube_list.size());
 }
 
 /// process edge called from are connected
@@ -2608,6 +2811,7 @@ void SHREC::compute_dual_isovert
 (const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
  const GRADIENT_GRID_BASE & gradient_grid,
  const SCALAR_TYPE isovalue,
+ const ACTIVE_GRID_REGION & active_region,
  const SHARP_ISOVERT_PARAM & isovert_param,
  const VERTEX_POSITION_METHOD vertex_position_method,
  ISOVERT & isovert)
@@ -2620,7 +2824,9 @@ void SHREC::compute_dual_isovert
       (scalar_grid, "gradient grid", "scalar grid", error))
 	{ throw error; }
 
-  create_active_cubes(scalar_grid, isovalue, isovert);
+  create_active_cubes
+    (scalar_grid, isovalue, active_region, 
+     isovert_param.flag_sparse_index_grid, isovert);
 
   MSDEBUG();
   flag_debug = false;
@@ -2655,10 +2861,13 @@ void SHREC::compute_dual_isovert
  const std::vector<COORD_TYPE> & edgeI_coord,
  const std::vector<GRADIENT_COORD_TYPE> & edgeI_normal_coord,
  const SCALAR_TYPE isovalue,
+ const ACTIVE_GRID_REGION & active_region,
  const SHARP_ISOVERT_PARAM & isovert_param,
  ISOVERT &isovert)
 {
-  create_active_cubes(scalar_grid, isovalue, isovert);
+  create_active_cubes
+    (scalar_grid, isovalue, active_region, 
+     isovert_param.flag_sparse_index_grid, isovert);
 
   compute_all_isovert_positions 
     (scalar_grid, edgeI_coord, edgeI_normal_coord,
@@ -2692,7 +2901,7 @@ void SHREC::set_cover_type(ISOVERT & isovert)
 {
 
   for (int i = 0; i < isovert.gcube_list.size(); i++)
-    { isovert.gcube_list[i].cover_type = NO_ADJACENT_CUBE; }
+    { isovert.gcube_info[i].cover_type = NO_ADJACENT_CUBE; }
 
   // Set VERTEX_ADJACENT.
   for (int i = 0; i < isovert.gcube_list.size(); i++) {
@@ -2709,7 +2918,7 @@ void SHREC::set_cover_type(ISOVERT & isovert)
           VERTEX_INDEX cube1_index = isovert.grid.CubeNeighborV(cube0_index, j);
           INDEX_DIFF_TYPE gcube1_index = isovert.GCubeIndex(cube1_index);
           if (gcube1_index != ISOVERT::NO_INDEX) {
-            isovert.gcube_list[gcube1_index].cover_type = VERTEX_ADJACENT;
+            isovert.gcube_info[gcube1_index].cover_type = VERTEX_ADJACENT;
           }
         }
       }
@@ -2734,7 +2943,7 @@ void SHREC::set_cover_type(ISOVERT & isovert)
           VERTEX_INDEX cube1_index = isovert.grid.CubeNeighborE(cube0_index, j);
           INDEX_DIFF_TYPE gcube1_index = isovert.GCubeIndex(cube1_index);
           if (gcube1_index != ISOVERT::NO_INDEX) {
-            isovert.gcube_list[gcube1_index].cover_type = EDGE_ADJACENT;
+            isovert.gcube_info[gcube1_index].cover_type = EDGE_ADJACENT;
           }
         }
       }
@@ -2759,7 +2968,7 @@ void SHREC::set_cover_type(ISOVERT & isovert)
           VERTEX_INDEX cube1_index = isovert.grid.CubeNeighborF(cube0_index, j);
           INDEX_DIFF_TYPE gcube1_index = isovert.GCubeIndex(cube1_index);
           if (gcube1_index != ISOVERT::NO_INDEX) {
-            isovert.gcube_list[gcube1_index].cover_type = FACET_ADJACENT;
+            isovert.gcube_info[gcube1_index].cover_type = FACET_ADJACENT;
           }
         }
       }
@@ -2789,6 +2998,16 @@ void SHREC::store_table_index
 	{ gcube_list[i].table_index = table_index[i]; }
 }
 
+// Get isosurface lookup table index of each cube in gcube_list.
+void SHREC::get_table_index
+(const GRID_CUBE_DATA_ARRAY & gcube_list,
+ std::vector<IJKDUALTABLE::TABLE_INDEX> & table_index)
+{
+  table_index.resize(gcube_list.size());
+  for (std::size_t i = 0; i < gcube_list.size(); i++)
+    { table_index[i] = gcube_list[i].table_index; }
+}
+
 /// Compute the overlap region between two 3x3x3 regions around cubes.
 /// @param[out] Overlap dimension.  No overlap has overlap dimension -1.
 bool SHREC::find_3x3x3_overlap
@@ -3044,7 +3263,6 @@ void GRID_CUBE_DATA::Init()
 {
   num_eigenvalues = 0;
   flag = AVAILABLE_GCUBE;
-  cover_type = NO_ADJACENT_CUBE;
   boundary_bits = 0;
   cube_index = 0;
   linf_dist = 0;
@@ -3052,18 +3270,10 @@ void GRID_CUBE_DATA::Init()
   flag_centroid_location = false;
   flag_conflict = false;
   flag_near_corner = false;
-  flag_coord_from_other_cube = false;
-  flag_coord_from_vertex = false;
-  flag_coord_from_edge = false;
-  flag_using_substitute_coord = false;
-  flag_recomputed_coord = false;
-  flag_recomputed_coord_min_offset = false;
-  flag_recomputed_using_adjacent = false;
-  flag_far = false;
-  flag_ignore_mismatch = false;
   cube_containing_isovert = 0;
   table_index = 0;
   covered_by = 0;
+  IJK::set_coord_3D(0, direction);
 }
 
 bool GRID_CUBE_DATA::IsCoveredOrSelected() const
@@ -3075,6 +3285,25 @@ bool GRID_CUBE_DATA::IsCoveredOrSelected() const
     { return false; }
 }
 
+
+// **************************************************
+// GRID_CUBE_INFO member functions
+// **************************************************
+
+void GRID_CUBE_INFO::Init()
+{
+  cover_type = NO_ADJACENT_CUBE;
+  flag_coord_from_other_cube = false;
+  flag_coord_from_vertex = false;
+  flag_coord_from_edge = false;
+  flag_using_substitute_coord = false;
+  flag_recomputed_coord = false;
+  flag_recomputed_coord_min_offset = false;
+  flag_recomputed_using_adjacent = false;
+  flag_far = false;
+  flag_ignore_mismatch = false;
+}
+
 // **************************************************
 // ISOVERT member functions
 // **************************************************
@@ -3228,7 +3457,7 @@ void SHREC::bin_grid_insert
 (const SHARPISO_GRID & grid, const AXIS_SIZE_TYPE bin_width,
  const VERTEX_INDEX cube_index, BIN_GRID<int> & bin_grid)
 {
-  static GRID_COORD_TYPE coord[DIM3];
+  GRID_COORD_TYPE coord[DIM3];
 
   grid.ComputeCoord(cube_index, coord);
   divide_coord_3D(bin_width, coord);
@@ -3240,7 +3469,7 @@ void SHREC::bin_grid_remove
 (const SHARPISO_GRID & grid, const AXIS_SIZE_TYPE bin_width,
  const VERTEX_INDEX cube_index, BIN_GRID<int> & bin_grid)
 {
-  static GRID_COORD_TYPE coord[DIM3];
+  GRID_COORD_TYPE coord[DIM3];
 
   grid.ComputeCoord(cube_index, coord);
   divide_coord_3D(bin_width, coord);
@@ -3257,9 +3486,9 @@ void SHREC::get_selected
  std::vector<VERTEX_INDEX> & selected_list)
 {
   const int dimension = grid.Dimension();
-  static GRID_COORD_TYPE coord[DIM3];
-  static GRID_COORD_TYPE min_coord[DIM3];
-  static GRID_COORD_TYPE max_coord[DIM3];
+  GRID_COORD_TYPE coord[DIM3];
+  GRID_COORD_TYPE min_coord[DIM3];
+  GRID_COORD_TYPE max_coord[DIM3];
 
   long boundary_bits;
 
@@ -3695,11 +3924,11 @@ namespace {
       { isovert.gcube_list[gcube_index].flag_centroid_location = false; }
 
     isovert.gcube_list[gcube_index].flag_conflict = svd_info.flag_conflict;
-    isovert.gcube_list[gcube_index].flag_far = svd_info.flag_far;
+    isovert.gcube_info[gcube_index].flag_far = svd_info.flag_far;
 
     // Initialize
-    isovert.gcube_list[gcube_index].flag_using_substitute_coord = false;
-    isovert.gcube_list[gcube_index].flag_coord_from_other_cube = false;
+    isovert.gcube_info[gcube_index].flag_using_substitute_coord = false;
+    isovert.gcube_info[gcube_index].flag_coord_from_other_cube = false;
 
     // store Linf and L1 distances.
     compute_Linf_distance_from_cube_center
@@ -3716,7 +3945,7 @@ namespace {
       cerr << "  isovert_coord: ";
       IJK::print_coord3D(cerr, isovert.gcube_list[gcube_index].isovert_coord);
       cerr << "  isovert_coordB: ";
-      IJK::print_coord3D(cerr, isovert.gcube_list[gcube_index].isovert_coordB);
+      IJK::print_coord3D(cerr, isovert.gcube_info[gcube_index].isovert_coordB);
       cerr << "  Linf dist: " << isovert.gcube_list[gcube_index].linf_dist 
            << endl;
       cerr << "  Num large eigenvalues: " << num_large_eigenvalues;
@@ -3816,19 +4045,6 @@ namespace {
     }
   }
 
-  // Set cube_containing_isovert
-  void set_cube_containing_isovert
-  (const SHARPISO_SCALAR_GRID_BASE & scalar_grid, 
-   const SCALAR_TYPE isovalue, ISOVERT & isovert)
-  {
-    COORD_TYPE cube_coord[DIM3];
-    VERTEX_INDEX cube_containing_point;
-
-    for (NUM_TYPE i = 0; i < isovert.gcube_list.size(); i++) {
-      set_cube_containing_isovert(scalar_grid, isovalue, i, isovert);
-    }
-  }
-
   /// Snap pointA to point in cube cube_index.
   void snap2cube
   (const SHARPISO_GRID & grid, const VERTEX_INDEX cube_index, 
@@ -3881,7 +4097,7 @@ namespace {
     const COORD_TYPE * isovert_coord =
       isovert.gcube_list[gcube_index].isovert_coord;
     const COORD_TYPE * isovert_coordB =
-      isovert.gcube_list[gcube_index].isovert_coordB;
+      isovert.gcube_info[gcube_index].isovert_coordB;
 
     if (!cube_contains_point(scalar_grid, cube_index, isovert_coord)) {
       if (cube_contains_point(scalar_grid, cube_index, isovert_coordB)) {
@@ -3894,7 +4110,7 @@ namespace {
   ///   replace with substitute coord isovert_coordB.
   void check_covered_and_substitute
   (const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
-   const SHARPISO_BOOL_GRID & covered_grid,
+   const SHARPISO_BIT_GRID & covered_grid,
    const SCALAR_TYPE isovalue,
    const NUM_TYPE gcube_index,
    ISOVERT & isovert)
@@ -3911,7 +4127,7 @@ namespace {
   // *** MOVED TO shrec_select
   /// Return true if sharp vertex is in a cube which is covered.
   bool check_covered_point
-  (const SHARPISO_BOOL_GRID & covered_grid,
+  (const SHARPISO_BIT_GRID & covered_grid,
    const ISOVERT & isovert,
    const VERTEX_INDEX & gcube0_index)
   {
@@ -3936,7 +4152,7 @@ namespace {
 
   /// If sharp vertex is in covered cube, set cube to COVERED_POINT.
   void check_and_set_covered_point
-  (const SHARPISO_BOOL_GRID & covered_grid,
+  (const SHARPISO_BIT_GRID & covered_grid,
    ISOVERT & isovert,
    const VERTEX_INDEX & gcube_index)
   {
@@ -3955,62 +4171,24 @@ namespace {
   }
 
   void set_covered_grid
-  (const ISOVERT & isovert, SHARPISO_BOOL_GRID & covered_grid)
+  (const ISOVERT & isovert, SHARPISO_BIT_GRID & covered_grid)
   {
-    SHARPISO_GRID_NEIGHBORS grid;
-    BOUNDARY_BITS_TYPE mask[2*DIM3];
-
-    grid.SetSize(covered_grid);
-
-    for (int i = 0; i < 2*DIM3; i++) 
-      { mask[i] = (BOUNDARY_BITS_TYPE(1) << i); }
+    IJK::BOX<GRID_COORD_TYPE> box(DIM3);
 
     covered_grid.SetAll(false);
     for (NUM_TYPE i = 0; i < isovert.gcube_list.size(); i++) {
 
-      const VERTEX_INDEX cube_index = isovert.CubeIndex(i);
-
-      covered_grid.Set(cube_index, true);
-
-      const BOUNDARY_BITS_TYPE boundary_bits = 
-        isovert.gcube_list[i].boundary_bits;
-
-      if (boundary_bits == 0) {
-
-        // mark all the neighbors as covered
-        for (int i=0; i < grid.NumVertexNeighborsC(); i++) {
-          VERTEX_INDEX cube2_index = grid.VertexNeighborC(cube_index, i);
-
-          covered_grid.Set(cube2_index, true);
-        }
+      const GRID_COORD_TYPE * cube_coord = isovert.gcube_list[i].cube_coord;
 
+      // Mark the cube and all its neighbors as covered.
+      // Skip neighbors outside the grid.
+      for (int d = 0; d < DIM3; d++) {
+        const GRID_COORD_TYPE max_coord = covered_grid.AxisSize(d)-2;
+        box.SetMinCoord(d, std::max(cube_coord[d]-1, GRID_COORD_TYPE(0)));
+        box.SetMaxCoord(d, std::min(cube_coord[d]+1, max_coord));
       }
-      else {
-        // Handle boundary case.
-        for (int j0 = -1; j0 < 2; j0++) {
-
-          if ((boundary_bits & mask[0]) && j0 < 0) { continue; }
-          if ((boundary_bits & mask[1]) && j0 > 0) { continue; }
-
-          for (int j1 = -1; j1 < 2; j1++) {
-
-            if ((boundary_bits & mask[2]) && j1 < 0) { continue; }
-            if ((boundary_bits & mask[3]) && j1 > 0) { continue; }
-
-            for (int j2 = -1; j2 < 2; j2++) {
 
-              if ((boundary_bits & mask[4]) && j2 < 0) { continue; }
-              if ((boundary_bits & mask[5]) && j2 > 0) { continue; }
-
-              VERTEX_INDEX cube2_index =
-                cube_index + j0*grid.AxisIncrement(0) +
-                j1*grid.AxisIncrement(1) + j2*grid.AxisIncrement(2);
-
-              covered_grid.Set(cube2_index, true);
-            }
-          }
-        }
-      }
+      covered_grid.SetRegion(box, true);
     }
   }
 
@@ -28,6 +28,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "sharpiso_grids.h"
 #include "sharpiso_feature.h"
 #include "shrec_types.h"
+#include "shrec_span_space.h"
 
 #include <vector>
 
@@ -66,27 +67,11 @@ protected:
   void Init();
 
 public:
-  GRID_COORD_TYPE cube_coord[DIM3];  ///< Cube coordinates (unscaled).
-  COORD_TYPE isovert_coord[DIM3];    ///< Location of the sharp isovertex.
-  COORD_TYPE isovert_coordB[DIM3];   ///< Substitute location.
-  unsigned char num_eigenvalues;     ///< Number of eigenvalues.
-  GRID_CUBE_FLAG flag;               ///< Type for this cube.
-  BOUNDARY_BITS_TYPE boundary_bits;  ///< Boundary bits for the cube
-  VERTEX_INDEX cube_index;           ///< Index of cube in scalar grid.
 
-  /// Type of cube cover.
-  CUBE_ADJACENCY_TYPE cover_type;
-
-  /// If num_eigenvalues == 2, then direction = direction of isosurface edge.
-  /// If num_eigenvalues == 1, then 
-  ///   direction = direction orthogonal to isosurface.
-  COORD_TYPE direction[DIM3];         
+  // Fields read by the selection and merge loops are stored first.
 
-  /// Linf-dist from isovert_coord[] to cube-center.
-  COORD_TYPE linf_dist;
-
-  /// L1-dist from isovert_coord[] to cube.
-  COORD_TYPE L1_dist_to_cube;
+  GRID_CUBE_FLAG flag;               ///< Type for this cube.
+  unsigned char num_eigenvalues;     ///< Number of eigenvalues.
 
   /// If true, location is centroid of (grid edge)-isosurface intersections.
   bool flag_centroid_location;
@@ -97,51 +82,88 @@ public:
   /// If true, cube is near corner cube.
   bool flag_near_corner;
 
+  VERTEX_INDEX cube_index;           ///< Index of cube in scalar grid.
+
+  /// Grid index of cube which covered this cube.
+  VERTEX_INDEX covered_by;
+
+  BOUNDARY_BITS_TYPE boundary_bits;  ///< Boundary bits for the cube
+
   /// Grid index of cube containing the isovert_coord.
   VERTEX_INDEX cube_containing_isovert;
 
+  /// Linf-dist from isovert_coord[] to cube-center.
+  COORD_TYPE linf_dist;
+
+  /// L1-dist from isovert_coord[] to cube.
+  COORD_TYPE L1_dist_to_cube;
+
+  /// Index of cube configuration is isosurface lookup table.
+  /// Set from the sign grid when the active cubes are created.
+  IJKDUALTABLE::TABLE_INDEX table_index;
+
+  /// Grid index of cube which this cube maps to.
+  /// Currently, only used for output information.
+  VERTEX_INDEX maps_to_cube;
+
+  GRID_COORD_TYPE cube_coord[DIM3];  ///< Cube coordinates (unscaled).
+  COORD_TYPE isovert_coord[DIM3];    ///< Location of the sharp isovertex.
+
+  /// If num_eigenvalues == 2, then direction = direction of isosurface edge.
+  /// If num_eigenvalues == 1, then 
+  ///   direction = direction orthogonal to isosurface.
+  COORD_TYPE direction[DIM3];         
+
+  /// Return true if cube is covered or selected.
+  bool IsCoveredOrSelected() const;
+
+  GRID_CUBE_DATA() { Init(); }
+};
+
+/// Grid cube data which is rarely read.
+/// Stored apart from GRID_CUBE_DATA so that loops over gcube_list 
+///   read fewer cache lines.
+class GRID_CUBE_INFO {
+
+protected:
+
+  void Init();
+
+public:
+  COORD_TYPE isovert_coordB[DIM3];   ///< Substitute location.
+
+  /// Type of cube cover.
+  CUBE_ADJACENCY_TYPE cover_type;
+
   /// If true, isovert_coord[] determined by an adjacent cube.
-  bool flag_coord_from_other_cube;
+  bool flag_coord_from_other_cube:1;
 
   /// If true, isovert_coord[] determined by a grid vertex.
-  bool flag_coord_from_vertex;
+  bool flag_coord_from_vertex:1;
 
   /// If true, isovert_coord[] determined by a grid edge.
-  bool flag_coord_from_edge;
+  bool flag_coord_from_edge:1;
 
   /// If true, using replacement coordinate.
-  bool flag_using_substitute_coord;
+  bool flag_using_substitute_coord:1;
 
   /// If true, coordinates have been recomputed.
-  bool flag_recomputed_coord;
+  bool flag_recomputed_coord:1;
 
   /// If true, coordinates have been recomputed
   ///   with min gradient cube offset.
-  bool flag_recomputed_coord_min_offset;
+  bool flag_recomputed_coord_min_offset:1;
 
   /// If true, location is recomputed from location of adjacent vertices.
-  bool flag_recomputed_using_adjacent;
+  bool flag_recomputed_using_adjacent:1;
 
   /// If true, svd coord were farther than max_dist.
-  bool flag_far;
+  bool flag_far:1;
 
   /// If true, cube is selected despite mismatch.
-  bool flag_ignore_mismatch;
+  bool flag_ignore_mismatch:1;
 
-  /// Index of cube configuration is isosurface lookup table.
-  IJKDUALTABLE::TABLE_INDEX table_index;
-
-  /// Grid index of cube which covered this cube.
-  VERTEX_INDEX covered_by;
-
-  /// Grid index of cube which this cube maps to.
-  /// Currently, only used for output information.
-  VERTEX_INDEX maps_to_cube;
-
-  /// Return true if cube is covered or selected.
-  bool IsCoveredOrSelected() const;
-
-  GRID_CUBE_DATA() { Init(); }
+  GRID_CUBE_INFO() { Init(); }
 };
 
 typedef std::vector<GRID_CUBE_DATA> GRID_CUBE_DATA_ARRAY;
@@ -180,6 +202,70 @@ public:
 };
 
 
+// **************************************************
+// GCUBE INDEX GRID
+// **************************************************
+
+/// Grid mapping cube index to index in gcube_list.
+/// Dense version stores an index for every grid cube.
+/// Sparse version stores only active cubes in a hash table,
+///   using memory proportional to the number of active cubes.
+/// Cubes which are not stored have index -1 (ISOVERT::NO_INDEX).
+class GCUBE_INDEX_GRID:public SHARPISO_GRID {
+
+protected:
+  bool flag_sparse;
+  std::vector<INDEX_DIFF_TYPE> dense_index;
+  SHARPISO::INDEX_HASH_TABLE<VERTEX_INDEX> sparse_index;
+
+public:
+  GCUBE_INDEX_GRID() { flag_sparse = false; };
+
+  /// Set size and spacing to match grid.
+  /// Set index of every cube to -1.
+  /// @param flag_sparse If true, use the sparse version.
+  void SetGrid(const SHARPISO_GRID & grid, const bool flag_sparse)
+  {
+    this->SetSize(grid);
+    this->SetSpacing(grid.SpacingPtrConst());
+    this->flag_sparse = flag_sparse;
+
+    sparse_index.Clear();
+    if (flag_sparse) {
+      std::vector<INDEX_DIFF_TYPE> empty_index;
+      dense_index.swap(empty_index);
+    }
+    else
+      { dense_index.assign(grid.NumVertices(), INDEX_DIFF_TYPE(-1)); }
+  }
+
+  /// Return true if index grid is sparse.
+  bool IsSparse() const
+  { return(flag_sparse); }
+
+  /// Return index of cube iv or -1.
+  INDEX_DIFF_TYPE Scalar(const VERTEX_INDEX iv) const
+  {
+    if (flag_sparse) { return(sparse_index.Find(iv)); }
+    else { return(dense_index[iv]); }
+  }
+
+  /// Set index of cube iv.
+  void Set(const VERTEX_INDEX iv, const INDEX_DIFF_TYPE index)
+  {
+    if (flag_sparse) { sparse_index.Insert(iv, index); }
+    else { dense_index[iv] = index; }
+  }
+
+  /// Return number of bytes allocated for indices.
+  long long NumBytes() const
+  {
+    return((long long)(dense_index.capacity())*sizeof(INDEX_DIFF_TYPE)
+           + sparse_index.NumBytes());
+  }
+};
+
+
 // **************************************************
 // ISOSURFACE VERTEX DATA
 // **************************************************
@@ -190,15 +276,24 @@ public:
 	/// gcube_list containing the active cubes and their vertices.
 	std::vector<GRID_CUBE_DATA> gcube_list;
 
+  /// Rarely read data of the active cubes.
+  /// gcube_info[i] is data of gcube_list[i].
+  std::vector<GRID_CUBE_INFO> gcube_info;
+
 	static const int NO_INDEX = -1;       ///< Flag for no index.
 
 	/// Grid containing the index to the gcube_list.
 	/// If cube is not active, then it is defined as NO_INDEX.
-	SHARPISO_INDEX_GRID index_grid;
+	GCUBE_INDEX_GRID index_grid;
 
   /// Grid neighbor information.
   SHARPISO_GRID_NEIGHBORS grid;
 
+  /// Signs of the scalar grid vertices.
+  /// sign_grid.Scalar(iv) is true if the scalar value at vertex iv
+  ///   is greater than or equal to the isovalue.
+  SHARPISO_BIT_GRID sign_grid;
+
   /// Return true if cube is active.
 	bool isActive(const int cube_index) const;
 
@@ -337,10 +432,13 @@ public:
 // **************************************************
 
 /// Compute dual isosurface vertices.
+/// @param active_region Bricks or cubes which may intersect isosurface.
+///   Only cubes in active_region are examined.
 void compute_dual_isovert
   (const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
    const GRADIENT_GRID_BASE & gradient_grid,
    const SCALAR_TYPE isovalue,
+   const ACTIVE_GRID_REGION & active_region,
    const SHARP_ISOVERT_PARAM & isovert_param,
    const VERTEX_POSITION_METHOD vertex_position_method,
    ISOVERT & isovert);
@@ -351,6 +449,7 @@ void compute_dual_isovert
    const std::vector<COORD_TYPE> & edgeI_coord,
    const std::vector<GRADIENT_COORD_TYPE> & edgeI_normal_coord,
    const SCALAR_TYPE isovalue,
+   const ACTIVE_GRID_REGION & active_region,
    const SHARP_ISOVERT_PARAM & isovert_param,
    ISOVERT & isovert);
 
@@ -389,7 +488,7 @@ void recompute_isovert_positions
 void recompute_covered_point_positions
 (const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
  const GRADIENT_GRID_BASE & gradient_grid,
- const SHARPISO_BOOL_GRID & covered_grid,
+ const SHARPISO_BIT_GRID & covered_grid,
  const SCALAR_TYPE isovalue,
  const SHARP_ISOVERT_PARAM & isovert_param,
  ISOVERT & isovert);
@@ -400,7 +499,7 @@ void recompute_covered_point_positions
 void recompute_covered_point_positions
 (const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
  const GRADIENT_GRID_BASE & gradient_grid,
- const SHARPISO_BOOL_GRID & covered_grid,
+ const SHARPISO_BIT_GRID & covered_grid,
  const SCALAR_TYPE isovalue,
  const std::vector<NUM_TYPE> gcube_index_list,
  const SHARP_ISOVERT_PARAM & isovert_param,
@@ -413,7 +512,7 @@ void recompute_covered_point_positions
 void recompute_covered_point_positions
 (const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
  const GRADIENT_GRID_BASE & gradient_grid,
- const SHARPISO_BOOL_GRID & covered_grid,
+ const SHARPISO_BIT_GRID & covered_grid,
  const SCALAR_TYPE isovalue,
  const SHARP_ISOVERT_PARAM & isovert_param,
  const OFFSET_VOXEL & voxel,
@@ -429,7 +528,7 @@ void recompute_covered_point_positions
 void recompute_covered_point_positions
 (const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
  const GRADIENT_GRID_BASE & gradient_grid,
- const SHARPISO_BOOL_GRID & covered_grid,
+ const SHARPISO_BIT_GRID & covered_grid,
  const SCALAR_TYPE isovalue,
  const std::vector<NUM_TYPE> gcube_index_list,
  const SHARP_ISOVERT_PARAM & isovert_param,
@@ -451,9 +550,10 @@ void recompute_using_adjacent
 /// Set cover type of all covered cubes.
 void set_cover_type(ISOVERT & isovert);
 
-/// Set grid containing locations of edges in edgeI_coord[].
+/// Set locations of edges in edgeI_coord[].
+/// Memory of edge_index is proportional to the number of edges.
 void set_edge_index(const std::vector<COORD_TYPE> & edgeI_coord,
-                    SHARPISO_EDGE_INDEX_GRID & edge_index);
+                    SHARPISO_EDGE_INDEX_HASH & edge_index);
 
 /// Count number of vertices on sharp corners or sharp edges.
 /// Count number of smooth vertices.
@@ -630,6 +730,11 @@ void store_table_index
 (const std::vector<IJKDUALTABLE::TABLE_INDEX> & table_index,
  GRID_CUBE_DATA_ARRAY & gcube_list);
 
+/// Get isosurface lookup table index of each cube in gcube_list.
+void get_table_index
+(const GRID_CUBE_DATA_ARRAY & gcube_list,
+ std::vector<IJKDUALTABLE::TABLE_INDEX> & table_index);
+
 /// Return true if line through sharp edge in cube0 passes near cube1.
 /// Return false if cube0 has no sharp edge.
 /// @param max_distance Line points to cube if distance between line and cube
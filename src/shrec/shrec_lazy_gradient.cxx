@@ -0,0 +1,324 @@
+/// \file shrec_lazy_gradient.cxx
+/// Gradient grid computed on demand from the scalar grid.
+
+/*
+Copyright (C) 2015 Arindam Bhattacharya and Rephael Wenger
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public License
+(LGPL) as published by the Free Software Foundation; either
+version 2.1 of the License, or any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include <algorithm>
+#include <cstring>
+
+#if !defined(_WIN32)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include "shrec_lazy_gradient.h"
+
+using namespace SHREC;
+
+
+// **************************************************
+// Memory fault handler data
+// **************************************************
+
+namespace {
+
+  /// Lazy gradient grids whose blocks are computed on read.
+  std::vector<LAZY_GRADIENT_GRID *> compute_on_read_grid;
+
+  /// Lock for compute_on_read_grid.
+  std::mutex compute_on_read_grid_mutex;
+
+#if !defined(_WIN32)
+  bool is_fault_handler_installed = false;
+  struct sigaction previous_fault_action;
+#endif
+
+}
+
+
+// **************************************************
+// LAZY_GRADIENT_GRID member functions
+// **************************************************
+
+void LAZY_GRADIENT_GRID::Init()
+{
+  mapped_address = NULL;
+  mapped_length = 0;
+  scalar_grid_ptr = NULL;
+  flag_compute_on_read = false;
+  num_computed_blocks = 0;
+  is_block_computed.clear();
+}
+
+
+void LAZY_GRADIENT_GRID::FreeAll()
+{
+  if (flag_compute_on_read) {
+    std::lock_guard<std::mutex> lock(compute_on_read_grid_mutex);
+    compute_on_read_grid.erase
+      (std::remove(compute_on_read_grid.begin(), compute_on_read_grid.end(),
+                   this), compute_on_read_grid.end());
+  }
+
+  if (mapped_address != NULL) {
+#if defined(_WIN32)
+    delete [] (GRADIENT_STORAGE_TYPE *) mapped_address;
+#else
+    munmap(mapped_address, mapped_length);
+#endif
+  }
+  this->vec = NULL;
+  Init();
+}
+
+
+// Reserve storage for gradients of scalar_grid.
+void LAZY_GRADIENT_GRID::Reserve
+(const SHARPISO_SCALAR_GRID_BASE & scalar_grid)
+{
+  IJK::PROCEDURE_ERROR error("LAZY_GRADIENT_GRID::Reserve");
+
+  FreeAll();
+
+  if (scalar_grid.Dimension() != DIM3) {
+    error.AddMessage("Programming error.  Scalar grid dimension ",
+                     scalar_grid.Dimension(), " is not ", DIM3, ".");
+    throw error;
+  }
+
+  this->SetSize(scalar_grid.Dimension(), scalar_grid.AxisSize(),
+                scalar_grid.Dimension());
+  this->SetSpacing(scalar_grid.SpacingPtrConst());
+  scalar_grid_ptr = &scalar_grid;
+
+  const NUM_TYPE num_vertices = scalar_grid.NumVertices();
+  const NUM_TYPE num_blocks = (num_vertices+BlockSize()-1)/BlockSize();
+  const size_t num_coord =
+    size_t(num_blocks)*BlockSize()*scalar_grid.Dimension();
+
+  if (num_coord == 0) { return; }
+
+  mapped_length = num_coord*sizeof(GRADIENT_STORAGE_TYPE);
+
+#if defined(_WIN32)
+  GRADIENT_STORAGE_TYPE * gradient_coord = new GRADIENT_STORAGE_TYPE[num_coord];
+  mapped_address = gradient_coord;
+#else
+
+#if defined(__linux__)
+  // Computed blocks replace whole memory pages.
+  const long page_size = sysconf(_SC_PAGESIZE);
+  flag_compute_on_read = (page_size > 0 && BlockLength()%page_size == 0);
+#endif
+
+  // Anonymous pages use no memory until written.
+  // If blocks are computed on read, no page is readable
+  //   until its block is computed.
+  const int protection = 
+    (flag_compute_on_read ? PROT_NONE : (PROT_READ | PROT_WRITE));
+  void * address = mmap(NULL, mapped_length, protection,
+                        MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  if (address == MAP_FAILED) {
+    mapped_length = 0;
+    flag_compute_on_read = false;
+    error.AddMessage("Unable to reserve memory for gradient grid.");
+    throw error;
+  }
+  mapped_address = address;
+#endif
+
+  this->vec = (GRADIENT_STORAGE_TYPE *) mapped_address;
+  is_block_computed.assign(num_blocks, false);
+
+#if !defined(_WIN32)
+  if (flag_compute_on_read) {
+    std::lock_guard<std::mutex> lock(compute_on_read_grid_mutex);
+
+    if (!is_fault_handler_installed) {
+      struct sigaction action;
+      std::memset(&action, 0, sizeof(action));
+      action.sa_sigaction = HandleFault;
+      sigemptyset(&action.sa_mask);
+      action.sa_flags = SA_SIGINFO;
+      if (sigaction(SIGSEGV, &action, &previous_fault_action) != 0) {
+        error.AddMessage("Unable to install memory fault handler.");
+        throw error;
+      }
+      is_fault_handler_installed = true;
+    }
+
+    compute_on_read_grid.push_back(this);
+  }
+#endif
+}
+
+
+// Compute gradients of vertices in block kblock
+//   and store them in block_gradient[].
+void LAZY_GRADIENT_GRID::ComputeBlockGradients
+(const NUM_TYPE kblock, GRADIENT_STORAGE_TYPE * block_gradient) const
+{
+  const SHARPISO_SCALAR_GRID_BASE & scalar_grid = *scalar_grid_ptr;
+  const VERTEX_INDEX iv_begin = VERTEX_INDEX(kblock)*BlockSize();
+  const VERTEX_INDEX iv_end =
+    std::min(iv_begin+BlockSize(), VERTEX_INDEX(scalar_grid.NumVertices()));
+  // No allocation, since this may be called by the memory fault handler.
+  GRID_COORD_TYPE coord[DIM3];
+
+  if (iv_begin >= iv_end) { return; }
+
+  scalar_grid.ComputeCoord(iv_begin, coord);
+
+  for (VERTEX_INDEX iv1 = iv_begin; iv1 < iv_end; iv1++) {
+
+    GRADIENT_STORAGE_TYPE * gradient = 
+      block_gradient + (iv1-iv_begin)*DIM3;
+
+    // Same differences as cgradient.
+    for (int d = 0; d < DIM3; d++) {
+      const SCALAR_TYPE s1 = scalar_grid.Scalar(iv1);
+      if (coord[d] > 0) {
+        const SCALAR_TYPE s0 = scalar_grid.Scalar(scalar_grid.PrevVertex(iv1, d));
+        if (coord[d]+1 < scalar_grid.AxisSize(d)) {
+          const SCALAR_TYPE s2 =
+            scalar_grid.Scalar(scalar_grid.NextVertex(iv1, d));
+          gradient[d] = (s2 - s0)/2;
+        }
+        else
+          { gradient[d] = s1 - s0; }
+      }
+      else if (coord[d]+1 < scalar_grid.AxisSize(d)) {
+        const SCALAR_TYPE s2 = scalar_grid.Scalar(scalar_grid.NextVertex(iv1, d));
+        gradient[d] = s2 - s1;
+      }
+      else
+        { gradient[d] = 0; }
+    }
+
+    // Increment coord to the coordinates of vertex iv1+1.
+    for (int d = 0; d < DIM3; d++) {
+      coord[d]++;
+      if (coord[d] < scalar_grid.AxisSize(d)) { break; }
+      coord[d] = 0;
+    }
+  }
+}
+
+
+// Compute block kblock, if it is not already computed,
+//   and make its storage readable.
+bool LAZY_GRADIENT_GRID::ComputeBlock(const NUM_TYPE kblock)
+{
+  std::lock_guard<std::mutex> lock(block_mutex);
+
+  if (is_block_computed[kblock]) { return(true); }
+
+  char * block_address = (char *) mapped_address + kblock*BlockLength();
+
+#if defined(__linux__)
+  if (flag_compute_on_read) {
+    // Compute gradients in new pages and move them into place in one step.
+    // Other threads never read a partially computed block.
+    void * block = mmap(NULL, BlockLength(), PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (block == MAP_FAILED) { return(false); }
+
+    ComputeBlockGradients(kblock, (GRADIENT_STORAGE_TYPE *) block);
+
+    if (mremap(block, BlockLength(), BlockLength(),
+               MREMAP_MAYMOVE | MREMAP_FIXED, block_address) == MAP_FAILED) {
+      munmap(block, BlockLength());
+      return(false);
+    }
+  }
+  else
+#endif
+    { ComputeBlockGradients(kblock, (GRADIENT_STORAGE_TYPE *) block_address); }
+
+  is_block_computed[kblock] = true;
+  num_computed_blocks++;
+
+  return(true);
+}
+
+
+// Compute block containing address, if address is in reserved storage.
+bool LAZY_GRADIENT_GRID::ComputeBlockAt(const void * address)
+{
+  const char * block_address = (const char *) address;
+  const char * begin = (const char *) mapped_address;
+
+  if (mapped_address == NULL || block_address < begin || 
+      block_address >= begin + mapped_length) 
+    { return(false); }
+
+  const NUM_TYPE kblock = (block_address - begin)/BlockLength();
+
+  if (!ComputeBlock(kblock)) {
+    // Cannot throw from the fault handler.
+    static const char message[] = 
+      "Error: Unable to allocate memory for gradients.\n";
+#if !defined(_WIN32)
+    const ssize_t num_written = 
+      write(STDERR_FILENO, message, sizeof(message)-1);
+    (void) num_written;
+#endif
+    abort();
+  }
+
+  return(true);
+}
+
+
+#if !defined(_WIN32)
+
+// Memory fault handler.  Computes blocks on first read.
+void LAZY_GRADIENT_GRID::HandleFault
+(int sig, siginfo_t * info, void * /* context */)
+{
+  {
+    std::lock_guard<std::mutex> lock(compute_on_read_grid_mutex);
+    for (std::size_t i = 0; i < compute_on_read_grid.size(); i++) {
+      if (compute_on_read_grid[i]->ComputeBlockAt(info->si_addr)) 
+        { return; }
+    }
+  }
+
+  // Fault is not a read of a lazy gradient.
+  // Restore the previous handler.  The faulting instruction
+  //   faults again and the previous handler handles it.
+  sigaction(sig, &previous_fault_action, NULL);
+}
+
+#endif
+
+
+// Compute gradients of all vertices.
+void LAZY_GRADIENT_GRID::ComputeAll()
+{
+  IJK::PROCEDURE_ERROR error("LAZY_GRADIENT_GRID::ComputeAll");
+
+  for (NUM_TYPE k = 0; k < NumBlocks(); k++) {
+    if (!ComputeBlock(k)) {
+      error.AddMessage("Unable to allocate memory for gradient block ",
+                       k, ".");
+      throw error;
+    }
+  }
+}
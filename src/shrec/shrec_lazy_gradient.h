@@ -0,0 +1,140 @@
+/// \file shrec_lazy_gradient.h
+/// Gradient grid computed on demand from the scalar grid.
+
+/*
+Copyright (C) 2015 Arindam Bhattacharya and Rephael Wenger
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public License
+(LGPL) as published by the Free Software Foundation; either
+version 2.1 of the License, or any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#ifndef _SHREC_LAZY_GRADIENT_H_
+#define _SHREC_LAZY_GRADIENT_H_
+
+#include "sharpiso_grids.h"
+#include "shrec_types.h"
+
+#include <mutex>
+#include <vector>
+
+#if !defined(_WIN32)
+#include <signal.h>
+#endif
+
+namespace SHREC {
+
+// **************************************************
+// LAZY GRADIENT GRID
+// **************************************************
+
+/// Gradient grid whose gradients are computed from the scalar grid
+///   only when they are read.
+/// Gradients are computed by central difference, as in cgradient,
+///   in blocks of BlockSize() consecutive vertices.
+/// Each block is computed at most once.
+/// Storage for all gradients is reserved, but memory is only used
+///   by computed blocks.
+/// Storage of blocks which are not computed is not readable.
+/// The first read of a gradient in such a block faults and the
+///   fault handler computes the block.  Reads by other threads wait
+///   until the block is computed.
+/// Blocks are computed on read only on Linux, and only if the memory
+///   page size divides the block storage.  Otherwise, IsComputedOnRead()
+///   is false and all blocks must be computed by ComputeAll().
+class LAZY_GRADIENT_GRID:public GRADIENT_GRID_BASE {
+
+protected:
+  void * mapped_address;     ///< Reserved storage for gradients.
+  size_t mapped_length;      ///< Length in bytes of reserved storage.
+
+  /// Scalar grid passed to Reserve().
+  const SHARPISO_SCALAR_GRID_BASE * scalar_grid_ptr;
+
+  /// If true, blocks are computed when first read.
+  bool flag_compute_on_read;
+
+  /// is_block_computed[k] is true if gradients in block k are computed.
+  /// Changed only while holding block_mutex.
+  std::vector<bool> is_block_computed;
+
+  NUM_TYPE num_computed_blocks;
+
+  /// Lock for computing blocks.
+  std::mutex block_mutex;
+
+  /// Length in bytes of the storage of one block.
+  size_t BlockLength() const
+  { return(size_t(BlockSize())*this->Dimension()*sizeof(GRADIENT_STORAGE_TYPE)); }
+
+  void Init();
+  void FreeAll();
+
+  /// Compute gradients of vertices in block kblock
+  ///   and store them in block_gradient[].
+  void ComputeBlockGradients
+    (const NUM_TYPE kblock, GRADIENT_STORAGE_TYPE * block_gradient) const;
+
+  /// Compute block kblock, if it is not already computed,
+  ///   and make its storage readable.
+  /// @return False if memory for the block could not be allocated.
+  bool ComputeBlock(const NUM_TYPE kblock);
+
+  /// Compute block containing address, if address is in reserved storage.
+  /// Called by the memory fault handler.
+  /// @return True if address is in reserved storage.
+  bool ComputeBlockAt(const void * address);
+
+#if !defined(_WIN32)
+  /// Memory fault handler.  Computes blocks on first read.
+  static void HandleFault(int sig, siginfo_t * info, void * context);
+#endif
+
+public:
+  LAZY_GRADIENT_GRID() { Init(); };
+  ~LAZY_GRADIENT_GRID() { FreeAll(); };
+
+  /// Number of vertices in a block.
+  /// Block storage is a multiple of the 4096 byte memory page size.
+  static NUM_TYPE BlockSize() { return(4096); }
+
+  /// Reserve storage for gradients of scalar_grid.
+  /// Set spacing to spacing of scalar_grid.
+  /// No gradients are computed.
+  /// @pre scalar_grid exists until this gradient grid is freed.
+  void Reserve(const SHARPISO_SCALAR_GRID_BASE & scalar_grid);
+
+  /// Compute gradients of all vertices.
+  /// Blocks which were previously computed are not recomputed.
+  void ComputeAll();
+
+  /// Return true if blocks are computed when first read.
+  bool IsComputedOnRead() const
+  { return(flag_compute_on_read); }
+
+  /// Return number of blocks.
+  NUM_TYPE NumBlocks() const
+  { return(is_block_computed.size()); }
+
+  /// Return number of computed blocks.
+  NUM_TYPE NumComputedBlocks() const
+  { return(num_computed_blocks); }
+
+  /// Return true if block kblock is computed.
+  bool IsBlockComputed(const NUM_TYPE kblock) const
+  { return(is_block_computed[kblock]); }
+};
+
+}
+
+#endif
@@ -22,24 +22,44 @@
 
 
 #include <iostream>
+#include <memory>
 
 #include "shrec.h"
 #include "shrecIO.h"
+#include "shrec_lazy_gradient.h"
+#include "shrec_thread.txx"
 
 #include "ijkmesh.txx"
 #include "ijkmesh_cpp11.txx"
 #include "ijkmesh_geom.txx"
+#include "ijktime.txx"
 
 using namespace IJK;
 using namespace SHREC;
 
 using namespace std;
 
+// local types
+
+/// Isosurface and isosurface vertex data for one isovalue.
+class ISOVALUE_RESULT {
+
+public:
+  ISOVERT isovert;
+  DUAL_ISOSURFACE dual_isosurface;
+  SHREC_INFO shrec_info;
+
+  ISOVALUE_RESULT(const int dimension):shrec_info(dimension) {};
+};
+
 // local subroutines
 void memory_exhaustion();
 void construct_isosurface
 (const INPUT_INFO & input_info, const SHREC_DATA & shrec_data,
  SHREC_TIME & shrec_time, IO_TIME & io_time);
+void compute_lazy_gradients
+(const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
+ LAZY_GRADIENT_GRID & gradient_grid, SHREC_TIME & shrec_time);
 
 
 // **************************************************
@@ -62,17 +82,44 @@ int main(int argc, char **argv)
 
     parse_command_line(argc, argv, input_info);
 
-    SHARPISO_SCALAR_GRID full_scalar_grid;
+    SHARPISO_SCALAR_GRID full_scalar_grid_read;
+    SHARPISO_SCALAR_GRID_MMAP full_scalar_grid_mmap;
+    const SHARPISO_SCALAR_GRID_BASE * full_scalar_grid_ptr =
+      &full_scalar_grid_read;
     NRRD_INFO nrrd_info;
-    read_nrrd_file
-      (input_info.scalar_filename, full_scalar_grid,  nrrd_info, io_time);
+    std::string mmap_message;
+
+    if (input_info.flag_mmap &&
+        mmap_nrrd_file(input_info.scalar_filename, full_scalar_grid_mmap,
+                       nrrd_info, io_time, mmap_message)) {
+      full_scalar_grid_ptr = &full_scalar_grid_mmap;
+    }
+    else {
+      if (input_info.flag_mmap) {
+        cerr << "Warning: Unable to memory map "
+             << input_info.scalar_filename << ". " << mmap_message << endl;
+      }
+      read_nrrd_file(input_info.scalar_filename, full_scalar_grid_read,
+                     nrrd_info, io_time);
+    }
+    const SHARPISO_SCALAR_GRID_BASE & full_scalar_grid = *full_scalar_grid_ptr;
 
-    GRADIENT_GRID full_gradient_grid;
+    GRADIENT_GRID full_gradient_grid_read;
+    GRADIENT_GRID_MMAP full_gradient_grid_mmap;
+    LAZY_GRADIENT_GRID full_gradient_grid_lazy;
+    const GRADIENT_GRID_BASE * full_gradient_grid_ptr =
+      &full_gradient_grid_read;
     NRRD_INFO nrrd_gradient_info;
     std::vector<COORD_TYPE> edgeI_coord;
     std::vector<GRADIENT_COORD_TYPE> edgeI_normal_coord;
 
-    if (input_info.GradientsRequired()) {
+    if (input_info.GradientsRequired() && input_info.flag_lazy_gradients) {
+      compute_lazy_gradients
+        (full_scalar_grid, full_gradient_grid_lazy, shrec_time);
+      full_gradient_grid_ptr = &full_gradient_grid_lazy;
+      flag_gradient = true;
+    }
+    else if (input_info.GradientsRequired()) {
 
       string gradient_filename;
 
@@ -84,11 +131,22 @@ int main(int argc, char **argv)
         gradient_filename = string(input_info.gradient_filename);
       }
 
-      read_nrrd_file(gradient_filename.c_str(), full_gradient_grid,
-                     nrrd_gradient_info);
+      if (input_info.flag_mmap &&
+          mmap_nrrd_file(gradient_filename.c_str(), full_gradient_grid_mmap,
+                         nrrd_gradient_info, mmap_message)) {
+        full_gradient_grid_ptr = &full_gradient_grid_mmap;
+      }
+      else {
+        if (input_info.flag_mmap) {
+          cerr << "Warning: Unable to memory map "
+               << gradient_filename << ". " << mmap_message << endl;
+        }
+        read_nrrd_file(gradient_filename.c_str(), full_gradient_grid_read,
+                       nrrd_gradient_info);
+      }
       flag_gradient = true;
 
-      if (!full_gradient_grid.CompareSize(full_scalar_grid)) {
+      if (!full_gradient_grid_ptr->CompareSize(full_scalar_grid)) {
         error.AddMessage("Input error. Grid mismatch.");
         error.AddMessage
           ("  Dimension or axis sizes of gradient grid and scalar grid do not match.");
@@ -116,25 +174,40 @@ int main(int argc, char **argv)
     SHREC_DATA shrec_data;
     shrec_data.grad_selection_cube_offset = 0.1;
 
+    // Full grids are used without copying unless they are resampled.
+    // Full grids must exist until shrec_data is no longer in use.
+    const bool flag_resample =
+      (input_info.flag_subsample || input_info.flag_supersample);
+
     if (flag_gradient) {
-      shrec_data.SetGrids
-        (full_scalar_grid, full_gradient_grid,
-         input_info.flag_subsample, input_info.subsample_resolution,
-         input_info.flag_supersample, input_info.supersample_resolution);
+      if (flag_resample) {
+        shrec_data.SetGrids
+          (full_scalar_grid, *full_gradient_grid_ptr,
+           input_info.flag_subsample, input_info.subsample_resolution,
+           input_info.flag_supersample, input_info.supersample_resolution);
+      }
+      else {
+        shrec_data.WrapGrids(full_scalar_grid, *full_gradient_grid_ptr);
+      }
     }
     else
     {
-      shrec_data.SetScalarGrid
-        (full_scalar_grid, 
-         input_info.flag_subsample, input_info.subsample_resolution,
-         input_info.flag_supersample, input_info.supersample_resolution);
+      if (flag_resample) {
+        shrec_data.SetScalarGrid
+          (full_scalar_grid, 
+           input_info.flag_subsample, input_info.subsample_resolution,
+           input_info.flag_supersample, input_info.supersample_resolution);
+      }
+      else {
+        shrec_data.WrapScalarGrid(full_scalar_grid);
+      }
 
       if (input_info.NormalsRequired()) {
         shrec_data.SetEdgeI(edgeI_coord, edgeI_normal_coord);
       }
 
     }
-    // Note: shrec_data.SetScalarGrid or shrec_data.SetGrids
+    // Note: shrec_data.SetScalarGrid, SetGrids, WrapScalarGrid or WrapGrids
     //       must be called before set_shrec_data.
     set_shrec_data(input_info, shrec_data, shrec_time);
 
@@ -179,67 +252,116 @@ void construct_isosurface
   const int num_cubes = shrec_data.ScalarGrid().ComputeNumCubes();
 
   io_time.write_time = 0;
-  for (unsigned int i = 0; i < input_info.isovalue.size(); i++) {
 
-    ISOVERT isovert;
+  // Active cubes for all isovalues.
+  std::vector< std::vector<VERTEX_INDEX> > active_cube;
+  if (shrec_data.flag_shared_active_cubes) {
+    float active_cube_time;
+    clock_t t0 = clock();
+    get_active_cubes(shrec_data, input_info.isovalue, active_cube);
+    clock_t t1 = clock();
+    clock2seconds(t1-t0, active_cube_time);
+    shrec_time.preprocessing += active_cube_time;
+  }
 
-    const SCALAR_TYPE isovalue = input_info.isovalue[i];
+  // Isosurfaces computed but not yet written.
+  std::vector< std::unique_ptr<ISOVALUE_RESULT> > 
+    result(input_info.isovalue.size());
+
+  // Compute isosurfaces concurrently.  Write them in isovalue order
+  //   while later isosurfaces are computed.
+  compute_in_parallel_output_in_order
+    (shrec_data.num_isovalue_threads, NUM_TYPE(input_info.isovalue.size()),
+     NUM_TYPE(2*shrec_data.num_isovalue_threads),
+     [&](const NUM_TYPE i) {
+      std::unique_ptr<ISOVALUE_RESULT> isovalue_result
+        (new ISOVALUE_RESULT(dimension));
+      ISOVERT & isovert = isovalue_result->isovert;
+      DUAL_ISOSURFACE & dual_isosurface = isovalue_result->dual_isosurface;
+      SHREC_INFO & shrec_info = isovalue_result->shrec_info;
+
+      const SCALAR_TYPE isovalue = input_info.isovalue[i];
+
+      shrec_info.grid.num_cubes = num_cubes;
+
+      if (shrec_data.flag_shared_active_cubes) {
+        // Active cube list is freed when active_region goes out of scope.
+        ACTIVE_GRID_REGION active_region;
+        active_region.SwapCubeList(active_cube[i]);
+        dual_contouring
+          (shrec_data, isovalue, active_region, dual_isosurface, isovert,
+           shrec_info);
+      }
+      else {
+        dual_contouring
+          (shrec_data, isovalue, dual_isosurface, isovert, shrec_info);
+      }
 
-    DUAL_ISOSURFACE dual_isosurface;
-    SHREC_INFO shrec_info(dimension);
-    shrec_info.grid.num_cubes = num_cubes;
+      if (shrec_data.flag_convert_quad_to_tri) {
 
-    dual_contouring
-      (shrec_data, isovalue, dual_isosurface, isovert, shrec_info);
-    shrec_time.Add(shrec_info.time);
+        VERTEX_INDEX_ARRAY quad_vert(dual_isosurface.quad_vert);
+        VERTEX_INDEX_ARRAY quad_vert2;
+        DUAL_ISOSURFACE isosurface_tri_mesh;
+        isosurface_tri_mesh.vertex_coord = dual_isosurface.vertex_coord;
+        isosurface_tri_mesh.tri_vert = dual_isosurface.tri_vert;
 
-    OUTPUT_INFO output_info;
-    set_output_info(input_info, i, output_info);
+        IJK::reorder_quad_vertices(quad_vert);
 
-    int grow_factor = 1;
-    int shrink_factor = 1;
-    if (input_info.flag_subsample)
-      { grow_factor = input_info.subsample_resolution; }
-    if (input_info.flag_supersample)
-      { shrink_factor = input_info.supersample_resolution; }
+        triangulate_quad_sharing_multiple_edges
+          (quad_vert, isosurface_tri_mesh.tri_vert, quad_vert2);
 
-    if (shrec_data.flag_convert_quad_to_tri) {
+        if (shrec_data.quad_tri_method == SPLIT_MAX_ANGLE) {
 
-      VERTEX_INDEX_ARRAY quad_vert(dual_isosurface.quad_vert);
-      VERTEX_INDEX_ARRAY quad_vert2;
-      DUAL_ISOSURFACE isosurface_tri_mesh;
-      isosurface_tri_mesh.vertex_coord = dual_isosurface.vertex_coord;
-      isosurface_tri_mesh.tri_vert = dual_isosurface.tri_vert;
+          // *** CREATE create_dual_tri IN shrec.cxx ***
+          triangulate_quad_split_max_angle
+            (DIM3, isosurface_tri_mesh.vertex_coord, quad_vert2,
+             shrec_data.max_small_magnitude, isosurface_tri_mesh.tri_vert);
+        }
+        else {
+          triangulate_quad(quad_vert2, isosurface_tri_mesh.tri_vert);
+        }
 
-      IJK::reorder_quad_vertices(quad_vert);
+        std::swap(dual_isosurface, isosurface_tri_mesh);
+      }
 
-      triangulate_quad_sharing_multiple_edges
-        (quad_vert, isosurface_tri_mesh.tri_vert, quad_vert2);
+      result[i] = std::move(isovalue_result);
+    },
+     [&](const NUM_TYPE i) {
+      shrec_time.Add(result[i]->shrec_info.time);
 
-      if (shrec_data.quad_tri_method == SPLIT_MAX_ANGLE) {
+      OUTPUT_INFO output_info;
+      set_output_info(input_info, i, output_info);
 
-        // *** CREATE create_dual_tri IN shrec.cxx ***
-        triangulate_quad_split_max_angle
-          (DIM3, isosurface_tri_mesh.vertex_coord, quad_vert2,
-           shrec_data.max_small_magnitude, isosurface_tri_mesh.tri_vert);
-      }
-      else {
-        triangulate_quad(quad_vert2, isosurface_tri_mesh.tri_vert);
-      }
-	   
-      output_dual_isosurface
-        (output_info, shrec_data, isosurface_tri_mesh, isovert,
-         shrec_info, io_time);
-    }
-    else {
       output_dual_isosurface
-        (output_info, shrec_data, dual_isosurface, isovert,
-         shrec_info, io_time);
-    }
-  }
+        (output_info, shrec_data, result[i]->dual_isosurface, 
+         result[i]->isovert, result[i]->shrec_info, io_time);
+
+      // Free isosurface.
+      result[i].reset();
+    });
 
 }
 
+/**
+* Reserve lazy gradient grid.
+* Gradients are computed when first read.
+* If gradients cannot be computed on read, compute all gradients here.
+*/
+void compute_lazy_gradients
+(const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
+ LAZY_GRADIENT_GRID & gradient_grid, SHREC_TIME & shrec_time)
+{
+  float gradient_time;
+
+  clock_t t0 = clock();
+  gradient_grid.Reserve(scalar_grid);
+  if (!gradient_grid.IsComputedOnRead()) 
+    { gradient_grid.ComputeAll(); }
+  clock_t t1 = clock();
+  clock2seconds(t1-t0, gradient_time);
+  shrec_time.gradient += gradient_time;
+}
+
 void memory_exhaustion()
 {
   cerr << "Error: Out of memory.  Terminating program." << endl;
@@ -30,6 +30,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 #include "ijkgrid_macros.h"
 
 #include "shrec_apply.txx"
+#include "shrec_thread.txx"
 #include "sharpiso_array.txx"
 
 #include "shrec_types.h"
@@ -63,12 +64,14 @@ namespace {
 	void map_adjacent_cubes
   (const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
    const SCALAR_TYPE isovalue,
+   const int num_threads,
    const SHREC::ISOVERT & isovert, 
    std::vector<SHARPISO::VERTEX_INDEX> & gcube_map);
 
 	void unmap_non_disk_isopatches
   (const SHARPISO_SCALAR_GRID_BASE & scalar_grid, 
    const SCALAR_TYPE isovalue,
+   const int num_threads,
    SHREC::ISOVERT & isovert, 
    std::vector<SHARPISO::VERTEX_INDEX> & gcube_map, 
    SHREC::SHARPISO_INFO & sharpiso_info);
@@ -96,6 +99,7 @@ namespace {
 		(const SHARPISO_SCALAR_GRID_BASE & scalar_grid, 
 		const IJKDUALTABLE::ISODUAL_CUBE_TABLE & isodual_table,
 		const SCALAR_TYPE isovalue,
+		const int num_threads,
 		SHREC::ISOVERT & isovert, 
 		std::vector<SHARPISO::VERTEX_INDEX> & gcube_map, 
 		SHREC::SHARPISO_INFO & sharpiso_info);
@@ -124,6 +128,7 @@ namespace {
   (const SHARPISO_SCALAR_GRID_BASE & scalar_grid, 
    const SCALAR_TYPE isovalue,
    const std::vector<NUM_TYPE> & selected_gcube_list,
+   const int num_threads,
    SHREC::ISOVERT & isovert, 
    std::vector<SHARPISO::VERTEX_INDEX> & gcube_map);
 
@@ -395,6 +400,131 @@ namespace {
 
 	using namespace SHREC;
 
+	/// Number of cubes along axis 2 in each slab of the parallel merge.
+	const int MERGE_SLAB_WIDTH = 64;
+
+	/// Cubes within MERGE_SLAB_MARGIN of a slab boundary are in a seam.
+	/// Mapping to a cube reads and writes gcube_map[] and gcube_list[].flag
+	///   only within a few cubes of the cube.  (The extended corner region
+	///   and the 5x5x5 regions of extend_mapping reach at most 3 cubes,
+	///   and checks of connected cubes add at most 3 more.)
+	/// MERGE_SLAB_MARGIN must be at least that distance.
+	const int MERGE_SLAB_MARGIN = 16;
+
+	/// Apply map_to_cube(to_gcube) to each to_gcube in to_gcube_list.
+	/// If num_threads <= 1, apply map_to_cube in list order.
+	/// If num_threads > 1, split the grid into slabs of MERGE_SLAB_WIDTH
+	///   cubes along axis 2.  First apply map_to_cube to cubes in the slab
+	///   interiors, all slabs in parallel.  Then apply map_to_cube
+	///   to cubes in the seams, all seams in parallel.
+	/// Each slab interior and each seam is processed in list order.
+	/// Slab interiors are 2*MERGE_SLAB_MARGIN cubes apart, as are seams,
+	///   so concurrent calls never access the same gcube_map[] entry.
+	/// The result does not depend on num_threads, for num_threads > 1.
+	///   It may differ from the result for num_threads = 1 near seams,
+	///   since seam cubes are mapped after the slab interiors.
+	template <typename MAP_FUNCTION>
+	void apply_to_cubes_in_slabs
+	(const int num_threads, const SHREC::ISOVERT & isovert,
+	 const std::vector<NUM_TYPE> & to_gcube_list, MAP_FUNCTION map_to_cube)
+	{
+		if (num_threads <= 1 || isovert.grid.Dimension() != DIM3) {
+			for (std::size_t i = 0; i < to_gcube_list.size(); i++)
+				{ map_to_cube(to_gcube_list[i]); }
+			return;
+		}
+
+		const std::size_t num_slabs = 
+			isovert.grid.AxisSize(2)/MERGE_SLAB_WIDTH + 1;
+		// seam_list[k] holds cubes within MERGE_SLAB_MARGIN 
+		//   of the boundary k*MERGE_SLAB_WIDTH.
+		std::vector< std::vector<NUM_TYPE> > interior_list(num_slabs);
+		std::vector< std::vector<NUM_TYPE> > seam_list(num_slabs+1);
+
+		for (std::size_t i = 0; i < to_gcube_list.size(); i++) {
+			const NUM_TYPE to_gcube = to_gcube_list[i];
+			const GRID_COORD_TYPE z = isovert.gcube_list[to_gcube].cube_coord[2];
+			const std::size_t k = z/MERGE_SLAB_WIDTH;
+			const GRID_COORD_TYPE r = z%MERGE_SLAB_WIDTH;
+
+			if (r < MERGE_SLAB_MARGIN)
+				{ seam_list[k].push_back(to_gcube); }
+			else if (r >= MERGE_SLAB_WIDTH-MERGE_SLAB_MARGIN)
+				{ seam_list[k+1].push_back(to_gcube); }
+			else
+				{ interior_list[k].push_back(to_gcube); }
+		}
+
+		auto map_to_list = [&](const std::vector<NUM_TYPE> & list) {
+			for (std::size_t j = 0; j < list.size(); j++)
+				{ map_to_cube(list[j]); }
+		};
+
+		apply_in_parallel
+			(num_threads, interior_list.size(),
+			 [&](const std::size_t k) { map_to_list(interior_list[k]); });
+
+		apply_in_parallel
+			(num_threads, seam_list.size(),
+			 [&](const std::size_t k) { map_to_list(seam_list[k]); });
+	}
+
+	/// Apply f to cubes which are facet adjacent to cubes in to_gcube_list.
+	/// Call f(..., args..., flag) as apply_to_cubes_facet_adjacent_to_list,
+	///   but with a flag local to each call, since f may run concurrently.
+	/// See apply_to_cubes_in_slabs.
+	template <typename FTYPE, typename... ATYPES>
+	void apply_to_cubes_facet_adjacent_to_list_in_slabs
+	(const int num_threads, FTYPE f, 
+	 const std::vector<NUM_TYPE> & to_gcube_list,
+	 const SHREC::ISOVERT & isovert, ATYPES & ... args)
+	{
+		apply_to_cubes_in_slabs
+			(num_threads, isovert, to_gcube_list, 
+			 [&](const NUM_TYPE to_gcube) {
+				bool flag;
+				apply_to_cubes_facet_adjacent_to
+					(f, isovert.grid, isovert.CubeIndex(to_gcube), 
+					 isovert.gcube_list[to_gcube].boundary_bits, args..., flag);
+			 });
+	}
+
+	/// Apply f to cubes which are edge adjacent to cubes in to_gcube_list.
+	/// See apply_to_cubes_facet_adjacent_to_list_in_slabs.
+	template <typename FTYPE, typename... ATYPES>
+	void apply_to_cubes_edge_adjacent_to_list_in_slabs
+	(const int num_threads, FTYPE f, 
+	 const std::vector<NUM_TYPE> & to_gcube_list,
+	 const SHREC::ISOVERT & isovert, ATYPES & ... args)
+	{
+		apply_to_cubes_in_slabs
+			(num_threads, isovert, to_gcube_list, 
+			 [&](const NUM_TYPE to_gcube) {
+				bool flag;
+				apply_to_cubes_edge_adjacent_to
+					(f, isovert.grid, isovert.CubeIndex(to_gcube), 
+					 isovert.gcube_list[to_gcube].boundary_bits, args..., flag);
+			 });
+	}
+
+	/// Apply f to cubes which are vertex adjacent to cubes in to_gcube_list.
+	/// See apply_to_cubes_facet_adjacent_to_list_in_slabs.
+	template <typename FTYPE, typename... ATYPES>
+	void apply_to_cubes_vertex_adjacent_to_list_in_slabs
+	(const int num_threads, FTYPE f, 
+	 const std::vector<NUM_TYPE> & to_gcube_list,
+	 const SHREC::ISOVERT & isovert, ATYPES & ... args)
+	{
+		apply_to_cubes_in_slabs
+			(num_threads, isovert, to_gcube_list, 
+			 [&](const NUM_TYPE to_gcube) {
+				bool flag;
+				apply_to_cubes_vertex_adjacent_to
+					(f, isovert.grid, isovert.CubeIndex(to_gcube), 
+					 isovert.gcube_list[to_gcube].boundary_bits, args..., flag);
+			 });
+	}
+
 	void determine_gcube_map
 		(const SHARPISO_SCALAR_GRID_BASE & scalar_grid, 
 		const SCALAR_TYPE isovalue,
@@ -407,19 +537,24 @@ namespace {
 
 		get_selected_cubes(isovert.gcube_list, selected_gcube_list);
 
-		map_adjacent_cubes(scalar_grid, isovalue, isovert, gcube_map);
+		// If merge_param.num_threads > 1, each mapping stage maps
+		//   slabs of the grid in parallel, followed by the seams.
+		map_adjacent_cubes
+			(scalar_grid, isovalue, merge_param.num_threads, isovert, gcube_map);
 
 		if (merge_param.flag_map_extended){
 			extend_mapping_corner_cube
         (scalar_grid, isovalue, merge_param, isovert, gcube_map);
 
 			extend_mapping
-        (scalar_grid, isovalue, selected_gcube_list, isovert, gcube_map);
+        (scalar_grid, isovalue, selected_gcube_list, merge_param.num_threads,
+         isovert, gcube_map);
 		}
 
 		if (merge_param.flag_check_disk) {
 			unmap_non_disk_isopatches
-				(scalar_grid, isovalue, isovert, gcube_map, sharpiso_info);
+				(scalar_grid, isovalue, merge_param.num_threads, isovert, gcube_map,
+         sharpiso_info);
 		}
 	}
 }
@@ -512,14 +647,17 @@ namespace {
     MSDEBUG();
     flag_debug = false;
 
+		// If merge_param.num_threads > 1, each mapping stage maps
+		//   slabs of the grid in parallel, followed by the seams.
+		// Collapsing triangles with small angles is sequential.
 		map_adjacent_cubes_multi
       (scalar_grid, isodual_table, ambig_info, isovalue,
        merge_param, isovert, gcube_map);
 
 		if (merge_param.flag_check_disk) {
 			unmap_non_disk_isopatches
-				(scalar_grid, isodual_table, isovalue, isovert, gcube_map, 
-				sharpiso_info);
+				(scalar_grid, isodual_table, isovalue, merge_param.num_threads,
+         isovert, gcube_map, sharpiso_info);
 		}
 	}
 
@@ -744,54 +882,53 @@ namespace {
 	// Map isosurface vertices adjacent to isosurface in selected cubes
   //   with given number of eigenvalues.
   // @param Map to cubes with the given number of eigenvalues.
+  // @param num_threads Number of threads.  If num_threads > 1,
+  //   map slabs in parallel.  See apply_to_cubes_in_slabs.
   // Handles SOME boundary cases.
 	void map_adjacent_cubes
   (const SHARPISO_SCALAR_GRID_BASE & scalar_grid, 
    const SCALAR_TYPE isovalue,
    const SHREC::ISOVERT & isovert, 
    const int num_eigenvalues,
+   const int num_threads,
    std::vector<SHARPISO::VERTEX_INDEX> & gcube_map)
 	{
 		std::vector<NUM_TYPE> sharp_gcube_list;
 		using namespace SHREC;
 
-		const NUM_TYPE num_gcube = isovert.gcube_list.size();
-		VERTEX_INDEX cube_index, neighbor_index;
-
 		get_corner_or_edge_cubes(isovert.gcube_list, sharp_gcube_list);
 
 		// Map cubes which share facets with selected cubes.
-		for (NUM_TYPE i = 0; i < sharp_gcube_list.size(); i++) {
-
-			NUM_TYPE to_gcube = sharp_gcube_list[i];
-
-      if (isovert.gcube_list[to_gcube].num_eigenvalues == num_eigenvalues) {
-        VERTEX_INDEX to_cube = isovert.CubeIndex(to_gcube);
-        map_facet_adjacent_cubes
-          (scalar_grid, isovalue, isovert, to_cube, gcube_map);
-      }
-		}
+		apply_to_cubes_in_slabs
+			(num_threads, isovert, sharp_gcube_list,
+			 [&](const NUM_TYPE to_gcube) {
+        if (isovert.gcube_list[to_gcube].num_eigenvalues == num_eigenvalues) {
+          VERTEX_INDEX to_cube = isovert.CubeIndex(to_gcube);
+          map_facet_adjacent_cubes
+            (scalar_grid, isovalue, isovert, to_cube, gcube_map);
+        }
+			 });
 
 		// Set cubes which share edges with selected cubes.
-		for (NUM_TYPE i = 0; i < sharp_gcube_list.size(); i++) {
-
-			NUM_TYPE to_gcube = sharp_gcube_list[i];
-      if (isovert.gcube_list[to_gcube].num_eigenvalues == num_eigenvalues) {
-        VERTEX_INDEX to_cube = isovert.CubeIndex(to_gcube);
-        map_edge_adjacent_cubes
-          (scalar_grid, isovalue, isovert, to_cube, gcube_map);
-      }
-		}
-
-		for (NUM_TYPE i = 0; i < sharp_gcube_list.size(); i++) {
-
-			NUM_TYPE to_gcube = sharp_gcube_list[i];
-      if (isovert.gcube_list[to_gcube].num_eigenvalues == num_eigenvalues) {
-        VERTEX_INDEX to_cube = isovert.CubeIndex(to_gcube);
-        map_vertex_adjacent_cubes
-          (scalar_grid, isovalue, isovert, to_cube, gcube_map);
-      }
-		}
+		apply_to_cubes_in_slabs
+			(num_threads, isovert, sharp_gcube_list,
+			 [&](const NUM_TYPE to_gcube) {
+        if (isovert.gcube_list[to_gcube].num_eigenvalues == num_eigenvalues) {
+          VERTEX_INDEX to_cube = isovert.CubeIndex(to_gcube);
+          map_edge_adjacent_cubes
+            (scalar_grid, isovalue, isovert, to_cube, gcube_map);
+        }
+			 });
+
+		apply_to_cubes_in_slabs
+			(num_threads, isovert, sharp_gcube_list,
+			 [&](const NUM_TYPE to_gcube) {
+        if (isovert.gcube_list[to_gcube].num_eigenvalues == num_eigenvalues) {
+          VERTEX_INDEX to_cube = isovert.CubeIndex(to_gcube);
+          map_vertex_adjacent_cubes
+            (scalar_grid, isovalue, isovert, to_cube, gcube_map);
+        }
+			 });
 
 	}
 
@@ -801,6 +938,7 @@ namespace {
 	void map_adjacent_cubes
   (const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
    const SCALAR_TYPE isovalue,
+   const int num_threads,
    const SHREC::ISOVERT & isovert, 
    std::vector<SHARPISO::VERTEX_INDEX> & gcube_map)
 	{
@@ -816,11 +954,11 @@ namespace {
 
     // Map to corner cubes.
     map_adjacent_cubes
-      (scalar_grid, isovalue, isovert, 3, gcube_map);
+      (scalar_grid, isovalue, isovert, 3, num_threads, gcube_map);
 
     // Map to edge cubes.
     map_adjacent_cubes
-      (scalar_grid, isovalue, isovert, 2, gcube_map);
+      (scalar_grid, isovalue, isovert, 2, num_threads, gcube_map);
 	}
 
 	void map_gcube_indices(const std::vector<VERTEX_INDEX> & gcube_map,
@@ -1028,7 +1166,7 @@ namespace {
     const VERTEX_INDEX cube_index[2] = { cubeA_index, cubeB_index };
     const INDEX_DIFF_TYPE gcube_index[2] = { gcubeA_index, gcubeB_index };
     NUM_TYPE store_map[2];
-    static CUBE_CONNECTED_ARRAY connected_sharp;
+    static thread_local CUBE_CONNECTED_ARRAY connected_sharp;
 
     if (gcubeA_index == ISOVERT::NO_INDEX) { throw error; }
     if (gcubeB_index == ISOVERT::NO_INDEX) { throw error; }
@@ -1076,7 +1214,7 @@ namespace {
       isovert.GCubeIndex(to_cube_index, error);
     INDEX_DIFF_TYPE gcube_index[3];
     NUM_TYPE store_map[3];
-    static CUBE_CONNECTED_ARRAY connected_sharp;
+    static thread_local CUBE_CONNECTED_ARRAY connected_sharp;
 
     if (to_gcube_index == ISOVERT::NO_INDEX) { throw error; }
     for (int i = 0; i < 3; i++) {
@@ -1131,7 +1269,7 @@ namespace {
    const std::vector<SHARPISO::VERTEX_INDEX> & gcube_map,
    const bool flag_extended)
   {
-    static CUBE_CONNECTED_ARRAY connected_sharp;
+    static thread_local CUBE_CONNECTED_ARRAY connected_sharp;
     INDEX_DIFF_TYPE to_gcube = isovert.GCubeIndex(to_cube);
     GRID_BOX region(DIM3);
 
@@ -1876,8 +2014,6 @@ namespace {
 	{
     const bool flag_strict(true);
     const MAP_PARAM_FLAGS param_flags = { false, flag_strict, true };
-    GRID_BOX region(DIM3);
-    bool flag;
 
 
     MSDEBUG();
@@ -1885,82 +2021,83 @@ namespace {
       cerr << endl << "--- In " << __func__ << endl;
     }
 
-    for (NUM_TYPE i = 0; i < selected_corner_gcube_list.size(); i++) {
-
-      NUM_TYPE gcube_index = selected_corner_gcube_list[i];
-
-      if (isovert.NumEigenvalues(gcube_index) != 3) { continue; }
-
-      VERTEX_INDEX to_cube = isovert.CubeIndex(gcube_index);
-      const BOUNDARY_BITS_TYPE boundary_bits =
-        isovert.gcube_list[gcube_index].boundary_bits;
-      construct_small_corner_cube_region
-        (isovert.grid, bin_grid, bin_width, isovert, to_cube, region);
-
-      // Map cubes which share facets with selected cubes.
-      map_facet_adjacent_cubes_multi
-        (scalar_grid, isodual_table, ambig_info, isovalue, isovert,
-         to_cube, param_flags, merge_param, region, gcube_map);
-
-      // Map cubes which share edges with selected cubes.
-      map_edge_adjacent_cubes_multi
-        (scalar_grid, isodual_table, ambig_info, isovalue, isovert,
-         to_cube, param_flags, merge_param, region, gcube_map);
-
-      // Map cube pairs (cube0, cube1) where cube0 is facet adjacent
-      //   to a selected cube
-      map_adjacent_pairs_facet_adjacent_to_corner
-        (scalar_grid, isodual_table, ambig_info, isovalue, isovert,
-         to_cube, boundary_bits, param_flags, merge_param, region, gcube_map);
-
-      // Try again to map cubes which share facets with selected cubes.
-      map_facet_adjacent_cubes_multi
-        (scalar_grid, isodual_table, ambig_info, isovalue, isovert,
-         to_cube, param_flags, merge_param, region, gcube_map);
-
-      // Try again to map cubes which share edges with selected cubes.
-      map_edge_adjacent_cubes_multi
-        (scalar_grid, isodual_table, ambig_info, isovalue, isovert,
-         to_cube, param_flags, merge_param, region, gcube_map);
-
-      // Map cubes which share vertices with selected cubes.
-      map_vertex_adjacent_cubes_multi
-        (scalar_grid, isodual_table, ambig_info, isovalue, isovert,
-         to_cube, param_flags, merge_param, region, gcube_map);
-
-      // Map cube pairs (cube0, cube1) where cube0 is edge adjacent
-      //   to a selected cube
-      map_adjacent_pairs_edge_adjacent_to_corner
-        (scalar_grid, isodual_table, ambig_info, isovalue, isovert,
-         to_cube, boundary_bits, param_flags, merge_param, region, gcube_map);
-
-      // Try again to map cubes which share facets with selected cubes.
-      map_facet_adjacent_cubes_multi
-        (scalar_grid, isodual_table, ambig_info, isovalue, isovert,
-         to_cube, param_flags, merge_param, region, gcube_map);
-
-      // Try again to map cubes which share edges with selected cubes.
-      map_edge_adjacent_cubes_multi
-        (scalar_grid, isodual_table, ambig_info, isovalue, isovert,
-         to_cube, param_flags, merge_param, region, gcube_map);
-
-      // Try again to map cubes which share vertices with selected cubes.
-      map_vertex_adjacent_cubes_multi
-        (scalar_grid, isodual_table, ambig_info, isovalue, isovert,
-         to_cube, param_flags, merge_param, region, gcube_map);
-
-      // Try again to map cube pairs (cube0, cube1) 
-      //   where cube0 is facet adjacent to a selected cube
-      map_adjacent_pairs_facet_adjacent_to_corner
-        (scalar_grid, isodual_table, ambig_info, isovalue, isovert,
-         to_cube, boundary_bits, param_flags, merge_param, region, gcube_map);
-
-      // Try again to map cube pairs (cube0, cube1) 
-      //   where cube0 is edge adjacent to a selected cube
-      map_adjacent_pairs_edge_adjacent_to_corner
-        (scalar_grid, isodual_table, ambig_info, isovalue, isovert,
-         to_cube, boundary_bits, param_flags, merge_param, region, gcube_map);
-    }
+    apply_to_cubes_in_slabs
+      (merge_param.num_threads, isovert, selected_corner_gcube_list,
+       [&](const NUM_TYPE gcube_index) {
+        if (isovert.NumEigenvalues(gcube_index) != 3) { return; }
+
+        GRID_BOX region(DIM3);
+
+        VERTEX_INDEX to_cube = isovert.CubeIndex(gcube_index);
+        const BOUNDARY_BITS_TYPE boundary_bits =
+          isovert.gcube_list[gcube_index].boundary_bits;
+        construct_small_corner_cube_region
+          (isovert.grid, bin_grid, bin_width, isovert, to_cube, region);
+
+        // Map cubes which share facets with selected cubes.
+        map_facet_adjacent_cubes_multi
+          (scalar_grid, isodual_table, ambig_info, isovalue, isovert,
+           to_cube, param_flags, merge_param, region, gcube_map);
+
+        // Map cubes which share edges with selected cubes.
+        map_edge_adjacent_cubes_multi
+          (scalar_grid, isodual_table, ambig_info, isovalue, isovert,
+           to_cube, param_flags, merge_param, region, gcube_map);
+
+        // Map cube pairs (cube0, cube1) where cube0 is facet adjacent
+        //   to a selected cube
+        map_adjacent_pairs_facet_adjacent_to_corner
+          (scalar_grid, isodual_table, ambig_info, isovalue, isovert,
+           to_cube, boundary_bits, param_flags, merge_param, region, gcube_map);
+
+        // Try again to map cubes which share facets with selected cubes.
+        map_facet_adjacent_cubes_multi
+          (scalar_grid, isodual_table, ambig_info, isovalue, isovert,
+           to_cube, param_flags, merge_param, region, gcube_map);
+
+        // Try again to map cubes which share edges with selected cubes.
+        map_edge_adjacent_cubes_multi
+          (scalar_grid, isodual_table, ambig_info, isovalue, isovert,
+           to_cube, param_flags, merge_param, region, gcube_map);
+
+        // Map cubes which share vertices with selected cubes.
+        map_vertex_adjacent_cubes_multi
+          (scalar_grid, isodual_table, ambig_info, isovalue, isovert,
+           to_cube, param_flags, merge_param, region, gcube_map);
+
+        // Map cube pairs (cube0, cube1) where cube0 is edge adjacent
+        //   to a selected cube
+        map_adjacent_pairs_edge_adjacent_to_corner
+          (scalar_grid, isodual_table, ambig_info, isovalue, isovert,
+           to_cube, boundary_bits, param_flags, merge_param, region, gcube_map);
+
+        // Try again to map cubes which share facets with selected cubes.
+        map_facet_adjacent_cubes_multi
+          (scalar_grid, isodual_table, ambig_info, isovalue, isovert,
+           to_cube, param_flags, merge_param, region, gcube_map);
+
+        // Try again to map cubes which share edges with selected cubes.
+        map_edge_adjacent_cubes_multi
+          (scalar_grid, isodual_table, ambig_info, isovalue, isovert,
+           to_cube, param_flags, merge_param, region, gcube_map);
+
+        // Try again to map cubes which share vertices with selected cubes.
+        map_vertex_adjacent_cubes_multi
+          (scalar_grid, isodual_table, ambig_info, isovalue, isovert,
+           to_cube, param_flags, merge_param, region, gcube_map);
+
+        // Try again to map cube pairs (cube0, cube1) 
+        //   where cube0 is facet adjacent to a selected cube
+        map_adjacent_pairs_facet_adjacent_to_corner
+          (scalar_grid, isodual_table, ambig_info, isovalue, isovert,
+           to_cube, boundary_bits, param_flags, merge_param, region, gcube_map);
+
+        // Try again to map cube pairs (cube0, cube1) 
+        //   where cube0 is edge adjacent to a selected cube
+        map_adjacent_pairs_edge_adjacent_to_corner
+          (scalar_grid, isodual_table, ambig_info, isovalue, isovert,
+           to_cube, boundary_bits, param_flags, merge_param, region, gcube_map);
+      });
 	}
 
 	// Map isosurface vertices adjacent to isosurface in selected cubes.
@@ -1976,8 +2113,6 @@ namespace {
    const MERGE_PARAM & merge_param,
    std::vector<SHARPISO::VERTEX_INDEX> & gcube_map)
 	{
-    bool flag;
-
     MSDEBUG();
     if (flag_debug) {
       cerr << endl << "--- In " << __func__ << endl;
@@ -1986,22 +2121,25 @@ namespace {
     }
 
     // Map cubes which share facets with selected cubes.
-    apply_to_cubes_facet_adjacent_to_list
-      (check_and_map_isov_multi, selected_gcube_list, 
+    apply_to_cubes_facet_adjacent_to_list_in_slabs
+      (merge_param.num_threads,
+       check_and_map_isov_multi, selected_gcube_list, 
        isovert, scalar_grid, isodual_table, ambig_info, isovalue, isovert,
-       param_flags, merge_param, gcube_map, flag);
+       param_flags, merge_param, gcube_map);
 
     // Map cubes which share edges with selected cubes.
-    apply_to_cubes_edge_adjacent_to_list
-      (check_and_map_isov_multi, selected_gcube_list, 
+    apply_to_cubes_edge_adjacent_to_list_in_slabs
+      (merge_param.num_threads,
+       check_and_map_isov_multi, selected_gcube_list, 
        isovert, scalar_grid, isodual_table, ambig_info, isovalue, isovert,
-       param_flags, merge_param, gcube_map, flag);
+       param_flags, merge_param, gcube_map);
 
     // Map cubes which share vertex with selected cubes.
-    apply_to_cubes_vertex_adjacent_to_list
-      (check_and_map_isov_multi, selected_gcube_list, 
+    apply_to_cubes_vertex_adjacent_to_list_in_slabs
+      (merge_param.num_threads,
+       check_and_map_isov_multi, selected_gcube_list, 
        isovert, scalar_grid, isodual_table, ambig_info, isovalue, isovert,
-       param_flags, merge_param, gcube_map, flag);
+       param_flags, merge_param, gcube_map);
   }
 
 	// Map cube pairs which share an ambiguous facet
@@ -2017,7 +2155,6 @@ namespace {
    const MERGE_PARAM & merge_param,
    std::vector<SHARPISO::VERTEX_INDEX> & gcube_map)
   {
-    bool flag;
     MAP_PARAM_FLAGS param_flags;
 
     param_flags.extended = flag_extended;
@@ -2032,16 +2169,18 @@ namespace {
     }
 
     // Map cube pairs where one cube is facet adjacent to a cube in the list.
-    apply_to_cubes_facet_adjacent_to_list
-      (check_and_map_ambig_pair, selected_gcube_list, isovert,
+    apply_to_cubes_facet_adjacent_to_list_in_slabs
+      (merge_param.num_threads,
+       check_and_map_ambig_pair, selected_gcube_list, isovert,
        scalar_grid, isodual_table, ambig_info, isovalue, isovert,
-       param_flags, merge_param, gcube_map, flag);
+       param_flags, merge_param, gcube_map);
 
     // Map cube pairs where one cube is edge adjacent to a cube in the list.
-    apply_to_cubes_edge_adjacent_to_list
-      (check_and_map_ambig_pair, selected_gcube_list, isovert,
+    apply_to_cubes_edge_adjacent_to_list_in_slabs
+      (merge_param.num_threads,
+       check_and_map_ambig_pair, selected_gcube_list, isovert,
        scalar_grid, isodual_table, ambig_info, isovalue, isovert,
-       param_flags, merge_param, gcube_map, flag);
+       param_flags, merge_param, gcube_map);
   }
 
 	// Map isosurface vertices adjacent to isosurface in selected cubes
@@ -2065,7 +2204,6 @@ namespace {
     const bool flag_extended = false;
     const bool flag_strict = true;
     MAP_PARAM_FLAGS param_flags;
-    bool flag;
 
     param_flags.extended = flag_extended;
     param_flags.strict = flag_strict;
@@ -2078,41 +2216,47 @@ namespace {
     }
 
     // Map cubes which share facets with selected cubes.
-    apply_to_cubes_facet_adjacent_to_list
-      (check_and_map_isov_multi, selected_gcube_list, isovert, 
+    apply_to_cubes_facet_adjacent_to_list_in_slabs
+      (merge_param.num_threads,
+       check_and_map_isov_multi, selected_gcube_list, isovert, 
        scalar_grid, isodual_table, ambig_info, isovalue, isovert,
-       param_flags, merge_param, gcube_map, flag);
+       param_flags, merge_param, gcube_map);
 
     // Map cube pairs which share an ambiguous facet.
-    apply_to_cubes_facet_adjacent_to_list
-      (check_and_map_ambig_pair, selected_gcube_list, isovert, scalar_grid, 
+    apply_to_cubes_facet_adjacent_to_list_in_slabs
+      (merge_param.num_threads,
+       check_and_map_ambig_pair, selected_gcube_list, isovert, scalar_grid, 
        isodual_table, ambig_info, isovalue, isovert, param_flags,
-       merge_param, gcube_map, flag);
+       merge_param, gcube_map);
 
     // Map cube triples containing an ambiguous pair.
-    apply_to_cubes_facet_adjacent_to_list
-      (check_and_map_triple_ambig, selected_gcube_list, isovert, scalar_grid, 
+    apply_to_cubes_facet_adjacent_to_list_in_slabs
+      (merge_param.num_threads,
+       check_and_map_triple_ambig, selected_gcube_list, isovert, scalar_grid, 
        isodual_table, ambig_info, isovalue, isovert, flag_extended, 
-       merge_param, gcube_map, flag);
+       merge_param, gcube_map);
 
 		// Map cubes which share edges with selected cubes.
-    apply_to_cubes_edge_adjacent_to_list
-      (check_and_map_isov_multi, selected_gcube_list, isovert,  
+    apply_to_cubes_edge_adjacent_to_list_in_slabs
+      (merge_param.num_threads,
+       check_and_map_isov_multi, selected_gcube_list, isovert,  
        scalar_grid, isodual_table, ambig_info, isovalue, isovert,
-       param_flags, merge_param, gcube_map, flag);
+       param_flags, merge_param, gcube_map);
 
     // Map cube pairs which share an ambiguous facet.
-    apply_to_cubes_edge_adjacent_to_list
-      (check_and_map_ambig_pair, selected_gcube_list, isovert, scalar_grid,
+    apply_to_cubes_edge_adjacent_to_list_in_slabs
+      (merge_param.num_threads,
+       check_and_map_ambig_pair, selected_gcube_list, isovert, scalar_grid,
        isodual_table, ambig_info, isovalue, isovert, param_flags,
-       merge_param, gcube_map, flag);
+       merge_param, gcube_map);
 
     // Map cube pairs (cube0, cube1) where cube0 is facet adjacent
     //   to a selected cube
-    apply_to_cubes_facet_adjacent_to_list
-      (map_facet_adjacent_pairs, selected_gcube_list, isovert, scalar_grid, 
+    apply_to_cubes_facet_adjacent_to_list_in_slabs
+      (merge_param.num_threads,
+       map_facet_adjacent_pairs, selected_gcube_list, isovert, scalar_grid, 
        isodual_table, ambig_info, isovalue, isovert, flag_extended, 
-       merge_param, gcube_map, flag);
+       merge_param, gcube_map);
 
     // Map cubes which are facet, edge or vertex adjacent to selected cubes.
     map_adjacent_cubes_multi_simple
@@ -2126,29 +2270,33 @@ namespace {
 
     // Try again to map cube pairs (cube0, cube1) where cube0 
     //   is facet adjacent to a selected cube
-    apply_to_cubes_facet_adjacent_to_list
-      (map_facet_adjacent_pairs, selected_gcube_list, isovert, scalar_grid, 
+    apply_to_cubes_facet_adjacent_to_list_in_slabs
+      (merge_param.num_threads,
+       map_facet_adjacent_pairs, selected_gcube_list, isovert, scalar_grid, 
        isodual_table, ambig_info, isovalue, isovert, flag_extended,
-       merge_param, gcube_map, flag);
+       merge_param, gcube_map);
 
     // Map cube pairs (cube0, cube1) where cube0 is edge adjacent
     //   to a selected cube
-    apply_to_cubes_edge_adjacent_to_list
-      (map_facet_adjacent_pairs, selected_gcube_list, isovert, scalar_grid, 
+    apply_to_cubes_edge_adjacent_to_list_in_slabs
+      (merge_param.num_threads,
+       map_facet_adjacent_pairs, selected_gcube_list, isovert, scalar_grid, 
        isodual_table, ambig_info, isovalue, isovert, flag_extended, 
-       merge_param, gcube_map, flag);
+       merge_param, gcube_map);
 
     // Map two cubes to different cubes.
-    apply_to_cubes_facet_adjacent_to_list
-      (map_adjacent_cubes_to_different, selected_gcube_list, isovert, isovert,
+    apply_to_cubes_facet_adjacent_to_list_in_slabs
+      (merge_param.num_threads,
+       map_adjacent_cubes_to_different, selected_gcube_list, isovert, isovert,
        scalar_grid, isodual_table, ambig_info, isovalue, flag_extended, 
-       merge_param, gcube_map, flag);
+       merge_param, gcube_map);
 
     // Map two cubes to different cubes.
-    apply_to_cubes_edge_adjacent_to_list
-      (map_adjacent_cubes_to_different, selected_gcube_list, isovert, isovert,
+    apply_to_cubes_edge_adjacent_to_list_in_slabs
+      (merge_param.num_threads,
+       map_adjacent_cubes_to_different, selected_gcube_list, isovert, isovert,
        scalar_grid, isodual_table, ambig_info, isovalue, flag_extended, 
-       merge_param, gcube_map, flag);
+       merge_param, gcube_map);
 
     // Try again to map cubes which are facet, edge or vertex adjacent 
     //   to selected cubes.
@@ -2163,17 +2311,19 @@ namespace {
 
     // Try again to map cube pairs (cube0, cube1) where cube0 
     //   is facet adjacent to a selected cube
-    apply_to_cubes_facet_adjacent_to_list
-      (map_facet_adjacent_pairs, selected_gcube_list, isovert, scalar_grid, 
+    apply_to_cubes_facet_adjacent_to_list_in_slabs
+      (merge_param.num_threads,
+       map_facet_adjacent_pairs, selected_gcube_list, isovert, scalar_grid, 
        isodual_table, ambig_info, isovalue, isovert, flag_extended, 
-       merge_param, gcube_map, flag);
+       merge_param, gcube_map);
 
     // Map cube pairs (cube0, cube1) where cube0 is edge adjacent
     //   to a selected cube
-    apply_to_cubes_edge_adjacent_to_list
-      (map_facet_adjacent_pairs, selected_gcube_list, isovert, scalar_grid, 
+    apply_to_cubes_edge_adjacent_to_list_in_slabs
+      (merge_param.num_threads,
+       map_facet_adjacent_pairs, selected_gcube_list, isovert, scalar_grid, 
        isodual_table, ambig_info, isovalue, isovert, flag_extended, 
-       merge_param, gcube_map, flag);
+       merge_param, gcube_map);
 
     // Try again to map cubes which are facet, edge or vertex adjacent 
     //   to selected cubes.
@@ -2265,7 +2415,8 @@ namespace {
          merge_param, isovert, gcube_map);
 
       extend_mapping
-        (scalar_grid, isovalue, selected_gcube_list, isovert, gcube_map);
+        (scalar_grid, isovalue, selected_gcube_list, merge_param.num_threads,
+         isovert, gcube_map);
 
       extend_mappingII(scalar_grid, isovalue, selected_gcube_list, merge_param,
                        isovert, gcube_map);
@@ -2308,7 +2459,8 @@ namespace {
          flag_strict, merge_param, gcube_map);
 
       extend_mapping
-        (scalar_grid, isovalue, selected_gcube_list, isovert, gcube_map);
+        (scalar_grid, isovalue, selected_gcube_list, merge_param.num_threads,
+         isovert, gcube_map);
 
       extend_mappingII(scalar_grid, isovalue, selected_gcube_list, merge_param,
                        isovert, gcube_map);
@@ -4226,20 +4378,19 @@ namespace {
     insert_selected_in_bin_grid
       (scalar_grid, isovert, sharp_gcube_list, bin_width, bin_grid);
 
-    for (int i=0; i < sharp_gcube_list.size(); i++) {
-
-      NUM_TYPE gcube_index = sharp_gcube_list[i];
-
-      if (isovert.gcube_list[gcube_index].flag == SELECTED_GCUBE) {
-        if (isovert.NumEigenvalues(gcube_index) == 3) {
-          VERTEX_INDEX corner_cube_index = isovert.CubeIndex(gcube_index);
+    apply_to_cubes_in_slabs
+      (merge_param.num_threads, isovert, sharp_gcube_list,
+       [&](const NUM_TYPE gcube_index) {
+        if (isovert.gcube_list[gcube_index].flag == SELECTED_GCUBE) {
+          if (isovert.NumEigenvalues(gcube_index) == 3) {
+            VERTEX_INDEX corner_cube_index = isovert.CubeIndex(gcube_index);
 
-          extend_mapping_corner_cube
-            (scalar_grid, bin_grid, bin_width, isovalue,
-             corner_cube_index, isovert, gcube_map);
+            extend_mapping_corner_cube
+              (scalar_grid, bin_grid, bin_width, isovalue,
+               corner_cube_index, isovert, gcube_map);
+          }
         }
-      }
-    }
+      });
   }
 
   // Return number of coordinates which differ by exactly two.
@@ -4548,7 +4699,7 @@ namespace {
   {
     INDEX_DIFF_TYPE from_gcube = isovert.GCubeIndex(from_cube);
     INDEX_DIFF_TYPE to_gcube = isovert.GCubeIndex(to_cube);
-    static CUBE_CONNECTED_ARRAY connected_sharp;
+    static thread_local CUBE_CONNECTED_ARRAY connected_sharp;
 
     flag_map = false;
 
@@ -4668,21 +4819,20 @@ namespace {
     insert_selected_in_bin_grid
       (scalar_grid, isovert, sharp_gcube_list, bin_width, bin_grid);
 
-    for (int i=0; i < sharp_gcube_list.size(); i++) {
-
-      NUM_TYPE gcube_index = sharp_gcube_list[i];
-
-      if (isovert.gcube_list[gcube_index].flag == SELECTED_GCUBE) {
-        if (isovert.NumEigenvalues(gcube_index) == 3) {
-          VERTEX_INDEX corner_cube_index = isovert.CubeIndex(gcube_index);
-
-          extend_mapping_corner_cube_multi
-            (scalar_grid, isodual_table, ambig_info, 
-             bin_grid, bin_width, isovalue, corner_cube_index, merge_param,
-             isovert, gcube_map);
+    apply_to_cubes_in_slabs
+      (merge_param.num_threads, isovert, sharp_gcube_list,
+       [&](const NUM_TYPE gcube_index) {
+        if (isovert.gcube_list[gcube_index].flag == SELECTED_GCUBE) {
+          if (isovert.NumEigenvalues(gcube_index) == 3) {
+            VERTEX_INDEX corner_cube_index = isovert.CubeIndex(gcube_index);
+
+            extend_mapping_corner_cube_multi
+              (scalar_grid, isodual_table, ambig_info, 
+               bin_grid, bin_width, isovalue, corner_cube_index, merge_param,
+               isovert, gcube_map);
+          }
         }
-      }
-    }
+      });
   }
 
   /// Extend mapping of isosurface vertices to corner cube.
@@ -4864,20 +5014,23 @@ namespace {
 
 
   /// Extend mapping of isosurface vertices
+  /// @param num_threads Number of threads.  If num_threads > 1,
+  ///   map slabs in parallel.  See apply_to_cubes_in_slabs.
 	void extend_mapping
   (const SHARPISO_SCALAR_GRID_BASE & scalar_grid, 
    const SCALAR_TYPE isovalue,
    const std::vector<NUM_TYPE> & selected_gcube_list,
+   const int num_threads,
    SHREC::ISOVERT & isovert, 
    std::vector<SHARPISO::VERTEX_INDEX> & gcube_map)
 	{
-    for (NUM_TYPE i = 0; i < selected_gcube_list.size(); i++) {
-
-      const NUM_TYPE gcube_index = selected_gcube_list[i];
-      extend_mapping_to_cube
-        (scalar_grid, isovalue, isovert.gcube_list[gcube_index], 
-         isovert, gcube_map);
-    }
+    apply_to_cubes_in_slabs
+      (num_threads, isovert, selected_gcube_list,
+       [&](const NUM_TYPE gcube_index) {
+        extend_mapping_to_cube
+          (scalar_grid, isovalue, isovert.gcube_list[gcube_index], 
+           isovert, gcube_map);
+      });
 	}
 
 
@@ -4894,13 +5047,13 @@ namespace {
     if (flag_debug)
       { cerr << endl << "--- In " << __func__ << endl; }
 
-    for (NUM_TYPE i = 0; i < selected_gcube_list.size(); i++) {
-
-      const NUM_TYPE gcube_index = selected_gcube_list[i];
-      extend_mapping_to_cubeII
-        (scalar_grid, isovalue, isovert.gcube_list[gcube_index], merge_param,
-         isovert, gcube_map);
-    }
+    apply_to_cubes_in_slabs
+      (merge_param.num_threads, isovert, selected_gcube_list,
+       [&](const NUM_TYPE gcube_index) {
+        extend_mapping_to_cubeII
+          (scalar_grid, isovalue, isovert.gcube_list[gcube_index], 
+           merge_param, isovert, gcube_map);
+      });
 	}
 
   // *** CURRENTLY NOT USED. ***
@@ -5091,7 +5244,6 @@ namespace {
    std::vector<SHARPISO::VERTEX_INDEX> & gcube_map)
   {
     const bool flag_extended = true;
-    BOUNDARY_BITS_TYPE boundary_bits;
 
     if (flag_debug) {
       MSDEBUG();
@@ -5100,47 +5252,46 @@ namespace {
            << endl;
     }
 
-		for (NUM_TYPE i = 0; i < sharp_gcube_list.size(); i++) {
-
-			NUM_TYPE to_gcube = sharp_gcube_list[i];
-
-      if (isovert.gcube_list[to_gcube].flag == SELECTED_GCUBE) {
-        VERTEX_INDEX to_cube = isovert.CubeIndex(to_gcube);
-        boundary_bits = isovert.gcube_list[to_gcube].boundary_bits;
-
-        bool flag_map;
-        apply_to_cubes_facet_adjacent_to
-          (map_facet_adjacent_pairs, isovert.grid, to_cube, boundary_bits,
-           scalar_grid, isodual_table, ambig_info, isovalue, isovert,
-           flag_extended, merge_param, gcube_map, flag_map);
-
-        apply_to_cubes_edge_adjacent_to
-          (map_facet_adjacent_pairs, isovert.grid, to_cube, boundary_bits,
-           scalar_grid, isodual_table, ambig_info, isovalue, isovert,
-           flag_extended, merge_param, gcube_map, flag_map);
-
-        apply_to_cubes_vertex_adjacent_to
-          (map_facet_adjacent_pairs, isovert.grid, to_cube, boundary_bits,
-           scalar_grid, isodual_table, ambig_info, isovalue, isovert,
-           flag_extended, merge_param, gcube_map, flag_map);
-
-        apply_to_cubes_facet_adjacent_to
-          (map_edge_adjacent_pairs, isovert.grid, to_cube, boundary_bits,
-           scalar_grid, isodual_table, ambig_info, isovalue, isovert,
-           flag_extended, merge_param, gcube_map, flag_map);
-
-        apply_to_cubes_edge_adjacent_to
-          (map_edge_adjacent_pairs, isovert.grid, to_cube, boundary_bits,
-           scalar_grid, isodual_table, ambig_info, isovalue, isovert,
-           flag_extended, merge_param, gcube_map, flag_map);
-
-        apply_to_cubes_vertex_adjacent_to
-          (map_edge_adjacent_pairs, isovert.grid, to_cube, boundary_bits,
-           scalar_grid, isodual_table, ambig_info, isovalue, isovert,
-           flag_extended, merge_param, gcube_map, flag_map);
-      }
-		}
+    apply_to_cubes_in_slabs
+      (merge_param.num_threads, isovert, sharp_gcube_list,
+       [&](const NUM_TYPE to_gcube) {
+        if (isovert.gcube_list[to_gcube].flag == SELECTED_GCUBE) {
+          VERTEX_INDEX to_cube = isovert.CubeIndex(to_gcube);
+          const BOUNDARY_BITS_TYPE boundary_bits = 
+            isovert.gcube_list[to_gcube].boundary_bits;
 
+          bool flag_map;
+          apply_to_cubes_facet_adjacent_to
+            (map_facet_adjacent_pairs, isovert.grid, to_cube, boundary_bits,
+             scalar_grid, isodual_table, ambig_info, isovalue, isovert,
+             flag_extended, merge_param, gcube_map, flag_map);
+
+          apply_to_cubes_edge_adjacent_to
+            (map_facet_adjacent_pairs, isovert.grid, to_cube, boundary_bits,
+             scalar_grid, isodual_table, ambig_info, isovalue, isovert,
+             flag_extended, merge_param, gcube_map, flag_map);
+
+          apply_to_cubes_vertex_adjacent_to
+            (map_facet_adjacent_pairs, isovert.grid, to_cube, boundary_bits,
+             scalar_grid, isodual_table, ambig_info, isovalue, isovert,
+             flag_extended, merge_param, gcube_map, flag_map);
+
+          apply_to_cubes_facet_adjacent_to
+            (map_edge_adjacent_pairs, isovert.grid, to_cube, boundary_bits,
+             scalar_grid, isodual_table, ambig_info, isovalue, isovert,
+             flag_extended, merge_param, gcube_map, flag_map);
+
+          apply_to_cubes_edge_adjacent_to
+            (map_edge_adjacent_pairs, isovert.grid, to_cube, boundary_bits,
+             scalar_grid, isodual_table, ambig_info, isovalue, isovert,
+             flag_extended, merge_param, gcube_map, flag_map);
+
+          apply_to_cubes_vertex_adjacent_to
+            (map_edge_adjacent_pairs, isovert.grid, to_cube, boundary_bits,
+             scalar_grid, isodual_table, ambig_info, isovalue, isovert,
+             flag_extended, merge_param, gcube_map, flag_map);
+        }
+      });
   }
 
   /// Extend mapping of pairs of adjacent cubes.
@@ -5178,7 +5329,6 @@ namespace {
    std::vector<SHARPISO::VERTEX_INDEX> & gcube_map)
   {
     MAP_PARAM_FLAGS param_flags;
-    BOUNDARY_BITS_TYPE boundary_bits;
 
     param_flags.extended = true;
     param_flags.strict = flag_strict;
@@ -5189,32 +5339,31 @@ namespace {
       cerr << "        flag_strict: " << int(param_flags.strict) << endl;
     }
 
-		for (NUM_TYPE i = 0; i < sharp_gcube_list.size(); i++) {
-
-			NUM_TYPE to_gcube = sharp_gcube_list[i];
-
-      if (isovert.gcube_list[to_gcube].flag == SELECTED_GCUBE) {
-        VERTEX_INDEX to_cube = isovert.CubeIndex(to_gcube);
-        boundary_bits = isovert.gcube_list[to_gcube].boundary_bits;
-
-        bool flag_map;
-        apply_to_cubes_facet_adjacent_to
-          (map_cubes_around_edge, isovert.grid, to_cube, boundary_bits,
-           isovert, scalar_grid, isodual_table, ambig_info, isovalue,
-           param_flags, merge_param, gcube_map, flag_map);
-
-        apply_to_cubes_edge_adjacent_to
-          (map_cubes_around_edge, isovert.grid, to_cube, boundary_bits,
-           isovert, scalar_grid, isodual_table, ambig_info, isovalue,
-           param_flags, merge_param, gcube_map, flag_map);
-
-        apply_to_cubes_vertex_adjacent_to
-          (map_cubes_around_edge, isovert.grid, to_cube, boundary_bits,
-           isovert, scalar_grid, isodual_table, ambig_info, isovalue,
-           param_flags, merge_param, gcube_map, flag_map);
-      }
-		}
+    apply_to_cubes_in_slabs
+      (merge_param.num_threads, isovert, sharp_gcube_list,
+       [&](const NUM_TYPE to_gcube) {
+        if (isovert.gcube_list[to_gcube].flag == SELECTED_GCUBE) {
+          VERTEX_INDEX to_cube = isovert.CubeIndex(to_gcube);
+          const BOUNDARY_BITS_TYPE boundary_bits = 
+            isovert.gcube_list[to_gcube].boundary_bits;
 
+          bool flag_map;
+          apply_to_cubes_facet_adjacent_to
+            (map_cubes_around_edge, isovert.grid, to_cube, boundary_bits,
+             isovert, scalar_grid, isodual_table, ambig_info, isovalue,
+             param_flags, merge_param, gcube_map, flag_map);
+
+          apply_to_cubes_edge_adjacent_to
+            (map_cubes_around_edge, isovert.grid, to_cube, boundary_bits,
+             isovert, scalar_grid, isodual_table, ambig_info, isovalue,
+             param_flags, merge_param, gcube_map, flag_map);
+
+          apply_to_cubes_vertex_adjacent_to
+            (map_cubes_around_edge, isovert.grid, to_cube, boundary_bits,
+             isovert, scalar_grid, isodual_table, ambig_info, isovalue,
+             param_flags, merge_param, gcube_map, flag_map);
+        }
+      });
   }
 
   /// Extend mapping around edges.  Try to map three cubes at the same time.
@@ -6969,7 +7118,7 @@ namespace {
     INDEX_DIFF_TYPE from_gcube = isovert.GCubeIndex(from_cube);
     INDEX_DIFF_TYPE to_gcube = isovert.GCubeIndex(to_cube);
     VERTEX_INDEX cubeC_index;
-    static CUBE_CONNECTED_ARRAY connected_sharp;
+    static thread_local CUBE_CONNECTED_ARRAY connected_sharp;
 
     if (from_gcube == ISOVERT::NO_INDEX ||
         to_gcube == ISOVERT::NO_INDEX) { return; }
@@ -7531,45 +7680,166 @@ namespace {
 		}
 	}
 
+	// Flags in near_unmapped[gcube_index].
+	const unsigned char NEAR_UNMAPPED_IN_PASS = 1;
+	const unsigned char NEAR_UNMAPPED_IN_PREVIOUS_PASS = 2;
+
+	// Set flag in near_unmapped[] of each active cube
+	//   within Linf distance dist of cube_index.
+	void set_near_unmapped
+		(const SHARPISO_GRID & grid, const SHREC::ISOVERT & isovert,
+		const VERTEX_INDEX cube_index, const int dist,
+		const unsigned char flag, std::vector<unsigned char> & near_unmapped)
+	{
+		GRID_COORD_TYPE coord[DIM3], min_coord[DIM3], max_coord[DIM3];
+
+		grid.ComputeCoord(cube_index, coord);
+		for (int d = 0; d < DIM3; d++) {
+			min_coord[d] = (coord[d] > dist) ? coord[d]-dist : 0;
+			max_coord[d] = std::min(GRID_COORD_TYPE(coord[d]+dist),
+				GRID_COORD_TYPE(grid.AxisSize(d)-2));
+		}
+
+		for (coord[2] = min_coord[2]; coord[2] <= max_coord[2]; coord[2]++) 
+			for (coord[1] = min_coord[1]; coord[1] <= max_coord[1]; coord[1]++) 
+				for (coord[0] = min_coord[0]; coord[0] <= max_coord[0]; coord[0]++) {
+					const INDEX_DIFF_TYPE gcube_index = 
+						isovert.GCubeIndex(grid.ComputeVertexIndex(coord));
+					if (gcube_index != ISOVERT::NO_INDEX) 
+						{ near_unmapped[gcube_index] |= flag; }
+				}
+	}
+
 	// Reverse merges which create isopatches which are not disks.
-	void unmap_non_disk_isopatches
-		(const SHARPISO_SCALAR_GRID_BASE & scalar_grid, 
-		const SCALAR_TYPE isovalue,
+	// extract_isopatch(cube_index, tri_vert, quad_vert) extracts
+	//   the isopatch incident on the selected cube cube_index.
+	// After the first pass, only cubes near cubes unmapped in the
+	//   previous or current pass are checked.  Other isopatches
+	//   are unchanged since they were checked.
+	// If num_threads > 1, disk checks of cubes near cubes unmapped
+	//   in the previous pass are computed in parallel at the start of 
+	//   each pass and applied in gcube order.  A check is recomputed
+	//   if some cube within distance 2*dist2cube+1 was unmapped earlier 
+	//   in the pass, so results match the sequential pass.
+	template <typename EXTRACT_FUNCTION>
+	void unmap_non_disk_isopatches_T
+		(const SHARPISO_GRID & grid,
+		const int num_threads,
+		EXTRACT_FUNCTION extract_isopatch,
 		SHREC::ISOVERT & isovert, 
 		std::vector<SHARPISO::VERTEX_INDEX> & gcube_map, 
 		SHREC::SHARPISO_INFO & sharpiso_info)
 	{
 		const NUM_TYPE num_gcube = isovert.gcube_list.size();
-
 		const int dist2cube = 1;
+		// Unmapping changes gcube_map within dist2cube of the unmapped cube.
+		// The isopatch reads gcube_map within dist2cube+1 of its cube.
+		const int dist2unmapped = 2*dist2cube+1;
 		std::vector<ISO_VERTEX_INDEX> tri_vert;
 		std::vector<ISO_VERTEX_INDEX> quad_vert;
+		std::vector<NUM_TYPE> check_list;
+		std::vector<unsigned char> is_disk;
+		std::vector<unsigned char> near_unmapped(num_gcube, 0);
 
+		bool flag_first_pass = true;
 		bool passed_all_disk_checks;
 		do {
 			passed_all_disk_checks = true;
 
+			check_list.clear();
 			for (NUM_TYPE i = 0; i < num_gcube; i++) {
-				if (isovert.gcube_list[i].flag == SELECTED_GCUBE) {
-					VERTEX_INDEX cube_index = isovert.gcube_list[i].cube_index;
+				if (isovert.gcube_list[i].flag == SELECTED_GCUBE &&
+					(flag_first_pass || near_unmapped[i] != 0))
+					{ check_list.push_back(i); }
+			}
 
-					extract_dual_isopatch_incident_on
-						(scalar_grid, isovalue, isovert, cube_index,
-						gcube_map, dist2cube, tri_vert, quad_vert);
+			if (num_threads > 1) {
+				is_disk.resize(check_list.size());
+
+				// Each block writes only is_disk[k] for k in [k0,k1).
+				apply_to_blocks_in_parallel
+					(num_threads, check_list.size(),
+					[&](const NUM_TYPE k0, const NUM_TYPE k1) {
+						std::vector<ISO_VERTEX_INDEX> tri_vert;
+						std::vector<ISO_VERTEX_INDEX> quad_vert;
+
+						for (NUM_TYPE k = k0; k < k1; k++) {
+							extract_isopatch
+								(isovert.CubeIndex(check_list[k]), tri_vert, quad_vert);
+							IJK::reorder_quad_vertices(quad_vert);
+							is_disk[k] = is_isopatch_disk3D(tri_vert, quad_vert);
+						}
+					});
+			}
+
+			// Cubes in check_list are in increasing gcube order.
+			std::size_t k = 0;
+			for (NUM_TYPE i = 0; i < num_gcube; i++) {
+				const bool flag_in_check_list = 
+					(k < check_list.size() && check_list[k] == i);
+				if (flag_in_check_list) { k++; }
 
+				if (isovert.gcube_list[i].flag != SELECTED_GCUBE) { continue; }
+				if (!flag_in_check_list &&
+					(near_unmapped[i] & NEAR_UNMAPPED_IN_PASS) == 0)
+					{ continue; }
+
+				VERTEX_INDEX cube_index = isovert.gcube_list[i].cube_index;
+
+				bool flag_disk;
+				if (num_threads > 1 && flag_in_check_list &&
+					(near_unmapped[i] & NEAR_UNMAPPED_IN_PASS) == 0)
+					{ flag_disk = is_disk[k-1]; }
+				else {
+					extract_isopatch(cube_index, tri_vert, quad_vert);
 					IJK::reorder_quad_vertices(quad_vert);
+					flag_disk = is_isopatch_disk3D(tri_vert, quad_vert);
+				}
 
-					if (!is_isopatch_disk3D(tri_vert, quad_vert)) {
-						unmap_merged_cubes(isovert, cube_index, dist2cube, gcube_map);
-						sharpiso_info.num_non_disk_isopatches++;
-						passed_all_disk_checks = false;
-					}
+				if (!flag_disk) {
+					unmap_merged_cubes(isovert, cube_index, dist2cube, gcube_map);
+					sharpiso_info.num_non_disk_isopatches++;
+					passed_all_disk_checks = false;
+					set_near_unmapped
+						(grid, isovert, cube_index, dist2unmapped, 
+						NEAR_UNMAPPED_IN_PASS, near_unmapped);
 				}
 			}
+
+			for (NUM_TYPE i = 0; i < num_gcube; i++) {
+				if (near_unmapped[i] & NEAR_UNMAPPED_IN_PASS)
+					{ near_unmapped[i] = NEAR_UNMAPPED_IN_PREVIOUS_PASS; }
+				else
+					{ near_unmapped[i] = 0; }
+			}
+			flag_first_pass = false;
 		}
 		while (!passed_all_disk_checks);
 	}
 
+	// Reverse merges which create isopatches which are not disks.
+	void unmap_non_disk_isopatches
+		(const SHARPISO_SCALAR_GRID_BASE & scalar_grid, 
+		const SCALAR_TYPE isovalue,
+		const int num_threads,
+		SHREC::ISOVERT & isovert, 
+		std::vector<SHARPISO::VERTEX_INDEX> & gcube_map, 
+		SHREC::SHARPISO_INFO & sharpiso_info)
+	{
+		const int dist2cube = 1;
+
+		unmap_non_disk_isopatches_T
+			(scalar_grid, num_threads,
+			[&](const VERTEX_INDEX cube_index,
+			std::vector<ISO_VERTEX_INDEX> & tri_vert,
+			std::vector<ISO_VERTEX_INDEX> & quad_vert) {
+				extract_dual_isopatch_incident_on
+					(scalar_grid, isovalue, isovert, cube_index,
+					gcube_map, dist2cube, tri_vert, quad_vert);
+			},
+			isovert, gcube_map, sharpiso_info);
+	}
+
 	// Renumber vertices in vlist so that they are numbered starting at 0.
 	// Construct cube list of distinct vertices in vlist.
 	template <typename VTYPE0, typename VTYPE1>
@@ -7597,39 +7867,23 @@ namespace {
 		(const SHARPISO_SCALAR_GRID_BASE & scalar_grid, 
 		const IJKDUALTABLE::ISODUAL_CUBE_TABLE & isodual_table,
 		const SCALAR_TYPE isovalue,
+		const int num_threads,
 		SHREC::ISOVERT & isovert, 
 		std::vector<SHARPISO::VERTEX_INDEX> & gcube_map, 
 		SHREC::SHARPISO_INFO & sharpiso_info)
 	{
-		const NUM_TYPE num_gcube = isovert.gcube_list.size();
-
 		const int dist2cube = 1;
-		std::vector<ISO_VERTEX_INDEX> tri_vert;
-		std::vector<ISO_VERTEX_INDEX> quad_vert;
 
-		bool passed_all_disk_checks;
-		do {
-			passed_all_disk_checks = true;
-
-			for (NUM_TYPE i = 0; i < num_gcube; i++) {
-				if (isovert.gcube_list[i].flag == SELECTED_GCUBE) {
-					VERTEX_INDEX cube_index = isovert.gcube_list[i].cube_index;
-
-					extract_dual_isopatch_incident_on_multi
-						(scalar_grid, isodual_table, isovalue, isovert, 
-						cube_index, gcube_map, dist2cube, tri_vert, quad_vert);
-					IJK::reorder_quad_vertices(quad_vert);
-
-					if (!is_isopatch_disk3D(tri_vert, quad_vert)) {
-						unmap_merged_cubes(isovert, cube_index, dist2cube, gcube_map);
-						isovert.gcube_list[i].flag = NON_DISK_GCUBE;
-						sharpiso_info.num_non_disk_isopatches++;
-						passed_all_disk_checks = false;
-					}
-				}
-			}
-		}
-		while (!passed_all_disk_checks);
+		unmap_non_disk_isopatches_T
+			(scalar_grid, num_threads,
+			[&](const VERTEX_INDEX cube_index,
+			std::vector<ISO_VERTEX_INDEX> & tri_vert,
+			std::vector<ISO_VERTEX_INDEX> & quad_vert) {
+				extract_dual_isopatch_incident_on_multi
+					(scalar_grid, isodual_table, isovalue, isovert, 
+					cube_index, gcube_map, dist2cube, tri_vert, quad_vert);
+			},
+			isovert, gcube_map, sharpiso_info);
 	}
 
 	// Set table_index[i] of cube cube_list[i].
@@ -7658,13 +7912,6 @@ namespace {
 // **************************************************
 
 // Forward declarations:
-template <typename VTYPE>
-void renumber_tri_quad_vertices
-	(const std::vector<VTYPE> & tri_vert,
-	const std::vector<VTYPE> & quad_vert,
-	std::vector<VTYPE> & new_tri_vert,
-	std::vector<VTYPE> & new_quad_vert,
-	NUM_TYPE & num_vert);
 
 // Search cycle starting at iv0.
 // @pre All vertices in cycle containing iv0 have is_visited set to false.
@@ -7672,65 +7919,111 @@ void renumber_tri_quad_vertices
 void search_cycle
 	(const VERTEX_INDEX iv0, std::vector<CYCLE_VERTEX> & cycle_vertex);
 
+namespace {
+
+	void insert_cycle_vertex
+		(const VERTEX_INDEX iv0, const VERTEX_INDEX iv1,
+		std::vector<CYCLE_VERTEX> & cycle_vertex);
+
+	// Append polygon edges to edge_list.
+	// Each edge (iv0,iv1) is stored with iv0 <= iv1.
+	void append_poly_edges
+		(const std::vector<ISO_VERTEX_INDEX> & poly_vert, 
+		const NUM_TYPE num_vert_per_poly,
+		std::vector<VERTEX_PAIR> & edge_list)
+	{
+		NUM_TYPE num_poly = poly_vert.size()/num_vert_per_poly;
+
+		for (NUM_TYPE i = 0; i < num_poly; i++) {
+			for (int k0 = 0; k0 < num_vert_per_poly; k0++) {
+				VERTEX_INDEX iv0 = poly_vert[i*num_vert_per_poly+k0];
+				int k1 = (k0+1)%num_vert_per_poly;
+				VERTEX_INDEX iv1 = poly_vert[i*num_vert_per_poly+k1];
+				if (iv0 > iv1) { std::swap(iv0, iv1); }
+				edge_list.push_back(std::make_pair(iv0, iv1));
+			}
+		}
+	}
+
+	// Return location of iv in sorted list vlist.
+	// @pre iv is in vlist.
+	inline NUM_TYPE get_sorted_location
+		(const VERTEX_INDEX iv, const std::vector<VERTEX_INDEX> & vlist)
+	{
+		return(std::lower_bound(vlist.begin(), vlist.end(), iv) - vlist.begin());
+	}
+}
+
 // Return true if isopatch incident on vertex is a disk.
 // @param tri_vert Triangle vertices.
 // @param quad_vert Quadrilateral vertices in order around quadrilateral.
 // @pre Assumes the boundary of the isopatch is the link of some vertex.
+// Isopatches have at most a few hundred edges, so edges are counted
+//   in a sorted list instead of a hash table.  Lists are reused 
+//   between calls by the same thread.
 bool SHREC::is_isopatch_disk3D
 	(const std::vector<ISO_VERTEX_INDEX> & tri_vert,
 	const std::vector<ISO_VERTEX_INDEX> & quad_vert)
 {
-	const NUM_TYPE num_tri = tri_vert.size()/NUM_VERT_PER_TRI;
-	const NUM_TYPE num_quad = quad_vert.size()/NUM_VERT_PER_QUAD;
-	std::vector<ISO_VERTEX_INDEX> tri_vert2;
-	std::vector<ISO_VERTEX_INDEX> quad_vert2;
-	NUM_TYPE num_vert;
-
-	VERTEX_HASH_TABLE vertex_hash;
-	EDGE_HASH_TABLE edge_hash;
+	static thread_local std::vector<VERTEX_PAIR> edge_list;
+	static thread_local std::vector<VERTEX_INDEX> boundary_vert;
+	static thread_local std::vector<CYCLE_VERTEX> cycle_vertex;
 
-	// Renumber tri and quad vertices
-	renumber_tri_quad_vertices
-		(tri_vert, quad_vert, tri_vert2, quad_vert2, num_vert);
+	edge_list.clear();
+	append_poly_edges(tri_vert, NUM_VERT_PER_TRI, edge_list);
+	append_poly_edges(quad_vert, NUM_VERT_PER_QUAD, edge_list);
+	std::sort(edge_list.begin(), edge_list.end());
 
 	// Check for edges in more than two isosurface polygons.
-	insert_tri_quad_edges(tri_vert2, quad_vert2, edge_hash);
-
-	for (EDGE_HASH_TABLE::const_iterator edge_iter = edge_hash.begin();
-		edge_iter != edge_hash.end(); edge_iter++) {
-			if (edge_iter->second > 2) {
-				return(false); 
-			}
+	// Keep boundary edges, i.e., edges in only one isosurface polygon.
+	std::size_t num_boundary_edges = 0;
+	std::size_t i0 = 0;
+	while (i0 < edge_list.size()) {
+		std::size_t i1 = i0+1;
+		while (i1 < edge_list.size() && edge_list[i1] == edge_list[i0])
+			{ i1++; }
+
+		if (i1-i0 > 2) { return(false); }
+		if (i1-i0 == 1) {
+			edge_list[num_boundary_edges] = edge_list[i0];
+			num_boundary_edges++;
+		}
+		i0 = i1;
 	}
+	edge_list.resize(num_boundary_edges);
 
 	// Check that boundary is a cycle or edge.
-	std::vector<CYCLE_VERTEX> cycle_vertex(num_vert);
-
-	construct_boundary_cycle(edge_hash, cycle_vertex);
-	NUM_TYPE num_boundary_vertices = 0;
-	NUM_TYPE first_adjacent = 0;
-	for (NUM_TYPE i = 0; i < cycle_vertex.size(); i++) {
-		NUM_TYPE num_adjacent = cycle_vertex[i].num_adjacent;
-		if (num_adjacent == 2) {
-			first_adjacent = i;
-			num_boundary_vertices++;
-		}
-		else if (num_adjacent != 0) {
-			return(false); 
-		}
+	boundary_vert.clear();
+	for (std::size_t i = 0; i < edge_list.size(); i++) {
+		boundary_vert.push_back(edge_list[i].first);
+		boundary_vert.push_back(edge_list[i].second);
+	}
+	std::sort(boundary_vert.begin(), boundary_vert.end());
+	boundary_vert.erase
+		(std::unique(boundary_vert.begin(), boundary_vert.end()), 
+		boundary_vert.end());
+
+	cycle_vertex.assign(boundary_vert.size(), CYCLE_VERTEX());
+	for (std::size_t i = 0; i < edge_list.size(); i++) {
+		NUM_TYPE k0 = get_sorted_location(edge_list[i].first, boundary_vert);
+		NUM_TYPE k1 = get_sorted_location(edge_list[i].second, boundary_vert);
+		insert_cycle_vertex(k0, k1, cycle_vertex);
+		insert_cycle_vertex(k1, k0, cycle_vertex);
+	}
+
+	for (std::size_t i = 0; i < cycle_vertex.size(); i++) {
+		if (cycle_vertex[i].num_adjacent != 2) { return(false); }
 	}
 
-	if (num_boundary_vertices < 3) { 
+	if (cycle_vertex.size() < 3) { 
 		// Disk must have at least three boundary cycle vertices.
 		return(false); 
 	}
 
-	search_cycle(first_adjacent, cycle_vertex);
+	search_cycle(0, cycle_vertex);
 
-	for (NUM_TYPE i = 0; i < cycle_vertex.size(); i++) { 
-		if (cycle_vertex[i].num_adjacent == 2) {
-			if (!cycle_vertex[i].is_visited) { return(false); }
-		}
+	for (std::size_t i = 0; i < cycle_vertex.size(); i++) { 
+		if (!cycle_vertex[i].is_visited) { return(false); }
 	}
 
 	return(true);
@@ -8054,25 +8347,6 @@ void SHREC::construct_boundary_cycle
 	}
 }
 
-// Renumber tri and quad vertices so that they are from 0 to num_vert-1.
-template <typename VTYPE>
-void renumber_tri_quad_vertices
-	(const std::vector<VTYPE> & tri_vert,
-	const std::vector<VTYPE> & quad_vert,
-	std::vector<VTYPE> & new_tri_vert,
-	std::vector<VTYPE> & new_quad_vert,
-	NUM_TYPE & num_vert)
-{
-	VERTEX_HASH_TABLE vertex_hash;
-
-	insert_vertex_list(tri_vert, vertex_hash);
-	insert_vertex_list(quad_vert, vertex_hash);
-
-	num_vert = vertex_hash.size();
-	remap_vertex_list(vertex_hash, tri_vert, new_tri_vert);
-	remap_vertex_list(vertex_hash, quad_vert, new_quad_vert);
-}
-
 // Search cycle starting at iv0.
 // @pre All vertices in cycle containing iv0 have is_visited set to false.
 // @pre All vertices have degree two.
@@ -611,10 +611,10 @@ void SHREC::compute_isosurface_grid_edge_centroid
  const SHREC_CUBE_FACE_INFO & cube,
  COORD_TYPE * coord)
 {
-  static COORD_TYPE vcoord[DIM3];
-  static COORD_TYPE coord0[DIM3];
-  static COORD_TYPE coord1[DIM3];
-  static COORD_TYPE coord2[DIM3];
+  COORD_TYPE vcoord[DIM3];
+  COORD_TYPE coord0[DIM3];
+  COORD_TYPE coord1[DIM3];
+  COORD_TYPE coord2[DIM3];
 
   int num_intersected_edges = 0;
   IJK::set_coord_3D(0.0, vcoord);
@@ -743,8 +743,7 @@ void SHREC::split_dual_isovert_ambig
 void SHREC::split_dual_isovert_ambig
 (const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
  const IJKDUALTABLE::ISODUAL_CUBE_TABLE & isodual_table,
- const SCALAR_TYPE isovalue,
- const std::vector<ISO_VERTEX_INDEX> & cube_list,
+ const ISOVERT & isovert,
  const std::vector<AMBIGUITY_TYPE> & cube_ambig,
  const std::vector<ISO_VERTEX_INDEX> & isoquad_cube,     
  const std::vector<FACET_VERTEX_INDEX> & facet_vertex,
@@ -753,32 +752,29 @@ void SHREC::split_dual_isovert_ambig
  VERTEX_INDEX & num_split)
 {
   const int dimension = scalar_grid.Dimension();
-  const NUM_TYPE num_cube_vertices = scalar_grid.NumCubeVertices();
   const NUM_TYPE num_facet_vertices = scalar_grid.NumFacetVertices();
   std::vector<FACET_VERTEX_INDEX> num_isov;
   std::vector<ISO_VERTEX_INDEX> first_cube_isov;
   std::vector<IJKDUALTABLE::TABLE_INDEX> cube_table_index;
-  num_isov.resize(cube_list.size());
-  first_cube_isov.resize(cube_list.size());
+  const NUM_TYPE num_gcube = isovert.gcube_list.size();
+  num_isov.resize(num_gcube);
+  first_cube_isov.resize(num_gcube);
   IJK::CUBE_FACE_INFO<int,NUM_TYPE,NUM_TYPE> cube(dimension);
   IJK::PROCEDURE_ERROR error("split_dual_isovert_ambig");
 
-  if (cube_list.size() != cube_ambig.size()) {
-    error.AddMessage("Programming error. Mismatch between cube_list and cube_ambig sizes.");
-    error.AddMessage("  cube_list.size() = ", cube_list.size(), ".");
+  if (num_gcube != NUM_TYPE(cube_ambig.size())) {
+    error.AddMessage("Programming error. Mismatch between gcube_list and cube_ambig sizes.");
+    error.AddMessage("  isovert.gcube_list.size() = ", num_gcube, ".");
     error.AddMessage("  cube_ambig.size() = ", cube_ambig.size(), ".");
     throw error;
   }
 
   num_split = 0;
 
-  cube_table_index.resize(cube_list.size());
+  cube_table_index.resize(num_gcube);
   ISO_VERTEX_INDEX total_num_isov = 0;
-  for (ISO_VERTEX_INDEX i = 0; i < cube_list.size(); i++) {
-    IJKDUALTABLE::TABLE_INDEX it;
-    IJK::compute_isotable_index
-      (scalar_grid.ScalarPtrConst(), isovalue, cube_list[i],
-       scalar_grid.CubeVertexIncrement(), num_cube_vertices, it);
+  for (ISO_VERTEX_INDEX i = 0; i < num_gcube; i++) {
+    IJKDUALTABLE::TABLE_INDEX it = isovert.gcube_list[i].table_index;
 
     if (cube_ambig[i] == SEPARATE_POS) 
       // Complement table entry.
@@ -793,10 +789,10 @@ void SHREC::split_dual_isovert_ambig
   iso_vlist.resize(total_num_isov);
 
   ISO_VERTEX_INDEX k = 0;
-  for (ISO_VERTEX_INDEX i = 0; i < cube_list.size(); i++) {
+  for (ISO_VERTEX_INDEX i = 0; i < num_gcube; i++) {
     first_cube_isov[i] = k;
     for (FACET_VERTEX_INDEX j = 0; j < num_isov[i]; j++) {
-      iso_vlist[k+j].cube_index = cube_list[i];
+      iso_vlist[k+j].cube_index = isovert.gcube_list[i].cube_index;
       iso_vlist[k+j].patch_index = j;
       iso_vlist[k+j].table_index = cube_table_index[i];
     }
@@ -829,7 +825,6 @@ void SHREC::split_dual_isovert_ambig
 void SHREC::full_split_dual_isovert
 (const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
  const IJKDUALTABLE::ISODUAL_CUBE_TABLE & isodual_table,
- const SCALAR_TYPE isovalue,
  const ISOVERT & isovert,
  const std::vector<ISO_VERTEX_INDEX> & isoquad_cube,     
  const std::vector<FACET_VERTEX_INDEX> & facet_vertex,
@@ -848,25 +843,21 @@ void SHREC::full_split_dual_isovert
     { cube_list[i] = isovert.gcube_list[i].cube_index; }
 
   int num_split;
+  get_table_index(isovert.gcube_list, table_index);
+
   if (shrec_param.flag_split_non_manifold) {
     IJKDUALTABLE::ISODUAL_CUBE_TABLE_AMBIG_INFO ambig_info(dimension);
     int num_non_manifold_split;
 
-    IJK::split_dual_isovert_manifold
-      (scalar_grid, isodual_table, ambig_info, isovalue, 
-       cube_list, isoquad_cube, facet_vertex, table_index,
-       iso_vlist, isoquad_vert,
-       num_split, num_non_manifold_split);
+    IJK::split_non_manifold_isov_pairs
+      (scalar_grid, isodual_table, ambig_info, cube_list, table_index,
+       num_non_manifold_split);
     sharp_info.num_non_manifold_split = num_non_manifold_split;
   }
-  else {
-    compute_cube_isotable_index
-      (scalar_grid, isodual_table, isovalue, cube_list, table_index);
 
-    IJK::split_dual_isovert
-      (isodual_table, cube_list, table_index, isoquad_cube, facet_vertex,
-       iso_vlist, isoquad_vert, num_split);
-  }
+  IJK::split_dual_isovert
+    (isodual_table, cube_list, table_index, isoquad_cube, facet_vertex,
+     iso_vlist, isoquad_vert, num_split);
   sharp_info.num_cube_multi_isov = num_split;
   sharp_info.num_cube_single_isov = num_gcube - num_split;
 }
@@ -878,7 +869,6 @@ void SHREC::full_split_dual_isovert
 void SHREC::full_split_dual_isovert
 (const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
  const IJKDUALTABLE::ISODUAL_CUBE_TABLE & isodual_table,
- const SCALAR_TYPE isovalue,
  const ISOVERT & isovert,
  const std::vector<ISO_VERTEX_INDEX> & isoquad_cube,     
  const std::vector<FACET_VERTEX_INDEX> & facet_vertex,
@@ -890,7 +880,7 @@ void SHREC::full_split_dual_isovert
   std::vector<IJKDUALTABLE::TABLE_INDEX> table_index;
 
   full_split_dual_isovert
-    (scalar_grid, isodual_table,isovalue, isovert, isoquad_cube, facet_vertex,
+    (scalar_grid, isodual_table, isovert, isoquad_cube, facet_vertex,
      shrec_param, table_index, iso_vlist, isoquad_vert, sharp_info);
 }
 
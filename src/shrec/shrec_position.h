@@ -284,12 +284,12 @@ namespace SHREC {
   /// Split dual isosurface vertices.
   /// @param isodual_table Dual isosurface lookup table.
   /// Version using vector<DUAL_ISOVERT>.
+  /// Uses the table index of each cube in isovert.gcube_list.
   /// @param[out] iso_vlist[] List of isosurface vertices.
   void split_dual_isovert_ambig
   (const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
    const IJKDUALTABLE::ISODUAL_CUBE_TABLE & isodual_table,
-   const SCALAR_TYPE isovalue,
-   const std::vector<ISO_VERTEX_INDEX> & cube_list,
+   const ISOVERT & isovert,
    const std::vector<AMBIGUITY_TYPE> & cube_ambig,
    const std::vector<ISO_VERTEX_INDEX> & isoquad_cube,     
    const std::vector<FACET_VERTEX_INDEX> & facet_vertex,
@@ -305,7 +305,6 @@ namespace SHREC {
   void full_split_dual_isovert
   (const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
    const IJKDUALTABLE::ISODUAL_CUBE_TABLE & isodual_table,
-   const SCALAR_TYPE isovalue,
    const ISOVERT & isovert,
    const std::vector<ISO_VERTEX_INDEX> & isoquad_cube,     
    const std::vector<FACET_VERTEX_INDEX> & facet_vertex,
@@ -322,7 +321,6 @@ namespace SHREC {
   void full_split_dual_isovert
   (const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
    const IJKDUALTABLE::ISODUAL_CUBE_TABLE & isodual_table,
-   const SCALAR_TYPE isovalue,
    const ISOVERT & isovert,
    const std::vector<ISO_VERTEX_INDEX> & isoquad_cube,     
    const std::vector<FACET_VERTEX_INDEX> & facet_vertex,
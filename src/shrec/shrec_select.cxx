@@ -34,6 +34,7 @@ Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
 
 #include "shrec_types.h"
 #include "shrec_select.h"
+#include "shrec_thread.txx"
 #include "shrec_debug.h"
 
 using namespace std;
@@ -49,33 +50,33 @@ using namespace IJK;
 namespace {
 
   void reset_covered_isovert_positions
-  (const SHARPISO_BOOL_GRID & covered_grid, ISOVERT & isovert);
+  (const SHARPISO_BIT_GRID & covered_grid, ISOVERT & isovert);
 
   void reset_covered_isovert_positions
-  (const SHARPISO_BOOL_GRID & covered_grid,
+  (const SHARPISO_BIT_GRID & covered_grid,
    const std::vector<NUM_TYPE> & gcube_index_list,
    ISOVERT & isovert);
 
   bool check_covered_point
-  (const SHARPISO_BOOL_GRID & covered_grid,
+  (const SHARPISO_BIT_GRID & covered_grid,
    ISOVERT & isovert,
    const VERTEX_INDEX & gcube0_index);
 
   void check_and_set_covered_point
-  (const SHARPISO_BOOL_GRID & covered_grid,
+  (const SHARPISO_BIT_GRID & covered_grid,
    ISOVERT & isovert,
    const VERTEX_INDEX & gcube_index);
 
   bool is_some_facet_adjacent_true
-  (const SHARPISO_BOOL_GRID & bool_grid, 
+  (const SHARPISO_BIT_GRID & bool_grid, 
    const VERTEX_INDEX icubeA, const BOUNDARY_BITS_TYPE boundary_bits);
 
   bool is_some_edge_adjacent_true
-  (const SHARPISO_BOOL_GRID & bool_grid,
+  (const SHARPISO_BIT_GRID & bool_grid,
    const VERTEX_INDEX icubeA, const BOUNDARY_BITS_TYPE boundary_bits);
 
   bool is_some_dist2_neighbor_true
-  (const SHARPISO_BOOL_GRID & bool_grid, 
+  (const SHARPISO_BIT_GRID & bool_grid, 
    const VERTEX_INDEX cubeA_index, const GRID_COORD_TYPE cubeA_coord[DIM3],
    const BOUNDARY_BITS_TYPE boundary_bits);
 
@@ -88,7 +89,7 @@ namespace {
    const GRID_CUBE_FLAG flag, int & orth_dir, int & side);
 
   bool is_facet_on_corner_3x3x3
-  (const GRID_CUBE_DATA & c, const SHARPISO_BOOL_GRID & covered_grid,
+  (const GRID_CUBE_DATA & c, const SHARPISO_BIT_GRID & covered_grid,
    const ISOVERT & isovert, int & orth_dir, int & side,
    VERTEX_INDEX & corner_cube_index);
 
@@ -97,19 +98,172 @@ namespace {
    const GRID_CUBE_FLAG flag);
 
   bool is_near_corner_covered_cube
-  (const SHARPISO_BOOL_GRID & corner_covered_grid,
+  (const SHARPISO_BIT_GRID & corner_covered_grid,
    const GRID_CUBE_DATA & c);
 
   bool is_facet_neighbor_covered_B
-  (const SHARPISO_BOOL_GRID & covered_grid, const VERTEX_INDEX cube_index0);
+  (const SHARPISO_BIT_GRID & covered_grid, const VERTEX_INDEX cube_index0);
 
   bool is_edge_neighbor_covered_B
-  (const SHARPISO_BOOL_GRID & covered_grid, const VERTEX_INDEX cube_index0);
+  (const SHARPISO_BIT_GRID & covered_grid, const VERTEX_INDEX cube_index0);
 
   int get_index_smallest_abs(const COORD_TYPE coord[DIM3]);
 };
 
 
+// **************************************************
+// PRECOMPUTED TRIANGLE CHECKS
+// **************************************************
+
+// Selecting a cube changes the result of creates_triangle_new()
+//   only for cubes within Linf distance 2 of the selected cube,
+//   since triangles are only formed by cubes whose 3x3x3 regions overlap.
+// Triangle checks for a list of cubes are computed in parallel 
+//   before the cubes are processed in order.  A precomputed check
+//   is used only if no cube within distance 2 was selected since
+//   it was computed.  Selection is identical to sequential selection.
+// Cubes in the same mod 3 or mod 6 residue class are at Linf distance
+//   at least 3 from each other, so selecting cubes from such a list
+//   does not invalidate the precomputed checks of the list.
+
+/// Precompute creates_triangle_new() for cubes in gcube_index_list[].
+/// Only check cubes where is_candidate(gcube_index) is true
+///   and which are available, not on the grid boundary
+///   and could be selected as edge cubes.
+/// Does nothing if selection_data.NumThreads() <= 1.
+template <typename PTYPE>
+void precompute_triangle_checks
+(const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
+ const SCALAR_TYPE isovalue,
+ const SHARP_ISOVERT_PARAM & isovert_param,
+ const vector<NUM_TYPE> & gcube_index_list,
+ const ISOVERT & isovert,
+ PTYPE is_candidate,
+ SELECTION_DATA & selection_data)
+{
+  const COORD_TYPE linf_dist_threshold = 
+    isovert_param.linf_dist_thresh_merge_sharp;
+  std::vector<NUM_TYPE> & checked_list = selection_data.triangle_checked_list;
+
+  if (selection_data.NumThreads() <= 1) { return; }
+
+  if (selection_data.triangle_check.size() != isovert.gcube_list.size()) {
+    selection_data.triangle_check.assign
+      (isovert.gcube_list.size(), TRIANGLE_NOT_CHECKED);
+  }
+
+  for (std::size_t i = 0; i < gcube_index_list.size(); i++) {
+    const NUM_TYPE gcube_index = gcube_index_list[i];
+    const GRID_CUBE_DATA & gcube = isovert.gcube_list[gcube_index];
+
+    if (gcube.flag == AVAILABLE_GCUBE && gcube.boundary_bits == 0 &&
+        gcube.num_eigenvalues == 2 && !gcube.flag_conflict &&
+        gcube.linf_dist < linf_dist_threshold && is_candidate(gcube_index))
+      { checked_list.push_back(gcube_index); }
+  }
+
+  // Each call writes only triangle_check[checked_list[k]].
+  apply_in_parallel
+    (selection_data.NumThreads(), checked_list.size(),
+     [&](const NUM_TYPE k) {
+      const NUM_TYPE gcube_index = checked_list[k];
+      VERTEX_INDEX iv1, iv2;
+
+      if (creates_triangle_new
+          (scalar_grid, isovert, isovert.CubeIndex(gcube_index), isovalue,
+           selection_data.bin_grid, selection_data.BinWidth(), iv1, iv2))
+        { selection_data.triangle_check[gcube_index] = 
+            CREATES_LARGE_TRIANGLE; }
+      else
+        { selection_data.triangle_check[gcube_index] = NO_LARGE_TRIANGLE; }
+    });
+}
+
+
+/// Set or clear triangle_changed_grid in the 5x5x5 region around cube_index.
+void set_triangle_changed_region
+(const SHARPISO_GRID & grid, const VERTEX_INDEX cube_index, const bool flag,
+ SELECTION_DATA & selection_data)
+{
+  GRID_COORD_TYPE coord[DIM3], min_coord[DIM3], max_coord[DIM3];
+
+  grid.ComputeCoord(cube_index, coord);
+  for (int d = 0; d < DIM3; d++) {
+    min_coord[d] = std::max(coord[d]-2, 0);
+    max_coord[d] = std::min(coord[d]+2, grid.AxisSize(d)-1);
+  }
+
+  for (coord[2] = min_coord[2]; coord[2] <= max_coord[2]; coord[2]++)
+    for (coord[1] = min_coord[1]; coord[1] <= max_coord[1]; coord[1]++)
+      for (coord[0] = min_coord[0]; coord[0] <= max_coord[0]; coord[0]++) {
+        selection_data.triangle_changed_grid.Set
+          (grid.ComputeVertexIndex(coord), flag);
+      }
+}
+
+
+/// Invalidate precomputed triangle checks near cube_index.
+/// Called when cube_index is selected or unselected.
+void invalidate_triangle_checks
+(const SHARPISO_GRID & grid, const VERTEX_INDEX cube_index,
+ SELECTION_DATA & selection_data)
+{
+  if (selection_data.triangle_checked_list.empty()) { return; }
+
+  set_triangle_changed_region(grid, cube_index, true, selection_data);
+  selection_data.triangle_changed_list.push_back(cube_index);
+}
+
+
+/// Clear precomputed triangle checks.
+void clear_triangle_checks
+(const SHARPISO_GRID & grid, SELECTION_DATA & selection_data)
+{
+  for (std::size_t i = 0; i < selection_data.triangle_checked_list.size(); i++) {
+    const NUM_TYPE gcube_index = selection_data.triangle_checked_list[i];
+    selection_data.triangle_check[gcube_index] = TRIANGLE_NOT_CHECKED;
+  }
+  selection_data.triangle_checked_list.clear();
+
+  for (std::size_t i = 0; i < selection_data.triangle_changed_list.size(); i++) {
+    set_triangle_changed_region
+      (grid, selection_data.triangle_changed_list[i], false, selection_data);
+  }
+  selection_data.triangle_changed_list.clear();
+}
+
+
+/// Return true if selecting gcube_index creates a triangle 
+///   with a large angle.
+/// Use precomputed result if it is still valid.
+bool creates_triangle_precomputed
+(const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
+ const ISOVERT & isovert,
+ const NUM_TYPE gcube_index,
+ const SCALAR_TYPE isovalue,
+ const SELECTION_DATA & selection_data,
+ VERTEX_INDEX & iv1,
+ VERTEX_INDEX & iv2)
+{
+  const VERTEX_INDEX cube_index = isovert.CubeIndex(gcube_index);
+
+  // Recompute if debugging to report iv1 and iv2.
+  if (!flag_debug &&
+      gcube_index < NUM_TYPE(selection_data.triangle_check.size())) {
+    const TRIANGLE_CHECK_RESULT result =
+      selection_data.triangle_check[gcube_index];
+
+    if (result != TRIANGLE_NOT_CHECKED &&
+        !selection_data.triangle_changed_grid.Scalar(cube_index))
+      { return(result == CREATES_LARGE_TRIANGLE); }
+  }
+
+  return(creates_triangle_new
+         (scalar_grid, isovert, cube_index, isovalue, 
+          selection_data.bin_grid, selection_data.BinWidth(), iv1, iv2));
+}
+
+
 // **************************************************
 // SELECT ROUTINES
 // **************************************************
@@ -149,6 +303,8 @@ void select_cube
   bin_grid_insert(scalar_grid, selection_data.BinWidth(), cube_index, 
                   selection_data.bin_grid);
 
+  invalidate_triangle_checks(isovert.grid, cube_index, selection_data);
+
   // mark all the neighbors as covered
   for (int i=0;i < isovert.grid.NumVertexNeighborsC(); i++) {
     VERTEX_INDEX cube_index2 = isovert.grid.VertexNeighborC(cube_index, i);
@@ -213,9 +369,8 @@ void check_and_select_cube
   }
 
   bool triangle_flag =
-    creates_triangle_new
-    (scalar_grid, isovert, cube_index, isovalue, 
-     selection_data.bin_grid, selection_data.BinWidth(), v1, v2);
+    creates_triangle_precomputed
+    (scalar_grid, isovert, gcube_index, isovalue, selection_data, v1, v2);
 
   if (!triangle_flag) {
     select_cube
@@ -264,9 +419,8 @@ void check_and_select_cube_no_conflict
   if (isovert.gcube_list[gcube_index].flag_conflict) { return; }
 
   bool triangle_flag =
-    creates_triangle_new
-    (scalar_grid, isovert, cube_index, isovalue, 
-     selection_data.bin_grid, selection_data.BinWidth(), v1, v2);
+    creates_triangle_precomputed
+    (scalar_grid, isovert, gcube_index, isovalue, selection_data, v1, v2);
 
   if (!triangle_flag) {
     select_cube
@@ -297,6 +451,7 @@ void unselect_cube(const NUM_TYPE gcube_index, ISOVERT & isovert,
   isovert.gcube_list[gcube_index].flag = AVAILABLE_GCUBE;
   bin_grid_remove(isovert.grid, selection_data.BinWidth(), cube_index, 
                   selection_data.bin_grid);
+  invalidate_triangle_checks(isovert.grid, cube_index, selection_data);
 
   if (isovert.gcube_list[gcube_index].boundary_bits == 0) {
 
@@ -447,7 +602,7 @@ void select_edge_cubes_ignore_mismatch
     if (isovert.gcube_list[gcube_index].flag == SELECTED_GCUBE) {
       const VERTEX_INDEX cube_index = isovert.CubeIndex(gcube_index);
       if (selection_data.mismatch_grid.Scalar(cube_index))
-        { isovert.gcube_list[gcube_index].flag_ignore_mismatch = true; }
+        { isovert.gcube_info[gcube_index].flag_ignore_mismatch = true; }
     }
   }
 }
@@ -511,6 +666,13 @@ void select_edge_cubes
  ISOVERT & isovert,
  SELECTION_DATA & selection_data)
 {
+  precompute_triangle_checks
+    (scalar_grid, isovalue, isovert_param, sharp_gcube_list, isovert,
+     [&](const NUM_TYPE gcube_index) {
+      return(!selection_data.mismatch_grid.Scalar
+             (isovert.CubeIndex(gcube_index)));
+    }, selection_data);
+
   for (int i=0; i < sharp_gcube_list.size(); i++) {
     NUM_TYPE gcube_index = sharp_gcube_list[i];
     VERTEX_INDEX cube_index = isovert.CubeIndex(gcube_index);
@@ -531,6 +693,8 @@ void select_edge_cubes
       (scalar_grid, isovalue, isovert_param, gcube_index, COVERED_A_GCUBE, 
        isovert, selection_data);
   }
+
+  clear_triangle_checks(isovert.grid, selection_data);
 }
 
 /// Select edge cubes (eigenvalue 2) with isovert within given distance
@@ -545,6 +709,14 @@ void select_edge_cubes_within_dist
  ISOVERT & isovert,
  SELECTION_DATA & selection_data)
 {
+  precompute_triangle_checks
+    (scalar_grid, isovalue, isovert_param, sharp_gcube_list, isovert,
+     [&](const NUM_TYPE gcube_index) {
+      return(isovert.gcube_list[gcube_index].linf_dist <= max_distance &&
+             !selection_data.mismatch_grid.Scalar
+             (isovert.CubeIndex(gcube_index)));
+    }, selection_data);
+
   for (int i=0; i < sharp_gcube_list.size(); i++) {
     NUM_TYPE gcube_index = sharp_gcube_list[i];
     VERTEX_INDEX cube_index = isovert.CubeIndex(gcube_index);
@@ -568,6 +740,8 @@ void select_edge_cubes_within_dist
       (scalar_grid, isovalue, isovert_param, gcube_index, COVERED_A_GCUBE, 
        isovert, selection_data);
   }
+
+  clear_triangle_checks(isovert.grid, selection_data);
 }
 
 
@@ -581,6 +755,16 @@ void select_edge_cubes_near_corners
  ISOVERT & isovert,
  SELECTION_DATA & selection_data)
 {
+  precompute_triangle_checks
+    (scalar_grid, isovalue, isovert_param, sharp_gcube_list, isovert,
+     [&](const NUM_TYPE gcube_index) {
+      return(!selection_data.mismatch_grid.Scalar
+             (isovert.CubeIndex(gcube_index)) &&
+             is_near_corner_covered_cube
+             (selection_data.corner_covered_grid, 
+              isovert.gcube_list[gcube_index]));
+    }, selection_data);
+
   for (int i=0; i < sharp_gcube_list.size(); i++) {
     NUM_TYPE gcube_index = sharp_gcube_list[i];
     VERTEX_INDEX cube_index = isovert.CubeIndex(gcube_index);
@@ -605,6 +789,8 @@ void select_edge_cubes_near_corners
     }
 
   }
+
+  clear_triangle_checks(isovert.grid, selection_data);
 }
 
 
@@ -620,6 +806,17 @@ void select_edge_cubes_near_corners_within_dist
  ISOVERT & isovert,
  SELECTION_DATA & selection_data)
 {
+  precompute_triangle_checks
+    (scalar_grid, isovalue, isovert_param, sharp_gcube_list, isovert,
+     [&](const NUM_TYPE gcube_index) {
+      return(isovert.gcube_list[gcube_index].linf_dist <= max_distance &&
+             !selection_data.mismatch_grid.Scalar
+             (isovert.CubeIndex(gcube_index)) &&
+             is_near_corner_covered_cube
+             (selection_data.corner_covered_grid, 
+              isovert.gcube_list[gcube_index]));
+    }, selection_data);
+
   for (int i=0; i < sharp_gcube_list.size(); i++) {
     NUM_TYPE gcube_index = sharp_gcube_list[i];
     VERTEX_INDEX cube_index = isovert.CubeIndex(gcube_index);
@@ -661,6 +858,8 @@ void select_edge_cubes_near_corners_within_dist
          isovert, selection_data);
     }
   }
+
+  clear_triangle_checks(isovert.grid, selection_data);
 }
 
 /// Select one edge cube (eigenvalue 2).
@@ -1179,7 +1378,7 @@ void SHREC::select_sharp_isovert
 /// Set mismatch flags for cubes near corners.
 void set_mismatch_near_corner
 (const ISOVERT & isovert, const GRID_CUBE_DATA & gcubeA, 
- const SELECTION_DATA & selection_data, SHARPISO_BOOL_GRID & mismatch_grid)
+ const SELECTION_DATA & selection_data, SHARPISO_BIT_GRID & mismatch_grid)
 {
   int orth_dir, side;
   GRID_COORD_TYPE distance2boundary;
@@ -1254,7 +1453,7 @@ void set_mismatch_near_corner
 /// Set mismatch flags for cubes near corners.
 void set_mismatch_near_corner
 (const ISOVERT & isovert,  const vector<NUM_TYPE> & sharp_gcube_list,
- const SELECTION_DATA & selection_data, SHARPISO_BOOL_GRID & mismatch_grid)
+ const SELECTION_DATA & selection_data, SHARPISO_BIT_GRID & mismatch_grid)
 {
   MSDEBUG();
   if (flag_debug)
@@ -1284,7 +1483,7 @@ void set_mismatch_near_corner
 /// Compute mismatch grid.
 void compute_mismatch_grid
 (const ISOVERT & isovert,  const vector<NUM_TYPE> & sharp_gcube_list,
- const SELECTION_DATA & selection_data, SHARPISO_BOOL_GRID & mismatch_grid)
+ const SELECTION_DATA & selection_data, SHARPISO_BIT_GRID & mismatch_grid)
 {
   mismatch_grid.SetAll(false);
 
@@ -1308,6 +1507,11 @@ void compute_mismatch_grid
     }
   }
 
+  MSDEBUG();
+  if (flag_debug) {
+    cerr << "  Number of mismatched cubes: "
+         << mismatch_grid.CountTrue() << endl;
+  }
 }
 
 /// Compute mismatch grid.
@@ -1438,6 +1642,16 @@ void select_cubes_with_k_coord_cong2zero
     { cerr << endl << "--- Selecting cubes with " << k
            << " coord cong to 0 mod " << modulus << "." << endl; }
 
+  // For k = 3, precomputed triangle checks are never invalidated.
+  precompute_triangle_checks
+    (scalar_grid, isovalue, isovert_param, sharp_gcube_list, isovert,
+     [&](const NUM_TYPE gcube_index) {
+      return(isovert.gcube_list[gcube_index].cube_containing_isovert ==
+             isovert.CubeIndex(gcube_index) &&
+             are_k_coord_cong2zero<k,modulus>
+             (isovert.gcube_list[gcube_index].cube_coord));
+    }, selection_data);
+
   for (int i=0; i < sharp_gcube_list.size(); i++) {
     NUM_TYPE gcube_index = sharp_gcube_list[i];
     VERTEX_INDEX cube_index = isovert.CubeIndex(gcube_index);
@@ -1456,6 +1670,8 @@ void select_cubes_with_k_coord_cong2zero
     }
   }
 
+  clear_triangle_checks(isovert.grid, selection_data);
+
   recompute_covered_point_positions
     (scalar_grid, gradient_grid, selection_data.covered_grid, isovalue, 
      isovert_param, isovert);
@@ -3004,7 +3220,7 @@ namespace {
   // Change isovert positions which lie in covered cubes.
   // @param gcube_index_list Examine only cubes in gcube_index_list.
   void reset_covered_isovert_positions
-  (const SHARPISO_BOOL_GRID & covered_grid,
+  (const SHARPISO_BIT_GRID & covered_grid,
    const std::vector<NUM_TYPE> & gcube_index_list,
    ISOVERT & isovert)
   {
@@ -3067,7 +3283,7 @@ namespace {
 
   // Change isovert positions which lie in covered cubes.
   void reset_covered_isovert_positions
-  (const SHARPISO_BOOL_GRID & covered_grid,
+  (const SHARPISO_BIT_GRID & covered_grid,
    ISOVERT & isovert)
   {
     std::vector<NUM_TYPE> gcube_sharp_list;
@@ -3087,7 +3303,7 @@ namespace {
 
   /// Return true if sharp vertex is in a cube which is covered.
   bool check_covered_point
-  (const SHARPISO_BOOL_GRID & covered_grid,
+  (const SHARPISO_BIT_GRID & covered_grid,
    ISOVERT & isovert,
    const VERTEX_INDEX & gcube0_index)
   {
@@ -3111,7 +3327,7 @@ namespace {
 
   /// If sharp vertex is in covered cube, set cube to COVERED_POINT.
   void check_and_set_covered_point
-  (const SHARPISO_BOOL_GRID & covered_grid,
+  (const SHARPISO_BIT_GRID & covered_grid,
    ISOVERT & isovert,
    const VERTEX_INDEX & gcube_index)
   {
@@ -3214,7 +3430,7 @@ namespace {
 
   // Return true if cube facet lies on a 3x3x3 region around a corner cube.
   bool is_facet_on_corner_3x3x3
-  (const GRID_CUBE_DATA & c, const SHARPISO_BOOL_GRID & covered_grid,
+  (const GRID_CUBE_DATA & c, const SHARPISO_BIT_GRID & covered_grid,
    const ISOVERT & isovert, int & orth_dir, int & side,
    VERTEX_INDEX & corner_cube_index)
   {
@@ -3272,7 +3488,7 @@ namespace {
   ///   or if cube at (c0,c1,c2) +/- (a,0,0) or (0,a,0) or (0,0,a)
   //    for a = 1 or 2 is covered.
   bool is_near_corner_covered_cube
-  (const SHARPISO_BOOL_GRID & corner_covered_grid,
+  (const SHARPISO_BIT_GRID & corner_covered_grid,
    const GRID_CUBE_DATA & c)
   {
     if (is_some_edge_adjacent_true
@@ -3326,7 +3542,7 @@ namespace {
   /// Version based on covered_grid.
   /// @pre cube0 is an internal cube.
   bool is_facet_neighbor_covered_B
-  (const SHARPISO_BOOL_GRID & covered_grid, const VERTEX_INDEX cube_index0)
+  (const SHARPISO_BIT_GRID & covered_grid, const VERTEX_INDEX cube_index0)
   {
     for (int d = 0; d < DIM3; d++) {
       for (int iside = 0; iside < 2; iside++) {
@@ -3344,7 +3560,7 @@ namespace {
   /// Version based on covered_grid.
   /// @pre cube0 is an internal cube.
   bool is_edge_neighbor_covered_B
-  (const SHARPISO_BOOL_GRID & covered_grid, const VERTEX_INDEX cube_index0)
+  (const SHARPISO_BIT_GRID & covered_grid, const VERTEX_INDEX cube_index0)
   {
     for (int edge_dir = 0; edge_dir < DIM3; edge_dir++) {
       int d1 = (edge_dir+1)%DIM3;
@@ -3385,7 +3601,7 @@ namespace {
   /// Return true if bool_grid.Scalar(icubeB) is true for some cube
   ///   facet adjacent to icubeA
   bool is_some_facet_adjacent_true
-  (const SHARPISO_BOOL_GRID & bool_grid, 
+  (const SHARPISO_BIT_GRID & bool_grid, 
    const VERTEX_INDEX icubeA, const BOUNDARY_BITS_TYPE boundary_bits)
   {
     VERTEX_INDEX icubeB;
@@ -3423,7 +3639,7 @@ namespace {
   /// Return true if bool_grid.Scalar(icubeB) is true for some cube
   ///   edge adjacent to icubeA
   bool is_some_edge_adjacent_true
-  (const SHARPISO_BOOL_GRID & bool_grid, 
+  (const SHARPISO_BIT_GRID & bool_grid, 
    const VERTEX_INDEX icubeA, const BOUNDARY_BITS_TYPE boundary_bits)
   {
     if (boundary_bits == 0) {
@@ -3468,7 +3684,7 @@ namespace {
   /// Return true if bool_grid.Scalar(icube) is true for some cube
   ///   at (c0,c1,c2) +/- (a,0,0) or (0,a,0) or (0,0,a) where a = 1 or 2.
   bool is_some_dist2_neighbor_true
-  (const SHARPISO_BOOL_GRID & bool_grid, 
+  (const SHARPISO_BIT_GRID & bool_grid, 
    const VERTEX_INDEX cubeA_index, const GRID_COORD_TYPE cubeA_coord[DIM3],
    const BOUNDARY_BITS_TYPE boundary_bits)
   {
@@ -3479,7 +3695,13 @@ namespace {
       (cubeA_coord, distance2boundary);
 
     if (distance2boundary >= max_dist) {
-      for (int d = 0; d < DIM3; d++) {
+
+      // Check the row along axis 0 with one IsSomeTrue() call per side.
+      if (bool_grid.IsSomeTrue(cubeA_index-max_dist, cubeA_index) ||
+          bool_grid.IsSomeTrue(cubeA_index+1, cubeA_index+max_dist+1))
+        { return(true); }
+
+      for (int d = 1; d < DIM3; d++) {
         for (int j = 0; j < 2; j++) {
 
           VERTEX_INDEX cubeB_index = cubeA_index;
@@ -3718,7 +3940,7 @@ void MISMATCH_TABLE::AddSignedPermutations
 
 bool MISMATCH_TABLE::IsBlocked
 (const NUM_TYPE ientry, const VERTEX_INDEX cubeA_index,
- const SHARPISO_BOOL_GRID & selected_grid) const
+ const SHARPISO_BIT_GRID & selected_grid) const
 {
   for (NUM_TYPE j = 0; j < entry[ientry].NumBlockingLocations(); j++) {
 
@@ -3735,8 +3957,8 @@ bool MISMATCH_TABLE::IsBlocked
 void MISMATCH_TABLE::SetMismatchGrid
 (const GRID_CUBE_DATA & gcubeA,
  const ISOVERT & isovert,
- const SHARPISO_BOOL_GRID & selected_grid,
- SHARPISO_BOOL_GRID & mismatch_grid) const
+ const SHARPISO_BIT_GRID & selected_grid,
+ SHARPISO_BIT_GRID & mismatch_grid) const
 {
   const VERTEX_INDEX cubeA_index = gcubeA.cube_index;
   GRID_COORD_TYPE distance2boundary;
@@ -3897,6 +4119,13 @@ SELECTION_DATA::SELECTION_DATA
   // Initialize mismatch grid.
   mismatch_grid.SetSize(grid);
   mismatch_grid.SetAll(false);
+
+  // Triangle checks are only precomputed using multiple threads.
+  num_threads = isovert_param.num_threads;
+  if (num_threads > 1) {
+    triangle_changed_grid.SetSize(grid);
+    triangle_changed_grid.SetAll(false);
+  }
 }
 
 // Constructor
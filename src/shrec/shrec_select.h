@@ -97,15 +97,15 @@ namespace SHREC {
     void SetMismatchGrid
     (const GRID_CUBE_DATA & gcubeA,
      const ISOVERT & isovert,
-     const SHARPISO_BOOL_GRID & selected_grid,
-     SHARPISO_BOOL_GRID & mismatch_grid) const;
+     const SHARPISO_BIT_GRID & selected_grid,
+     SHARPISO_BIT_GRID & mismatch_grid) const;
 
     /// Return true if (cubeA_index + entry offset) is blocked 
     ///   by some selected cube.
     /// @pre (cubeA_index + entry offset) is contained in the grid.
     bool IsBlocked
     (const NUM_TYPE ientry, const VERTEX_INDEX cubeA_index,
-     const SHARPISO_BOOL_GRID & selected_grid) const;
+     const SHARPISO_BIT_GRID & selected_grid) const;
   };
 
 
@@ -137,33 +137,60 @@ namespace SHREC {
     void AddSignedPermutations(const int ka, const int kb, const int kc);
   };
 
+  /// Precomputed result of checking whether selecting a cube
+  ///   creates a triangle with a large angle.
+  typedef enum { TRIANGLE_NOT_CHECKED, NO_LARGE_TRIANGLE, 
+                 CREATES_LARGE_TRIANGLE }
+  TRIANGLE_CHECK_RESULT;
+
   class SELECTION_DATA {
 
   protected:
     int bin_width;
+    int num_threads;
 
   public:
     BIN_GRID<VERTEX_INDEX> bin_grid;
-    SHARPISO_BOOL_GRID selected_grid;
+    SHARPISO_BIT_GRID selected_grid;
 
     /// covered_grid.Scalar(icube) = true if icube is covered.
-    SHARPISO_BOOL_GRID covered_grid;
+    SHARPISO_BIT_GRID covered_grid;
 
     /// corner_covered_grid.Scalar(icube) = true,
     ///   if icube is covered by a corner cube.
-    SHARPISO_BOOL_GRID corner_covered_grid;
+    SHARPISO_BIT_GRID corner_covered_grid;
 
     /// Cubes which should be avoided because of 3x3x3 region mismatches.
-    SHARPISO_BOOL_GRID mismatch_grid;
+    SHARPISO_BIT_GRID mismatch_grid;
 
     /// Table of offsets of cubes which do not match a given cube.
     MISMATCH_TABLE mismatch_table;
 
+    /// triangle_check[gcube_index] = result of creates_triangle_new()
+    ///   computed before selecting cubes from a list.
+    /// TRIANGLE_NOT_CHECKED if no result is precomputed.
+    std::vector<TRIANGLE_CHECK_RESULT> triangle_check;
+
+    /// List of gcube indices with precomputed triangle checks.
+    std::vector<NUM_TYPE> triangle_checked_list;
+
+    /// triangle_changed_grid.Scalar(icube) = true if some cube
+    ///   within Linf distance 2 of icube was selected after 
+    ///   the triangle checks were computed.
+    /// Precomputed triangle checks of such cubes are not used.
+    SHARPISO_BIT_GRID triangle_changed_grid;
+
+    /// List of cubes selected after the triangle checks were computed.
+    std::vector<VERTEX_INDEX> triangle_changed_list;
+
   public:
     SELECTION_DATA
     (const SHARPISO_GRID & grid, const SHARP_ISOVERT_PARAM & isovert_param);
 
     int BinWidth() const { return(bin_width); }
+
+    /// Number of threads used in precomputing triangle checks.
+    int NumThreads() const { return(num_threads); }
   };
 
   class SELECTION_DATA_MOD6:public SELECTION_DATA {
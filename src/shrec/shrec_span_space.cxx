@@ -0,0 +1,346 @@
+/// \file shrec_span_space.cxx
+/// Span space index of grid cubes for repeated isovalue queries.
+
+/*
+Copyright (C) 2015 Arindam Bhattacharya and Rephael Wenger
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public License
+(LGPL) as published by the Free Software Foundation; either
+version 2.1 of the License, or any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#include <algorithm>
+
+#include "ijkgrid_macros.h"
+
+#include "shrec_span_space.h"
+
+using namespace SHREC;
+
+
+// **************************************************
+// LOCAL TYPES
+// **************************************************
+
+namespace {
+
+  /// Scalar range of a grid cube.
+  class CUBE_SPAN {
+  public:
+    SCALAR_TYPE smin;
+    SCALAR_TYPE smax;
+    VERTEX_INDEX cube_index;
+  };
+
+  /// Range of cube_span[] which forms a subtree.
+  class SUBTREE_RANGE {
+  public:
+    NUM_TYPE begin;
+    NUM_TYPE end;
+    NUM_TYPE parent;
+    bool is_left_child;
+  };
+
+}
+
+
+// **************************************************
+// SPAN_SPACE_INDEX member functions
+// **************************************************
+
+void SPAN_SPACE_INDEX::Clear()
+{
+  node.clear();
+  min_list.clear();
+  max_list.clear();
+  is_set = false;
+}
+
+
+// Build index from scalar ranges of the cubes of scalar_grid.
+void SPAN_SPACE_INDEX::Set(const SHARPISO_SCALAR_GRID_BASE & scalar_grid)
+{
+  std::vector<CUBE_SPAN> cube_span;
+  std::vector<SUBTREE_RANGE> stack;
+
+  Clear();
+
+  if (scalar_grid.Dimension() < 1) { return; }
+
+  // Compute scalar range of each cube.  Skip cubes with min == max.
+  IJK_FOR_EACH_GRID_CUBE(icube, scalar_grid, VERTEX_INDEX) {
+    CUBE_SPAN span;
+    span.smin = span.smax = scalar_grid.Scalar(icube);
+    for (NUM_TYPE k = 1; k < scalar_grid.NumCubeVertices(); k++) {
+      const SCALAR_TYPE s = scalar_grid.Scalar(scalar_grid.CubeVertex(icube, k));
+      if (s < span.smin) { span.smin = s; }
+      if (s > span.smax) { span.smax = s; }
+    }
+
+    if (span.smin < span.smax) {
+      span.cube_index = icube;
+      cube_span.push_back(span);
+    }
+  }
+
+  min_list.resize(cube_span.size());
+  max_list.resize(cube_span.size());
+
+  if (cube_span.size() > 0) {
+    SUBTREE_RANGE root = { 0, NUM_TYPE(cube_span.size()), NoNode(), false };
+    stack.push_back(root);
+  }
+
+  NUM_TYPE num_stored = 0;
+  while (stack.size() > 0) {
+    const SUBTREE_RANGE range = stack.back();
+    stack.pop_back();
+
+    // Split at median of max values.
+    // The median cube has min < max == split, so it is stored in this node
+    //   and each subtree has at most half the cubes.
+    std::vector<CUBE_SPAN>::iterator begin = cube_span.begin() + range.begin;
+    std::vector<CUBE_SPAN>::iterator end = cube_span.begin() + range.end;
+    std::vector<CUBE_SPAN>::iterator median = begin + (end-begin)/2;
+    std::nth_element(begin, median, end,
+                     [](const CUBE_SPAN & a, const CUBE_SPAN & b)
+                     { return(a.smax < b.smax); });
+    const SCALAR_TYPE split = median->smax;
+
+    // Partition into [left subtree | node | right subtree].
+    std::vector<CUBE_SPAN>::iterator left_end =
+      std::partition(begin, end, [split](const CUBE_SPAN & a)
+                     { return(a.smax < split); });
+    std::vector<CUBE_SPAN>::iterator node_end =
+      std::partition(left_end, end, [split](const CUBE_SPAN & a)
+                     { return(a.smin < split); });
+
+    SPAN_NODE new_node;
+    new_node.split = split;
+    new_node.first_entry = num_stored;
+    new_node.num_entries = node_end - left_end;
+    new_node.left_child = NoNode();
+    new_node.right_child = NoNode();
+
+    const NUM_TYPE inode = node.size();
+    node.push_back(new_node);
+    if (range.parent != NoNode()) {
+      if (range.is_left_child) { node[range.parent].left_child = inode; }
+      else { node[range.parent].right_child = inode; }
+    }
+
+    std::sort(left_end, node_end, [](const CUBE_SPAN & a, const CUBE_SPAN & b)
+              { return(a.smin < b.smin); });
+    for (std::vector<CUBE_SPAN>::iterator iter = left_end;
+         iter != node_end; iter++) {
+      min_list[num_stored].s = iter->smin;
+      min_list[num_stored].cube_index = iter->cube_index;
+      num_stored++;
+    }
+
+    std::sort(left_end, node_end, [](const CUBE_SPAN & a, const CUBE_SPAN & b)
+              { return(a.smax > b.smax); });
+    NUM_TYPE j = new_node.first_entry;
+    for (std::vector<CUBE_SPAN>::iterator iter = left_end;
+         iter != node_end; iter++) {
+      max_list[j].s = iter->smax;
+      max_list[j].cube_index = iter->cube_index;
+      j++;
+    }
+
+    const NUM_TYPE ileft_end = left_end - cube_span.begin();
+    const NUM_TYPE inode_end = node_end - cube_span.begin();
+    if (range.begin < ileft_end) {
+      SUBTREE_RANGE left = { range.begin, ileft_end, inode, true };
+      stack.push_back(left);
+    }
+    if (inode_end < range.end) {
+      SUBTREE_RANGE right = { inode_end, range.end, inode, false };
+      stack.push_back(right);
+    }
+  }
+
+  is_set = true;
+}
+
+
+// Return number of bytes allocated by index.
+long long SPAN_SPACE_INDEX::NumBytes() const
+{
+  return((long long)(node.capacity())*sizeof(SPAN_NODE) +
+         (long long)(min_list.capacity())*sizeof(SPAN_ENTRY) +
+         (long long)(max_list.capacity())*sizeof(SPAN_ENTRY));
+}
+
+
+// Get active cubes for isovalue.
+void SPAN_SPACE_INDEX::GetActiveCubes
+(const SCALAR_TYPE isovalue, std::vector<VERTEX_INDEX> & cube_list) const
+{
+  cube_list.clear();
+
+  if (node.size() == 0) { return; }
+
+  NUM_TYPE inode = 0;
+  while (inode != NoNode()) {
+    const SPAN_NODE & current = node[inode];
+    const NUM_TYPE kend = current.first_entry + current.num_entries;
+
+    if (isovalue <= current.split) {
+      // All cubes in node have max >= split >= isovalue.
+      for (NUM_TYPE k = current.first_entry; k < kend; k++) {
+        if (min_list[k].s >= isovalue) { break; }
+        cube_list.push_back(min_list[k].cube_index);
+      }
+      inode = current.left_child;
+    }
+    else {
+      // All cubes in node have min < split < isovalue.
+      for (NUM_TYPE k = current.first_entry; k < kend; k++) {
+        if (max_list[k].s < isovalue) { break; }
+        cube_list.push_back(max_list[k].cube_index);
+      }
+      inode = current.right_child;
+    }
+  }
+
+  std::sort(cube_list.begin(), cube_list.end());
+}
+
+
+// **************************************************
+// ACTIVE GRID REGION
+// **************************************************
+
+// Set sign_grid to the signs of the vertices of the cubes
+//   in active_region.
+void SHREC::set_sign_grid
+(const SHARPISO_SCALAR_GRID_BASE & scalar_grid, const SCALAR_TYPE isovalue,
+ const ACTIVE_GRID_REGION & active_region, SHARPISO_BIT_GRID & sign_grid)
+{
+  const SCALAR_STORAGE_TYPE * scalar = scalar_grid.ScalarPtrConst();
+  const SHARPISO_ACTIVE_BRICKS & active_brick = active_region.active_brick;
+
+  sign_grid.SetSize(scalar_grid);
+
+  if (scalar_grid.Dimension() != DIM3 ||
+      (!active_region.IsCubeListSet() && !active_brick.IsSet())) {
+    sign_grid.SetGE(scalar, isovalue);
+    return;
+  }
+
+  const VERTEX_INDEX increment1 = scalar_grid.AxisIncrement(1);
+  const VERTEX_INDEX increment2 = scalar_grid.AxisIncrement(2);
+  std::vector<bool> is_word_needed(sign_grid.NumWords(), false);
+
+  // Mark words containing vertices iv0, iv0+1, ..., iv1-1.
+  auto mark_words = [&](const VERTEX_INDEX iv0, const VERTEX_INDEX iv1) {
+    for (NUM_TYPE k = iv0/IJK::BITS_PER_BIT_GRID_WORD;
+         k <= (iv1-1)/IJK::BITS_PER_BIT_GRID_WORD; k++)
+      { is_word_needed[k] = true; }
+  };
+
+  if (active_region.IsCubeListSet()) {
+    const std::vector<VERTEX_INDEX> & cube_list = active_region.cube_list;
+
+    // Cube vertices lie on four rows of two vertices along axis 0.
+    for (std::size_t i = 0; i < cube_list.size(); i++) {
+      const VERTEX_INDEX icube = cube_list[i];
+      mark_words(icube, icube+2);
+      mark_words(icube+increment1, icube+increment1+2);
+      mark_words(icube+increment2, icube+increment2+2);
+      mark_words(icube+increment1+increment2, icube+increment1+increment2+2);
+    }
+  }
+  else {
+    // Bricks include the grid vertices on their boundaries.
+    const AXIS_SIZE_TYPE brick_edge_length = active_brick.BrickEdgeLength();
+    GRID_COORD_TYPE brick_coord[DIM3];
+    GRID_COORD_TYPE vmin[DIM3], vmax[DIM3];
+
+    for (VERTEX_INDEX ib = 0; ib < active_brick.NumVertices(); ib++) {
+      if (!active_brick.Scalar(ib)) { continue; }
+
+      active_brick.ComputeCoord(ib, brick_coord);
+      for (int d = 0; d < DIM3; d++) {
+        vmin[d] = brick_coord[d]*brick_edge_length;
+        vmax[d] = std::min(GRID_COORD_TYPE(vmin[d]+brick_edge_length),
+                           GRID_COORD_TYPE(scalar_grid.AxisSize(d)-1));
+      }
+
+      for (GRID_COORD_TYPE z = vmin[2]; z <= vmax[2]; z++) {
+        for (GRID_COORD_TYPE y = vmin[1]; y <= vmax[1]; y++) {
+          const VERTEX_INDEX iv0 = vmin[0] + y*increment1 + z*increment2;
+          mark_words(iv0, iv0+vmax[0]-vmin[0]+1);
+        }
+      }
+    }
+  }
+
+  for (NUM_TYPE k = 0; k < sign_grid.NumWords(); k++) {
+    if (is_word_needed[k])
+      { sign_grid.SetGEInWord(scalar, isovalue, k); }
+  }
+}
+
+
+// **************************************************
+// ACTIVE CUBES FOR MULTIPLE ISOVALUES
+// **************************************************
+
+// Get active cubes for each isovalue in a single pass over scalar_grid.
+void SHREC::get_active_cubes
+(const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
+ const std::vector<SCALAR_TYPE> & isovalue,
+ std::vector< std::vector<VERTEX_INDEX> > & cube_list)
+{
+  const NUM_TYPE num_isovalues = isovalue.size();
+  std::vector<SCALAR_TYPE> sorted_isovalue(isovalue);
+  std::vector<NUM_TYPE> isovalue_index(num_isovalues);
+
+  cube_list.assign(num_isovalues, std::vector<VERTEX_INDEX>());
+
+  if (num_isovalues == 0) { return; }
+
+  // Sort isovalues.  The isovalues in (min(c),max(c)] are consecutive.
+  for (NUM_TYPE i = 0; i < num_isovalues; i++)
+    { isovalue_index[i] = i; }
+  std::sort(isovalue_index.begin(), isovalue_index.end(),
+            [&isovalue](const NUM_TYPE i0, const NUM_TYPE i1)
+            { return(isovalue[i0] < isovalue[i1]); });
+  for (NUM_TYPE i = 0; i < num_isovalues; i++)
+    { sorted_isovalue[i] = isovalue[isovalue_index[i]]; }
+
+  const SCALAR_TYPE min_isovalue = sorted_isovalue.front();
+  const SCALAR_TYPE max_isovalue = sorted_isovalue.back();
+
+  IJK_FOR_EACH_GRID_CUBE(icube, scalar_grid, VERTEX_INDEX) {
+    SCALAR_TYPE smin, smax;
+    smin = smax = scalar_grid.Scalar(icube);
+    for (NUM_TYPE k = 1; k < scalar_grid.NumCubeVertices(); k++) {
+      const SCALAR_TYPE s = scalar_grid.Scalar(scalar_grid.CubeVertex(icube, k));
+      if (s < smin) { smin = s; }
+      if (s > smax) { smax = s; }
+    }
+
+    if (smax < min_isovalue || smin >= max_isovalue) { continue; }
+
+    const NUM_TYPE ibegin =
+      std::upper_bound(sorted_isovalue.begin(), sorted_isovalue.end(), smin)
+      - sorted_isovalue.begin();
+    for (NUM_TYPE i = ibegin; i < num_isovalues; i++) {
+      if (sorted_isovalue[i] > smax) { break; }
+      cube_list[isovalue_index[i]].push_back(icube);
+    }
+  }
+}
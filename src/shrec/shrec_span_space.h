@@ -0,0 +1,174 @@
+/// \file shrec_span_space.h
+/// Span space index of grid cubes for repeated isovalue queries.
+
+/*
+Copyright (C) 2015 Arindam Bhattacharya and Rephael Wenger
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public License
+(LGPL) as published by the Free Software Foundation; either
+version 2.1 of the License, or any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#ifndef _SHREC_SPAN_SPACE_H_
+#define _SHREC_SPAN_SPACE_H_
+
+#include "sharpiso_grids.h"
+#include "shrec_types.h"
+
+#include <vector>
+
+namespace SHREC {
+
+// **************************************************
+// SPAN SPACE INDEX
+// **************************************************
+
+/// Interval tree on the scalar ranges of the grid cubes.
+/// Cube c is active for isovalue s if min(c) < s <= max(c),
+///   as in is_gt_cube_min_le_cube_max().
+/// Built once per scalar grid.  Active cubes for an isovalue
+///   are found in time proportional to the tree depth
+///   plus the number of active cubes.
+/// Cubes with min(c) == max(c) are never active and are not stored.
+class SPAN_SPACE_INDEX {
+
+protected:
+
+  /// Grid cube and one endpoint of its scalar range.
+  class SPAN_ENTRY {
+  public:
+    SCALAR_TYPE s;
+    VERTEX_INDEX cube_index;
+  };
+
+  /// Node of interval tree.
+  /// Node stores cubes whose range satisfies min < split <= max.
+  /// Cubes in the left subtree have max < split.
+  /// Cubes in the right subtree have min >= split.
+  class SPAN_NODE {
+  public:
+    SCALAR_TYPE split;
+    NUM_TYPE first_entry;   ///< First entry in min_list[] and max_list[].
+    NUM_TYPE num_entries;   ///< Number of cubes stored in node.
+    NUM_TYPE left_child;    ///< Index of left child or NoNode().
+    NUM_TYPE right_child;   ///< Index of right child or NoNode().
+  };
+
+  static NUM_TYPE NoNode() { return(-1); }
+
+  /// Tree nodes.  Node 0 is the root.
+  std::vector<SPAN_NODE> node;
+
+  /// Cubes of each node sorted by increasing min.
+  std::vector<SPAN_ENTRY> min_list;
+
+  /// Cubes of each node sorted by decreasing max.
+  std::vector<SPAN_ENTRY> max_list;
+
+  bool is_set;
+
+public:
+  SPAN_SPACE_INDEX() { Clear(); };
+
+  /// Remove all cubes.
+  void Clear();
+
+  /// Build index from scalar ranges of the cubes of scalar_grid.
+  void Set(const SHARPISO_SCALAR_GRID_BASE & scalar_grid);
+
+  /// Return true if index is set.
+  bool IsSet() const
+  { return(is_set); }
+
+  /// Return number of cubes stored in index.
+  NUM_TYPE NumCubes() const
+  { return(min_list.size()); }
+
+  /// Return number of tree nodes.
+  NUM_TYPE NumNodes() const
+  { return(node.size()); }
+
+  /// Return number of bytes allocated by index.
+  long long NumBytes() const;
+
+  /// Get active cubes for isovalue.
+  /// @param[out] cube_list[] Active cubes in increasing order.
+  void GetActiveCubes
+  (const SCALAR_TYPE isovalue, std::vector<VERTEX_INDEX> & cube_list) const;
+};
+
+
+// **************************************************
+// ACTIVE GRID REGION
+// **************************************************
+
+/// Grid bricks and cubes which may intersect the isosurface.
+/// Restricts isosurface extraction and active cube search.
+/// If neither active_brick nor cube_list is set,
+///   the whole grid is processed.
+class ACTIVE_GRID_REGION {
+
+public:
+
+  /// Flags for bricks whose scalar range contains isovalue.
+  SHARPISO_ACTIVE_BRICKS active_brick;
+
+  /// If true, cube_list[] contains all active cubes.
+  bool is_cube_list_set;
+
+  /// Active cubes in increasing order.
+  std::vector<VERTEX_INDEX> cube_list;
+
+  ACTIVE_GRID_REGION() { is_cube_list_set = false; };
+
+  /// Return true if cube_list[] contains all active cubes.
+  bool IsCubeListSet() const
+  { return(is_cube_list_set); }
+
+  /// Swap cube_list[] with list of active cubes active_cube[].
+  /// @param active_cube[] Active cubes in increasing order.
+  void SwapCubeList(std::vector<VERTEX_INDEX> & active_cube)
+  {
+    cube_list.swap(active_cube);
+    is_cube_list_set = true;
+  }
+};
+
+/// Set sign_grid to the signs of the vertices of the cubes
+///   in active_region.
+/// Vertex iv is positive if scalar_grid.Scalar(iv) >= isovalue.
+/// Only words of sign_grid containing vertices of cubes in cube_list[]
+///   or in active bricks are computed.  Other vertices are negative.
+/// If neither active_brick nor cube_list is set,
+///   compute the signs of all vertices.
+void set_sign_grid
+(const SHARPISO_SCALAR_GRID_BASE & scalar_grid, const SCALAR_TYPE isovalue,
+ const ACTIVE_GRID_REGION & active_region, SHARPISO_BIT_GRID & sign_grid);
+
+
+// **************************************************
+// ACTIVE CUBES FOR MULTIPLE ISOVALUES
+// **************************************************
+
+/// Get active cubes for each isovalue in a single pass over scalar_grid.
+/// Cube c is active for isovalue[i] if min(c) < isovalue[i] <= max(c).
+/// @param[out] cube_list[i] Active cubes for isovalue[i]
+///   in increasing order.
+void get_active_cubes
+(const SHARPISO_SCALAR_GRID_BASE & scalar_grid,
+ const std::vector<SCALAR_TYPE> & isovalue,
+ std::vector< std::vector<VERTEX_INDEX> > & cube_list);
+
+}
+
+#endif
@@ -0,0 +1,204 @@
+/// \file shrec_thread.txx
+/// Templates for splitting work among threads.
+
+/*
+Copyright (C) 2015 Arindam Bhattacharya and Rephael Wenger
+
+This library is free software; you can redistribute it and/or
+modify it under the terms of the GNU Lesser General Public License
+(LGPL) as published by the Free Software Foundation; either
+version 2.1 of the License, or any later version.
+
+This library is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public
+License along with this library; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+#ifndef _SHREC_THREAD_TXX_
+#define _SHREC_THREAD_TXX_
+
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace SHREC {
+
+  // **************************************************
+  // PARALLEL FOR TEMPLATES
+  // **************************************************
+
+  /// Apply f(k0,k1) to contiguous blocks [k0,k1) of [0,num_items).
+  /// Block j is processed by thread j.  Blocks are disjoint,
+  ///   so f may write data indexed by k in [k0,k1) without locking.
+  /// If num_threads <= 1, call f(0,num_items) in the calling thread.
+  /// Exceptions thrown by f are rethrown in the calling thread
+  ///   after all threads finish.
+  template <typename NTYPE0, typename NTYPE1, typename FTYPE>
+  void apply_to_blocks_in_parallel
+  (const NTYPE0 num_threads, const NTYPE1 num_items, FTYPE f)
+  {
+    NTYPE1 num_blocks = num_threads;
+
+    if (num_blocks > num_items) { num_blocks = num_items; }
+
+    if (num_blocks <= 1) {
+      if (num_items > 0) { f(NTYPE1(0), num_items); }
+      return;
+    }
+
+    std::vector<std::thread> thread_list;
+    std::vector<std::exception_ptr> error_list(num_blocks);
+
+    thread_list.reserve(num_blocks);
+    for (NTYPE1 j = 0; j < num_blocks; j++) {
+      const NTYPE1 k0 = (num_items*j)/num_blocks;
+      const NTYPE1 k1 = (num_items*(j+1))/num_blocks;
+      std::exception_ptr * error_ptr = &(error_list[j]);
+
+      thread_list.push_back
+        (std::thread([=, &f]() {
+            try { f(k0, k1); }
+            catch (...) { *error_ptr = std::current_exception(); }
+          }));
+    }
+
+    for (NTYPE1 j = 0; j < num_blocks; j++)
+      { thread_list[j].join(); }
+
+    for (NTYPE1 j = 0; j < num_blocks; j++) {
+      if (error_list[j]) { std::rethrow_exception(error_list[j]); }
+    }
+  }
+
+  /// Apply f(k) to each k in [0,num_items) using num_threads threads.
+  /// Calls to f(k) for different k must be independent.
+  template <typename NTYPE0, typename NTYPE1, typename FTYPE>
+  void apply_in_parallel
+  (const NTYPE0 num_threads, const NTYPE1 num_items, FTYPE f)
+  {
+    apply_to_blocks_in_parallel
+      (num_threads, num_items,
+       [&f](const NTYPE1 k0, const NTYPE1 k1) {
+        for (NTYPE1 k = k0; k < k1; k++) { f(k); }
+      });
+  }
+
+
+  // **************************************************
+  // PARALLEL COMPUTE, ORDERED OUTPUT
+  // **************************************************
+
+  /// Apply compute(k) to each k in [0,num_items) using num_threads
+  ///   worker threads and apply output(k) in the calling thread
+  ///   in increasing order of k.
+  /// output(k) runs as soon as compute(k) and output(k-1) finish,
+  ///   overlapping with compute() of later items.
+  /// At most max_pending items are computed or being computed
+  ///   but not yet output.  This bounds memory for computed results.
+  /// If num_threads <= 1, call compute(k) and output(k) 
+  ///   in the calling thread.
+  /// Exceptions thrown by compute(k) or output(k) are rethrown 
+  ///   in the calling thread after all worker threads finish.
+  template <typename NTYPE0, typename NTYPE1,
+            typename FTYPE0, typename FTYPE1>
+  void compute_in_parallel_output_in_order
+  (const NTYPE0 num_threads, const NTYPE1 num_items, 
+   const NTYPE1 max_pending, FTYPE0 compute, FTYPE1 output)
+  {
+    NTYPE1 num_workers = num_threads;
+
+    if (num_workers > num_items) { num_workers = num_items; }
+
+    if (num_workers <= 1) {
+      for (NTYPE1 k = 0; k < num_items; k++) {
+        compute(k);
+        output(k);
+      }
+      return;
+    }
+
+    std::mutex mutex;
+    std::condition_variable is_changed;
+    NTYPE1 next_to_compute = 0;
+    NTYPE1 next_to_output = 0;
+    bool flag_abort = false;
+    std::vector<bool> is_computed(num_items, false);
+    std::vector<std::exception_ptr> error_list(num_items);
+    std::vector<std::thread> thread_list;
+
+    auto worker = [&]() {
+      while (true) {
+        NTYPE1 k;
+        {
+          std::unique_lock<std::mutex> lock(mutex);
+          is_changed.wait(lock, [&]() {
+              return(flag_abort || next_to_compute >= num_items ||
+                     next_to_compute < next_to_output + max_pending);
+            });
+          if (flag_abort || next_to_compute >= num_items) { return; }
+          k = next_to_compute;
+          next_to_compute++;
+        }
+
+        std::exception_ptr error;
+        try { compute(k); }
+        catch (...) { error = std::current_exception(); }
+
+        {
+          std::lock_guard<std::mutex> lock(mutex);
+          error_list[k] = error;
+          is_computed[k] = true;
+        }
+        is_changed.notify_all();
+      }
+    };
+
+    auto stop_workers = [&]() {
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        flag_abort = true;
+      }
+      is_changed.notify_all();
+      for (std::size_t j = 0; j < thread_list.size(); j++)
+        { thread_list[j].join(); }
+    };
+
+    thread_list.reserve(num_workers);
+    for (NTYPE1 j = 0; j < num_workers; j++)
+      { thread_list.push_back(std::thread(worker)); }
+
+    try {
+      for (NTYPE1 k = 0; k < num_items; k++) {
+        {
+          std::unique_lock<std::mutex> lock(mutex);
+          is_changed.wait(lock, [&]() { return(bool(is_computed[k])); });
+          if (error_list[k]) { std::rethrow_exception(error_list[k]); }
+        }
+
+        output(k);
+
+        {
+          std::lock_guard<std::mutex> lock(mutex);
+          next_to_output = k+1;
+        }
+        is_changed.notify_all();
+      }
+    }
+    catch (...) {
+      stop_workers();
+      throw;
+    }
+
+    stop_workers();
+  }
+
+}
+
+#endif
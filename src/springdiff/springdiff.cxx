@@ -36,8 +36,7 @@ const float EPSILON = 0.0001;
 // local type definition
 namespace {
   
-  typedef IJK::BOOL_GRID_BASE<SHARPISO_GRID> BOOL_GRID_BASE;
-  typedef IJK::BOOL_GRID<SHARPISO_GRID> BOOL_GRID;
+  typedef IJK::BIT_GRID<SHARPISO_GRID> BIT_GRID;
   
 };
 
@@ -61,7 +60,7 @@ void compute_gradient_central_difference
   
   gradient_grid.SetSize(scalar_grid, dimension);
   
-  BOOL_GRID boundary_grid;
+  BIT_GRID boundary_grid;
   boundary_grid.SetSize(scalar_grid);
   compute_boundary_grid(boundary_grid);
   
@@ -202,7 +201,7 @@ void compute_spring_diffusion
   const int dimension = scalar_grid.Dimension();
   temp_gradient_grid.SetSize(scalar_grid, dimension);
   
-  BOOL_GRID boundary_grid;
+  BIT_GRID boundary_grid;
   boundary_grid.SetSize(scalar_grid);
   compute_boundary_grid(boundary_grid);
   
@@ -0,0 +1,525 @@
+/// Test BIT_GRID.
+/// Compare bit grids against reference scalar and boolean arrays
+///   on grids with random axis sizes.
+/// Usage: testbitgrid [-seed {S}] [-n {num_tests}]
+
+/*
+  IJK: Isosurface Jeneration Code
+  Copyright (C) 2015 Rephael Wenger
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License
+  (LGPL) as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include "sharpiso_grids.h"
+
+using namespace IJK;
+using namespace SHARPISO;
+using namespace std;
+
+
+// global variables
+long seed = 1;
+int num_tests = 20;
+
+// routines
+void set_random_grid(SHARPISO_GRID & grid);
+void test_set_range(const SHARPISO_GRID & grid);
+void test_set_ge(const SHARPISO_GRID & grid);
+void test_boundary_grid(const SHARPISO_GRID & grid);
+void test_set_region(const SHARPISO_GRID & grid);
+void test_logical_ops(const SHARPISO_GRID & grid);
+void test_count_and_find(const SHARPISO_GRID & grid);
+void test_count_bits_in_word();
+void set_random_bit_grid
+(const SHARPISO_GRID & grid, const int percent_true,
+ SHARPISO_BIT_GRID & bit_grid, std::vector<bool> & ref_flag);
+void check_bit_grid
+(const SHARPISO_BIT_GRID & bit_grid, const std::vector<bool> & ref_flag,
+ const char * msg);
+void parse_command_line(int argc, char **argv);
+void usage_error();
+
+
+int main(int argc, char **argv)
+{
+  try {
+    parse_command_line(argc, argv);
+    srandom(seed);
+
+    for (int i = 0; i < num_tests; i++) {
+      SHARPISO_GRID grid;
+      set_random_grid(grid);
+
+      test_set_range(grid);
+      test_set_ge(grid);
+      test_boundary_grid(grid);
+      test_set_region(grid);
+      test_logical_ops(grid);
+      test_count_and_find(grid);
+    }
+
+    test_count_bits_in_word();
+  }
+  catch (ERROR error) {
+    if (error.NumMessages() == 0) {
+      cerr << "Unknown error." << endl;
+    }
+    else { error.Print(cerr); }
+    cerr << "Exiting." << endl;
+    exit(20);
+  }
+  catch (...) {
+    cerr << "Unknown error." << endl;
+    exit(50);
+  };
+
+  cout << "Passed all tests." << endl;
+
+  return 0;
+}
+
+
+// Set grid to a 3D grid with random axis sizes.
+// Axis sizes are small, so rows cross word boundaries
+//   at many different offsets.
+void set_random_grid(SHARPISO_GRID & grid)
+{
+  AXIS_SIZE_TYPE axis_size[DIM3];
+
+  for (int d = 0; d < DIM3; d++)
+    { axis_size[d] = 2 + random()%70; }
+
+  grid.SetSize(DIM3, axis_size);
+}
+
+
+// **************************************************
+// Test Set, SetAll and SetRange
+// **************************************************
+
+// Set bit_grid to random values.
+// Each vertex is true with probability percent_true/100.
+void set_random_bit_grid
+(const SHARPISO_GRID & grid, const int percent_true,
+ SHARPISO_BIT_GRID & bit_grid, std::vector<bool> & ref_flag)
+{
+  const VERTEX_INDEX numv = grid.NumVertices();
+
+  bit_grid.SetSize(grid);
+  ref_flag.assign(numv, false);
+  for (VERTEX_INDEX iv = 0; iv < numv; iv++) {
+    const bool flag = (random()%100 < percent_true);
+    bit_grid.Set(iv, flag);
+    ref_flag[iv] = flag;
+  }
+}
+
+
+// Set and clear random ranges.  Check every vertex and Word().
+void test_set_range(const SHARPISO_GRID & grid)
+{
+  const VERTEX_INDEX numv = grid.NumVertices();
+  SHARPISO_BIT_GRID bit_grid;
+  std::vector<bool> ref_flag(numv, false);
+
+  bit_grid.SetSize(grid);
+  check_bit_grid(bit_grid, ref_flag, "After SetSize.");
+
+  for (int i = 0; i < 50; i++) {
+    const VERTEX_INDEX iv0 = random()%numv;
+    const VERTEX_INDEX iv1 = iv0 + random()%(numv-iv0+1);
+    const bool flag = (random()%2 == 0);
+
+    bit_grid.SetRange(iv0, iv1, flag);
+    for (VERTEX_INDEX iv = iv0; iv < iv1; iv++)
+      { ref_flag[iv] = flag; }
+  }
+  check_bit_grid(bit_grid, ref_flag, "After SetRange.");
+
+  for (int i = 0; i < 200; i++) {
+    const VERTEX_INDEX iv = random()%numv;
+    const bool flag = (random()%2 == 0);
+    bit_grid.Set(iv, flag);
+    ref_flag[iv] = flag;
+  }
+  check_bit_grid(bit_grid, ref_flag, "After Set.");
+
+  bit_grid.SetAll(true);
+  std::fill(ref_flag.begin(), ref_flag.end(), true);
+  check_bit_grid(bit_grid, ref_flag, "After SetAll(true).");
+
+  bit_grid.SetAll(false);
+  std::fill(ref_flag.begin(), ref_flag.end(), false);
+  check_bit_grid(bit_grid, ref_flag, "After SetAll(false).");
+}
+
+
+// **************************************************
+// Test SetGE and cube functions
+// **************************************************
+
+// Set bit grid from random scalar values, one word at a time
+//   and then all words.
+// Check every vertex, the cube table index of every cube and
+//   the mixed cube word of every cube.
+void test_set_ge(const SHARPISO_GRID & grid)
+{
+  const VERTEX_INDEX numv = grid.NumVertices();
+  const float isovalue = 5;
+  IJK::PROCEDURE_ERROR error("test_set_ge");
+  SHARPISO_BIT_GRID bit_grid;
+  std::vector<float> scalar(numv);
+  std::vector<bool> ref_flag(numv);
+
+  // Integer values, so some scalar values equal the isovalue.
+  for (VERTEX_INDEX iv = 0; iv < numv; iv++) {
+    scalar[iv] = random()%11;
+    ref_flag[iv] = (scalar[iv] >= isovalue);
+  }
+
+  // Set random words, then all words.
+  bit_grid.SetSize(grid);
+  std::vector<bool> ref_word_flag(numv, false);
+  for (int i = 0; i < 20; i++) {
+    const NUM_TYPE k = random()%bit_grid.NumWords();
+    bit_grid.SetGEInWord(&(scalar[0]), isovalue, k);
+    for (VERTEX_INDEX iv = k*BITS_PER_BIT_GRID_WORD;
+         iv < (k+1)*BITS_PER_BIT_GRID_WORD && iv < numv; iv++)
+      { ref_word_flag[iv] = ref_flag[iv]; }
+  }
+  check_bit_grid(bit_grid, ref_word_flag, "After SetGEInWord.");
+
+  bit_grid.SetGE(&(scalar[0]), isovalue);
+  check_bit_grid(bit_grid, ref_flag, "After SetGE.");
+
+  const NUM_TYPE num_cube_vertices = grid.NumCubeVertices();
+  const VERTEX_INDEX * increment = grid.CubeVertexIncrement();
+  const AXIS_SIZE_TYPE axis_size0 = grid.AxisSize(0);
+  GRID_COORD_TYPE coord[DIM3];
+
+  for (VERTEX_INDEX icube = 0; icube < numv; icube++) {
+
+    grid.ComputeCoord(icube, coord);
+    bool is_cube = true;
+    for (int d = 0; d < DIM3; d++) {
+      if (coord[d]+1 >= grid.AxisSize(d)) { is_cube = false; }
+    }
+    if (!is_cube) { continue; }
+
+    int ref_it = 0;
+    for (NUM_TYPE k = 0; k < num_cube_vertices; k++) {
+      if (ref_flag[icube+increment[k]]) { ref_it = (ref_it | (1 << k)); }
+    }
+
+    int it;
+    compute_cube_bit_index(bit_grid, icube, it);
+    if (it != ref_it) {
+      error.AddMessage("Incorrect cube index ", it, " for cube ", icube, ".");
+      error.AddMessage("  Expected cube index ", ref_it, ".");
+      throw error;
+    }
+
+    // Check mixed cube bits for cubes in the same row as icube.
+    const BIT_GRID_WORD w = compute_mixed_cube_word(bit_grid, icube);
+    const GRID_COORD_TYPE num_row_cubes =
+      std::min(GRID_COORD_TYPE(BITS_PER_BIT_GRID_WORD),
+               GRID_COORD_TYPE(axis_size0-1-coord[0]));
+    for (GRID_COORD_TYPE k = 0; k < num_row_cubes; k++) {
+      const VERTEX_INDEX icube2 = icube+k;
+      bool is_some_true = false;
+      bool is_some_false = false;
+      for (NUM_TYPE j = 0; j < num_cube_vertices; j++) {
+        if (ref_flag[icube2+increment[j]]) { is_some_true = true; }
+        else { is_some_false = true; }
+      }
+
+      const bool is_mixed = (((w >> k) & 1) != 0);
+      if (is_mixed != (is_some_true && is_some_false)) {
+        error.AddMessage("Incorrect mixed cube flag ", int(is_mixed),
+                         " for cube ", icube2, ".");
+        error.AddMessage("  Computed from word of cube ", icube, ".");
+        throw error;
+      }
+    }
+  }
+}
+
+
+// **************************************************
+// Test compute_boundary_grid
+// **************************************************
+
+void test_boundary_grid(const SHARPISO_GRID & grid)
+{
+  const VERTEX_INDEX numv = grid.NumVertices();
+  SHARPISO_BIT_GRID boundary_grid;
+  std::vector<bool> ref_flag(numv, false);
+  GRID_COORD_TYPE coord[DIM3];
+
+  for (VERTEX_INDEX iv = 0; iv < numv; iv++) {
+    grid.ComputeCoord(iv, coord);
+    for (int d = 0; d < DIM3; d++) {
+      if (coord[d] == 0 || coord[d]+1 == grid.AxisSize(d))
+        { ref_flag[iv] = true; }
+    }
+  }
+
+  boundary_grid.SetSize(grid);
+  boundary_grid.SetAll(true);
+  compute_boundary_grid(boundary_grid);
+  check_bit_grid(boundary_grid, ref_flag, "After compute_boundary_grid.");
+}
+
+
+// **************************************************
+// Test SetRegion
+// **************************************************
+
+// Set and clear random boxes.  Boxes include single vertices,
+//   rows and the full grid.
+void test_set_region(const SHARPISO_GRID & grid)
+{
+  const VERTEX_INDEX numv = grid.NumVertices();
+  SHARPISO_BIT_GRID bit_grid;
+  std::vector<bool> ref_flag;
+  IJK::BOX<GRID_COORD_TYPE> box(DIM3);
+  GRID_COORD_TYPE coord[DIM3];
+
+  set_random_bit_grid(grid, 50, bit_grid, ref_flag);
+
+  for (int i = 0; i < 20; i++) {
+    const bool flag = (random()%2 == 0);
+
+    for (int d = 0; d < DIM3; d++) {
+      const GRID_COORD_TYPE c0 = random()%grid.AxisSize(d);
+      GRID_COORD_TYPE c1 = c0 + random()%(grid.AxisSize(d)-c0);
+      if (i == 0) { c1 = c0; }
+      box.SetMinCoord(d, c0);
+      box.SetMaxCoord(d, c1);
+    }
+
+    if (i == 1) {
+      for (int d = 0; d < DIM3; d++) {
+        box.SetMinCoord(d, 0);
+        box.SetMaxCoord(d, grid.AxisSize(d)-1);
+      }
+    }
+
+    bit_grid.SetRegion(box, flag);
+    for (VERTEX_INDEX iv = 0; iv < numv; iv++) {
+      grid.ComputeCoord(iv, coord);
+      bool is_in_box = true;
+      for (int d = 0; d < DIM3; d++) {
+        if (coord[d] < box.MinCoord(d) || coord[d] > box.MaxCoord(d))
+          { is_in_box = false; }
+      }
+      if (is_in_box) { ref_flag[iv] = flag; }
+    }
+    check_bit_grid(bit_grid, ref_flag, "After SetRegion.");
+  }
+}
+
+
+// **************************************************
+// Test Or, And and AndNot
+// **************************************************
+
+void test_logical_ops(const SHARPISO_GRID & grid)
+{
+  const VERTEX_INDEX numv = grid.NumVertices();
+  SHARPISO_BIT_GRID bit_grid, bit_grid2;
+  std::vector<bool> ref_flag, ref_flag2;
+
+  set_random_bit_grid(grid, 50, bit_grid, ref_flag);
+  set_random_bit_grid(grid, 50, bit_grid2, ref_flag2);
+
+  bit_grid.Or(bit_grid2);
+  for (VERTEX_INDEX iv = 0; iv < numv; iv++)
+    { ref_flag[iv] = (ref_flag[iv] || ref_flag2[iv]); }
+  check_bit_grid(bit_grid, ref_flag, "After Or.");
+
+  set_random_bit_grid(grid, 50, bit_grid2, ref_flag2);
+  bit_grid.And(bit_grid2);
+  for (VERTEX_INDEX iv = 0; iv < numv; iv++)
+    { ref_flag[iv] = (ref_flag[iv] && ref_flag2[iv]); }
+  check_bit_grid(bit_grid, ref_flag, "After And.");
+
+  set_random_bit_grid(grid, 50, bit_grid, ref_flag);
+  set_random_bit_grid(grid, 50, bit_grid2, ref_flag2);
+  bit_grid.AndNot(bit_grid2);
+  for (VERTEX_INDEX iv = 0; iv < numv; iv++)
+    { ref_flag[iv] = (ref_flag[iv] && !ref_flag2[iv]); }
+  check_bit_grid(bit_grid, ref_flag, "After AndNot.");
+
+  // AndNot with itself clears the grid.
+  bit_grid.AndNot(bit_grid);
+  std::fill(ref_flag.begin(), ref_flag.end(), false);
+  check_bit_grid(bit_grid, ref_flag, "After AndNot with itself.");
+}
+
+
+// **************************************************
+// Test CountTrue, FindNextTrue and IsSomeTrue
+// **************************************************
+
+// Use sparse and dense grids, so FindNextTrue skips empty words.
+void test_count_and_find(const SHARPISO_GRID & grid)
+{
+  const VERTEX_INDEX numv = grid.NumVertices();
+  const int percent_true[] = { 0, 1, 50, 100 };
+  const int num_percent = sizeof(percent_true)/sizeof(int);
+  IJK::PROCEDURE_ERROR error("test_count_and_find");
+  SHARPISO_BIT_GRID bit_grid;
+  std::vector<bool> ref_flag;
+
+  for (int i = 0; i < num_percent; i++) {
+    set_random_bit_grid(grid, percent_true[i], bit_grid, ref_flag);
+
+    // Compute next true vertex from the end.
+    std::vector<VERTEX_INDEX> ref_next(numv+1, numv);
+    for (VERTEX_INDEX iv = numv; iv > 0; iv--) {
+      if (ref_flag[iv-1]) { ref_next[iv-1] = iv-1; }
+      else { ref_next[iv-1] = ref_next[iv]; }
+    }
+
+    const NUM_TYPE ref_count =
+      std::count(ref_flag.begin(), ref_flag.end(), true);
+    if (bit_grid.CountTrue() != ref_count) {
+      error.AddMessage("Incorrect CountTrue() ", bit_grid.CountTrue(), ".");
+      error.AddMessage("  Expected ", ref_count, ".");
+      throw error;
+    }
+
+    for (VERTEX_INDEX iv = 0; iv <= numv; iv++) {
+      if (bit_grid.FindNextTrue(iv) != ref_next[iv]) {
+        error.AddMessage("Incorrect FindNextTrue(", iv, ") ",
+                         bit_grid.FindNextTrue(iv), ".");
+        error.AddMessage("  Expected ", ref_next[iv], ".");
+        throw error;
+      }
+    }
+
+    for (int j = 0; j < 200; j++) {
+      const VERTEX_INDEX iv0 = random()%numv;
+      const VERTEX_INDEX iv1 = iv0 + random()%(numv-iv0+1);
+      const bool ref_is_some_true = (ref_next[iv0] < iv1);
+      if (bit_grid.IsSomeTrue(iv0, iv1) != ref_is_some_true) {
+        error.AddMessage("Incorrect IsSomeTrue(", iv0, ",", iv1, ") ",
+                         int(bit_grid.IsSomeTrue(iv0, iv1)), ".");
+        throw error;
+      }
+    }
+  }
+}
+
+
+// Compare count_bits_in_word with counting one bit at a time.
+void test_count_bits_in_word()
+{
+  IJK::PROCEDURE_ERROR error("test_count_bits_in_word");
+
+  for (int i = 0; i < 1000; i++) {
+    BIT_GRID_WORD w = 0;
+    const int k = random()%(BITS_PER_BIT_GRID_WORD+1);
+    for (int j = 0; j < BITS_PER_BIT_GRID_WORD; j++) {
+      // Random bits, or bits 0,...,k-1 set.
+      const bool flag = (i%2 == 0) ? (random()%2 == 0) : (j < k);
+      if (flag) { w = (w | (BIT_GRID_WORD(1) << j)); }
+    }
+
+    int ref_num_bits = 0;
+    for (int j = 0; j < BITS_PER_BIT_GRID_WORD; j++)
+      { if ((w >> j) & 1) { ref_num_bits++; } }
+
+    if (count_bits_in_word(w) != ref_num_bits) {
+      error.AddMessage("Incorrect count_bits_in_word ",
+                       count_bits_in_word(w), ".");
+      error.AddMessage("  Expected ", ref_num_bits, ".");
+      throw error;
+    }
+  }
+}
+
+
+// **************************************************
+// Check routines
+// **************************************************
+
+// Check Scalar() and Word() of every vertex against ref_flag[].
+// Check that bits past the last vertex are zero.
+void check_bit_grid
+(const SHARPISO_BIT_GRID & bit_grid, const std::vector<bool> & ref_flag,
+ const char * msg)
+{
+  const VERTEX_INDEX numv = bit_grid.NumVertices();
+  IJK::PROCEDURE_ERROR error("check_bit_grid");
+
+  for (VERTEX_INDEX iv = 0; iv < numv; iv++) {
+    if (bit_grid.Scalar(iv) != ref_flag[iv]) {
+      error.AddMessage(msg);
+      error.AddMessage("  Incorrect value ", int(bit_grid.Scalar(iv)),
+                       " for vertex ", iv, ".");
+      throw error;
+    }
+
+    const BIT_GRID_WORD w = bit_grid.Word(iv);
+    for (int k = 0; k < BITS_PER_BIT_GRID_WORD; k++) {
+      const bool ref_bit = (iv+k < numv) && ref_flag[iv+k];
+      if ((((w >> k) & 1) != 0) != ref_bit) {
+        error.AddMessage(msg);
+        error.AddMessage("  Incorrect bit ", k, " of word of vertex ", iv, ".");
+        throw error;
+      }
+    }
+  }
+}
+
+
+// **************************************************
+// Parse command line
+// **************************************************
+
+void parse_command_line(int argc, char **argv)
+{
+  int iarg = 1;
+
+  while (iarg < argc) {
+    if (strcmp(argv[iarg], "-seed") == 0) {
+      iarg++;
+      if (iarg >= argc) { usage_error(); }
+      seed = atol(argv[iarg]);
+    }
+    else if (strcmp(argv[iarg], "-n") == 0) {
+      iarg++;
+      if (iarg >= argc) { usage_error(); }
+      num_tests = atoi(argv[iarg]);
+    }
+    else { usage_error(); }
+    iarg++;
+  }
+}
+
+void usage_error()
+{
+  cerr << "Usage: testbitgrid [-seed {S}] [-n {num_tests}]" << endl;
+  exit(10);
+}
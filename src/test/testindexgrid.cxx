@@ -0,0 +1,291 @@
+/// Test GCUBE_INDEX_GRID and INDEX_HASH_TABLE.
+/// Compare dense and sparse cube index grids against a reference array.
+/// Usage: testindexgrid [-seed {S}]
+
+/*
+  IJK: Isosurface Jeneration Code
+  Copyright (C) 2015 Rephael Wenger
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License
+  (LGPL) as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include "sharpiso_grids.h"
+#include "shrec_isovert.h"
+
+using namespace IJK;
+using namespace SHARPISO;
+using namespace SHREC;
+using namespace std;
+
+
+// global variables
+long seed = 1;
+
+// routines
+void test_index_hash_table();
+void test_index_hash_table_large_keys();
+void test_gcube_index_grid(const bool flag_sparse);
+void check_index_hash_table
+(const INDEX_HASH_TABLE<VERTEX_INDEX> & table,
+ const std::vector<INDEX_DIFF_TYPE> & ref_index, const char * msg);
+void check_gcube_index_grid
+(const GCUBE_INDEX_GRID & index_grid,
+ const std::vector<INDEX_DIFF_TYPE> & ref_index, const char * msg);
+void parse_command_line(int argc, char **argv);
+void usage_error();
+
+
+int main(int argc, char **argv)
+{
+  try {
+    parse_command_line(argc, argv);
+    srandom(seed);
+
+    test_index_hash_table();
+    test_index_hash_table_large_keys();
+    test_gcube_index_grid(false);
+    test_gcube_index_grid(true);
+  }
+  catch (ERROR error) {
+    if (error.NumMessages() == 0) {
+      cerr << "Unknown error." << endl;
+    }
+    else { error.Print(cerr); }
+    cerr << "Exiting." << endl;
+    exit(20);
+  }
+  catch (...) {
+    cerr << "Unknown error." << endl;
+    exit(50);
+  };
+
+  cout << "Passed all tests." << endl;
+
+  return 0;
+}
+
+
+// **************************************************
+// Test INDEX_HASH_TABLE
+// **************************************************
+
+// Insert, overwrite and remove random keys.
+// Check every key in [0,max_key) after each phase.
+void test_index_hash_table()
+{
+  const NUM_TYPE max_key = 20000;
+  const NUM_TYPE num_insert = 3000;
+  INDEX_HASH_TABLE<VERTEX_INDEX> table;
+  std::vector<INDEX_DIFF_TYPE> ref_index(max_key, -1);
+
+  check_index_hash_table(table, ref_index, "Empty table.");
+
+  // Table starts with two blocks, so inserting forces many rehashes.
+  for (NUM_TYPE i = 0; i < num_insert; i++) {
+    const VERTEX_INDEX k = random()%max_key;
+    table.Insert(k, i);
+    ref_index[k] = i;
+  }
+  check_index_hash_table(table, ref_index, "After insert.");
+
+  // Overwrite half of the stored keys and remove some others.
+  for (NUM_TYPE k = 0; k < max_key; k++) {
+    if (ref_index[k] < 0) { continue; }
+
+    if (random()%2 == 0) {
+      table.Insert(k, ref_index[k]+num_insert);
+      ref_index[k] += num_insert;
+    }
+    else if (random()%4 == 0) {
+      table.Insert(k, -1);
+      ref_index[k] = -1;
+    }
+  }
+  check_index_hash_table(table, ref_index, "After overwrite and remove.");
+
+  // Reserve rehashes into a larger table.  Indices must not change.
+  table.Reserve(4*max_key);
+  check_index_hash_table(table, ref_index, "After reserve.");
+
+  table.Clear();
+  std::fill(ref_index.begin(), ref_index.end(), -1);
+  check_index_hash_table(table, ref_index, "After clear.");
+
+  // Consecutive keys share blocks.
+  for (NUM_TYPE k = 100; k < 300; k++) {
+    table.Insert(k, 2*k);
+    ref_index[k] = 2*k;
+  }
+  check_index_hash_table(table, ref_index, "After insert consecutive keys.");
+}
+
+// Test keys larger than 2^32, such as edge keys of large grids.
+void test_index_hash_table_large_keys()
+{
+  typedef long long KEY_TYPE;
+  const KEY_TYPE base_key = (KEY_TYPE(1) << 40);
+  const NUM_TYPE num_keys = 1000;
+  const NUM_TYPE key_step = 37;
+  INDEX_HASH_TABLE<KEY_TYPE> table;
+  IJK::PROCEDURE_ERROR error("test_index_hash_table_large_keys");
+
+  for (NUM_TYPE i = 0; i < num_keys; i++)
+    { table.Insert(base_key+i*key_step, i); }
+
+  if (table.NumKeys() != num_keys) {
+    error.AddMessage("Incorrect number of keys ", table.NumKeys(), ".");
+    error.AddMessage("  Expected ", num_keys, " keys.");
+    throw error;
+  }
+
+  for (NUM_TYPE i = 0; i < num_keys*key_step; i++) {
+    const KEY_TYPE k = base_key+i;
+    const INDEX_DIFF_TYPE index = table.Find(k);
+    INDEX_DIFF_TYPE expected = -1;
+    if (i%key_step == 0) { expected = i/key_step; }
+
+    if (index != expected) {
+      error.AddMessage("Incorrect index ", index, " for key ", k, ".");
+      error.AddMessage("  Expected index ", expected, ".");
+      throw error;
+    }
+
+    // Keys differing only in the high bits must not match.
+    if (table.Find(i) != -1) {
+      error.AddMessage("Key ", KEY_TYPE(i), " should not be stored.");
+      throw error;
+    }
+  }
+}
+
+
+// **************************************************
+// Test GCUBE_INDEX_GRID
+// **************************************************
+
+// Set random cubes and check every grid vertex.
+// Check that SetGrid() resets all indices to -1.
+void test_gcube_index_grid(const bool flag_sparse)
+{
+  const AXIS_SIZE_TYPE axis_size[DIM3] = { 23, 17, 31 };
+  SHARPISO_GRID grid(DIM3, axis_size);
+  GCUBE_INDEX_GRID index_grid;
+  std::vector<INDEX_DIFF_TYPE> ref_index(grid.NumVertices(), -1);
+  NUM_TYPE num_active = 0;
+
+  index_grid.SetGrid(grid, flag_sparse);
+  if (index_grid.IsSparse() != flag_sparse) {
+    IJK::PROCEDURE_ERROR error("test_gcube_index_grid");
+    error.AddMessage("Incorrect IsSparse() value.");
+    throw error;
+  }
+  check_gcube_index_grid(index_grid, ref_index, "Empty grid.");
+
+  // Set cubes in increasing order, as create_active_cubes does.
+  for (VERTEX_INDEX iv = 0; iv < grid.NumVertices(); iv++) {
+    if (random()%8 == 0) {
+      index_grid.Set(iv, num_active);
+      ref_index[iv] = num_active;
+      num_active++;
+    }
+  }
+  check_gcube_index_grid(index_grid, ref_index, "After set.");
+
+  index_grid.SetGrid(grid, flag_sparse);
+  std::fill(ref_index.begin(), ref_index.end(), -1);
+  check_gcube_index_grid(index_grid, ref_index, "After reset.");
+}
+
+
+// **************************************************
+// Check routines
+// **************************************************
+
+void check_index_hash_table
+(const INDEX_HASH_TABLE<VERTEX_INDEX> & table,
+ const std::vector<INDEX_DIFF_TYPE> & ref_index, const char * msg)
+{
+  IJK::PROCEDURE_ERROR error("check_index_hash_table");
+  NUM_TYPE num_keys = 0;
+
+  for (std::size_t k = 0; k < ref_index.size(); k++) {
+    const INDEX_DIFF_TYPE index = table.Find(k);
+    if (index != ref_index[k]) {
+      error.AddMessage(msg);
+      error.AddMessage("  Incorrect index ", index, " for key ", k, ".");
+      error.AddMessage("  Expected index ", ref_index[k], ".");
+      throw error;
+    }
+    if (ref_index[k] >= 0) { num_keys++; }
+  }
+
+  if (table.NumKeys() != num_keys) {
+    error.AddMessage(msg);
+    error.AddMessage("  Incorrect number of keys ", table.NumKeys(), ".");
+    error.AddMessage("  Expected ", num_keys, " keys.");
+    throw error;
+  }
+}
+
+void check_gcube_index_grid
+(const GCUBE_INDEX_GRID & index_grid,
+ const std::vector<INDEX_DIFF_TYPE> & ref_index, const char * msg)
+{
+  IJK::PROCEDURE_ERROR error("check_gcube_index_grid");
+
+  for (VERTEX_INDEX iv = 0; iv < index_grid.NumVertices(); iv++) {
+    const INDEX_DIFF_TYPE index = index_grid.Scalar(iv);
+    if (index != ref_index[iv]) {
+      error.AddMessage(msg);
+      if (index_grid.IsSparse()) { error.AddMessage("  Sparse index grid."); }
+      else { error.AddMessage("  Dense index grid."); }
+      error.AddMessage("  Incorrect index ", index, " for cube ", iv, ".");
+      error.AddMessage("  Expected index ", ref_index[iv], ".");
+      throw error;
+    }
+  }
+}
+
+
+// **************************************************
+// Parse command line
+// **************************************************
+
+void parse_command_line(int argc, char **argv)
+{
+  int iarg = 1;
+
+  while (iarg < argc) {
+    if (strcmp(argv[iarg], "-seed") == 0) {
+      iarg++;
+      if (iarg >= argc) { usage_error(); }
+      seed = atol(argv[iarg]);
+    }
+    else { usage_error(); }
+    iarg++;
+  }
+}
+
+void usage_error()
+{
+  cerr << "Usage: testindexgrid [-seed {S}]" << endl;
+  exit(10);
+}
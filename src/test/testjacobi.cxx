@@ -0,0 +1,464 @@
+/// Test compute_sym_eigen_jacobi_3x3.
+/// Compare the Jacobi eigen-decomposition and the Jacobi QEF solver
+///   against Eigen JacobiSVD on random symmetric 3x3 matrices.
+/// Usage: testjacobi [-seed {S}] [-n {num_tests}]
+
+/*
+  IJK: Isosurface Jeneration Code
+  Copyright (C) 2015 Rephael Wenger
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License
+  (LGPL) as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#include "ijk.txx"
+#include "ijkcoord.txx"
+#include "sharpiso_svd.h"
+
+using namespace IJK;
+using namespace std;
+
+
+// global variables
+long seed = 1;
+int num_tests = 1000;
+
+// types
+typedef enum { SPD_MATRIX, RANK1_MATRIX, RANK2_MATRIX,
+               NEAR_DEGENERATE_MATRIX } MATRIX_TYPE;
+const int NUM_MATRIX_TYPES = 4;
+
+// routines
+void test_jacobi_eigen(const MATRIX_TYPE matrix_type);
+void test_jacobi_qef(const int num_planes);
+void generate_matrix(const MATRIX_TYPE matrix_type, SCALAR_TYPE A[DIM3*DIM3]);
+void check_eigen(const MATRIX_TYPE matrix_type, const SCALAR_TYPE A[DIM3*DIM3],
+                 const double eigenvalues[DIM3], const double V[DIM3*DIM3]);
+void add_outer_product
+(const double w, const double u[DIM3], SCALAR_TYPE A[DIM3*DIM3]);
+void random_unit_vector(double u[DIM3]);
+void random_unit_vector(COORD_TYPE u[DIM3]);
+double random_double();
+const char * matrix_type_name(const MATRIX_TYPE matrix_type);
+void parse_command_line(int argc, char **argv);
+void usage_error();
+
+
+int main(int argc, char **argv)
+{
+  try {
+    parse_command_line(argc, argv);
+    srandom(seed);
+
+    for (int i = 0; i < num_tests; i++) {
+      for (int j = 0; j < NUM_MATRIX_TYPES; j++)
+        { test_jacobi_eigen(MATRIX_TYPE(j)); }
+    }
+
+    for (int i = 0; i < num_tests; i++) {
+      for (int num_planes = 1; num_planes <= DIM3; num_planes++)
+        { test_jacobi_qef(num_planes); }
+    }
+  }
+  catch (ERROR error) {
+    if (error.NumMessages() == 0) {
+      cerr << "Unknown error." << endl;
+    }
+    else { error.Print(cerr); }
+    cerr << "Exiting." << endl;
+    exit(20);
+  }
+  catch (...) {
+    cerr << "Unknown error." << endl;
+    exit(50);
+  };
+
+  cout << "Passed all tests." << endl;
+
+  return 0;
+}
+
+
+// **************************************************
+// Test routines
+// **************************************************
+
+// Compute eigenvalues and eigenvectors of a random matrix
+//   using Jacobi rotations and check against Eigen.
+void test_jacobi_eigen(const MATRIX_TYPE matrix_type)
+{
+  IJK::PROCEDURE_ERROR error("test_jacobi_eigen");
+  SCALAR_TYPE A[DIM3*DIM3];
+  double eigenvalues[DIM3];
+  double V[DIM3*DIM3];
+  int num_sweeps;
+
+  generate_matrix(matrix_type, A);
+
+  const bool flag_converged =
+    compute_sym_eigen_jacobi_3x3(A, eigenvalues, V, num_sweeps);
+
+  if (!flag_converged || num_sweeps > MAX_JACOBI_SWEEPS_3x3) {
+    error.AddMessage("Jacobi rotations did not converge in ",
+                     MAX_JACOBI_SWEEPS_3x3, " sweeps.");
+    error.AddMessage("  Matrix type: ", matrix_type_name(matrix_type), ".");
+    error.AddMessage("  Number of sweeps: ", num_sweeps, ".");
+    throw error;
+  }
+
+  check_eigen(matrix_type, A, eigenvalues, V);
+}
+
+
+// Compute a sharp point from gradients on num_planes planes
+//   using QEF_SOLVER_JACOBI and QEF_SOLVER_SVD.  Results must agree.
+void test_jacobi_qef(const int num_planes)
+{
+  const int NUM_VERT = 8;
+  const EIGENVALUE_TYPE err_tolerance = 0.01;
+  const SCALAR_TYPE isovalue = 0.5;
+  const double tolerance = 1.0e-4;
+  const COORD_TYPE pointX[DIM3] = { 0.5, 0.5, 0.5 };
+  IJK::PROCEDURE_ERROR error("test_jacobi_qef");
+  COORD_TYPE normal[DIM3][DIM3];
+  COORD_TYPE center[DIM3][DIM3];
+  COORD_TYPE vert_coords[NUM_VERT*DIM3];
+  SCALAR_TYPE vert_scalars[NUM_VERT];
+  GRADIENT_COORD_TYPE vert_grads[NUM_VERT*DIM3];
+  NUM_TYPE num_svals[2];
+  EIGENVALUE_TYPE svals[2][DIM3];
+  COORD_TYPE coord[2][DIM3];
+  COORD_TYPE edge_dir[2][DIM3];
+  COORD_TYPE orth_dir[2][DIM3];
+  const QEF_SOLVER_TYPE qef_solver[2] =
+    { QEF_SOLVER_SVD, QEF_SOLVER_JACOBI };
+
+  // Keep plane normals well separated so that the number of
+  //   singular values above err_tolerance is unambiguous.
+  bool flag_separated = false;
+  while (!flag_separated) {
+    flag_separated = true;
+    for (int j = 0; j < num_planes; j++) {
+      random_unit_vector(normal[j]);
+      for (int d = 0; d < DIM3; d++)
+        { center[j][d] = random_double(); }
+    }
+
+    for (int j0 = 0; j0 < num_planes; j0++) {
+      for (int j1 = j0+1; j1 < num_planes; j1++) {
+        COORD_TYPE x;
+        IJK::compute_inner_product_3D(normal[j0], normal[j1], x);
+        if (std::abs(x) > 0.5) { flag_separated = false; }
+      }
+    }
+
+    if (num_planes == DIM3) {
+      COORD_TYPE w[DIM3], x;
+      IJK::compute_cross_product_3D(normal[0], normal[1], w);
+      IJK::compute_inner_product_3D(w, normal[2], x);
+      if (std::abs(x) < 0.5) { flag_separated = false; }
+    }
+  }
+
+  // Assign cube vertices to planes.  
+  // Each plane has at least two vertices.
+  for (int iv = 0; iv < NUM_VERT; iv++) {
+    const int j = iv%num_planes;
+    COORD_TYPE * vcoord = vert_coords + iv*DIM3;
+    for (int d = 0; d < DIM3; d++)
+      { vcoord[d] = ((iv >> d) & 1); }
+
+    COORD_TYPE x[DIM3], s;
+    IJK::subtract_coord_3D(vcoord, center[j], x);
+    IJK::compute_inner_product_3D(normal[j], x, s);
+    vert_scalars[iv] = isovalue + s;
+    IJK::copy_coord_3D(normal[j], vert_grads+iv*DIM3);
+  }
+
+  for (int k = 0; k < 2; k++) {
+    svd_calculate_sharpiso_vertex_using_lindstrom_fast
+      (NUM_VERT, err_tolerance, qef_solver[k], isovalue,
+       vert_scalars, vert_coords, vert_grads, pointX,
+       num_svals[k], svals[k], coord[k], edge_dir[k], orth_dir[k]);
+  }
+
+  if (num_svals[0] != num_planes || num_svals[1] != num_planes) {
+    error.AddMessage("Incorrect number of singular values.");
+    error.AddMessage("  Number of planes: ", num_planes, ".");
+    error.AddMessage("  SVD: ", num_svals[0], ".  Jacobi: ",
+                     num_svals[1], ".");
+    error.AddMessage("  SVD singular values: ", svals[0][0], " ",
+                     svals[0][1], " ", svals[0][2], ".");
+    throw error;
+  }
+
+  for (int d = 0; d < DIM3; d++) {
+    if (std::abs(svals[0][d] - svals[1][d]) > tolerance*svals[0][0]) {
+      error.AddMessage("Singular values differ.");
+      error.AddMessage("  SVD: ", svals[0][0], " ", svals[0][1], " ",
+                       svals[0][2], ".");
+      error.AddMessage("  Jacobi: ", svals[1][0], " ", svals[1][1], " ",
+                       svals[1][2], ".");
+      throw error;
+    }
+
+    if (std::abs(coord[0][d] - coord[1][d]) > tolerance) {
+      error.AddMessage("Sharp point coordinates differ.");
+      error.AddMessage("  Number of planes: ", num_planes, ".");
+      error.AddMessage("  SVD: (", coord[0][0], ",", coord[0][1], ",",
+                       coord[0][2], ").");
+      error.AddMessage("  Jacobi: (", coord[1][0], ",", coord[1][1], ",",
+                       coord[1][2], ").");
+      throw error;
+    }
+  }
+
+  // Directions are unique up to sign.
+  COORD_TYPE edge_iprod, orth_iprod;
+  IJK::compute_inner_product_3D(edge_dir[0], edge_dir[1], edge_iprod);
+  IJK::compute_inner_product_3D(orth_dir[0], orth_dir[1], orth_iprod);
+
+  if (num_planes == 2 && std::abs(edge_iprod) < 1-tolerance) {
+    error.AddMessage("Edge directions differ.");
+    error.AddMessage("  SVD: (", edge_dir[0][0], ",", edge_dir[0][1], ",",
+                     edge_dir[0][2], ").");
+    error.AddMessage("  Jacobi: (", edge_dir[1][0], ",", edge_dir[1][1], ",",
+                     edge_dir[1][2], ").");
+    throw error;
+  }
+
+  if (num_planes == 1 && std::abs(orth_iprod) < 1-tolerance) {
+    error.AddMessage("Orthogonal directions differ.");
+    error.AddMessage("  SVD: (", orth_dir[0][0], ",", orth_dir[0][1], ",",
+                     orth_dir[0][2], ").");
+    error.AddMessage("  Jacobi: (", orth_dir[1][0], ",", orth_dir[1][1], ",",
+                     orth_dir[1][2], ").");
+    throw error;
+  }
+}
+
+
+// **************************************************
+// Generate matrices
+// **************************************************
+
+// Generate random symmetric matrix of type matrix_type.
+void generate_matrix(const MATRIX_TYPE matrix_type, SCALAR_TYPE A[DIM3*DIM3])
+{
+  double u[DIM3];
+
+  IJK::set_coord(DIM3*DIM3, 0, A);
+
+  switch(matrix_type) {
+
+  case SPD_MATRIX:
+    // Sum of outer products of several gradients, as in compute_A_B.
+    for (int k = 0; k < 8; k++) {
+      random_unit_vector(u);
+      add_outer_product(1, u, A);
+    }
+    break;
+
+  case RANK1_MATRIX:
+    random_unit_vector(u);
+    add_outer_product(1+7*random_double(), u, A);
+    break;
+
+  case RANK2_MATRIX:
+    {
+      // Several gradients in the plane spanned by u0 and u1.
+      double u0[DIM3], u1[DIM3];
+      random_unit_vector(u0);
+      random_unit_vector(u1);
+      for (int k = 0; k < 8; k++) {
+        const double t = 2*M_PI*random_double();
+        for (int d = 0; d < DIM3; d++)
+          { u[d] = std::cos(t)*u0[d] + std::sin(t)*u1[d]; }
+        add_outer_product(1, u, A);
+      }
+    }
+    break;
+
+  case NEAR_DEGENERATE_MATRIX:
+  default:
+    {
+      // Two or three nearly equal eigenvalues.
+      const double eps = 1.0e-5*random_double();
+      random_unit_vector(u);
+      A[0] = A[4] = A[8] = 4;
+      add_outer_product(eps, u, A);
+      random_unit_vector(u);
+      add_outer_product((random()%2)*(1+random_double()), u, A);
+    }
+    break;
+  }
+}
+
+
+// Add w*u*u^T to A.
+void add_outer_product
+(const double w, const double u[DIM3], SCALAR_TYPE A[DIM3*DIM3])
+{
+  for (int i = 0; i < DIM3; i++) {
+    for (int j = 0; j < DIM3; j++)
+      { A[i*DIM3+j] += w*u[i]*u[j]; }
+  }
+}
+
+
+// **************************************************
+// Check routines
+// **************************************************
+
+// Check eigenvalues against Eigen JacobiSVD singular values.
+// Check that V is orthonormal and that A*V = V*diag(eigenvalues).
+void check_eigen(const MATRIX_TYPE matrix_type, const SCALAR_TYPE A[DIM3*DIM3],
+                 const double eigenvalues[DIM3], const double V[DIM3*DIM3])
+{
+  const double tolerance = 1.0e-5;
+  IJK::PROCEDURE_ERROR error("check_eigen");
+  Matrix3d eigenA;
+
+  for (int i = 0; i < DIM3; i++) {
+    for (int j = 0; j < DIM3; j++)
+      { eigenA(i,j) = A[i*DIM3+j]; }
+  }
+
+  JacobiSVD<Matrix3d> svd(eigenA);
+  const Vector3d svals = svd.singularValues();
+  const double scale = std::max(svals[0], 1.0);
+
+  for (int k = 0; k < DIM3; k++) {
+    if (std::abs(std::abs(eigenvalues[k]) - svals[k]) > tolerance*scale) {
+      error.AddMessage("Eigenvalues do not match Eigen singular values.");
+      error.AddMessage("  Matrix type: ", matrix_type_name(matrix_type), ".");
+      error.AddMessage("  Jacobi: ", eigenvalues[0], " ", eigenvalues[1],
+                       " ", eigenvalues[2], ".");
+      error.AddMessage("  Eigen: ", svals[0], " ", svals[1], " ",
+                       svals[2], ".");
+      throw error;
+    }
+  }
+
+  for (int k0 = 0; k0 < DIM3; k0++) {
+    for (int k1 = 0; k1 < DIM3; k1++) {
+      double x = 0;
+      for (int i = 0; i < DIM3; i++)
+        { x += V[i*DIM3+k0]*V[i*DIM3+k1]; }
+      const double expected = ((k0 == k1) ? 1 : 0);
+      if (std::abs(x - expected) > tolerance) {
+        error.AddMessage("Eigenvectors are not orthonormal.");
+        error.AddMessage("  Matrix type: ", matrix_type_name(matrix_type),
+                         ".");
+        error.AddMessage("  Inner product of columns ", k0, " and ", k1,
+                         " is ", x, ".");
+        throw error;
+      }
+    }
+  }
+
+  for (int k = 0; k < DIM3; k++) {
+    for (int i = 0; i < DIM3; i++) {
+      double x = -eigenvalues[k]*V[i*DIM3+k];
+      for (int j = 0; j < DIM3; j++)
+        { x += A[i*DIM3+j]*V[j*DIM3+k]; }
+      if (std::abs(x) > tolerance*scale) {
+        error.AddMessage("Column ", k, " of V is not an eigenvector.");
+        error.AddMessage("  Matrix type: ", matrix_type_name(matrix_type),
+                         ".");
+        error.AddMessage("  Eigenvalue: ", eigenvalues[k],
+                         ".  Residual: ", x, ".");
+        throw error;
+      }
+    }
+  }
+}
+
+
+// **************************************************
+// Utility routines
+// **************************************************
+
+double random_double()
+{
+  return(double(random())/double(RAND_MAX));
+}
+
+void random_unit_vector(double u[DIM3])
+{
+  double mag = 0;
+  while (mag < 0.1) {
+    for (int d = 0; d < DIM3; d++)
+      { u[d] = 2*random_double()-1; }
+    IJK::compute_magnitude_3D(u, mag);
+  }
+  IJK::divide_coord(DIM3, mag, u, u);
+}
+
+void random_unit_vector(COORD_TYPE u[DIM3])
+{
+  double v[DIM3];
+  random_unit_vector(v);
+  IJK::copy_coord_3D(v, u);
+}
+
+const char * matrix_type_name(const MATRIX_TYPE matrix_type)
+{
+  switch(matrix_type) {
+  case SPD_MATRIX: return("symmetric positive definite");
+  case RANK1_MATRIX: return("rank 1");
+  case RANK2_MATRIX: return("rank 2");
+  case NEAR_DEGENERATE_MATRIX: return("near degenerate");
+  default: return("unknown");
+  }
+}
+
+
+// **************************************************
+// Parse command line
+// **************************************************
+
+void parse_command_line(int argc, char **argv)
+{
+  int iarg = 1;
+  while (iarg < argc && argv[iarg][0] == '-') {
+    string s = argv[iarg];
+    if (s == "-seed") {
+      iarg++;
+      if (iarg >= argc) { usage_error(); }
+      seed = atol(argv[iarg]);
+    }
+    else if (s == "-n") {
+      iarg++;
+      if (iarg >= argc) { usage_error(); }
+      num_tests = atoi(argv[iarg]);
+    }
+    else { usage_error(); }
+    iarg++;
+  }
+
+  if (iarg != argc) { usage_error(); }
+}
+
+void usage_error()
+{
+  cerr << "Usage: testjacobi [-seed {S}] [-n {num_tests}]" << endl;
+  exit(10);
+}
@@ -0,0 +1,373 @@
+/// Test merge_identical_by_sorting.
+/// Compare merge_identical_by_sorting against merge_identical
+///   using an INTEGER_LIST on random lists.
+/// Compare sorting in blocks on num_threads threads against sorting
+///   in a single block.
+/// Option -benchmark {N} times merging the quad vertex list of
+///   a spherical shell in an NxNxN grid.
+/// Usage: testmergeid [-seed {S}] [-n {num_tests}] [-threads {T}]
+///          [-benchmark {N}]
+
+/*
+  IJK: Isosurface Jeneration Code
+  Copyright (C) 2015 Rephael Wenger
+
+  This library is free software; you can redistribute it and/or
+  modify it under the terms of the GNU Lesser General Public License
+  (LGPL) as published by the Free Software Foundation; either
+  version 2.1 of the License, or (at your option) any later version.
+
+  This library is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+  Lesser General Public License for more details.
+
+  You should have received a copy of the GNU Lesser General Public
+  License along with this library; if not, write to the Free Software
+  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+*/
+
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <vector>
+
+#include "ijkmerge.txx"
+#include "shrec_thread.txx"
+
+using namespace IJK;
+using namespace std;
+
+
+// global variables
+long seed = 1;
+int num_tests = 200;
+int num_threads = 4;
+int benchmark_size = 0;
+
+// routines
+void test_merge_identical
+(const int min_int, const int num_int, const int list_length);
+void test_merge_identical_large_int(const int list_length);
+void benchmark_merge_identical(const int axis_size);
+template <typename ITYPE, typename MTYPE>
+void merge_identical_by_sorting_in_parallel
+(const std::vector<ITYPE> & list0, std::vector<ITYPE> & list1_nodup,
+ std::vector<MTYPE> & list0_map);
+template <typename ITYPE>
+void check_first_occurrence_order
+(const std::vector<ITYPE> & list0, const std::vector<ITYPE> & list1_nodup,
+ const std::vector<int> & list0_map);
+void parse_command_line(int argc, char **argv);
+void usage_error();
+
+
+int main(int argc, char **argv)
+{
+  // Ranges of values.  Small ranges have many duplicates.
+  // Large min_int values have several radix sort digits.
+  const int num_ranges = 6;
+  const int min_int[num_ranges] = { 0, 0, 0, 0, 1 << 28, 2000000000 };
+  const int num_int[num_ranges] = { 1, 4, 100, 10000, 1 << 20, 100000 };
+
+  try {
+    parse_command_line(argc, argv);
+    srandom(seed);
+
+    if (benchmark_size > 0) {
+      benchmark_merge_identical(benchmark_size);
+      return 0;
+    }
+
+    for (int j = 0; j < num_ranges; j++) {
+      test_merge_identical(min_int[j], num_int[j], 0);
+      test_merge_identical(min_int[j], num_int[j], 1);
+    }
+
+    for (int i = 0; i < num_tests; i++) {
+      const int j = random()%num_ranges;
+      const int list_length = 1 + random()%5000;
+      test_merge_identical(min_int[j], num_int[j], list_length);
+    }
+
+    // Long lists are split into several blocks.
+    for (int j = 0; j < num_ranges; j++)
+      { test_merge_identical(min_int[j], num_int[j], 100000); }
+
+    test_merge_identical_large_int(5000);
+  }
+  catch (ERROR error) {
+    if (error.NumMessages() == 0) {
+      cerr << "Unknown error." << endl;
+    }
+    else { error.Print(cerr); }
+    cerr << "Exiting." << endl;
+    exit(20);
+  }
+  catch (...) {
+    cerr << "Unknown error." << endl;
+    exit(50);
+  };
+
+  cout << "Passed all tests." << endl;
+
+  return 0;
+}
+
+
+// **************************************************
+// Test routines
+// **************************************************
+
+// Merge a random list of values in [min_int, min_int+num_int)
+//   by sorting and by an INTEGER_LIST.  Outputs must be identical.
+void test_merge_identical
+(const int min_int, const int num_int, const int list_length)
+{
+  IJK::PROCEDURE_ERROR error("test_merge_identical");
+  INTEGER_LIST<int,int> int_list(min_int, num_int);
+  std::vector<int> list0(list_length);
+  std::vector<int> list1_nodup_A, list1_nodup_B, list1_nodup_C;
+  std::vector<int> list0_map_A, list0_map_B, list0_map_C;
+
+  for (int i = 0; i < list_length; i++)
+    { list0[i] = min_int + random()%num_int; }
+
+  merge_identical(list0, list1_nodup_A, list0_map_A, int_list);
+  merge_identical_by_sorting(list0, list1_nodup_B, list0_map_B);
+  merge_identical_by_sorting_in_parallel(list0, list1_nodup_C, list0_map_C);
+
+  if (list1_nodup_A != list1_nodup_B) {
+    error.AddMessage("Lists without duplicates differ.");
+    error.AddMessage("  List length ", list_length, ".  Values in [",
+                     min_int, ",", min_int+num_int, ").");
+    throw error;
+  }
+
+  if (list0_map_A != list0_map_B) {
+    error.AddMessage("Maps from list0 to lists without duplicates differ.");
+    error.AddMessage("  List length ", list_length, ".  Values in [",
+                     min_int, ",", min_int+num_int, ").");
+    throw error;
+  }
+
+  if (list1_nodup_B != list1_nodup_C || list0_map_B != list0_map_C) {
+    error.AddMessage("Merge by sorting on ", num_threads,
+                     " threads differs from merge on one thread.");
+    error.AddMessage("  List length ", list_length, ".  Values in [",
+                     min_int, ",", min_int+num_int, ").");
+    throw error;
+  }
+
+  check_first_occurrence_order(list0, list1_nodup_B, list0_map_B);
+}
+
+
+// Merge a random list of 64 bit values by sorting.
+// Values are too large for an INTEGER_LIST, so check against std::map.
+void test_merge_identical_large_int(const int list_length)
+{
+  typedef long long ITYPE;
+  const ITYPE base_int = (ITYPE(1) << 40);
+  IJK::PROCEDURE_ERROR error("test_merge_identical_large_int");
+  std::vector<ITYPE> list0(list_length);
+  std::vector<ITYPE> list1_nodup;
+  std::vector<int> list0_map;
+  std::map<ITYPE,int> first_loc;
+
+  for (int i = 0; i < list_length; i++) {
+    // Values differ in low and high bits.
+    list0[i] = base_int*(random()%3) + random()%1000;
+  }
+
+  merge_identical_by_sorting_in_parallel(list0, list1_nodup, list0_map);
+
+  for (int i = 0; i < list_length; i++) {
+    if (first_loc.find(list0[i]) == first_loc.end()) {
+      const int j = first_loc.size();
+      first_loc[list0[i]] = j;
+    }
+  }
+
+  if (list1_nodup.size() != first_loc.size()) {
+    error.AddMessage("Incorrect number of values ", list1_nodup.size(),
+                     " in list without duplicates.");
+    error.AddMessage("  Expected ", first_loc.size(), " values.");
+    throw error;
+  }
+
+  for (int i = 0; i < list_length; i++) {
+    if (list0_map[i] != first_loc[list0[i]]) {
+      error.AddMessage("Incorrect map ", list0_map[i],
+                       " of list0[", i, "] = ", list0[i], ".");
+      error.AddMessage("  Expected ", first_loc[list0[i]], ".");
+      throw error;
+    }
+  }
+
+  check_first_occurrence_order(list0, list1_nodup, list0_map);
+}
+
+
+// **************************************************
+// Benchmark
+// **************************************************
+
+// Time merging the quad vertex list of a spherical shell
+//   in an axis_size^3 grid.  Each cube in the shell contributes
+//   four grid vertices, as in a dual isosurface quad.
+void benchmark_merge_identical(const int axis_size)
+{
+  typedef std::chrono::steady_clock CLOCK;
+  const int n = axis_size;
+  const double center = n/2.0;
+  const double radius = 0.4*n;
+  IJK::PROCEDURE_ERROR error("benchmark_merge_identical");
+  std::vector<int> list0;
+  std::vector<int> list1_nodup_A, list1_nodup_B, list1_nodup_C;
+  std::vector<int> list0_map_A, list0_map_B, list0_map_C;
+
+  for (int z = 0; z < n; z++) {
+    for (int y = 0; y < n; y++) {
+      for (int x = 0; x < n; x++) {
+        const double dx = x-center, dy = y-center, dz = z-center;
+        const double dist = sqrt(dx*dx + dy*dy + dz*dz);
+
+        if (fabs(dist-radius) < 0.9) {
+          const int iv = x + n*(y + n*z);
+          list0.push_back(iv);
+          list0.push_back(iv+1);
+          list0.push_back(iv+n);
+          list0.push_back(iv+n+1);
+        }
+      }
+    }
+  }
+
+  const CLOCK::time_point t0 = CLOCK::now();
+  {
+    INTEGER_LIST<int,int> int_list(0, n*n*n);
+    merge_identical(list0, list1_nodup_A, list0_map_A, int_list);
+  }
+  const CLOCK::time_point t1 = CLOCK::now();
+  merge_identical_by_sorting(list0, list1_nodup_B, list0_map_B);
+  const CLOCK::time_point t2 = CLOCK::now();
+  merge_identical_by_sorting_in_parallel(list0, list1_nodup_C, list0_map_C);
+  const CLOCK::time_point t3 = CLOCK::now();
+
+  if (list1_nodup_A != list1_nodup_B || list0_map_A != list0_map_B ||
+      list1_nodup_B != list1_nodup_C || list0_map_B != list0_map_C) {
+    error.AddMessage("Merged lists differ.");
+    throw error;
+  }
+
+  const double ms = 1000.0;
+  cout << "Grid: " << n << "^3.  List length: " << list0.size()
+       << ".  Distinct values: " << list1_nodup_A.size() << "." << endl;
+  cout << "  Integer list:               "
+       << ms*std::chrono::duration<double>(t1-t0).count() << " ms" << endl;
+  cout << "  Sort, 1 thread:             "
+       << ms*std::chrono::duration<double>(t2-t1).count() << " ms" << endl;
+  cout << "  Sort, " << num_threads << " threads:            "
+       << ms*std::chrono::duration<double>(t3-t2).count() << " ms" << endl;
+}
+
+
+// **************************************************
+// Merge using threads
+// **************************************************
+
+// Merge identical values by sorting num_threads blocks in parallel.
+template <typename ITYPE, typename MTYPE>
+void merge_identical_by_sorting_in_parallel
+(const std::vector<ITYPE> & list0, std::vector<ITYPE> & list1_nodup,
+ std::vector<MTYPE> & list0_map)
+{
+  merge_identical_by_sorting
+    (list0, list1_nodup, list0_map, num_threads,
+     [](const std::size_t num_blocks, auto f)
+     { SHREC::apply_in_parallel(num_threads, num_blocks, f); });
+}
+
+
+// **************************************************
+// Check routines
+// **************************************************
+
+// Check that list1_nodup[list0_map[i]] equals list0[i]
+//   and that list1_nodup is in order of first occurrence in list0.
+template <typename ITYPE>
+void check_first_occurrence_order
+(const std::vector<ITYPE> & list0, const std::vector<ITYPE> & list1_nodup,
+ const std::vector<int> & list0_map)
+{
+  IJK::PROCEDURE_ERROR error("check_first_occurrence_order");
+  int num_found = 0;
+
+  for (std::size_t i = 0; i < list0.size(); i++) {
+    const int j = list0_map[i];
+
+    if (j < 0 || j > num_found || list1_nodup[j] != list0[i]) {
+      error.AddMessage("Incorrect map ", j, " of list0[", i, "].");
+      error.AddMessage("  Number of distinct values before list0[", i,
+                       "] is ", num_found, ".");
+      throw error;
+    }
+
+    if (j == num_found) { num_found++; }
+  }
+
+  if (num_found != int(list1_nodup.size())) {
+    error.AddMessage("List without duplicates has ", list1_nodup.size(),
+                     " values.");
+    error.AddMessage("  List0 has ", num_found, " distinct values.");
+    throw error;
+  }
+}
+
+
+// **************************************************
+// Parse command line
+// **************************************************
+
+void parse_command_line(int argc, char **argv)
+{
+  int iarg = 1;
+
+  while (iarg < argc) {
+    if (strcmp(argv[iarg], "-seed") == 0) {
+      iarg++;
+      if (iarg >= argc) { usage_error(); }
+      seed = atol(argv[iarg]);
+    }
+    else if (strcmp(argv[iarg], "-n") == 0) {
+      iarg++;
+      if (iarg >= argc) { usage_error(); }
+      num_tests = atoi(argv[iarg]);
+    }
+    else if (strcmp(argv[iarg], "-threads") == 0) {
+      iarg++;
+      if (iarg >= argc) { usage_error(); }
+      num_threads = atoi(argv[iarg]);
+    }
+    else if (strcmp(argv[iarg], "-benchmark") == 0) {
+      iarg++;
+      if (iarg >= argc) { usage_error(); }
+      benchmark_size = atoi(argv[iarg]);
+    }
+    else { usage_error(); }
+    iarg++;
+  }
+}
+
+void usage_error()
+{
+  cerr << "Usage: testmergeid [-seed {S}] [-n {num_tests}] [-threads {T}]"
+       << endl
+       << "         [-benchmark {N}]" << endl;
+  exit(10);
+}